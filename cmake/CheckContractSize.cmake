@@ -0,0 +1,159 @@
+# Reports the size and instantiation cost of a contract module against its
+# budgets.
+#
+# Expects CONTRACT, FILE, BUDGET and ENFORCE to be defined on the command
+# line, and INSTANTIATION_BUDGET if the contract has one. A BUDGET of - has
+# not been recorded yet and is reported like an exceeded one. With RECORD set to
+# a margin in percent, the budgets in LISTS, the contract's CMakeLists.txt,
+# are instead rewritten to the measured values plus that margin.
+#
+# The instantiation cost is what a node allocates and writes each time it
+# instantiates the module: its initial linear memory plus the bytes of its
+# active data segments. It is read from the module's memory and data
+# sections.
+
+if(NOT EXISTS "${FILE}")
+   message(FATAL_ERROR "${CONTRACT}: ${FILE} does not exist")
+endif()
+
+file(READ "${FILE}" contents HEX)
+string(LENGTH "${contents}" hex_length)
+math(EXPR size "${hex_length} / 2")
+
+# Reads the byte at hex offset pos
+macro(read_byte out pos)
+   string(SUBSTRING "${contents}" ${pos} 2 _byte_hex)
+   math(EXPR ${out} "0x${_byte_hex}")
+endmacro()
+
+# Reads an unsigned LEB128 at hex offset ${pos_var}, advancing it
+function(read_uleb out pos_var)
+   set(pos ${${pos_var}})
+   set(value 0)
+   set(shift 0)
+   set(more 1)
+   while(more)
+      if(NOT pos LESS hex_length)
+         message(FATAL_ERROR "${CONTRACT}: ${FILE} is truncated")
+      endif()
+      read_byte(byte ${pos})
+      math(EXPR pos "${pos} + 2")
+      math(EXPR value "${value} + ((${byte} & 0x7f) << ${shift})")
+      math(EXPR shift "${shift} + 7")
+      math(EXPR more "${byte} >> 7")
+   endwhile()
+   set(${out} ${value} PARENT_SCOPE)
+   set(${pos_var} ${pos} PARENT_SCOPE)
+endfunction()
+
+# Skips a constant expression up to and including its end opcode. The
+# offsets of data segments are single instructions with LEB immediates.
+function(skip_const_expr pos_var)
+   set(pos ${${pos_var}})
+   read_byte(opcode ${pos})
+   math(EXPR pos "${pos} + 2")
+   while(NOT opcode EQUAL 0x0b)
+      read_uleb(unused pos)
+      read_byte(opcode ${pos})
+      math(EXPR pos "${pos} + 2")
+   endwhile()
+   set(${pos_var} ${pos} PARENT_SCOPE)
+endfunction()
+
+set(memory_pages 0)
+set(data_bytes 0)
+
+# Skip the magic and version, then walk the sections
+set(pos 16)
+while(pos LESS hex_length)
+   read_byte(section_id ${pos})
+   math(EXPR pos "${pos} + 2")
+   read_uleb(section_size pos)
+   math(EXPR section_end "${pos} + ${section_size} * 2")
+
+   if(section_id EQUAL 5)
+      # Memory section: the first memory's limits
+      read_uleb(count pos)
+      if(count GREATER 0)
+         math(EXPR pos "${pos} + 2")
+         read_uleb(memory_pages pos)
+      endif()
+   elseif(section_id EQUAL 11)
+      # Data section: the bytes of active segments
+      read_uleb(count pos)
+      while(count GREATER 0)
+         math(EXPR count "${count} - 1")
+         read_uleb(flags pos)
+         set(active 1)
+         if(flags EQUAL 1)
+            set(active 0)
+         else()
+            if(flags EQUAL 2)
+               read_uleb(unused pos)
+            endif()
+            skip_const_expr(pos)
+         endif()
+         read_uleb(length pos)
+         if(active)
+            math(EXPR data_bytes "${data_bytes} + ${length}")
+         endif()
+         math(EXPR pos "${pos} + ${length} * 2")
+      endwhile()
+   endif()
+
+   set(pos ${section_end})
+endwhile()
+
+math(EXPR instantiation "${memory_pages} * 65536 + ${data_bytes}")
+
+if(DEFINED RECORD)
+   math(EXPR new_budget "(${size} * (100 + ${RECORD}) + 99) / 100")
+   math(EXPR new_instantiation "(${instantiation} * (100 + ${RECORD}) + 99) / 100")
+
+   file(READ "${LISTS}" lists)
+   string(REGEX REPLACE "koinos_contract_size_budget\\(${CONTRACT} [^)]*\\)"
+      "koinos_contract_size_budget(${CONTRACT} ${new_budget} INSTANTIATION ${new_instantiation})" updated "${lists}")
+   if(updated STREQUAL lists)
+      message(FATAL_ERROR "${CONTRACT}: no koinos_contract_size_budget(${CONTRACT} ...) in ${LISTS}")
+   endif()
+   file(WRITE "${LISTS}" "${updated}")
+
+   message(STATUS "${CONTRACT}: recorded ${new_budget} byte size budget and ${new_instantiation} byte instantiation budget")
+   return()
+endif()
+
+set(over 0)
+
+if(BUDGET STREQUAL "-")
+   # Not recorded from a build yet, which counts as over budget
+   set(report "${CONTRACT}: ${size} bytes, no budget recorded (run record_contract_sizes)")
+   set(over 1)
+else()
+   math(EXPR percent "(${size} * 100) / ${BUDGET}")
+   set(report "${CONTRACT}: ${size} bytes (${percent}% of ${BUDGET} byte budget)")
+   if(size GREATER BUDGET)
+      set(report "${report} exceeds budget")
+      set(over 1)
+   endif()
+endif()
+
+set(instantiation_report "${CONTRACT}: instantiates ${instantiation} bytes (${memory_pages} pages, ${data_bytes} bytes of data)")
+if(INSTANTIATION_BUDGET)
+   math(EXPR percent "(${instantiation} * 100) / ${INSTANTIATION_BUDGET}")
+   set(instantiation_report "${instantiation_report}, ${percent}% of ${INSTANTIATION_BUDGET} byte budget")
+   if(instantiation GREATER INSTANTIATION_BUDGET)
+      set(instantiation_report "${instantiation_report} exceeds budget")
+      set(over 1)
+   endif()
+else()
+   set(instantiation_report "${instantiation_report}, no budget")
+endif()
+
+if(over AND ENFORCE)
+   message(FATAL_ERROR "${report}\n${instantiation_report}")
+elseif(over)
+   message(WARNING "${report}\n${instantiation_report}")
+else()
+   message(STATUS "${report}")
+   message(STATUS "${instantiation_report}")
+endif()
@@ -0,0 +1,70 @@
+# Instruction budgets for wasm contracts.
+#
+# koinos_contract_instruction_budget(<target> <fixture>) registers a test that
+# runs the built module in wasm_meter, the metering interpreter from the tools
+# build, over the fixed calls listed in the fixture. The test fails when a
+# call executes more instructions than its budget, when a call has no budget
+# recorded yet, or when a call succeeds or fails against the fixture's
+# expectation. The contract_instructions target reports every contract's
+# counts.
+#
+# The record_contract_instructions target rewrites every budget in the
+# fixtures to the measured count plus CONTRACT_INSTRUCTION_MARGIN percent.
+# wasm_meter refuses to record from a module on which any fixture call
+# succeeds or fails unexpectedly. Record from a build with the default
+# options.
+#
+# Nothing is registered unless WASM_METER_PROGRAM points at a wasm_meter
+# binary. Budgets are recorded for the default build options, so under
+# BUILD_FOR_TESTING, FIXED_LAYOUT_STATE, BATCHED_OBJECT_CALLS or
+# OPTIMIZE_FOR_SIZE the counts are reported but not enforced, and nothing
+# can be recorded.
+
+find_program(WASM_METER_PROGRAM wasm_meter)
+
+set(CONTRACT_INSTRUCTION_MARGIN 5 CACHE STRING "Headroom in percent that record_contract_instructions leaves above measured counts")
+
+if(WASM_METER_PROGRAM)
+   enable_testing()
+endif()
+
+function(koinos_contract_instruction_budget target fixture)
+   if(NOT WASM_METER_PROGRAM)
+      return()
+   endif()
+
+   set(meter_command ${WASM_METER_PROGRAM})
+   set(default_options ON)
+   if(BATCHED_OBJECT_CALLS)
+      list(APPEND meter_command -b)
+   endif()
+   if(BUILD_FOR_TESTING OR FIXED_LAYOUT_STATE OR BATCHED_OBJECT_CALLS OR OPTIMIZE_FOR_SIZE)
+      list(APPEND meter_command --report)
+      set(default_options OFF)
+   endif()
+   set(meter_files $<TARGET_FILE:${target}> ${CMAKE_CURRENT_SOURCE_DIR}/${fixture})
+   list(APPEND meter_command ${meter_files})
+
+   add_test(NAME ${target}_instructions COMMAND ${meter_command})
+
+   if(NOT TARGET contract_instructions)
+      add_custom_target(contract_instructions)
+   endif()
+
+   add_custom_target(${target}_instructions COMMAND ${meter_command} DEPENDS ${target} VERBATIM)
+   add_dependencies(contract_instructions ${target}_instructions)
+
+   if(NOT default_options)
+      return()
+   endif()
+
+   if(NOT TARGET record_contract_instructions)
+      add_custom_target(record_contract_instructions)
+   endif()
+
+   add_custom_target(${target}_record_instructions
+      COMMAND ${WASM_METER_PROGRAM} --record ${CONTRACT_INSTRUCTION_MARGIN} ${meter_files}
+      DEPENDS ${target}
+      VERBATIM)
+   add_dependencies(record_contract_instructions ${target}_record_instructions)
+endfunction()
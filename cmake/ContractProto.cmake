@@ -0,0 +1,43 @@
+# Generated types for a contract's own .proto files.
+#
+# koinos_contract_proto(<target> <proto> <package dir>) generates the
+# EmbeddedProto header of <proto> with protoc and the SDK's EmbeddedProto
+# plugin, and adds it to the target's include path under the directory of
+# its package, the path it is imported by. For example
+#
+#    koinos_contract_proto(koin koin_extensions.proto koinos/contracts/koin)
+#
+# lets koin include <koinos/contracts/koin/koin_extensions.h>, next to the
+# SDK's koin.h. The header is regenerated whenever the .proto changes, so the
+# contract always decodes and encodes what its ABI describes.
+#
+# koinos/options.proto, which contract .proto files import, comes from the
+# koinos-proto sources, KOINOS_PROTO_INCLUDE_DIR.
+
+find_program(PROTOC_PROGRAM protoc HINTS $ENV{KOINOS_SDK_ROOT}/bin)
+find_program(EMBEDDED_PROTO_PLUGIN protoc-gen-eams HINTS $ENV{KOINOS_SDK_ROOT}/bin $ENV{KOINOS_SDK_ROOT}/EmbeddedProto)
+find_path(KOINOS_PROTO_INCLUDE_DIR koinos/options.proto HINTS $ENV{KOINOS_SDK_ROOT}/include $ENV{KOINOS_SDK_ROOT}/proto)
+
+function(koinos_contract_proto target proto package_dir)
+   if(NOT PROTOC_PROGRAM OR NOT EMBEDDED_PROTO_PLUGIN OR NOT KOINOS_PROTO_INCLUDE_DIR)
+      message(FATAL_ERROR "${target} needs protoc, the EmbeddedProto plugin protoc-gen-eams and koinos/options.proto (KOINOS_PROTO_INCLUDE_DIR) to generate ${proto}")
+   endif()
+
+   get_filename_component(name ${proto} NAME_WE)
+   set(proto_dir ${CMAKE_CURRENT_BINARY_DIR}/proto)
+   set(header ${proto_dir}/${package_dir}/${name}.h)
+
+   # protoc names generated files by the .proto's path under an include
+   # directory, so the .proto is copied to its package directory first
+   add_custom_command(OUTPUT ${header}
+      COMMAND ${CMAKE_COMMAND} -E make_directory ${proto_dir}/${package_dir}
+      COMMAND ${CMAKE_COMMAND} -E copy ${CMAKE_CURRENT_SOURCE_DIR}/${proto} ${proto_dir}/${package_dir}/${name}.proto
+      COMMAND ${PROTOC_PROGRAM} --plugin=protoc-gen-eams=${EMBEDDED_PROTO_PLUGIN} -I${KOINOS_PROTO_INCLUDE_DIR} -I${proto_dir} --eams_out=${proto_dir} ${package_dir}/${name}.proto
+      DEPENDS ${CMAKE_CURRENT_SOURCE_DIR}/${proto}
+      COMMENT "Generating ${package_dir}/${name}.h"
+      VERBATIM)
+
+   add_custom_target(${target}_${name}_proto DEPENDS ${header})
+   add_dependencies(${target} ${target}_${name}_proto)
+   target_include_directories(${target} PRIVATE ${proto_dir})
+endfunction()
@@ -0,0 +1,70 @@
+# Size profile and size budgets for wasm contracts.
+#
+# With OPTIMIZE_FOR_SIZE, contracts are compiled with -Oz and LTO, unused
+# sections are garbage collected at link time, and the module is run through
+# wasm-opt when it is available.
+#
+# koinos_contract_size_budget(<target> <bytes> [INSTANTIATION <bytes>])
+# reports the size of the module after every build and compares it against
+# its budget, and likewise the bytes a node initializes to instantiate it,
+# see CheckContractSize.cmake. Exceeding a budget fails the build when
+# ENFORCE_SIZE_BUDGETS is on and warns otherwise. The contract_sizes target
+# reports every contract without rebuilding.
+#
+# The record_contract_sizes target rewrites every budget in the contracts'
+# CMakeLists.txt to the measured value plus CONTRACT_SIZE_MARGIN percent.
+# Record from a build with the default options and ENFORCE_SIZE_BUDGETS off.
+# Until then a contract's budget is -, which fails the build like an
+# exceeded budget.
+
+find_program(WASM_OPT_PROGRAM wasm-opt)
+
+set(CONTRACT_SIZE_SCRIPT ${CMAKE_CURRENT_LIST_DIR}/CheckContractSize.cmake)
+set(CONTRACT_SIZE_MARGIN 2 CACHE STRING "Headroom in percent that record_contract_sizes leaves above measured sizes")
+
+function(koinos_contract_size_budget target budget)
+   cmake_parse_arguments(BUDGET "" "INSTANTIATION" "" ${ARGN})
+
+   if(OPTIMIZE_FOR_SIZE)
+      target_compile_options(${target} PRIVATE -Oz -flto -ffunction-sections -fdata-sections)
+      set_property(TARGET ${target} APPEND_STRING PROPERTY LINK_FLAGS " -Oz -flto -Wl,--gc-sections -Wl,--strip-all -Wl,--lto-O3")
+
+      if(WASM_OPT_PROGRAM)
+         add_custom_command(TARGET ${target} POST_BUILD
+            COMMAND ${WASM_OPT_PROGRAM} -Oz --strip-debug --strip-producers $<TARGET_FILE:${target}> -o $<TARGET_FILE:${target}>
+            COMMENT "Running wasm-opt on ${target}")
+      endif()
+   endif()
+
+   set(check_command ${CMAKE_COMMAND}
+      -DCONTRACT=${target}
+      -DFILE=$<TARGET_FILE:${target}>
+      -DBUDGET=${budget}
+      -DENFORCE=${ENFORCE_SIZE_BUDGETS}
+      -DINSTANTIATION_BUDGET=${BUDGET_INSTANTIATION}
+      -P ${CONTRACT_SIZE_SCRIPT})
+
+   add_custom_command(TARGET ${target} POST_BUILD COMMAND ${check_command} VERBATIM)
+
+   if(NOT TARGET contract_sizes)
+      add_custom_target(contract_sizes)
+   endif()
+
+   add_custom_target(${target}_size COMMAND ${check_command} DEPENDS ${target} VERBATIM)
+   add_dependencies(contract_sizes ${target}_size)
+
+   if(NOT TARGET record_contract_sizes)
+      add_custom_target(record_contract_sizes)
+   endif()
+
+   add_custom_target(${target}_record_size
+      COMMAND ${CMAKE_COMMAND}
+         -DCONTRACT=${target}
+         -DFILE=$<TARGET_FILE:${target}>
+         -DRECORD=${CONTRACT_SIZE_MARGIN}
+         -DLISTS=${CMAKE_CURRENT_SOURCE_DIR}/CMakeLists.txt
+         -P ${CONTRACT_SIZE_SCRIPT}
+      DEPENDS ${target}
+      VERBATIM)
+   add_dependencies(record_contract_sizes ${target}_record_size)
+endfunction()
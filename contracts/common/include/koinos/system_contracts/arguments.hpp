@@ -0,0 +1,286 @@
+#pragma once
+
+#include <koinos/system/system_calls.hpp>
+#include <koinos/system_contracts/invocation.hpp>
+#include <koinos/system_contracts/wire.hpp>
+
+#include <array>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace koinos::system_contracts {
+
+namespace detail {
+
+// Parses get_arguments_result { argument_data value = 1; } where
+// argument_data { uint32 entry_point = 1; bytes arguments = 2; }
+inline bool parse_arguments( const uint8_t* data, std::size_t len, argument_view& view )
+{
+   wire::reader rdr( data, len );
+   uint32_t field;
+   wire::wire_type type;
+   const uint8_t* value;
+   std::size_t value_len;
+
+   if ( rdr.eof() )
+      return true;
+
+   if ( !rdr.read_tag( field, type ) || field != 1 || type != wire::wire_type::length_delimited
+      || !rdr.read_bytes( value, value_len ) )
+      return false;
+
+   wire::reader value_rdr( value, value_len );
+   while ( !value_rdr.eof() )
+   {
+      if ( !value_rdr.read_tag( field, type ) )
+         return false;
+
+      if ( field == 1 && type == wire::wire_type::varint )
+      {
+         uint64_t entry_point;
+         if ( !value_rdr.read_varint( entry_point ) )
+            return false;
+         view.entry_point = uint32_t( entry_point );
+      }
+      else if ( field == 2 && type == wire::wire_type::length_delimited )
+      {
+         if ( !value_rdr.read_bytes( view.data, view.size ) )
+            return false;
+      }
+      else if ( !value_rdr.skip( type ) )
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+// System call results are parsed in place rather than deserialized into the
+// SDK's chain types. A protocol::transaction holds every operation, with
+// each field in a fixed-size buffer sized for the largest upload, when only
+// the id and the signatures are read.
+
+// Parses get_transaction_result { transaction value = 1; } for the
+// transaction's id and signatures, where
+//
+//    transaction { bytes id = 1; transaction_header header = 2; repeated operation operations = 3; repeated bytes signatures = 4; }
+inline bool parse_transaction_signatures( const uint8_t* data, std::size_t len, std::string& id, std::vector< std::string >& signatures )
+{
+   id.clear();
+   signatures.clear();
+
+   wire::reader rdr( data, len );
+   uint32_t field;
+   wire::wire_type type;
+   const uint8_t* value;
+   std::size_t value_len;
+
+   if ( !rdr.read_tag( field, type ) || field != 1 || type != wire::wire_type::length_delimited
+      || !rdr.read_bytes( value, value_len ) )
+      return false;
+
+   wire::reader trx_rdr( value, value_len );
+   while ( !trx_rdr.eof() )
+   {
+      if ( !trx_rdr.read_tag( field, type ) )
+         return false;
+
+      bool ok;
+      if ( field == 1 && type == wire::wire_type::length_delimited )
+         ok = trx_rdr.read_bytes( id );
+      else if ( field == 4 && type == wire::wire_type::length_delimited )
+         ok = trx_rdr.read_bytes( signatures.emplace_back() );
+      else
+         ok = trx_rdr.skip( type );
+
+      if ( !ok )
+         return false;
+   }
+
+   return true;
+}
+
+// Parses get_transaction_field_result { value_type value = 1; } for the
+// transaction id, value_type.bytes_value = 14
+inline bool parse_transaction_id( const uint8_t* data, std::size_t len, std::string& id )
+{
+   id.clear();
+
+   wire::reader rdr( data, len );
+   uint32_t field;
+   wire::wire_type type;
+   const uint8_t* value;
+   std::size_t value_len;
+
+   if ( !rdr.read_tag( field, type ) || field != 1 || type != wire::wire_type::length_delimited
+      || !rdr.read_bytes( value, value_len ) )
+      return false;
+
+   wire::reader value_rdr( value, value_len );
+   while ( !value_rdr.eof() )
+   {
+      if ( !value_rdr.read_tag( field, type ) )
+         return false;
+
+      bool ok;
+      if ( field == 14 && type == wire::wire_type::length_delimited )
+         ok = value_rdr.read_bytes( id );
+      else
+         ok = value_rdr.skip( type );
+
+      if ( !ok )
+         return false;
+   }
+
+   return true;
+}
+
+inline void check_call( int32_t code, const char* message )
+{
+   if ( code )
+      system::fail( message );
+}
+
+inline bool invoke_check_authority( const uint8_t* args, std::size_t args_len )
+{
+   auto& buffer = current_invocation().syscall_buffer();
+   uint32_t bytes_written = 0;
+   check_call( invoke_system_call(
+      std::underlying_type_t< chain::system_call_id >( chain::system_call_id::check_authority ),
+      reinterpret_cast< char* >( buffer.data() ),
+      std::size( buffer ),
+      reinterpret_cast< char* >( const_cast< uint8_t* >( args ) ),
+      args_len,
+      &bytes_written
+   ), "check_authority failed" );
+
+   // check_authority_result { bool value = 1; }
+   wire::reader rdr( buffer.data(), bytes_written );
+   uint32_t field;
+   wire::wire_type type;
+   uint64_t value = 0;
+
+   while ( !rdr.eof() )
+   {
+      if ( !rdr.read_tag( field, type ) )
+         system::fail( "malformed check_authority result" );
+
+      if ( field == 1 && type == wire::wire_type::varint )
+      {
+         if ( !rdr.read_varint( value ) )
+            system::fail( "malformed check_authority result" );
+      }
+      else if ( !rdr.skip( type ) )
+      {
+         system::fail( "malformed check_authority result" );
+      }
+   }
+
+   return value != 0;
+}
+
+} // detail
+
+// Fetches the current invocation's arguments on first use and returns a view
+// of them. No copy of the arguments is made.
+inline const argument_view& get_arguments()
+{
+   auto& ctx = current_invocation();
+
+   if ( !ctx.arguments_fetched )
+   {
+      auto& buffer = ctx.argument_buffer;
+      uint32_t bytes_written = 0;
+
+      detail::check_call( invoke_system_call(
+         std::underlying_type_t< chain::system_call_id >( chain::system_call_id::get_arguments ),
+         reinterpret_cast< char* >( buffer.data() ),
+         buffer.size(),
+         nullptr,
+         0,
+         &bytes_written
+      ), "get_arguments failed" );
+
+      if ( !detail::parse_arguments( buffer.data(), bytes_written, ctx.arguments ) )
+         system::fail( "malformed get_arguments result" );
+
+      ctx.arguments_fetched = true;
+   }
+
+   return ctx.arguments;
+}
+
+// Deserializes an entry's arguments into their generated type. Reverts with
+// malformed when they do not decode, as when a field is longer than the type
+// allows.
+template< typename Arguments >
+inline Arguments decode_arguments( const argument_view& args, const char* malformed )
+{
+   Arguments arg;
+   auto rdbuf = args.reader();
+   if ( arg.deserialize( rdbuf ) != ::EmbeddedProto::Error::NO_ERRORS )
+      system::revert( malformed );
+   return arg;
+}
+
+// The contents of a generated bytes field
+template< typename Bytes >
+inline std::string bytes_string( const Bytes& bytes )
+{
+   return std::string( reinterpret_cast< const char* >( bytes.get_const() ), bytes.get_length() );
+}
+
+// Checks that an account authorized a contract call with the given
+// arguments. The call's check_authority_arguments are assembled around the
+// arguments where they already are in the argument buffer:
+//
+//    check_authority_arguments { authorization_type type = 1; bytes account = 2; bytes data = 3; }
+//
+// The data field is written first, its header in place of the get_arguments
+// framing just before the arguments, and the account field after them. The
+// overwritten framing is restored afterwards. Type is contract_call, which is
+// the default and so not encoded.
+inline bool check_authority( const std::string& account, const argument_view& args )
+{
+   constexpr uint8_t data_tag    = wire::make_tag( 3, wire::wire_type::length_delimited );
+   constexpr uint8_t account_tag = wire::make_tag( 2, wire::wire_type::length_delimited );
+
+   auto& buffer = current_invocation().argument_buffer;
+   auto header_size = 1 + wire::varint_size( args.size );
+   auto trailer_size = 1 + wire::varint_size( account.size() ) + account.size();
+
+   bool in_buffer = args.data >= buffer.data() && args.data + args.size <= buffer.data() + buffer.size();
+
+   if ( !in_buffer
+      || std::size_t( args.data - buffer.data() ) < header_size
+      || std::size_t( buffer.data() + buffer.size() - ( args.data + args.size ) ) < trailer_size )
+   {
+      std::string message;
+      wire::append_bytes( message, 3, args.data, args.size );
+      wire::append_bytes( message, 2, account );
+      return detail::invoke_check_authority( reinterpret_cast< const uint8_t* >( message.data() ), message.size() );
+   }
+
+   auto start = const_cast< uint8_t* >( args.data ) - header_size;
+
+   std::array< uint8_t, 11 > saved;
+   std::memcpy( saved.data(), start, header_size );
+
+   start[0] = data_tag;
+   wire::write_varint( start + 1, args.size );
+
+   auto trailer = const_cast< uint8_t* >( args.data ) + args.size;
+   trailer[0] = account_tag;
+   auto p = wire::write_varint( trailer + 1, account.size() );
+   std::memcpy( p, account.data(), account.size() );
+
+   bool authorized = detail::invoke_check_authority( start, header_size + args.size + trailer_size );
+
+   std::memcpy( start, saved.data(), header_size );
+
+   return authorized;
+}
+
+} // koinos::system_contracts
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <koinos/system_contracts/fixed_layout.hpp>
+#include <koinos/system_contracts/schema.hpp>
+#include <koinos/system_contracts/uint.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Balance checksums.
+//
+// An order-independent summary of every object holding a balance, kept up
+// to date as the objects are written so that it never needs a scan:
+//
+//    sum          the values added up, modulo 2^64
+//    fingerprint  each object's value times the weight of its key, added up
+//                 modulo 2^256
+//
+// The weight of a key is an odd 256-bit integer mixed from a 64-bit hash of
+// the object's space id and key, so updating the checksum costs a few
+// multiplications and no hash system call. Replacing an object's value adds
+// the weight times the change. Since every weight is odd, a change to any one
+// value always changes the fingerprint. The fingerprint is not a
+// cryptographic commitment: it catches a balance written wrongly, not
+// balances chosen to cancel out.
+//
+// Objects with a value of zero contribute nothing, so a missing object and
+// an emptied one are the same. On chain the sum is checked against the
+// supply. Offline, a snapshot is checked by rebuilding both from the raw
+// objects.
+//
+// The checksum can be spread over several stripe objects that add up to it,
+// so that concurrent writers do not all update one object. An object's
+// changes always go to the stripe picked by its key hash.
+namespace koinos::system_contracts::checksum {
+
+struct state
+{
+   uint64_t sum = 0;
+   uint256  fingerprint;
+};
+
+// FNV-1a over the id of the object's space and its key
+constexpr uint64_t key_hash( uint32_t space_id, std::string_view key )
+{
+   constexpr uint64_t prime = 0x100000001b3;
+
+   uint64_t h = 0xcbf29ce484222325;
+   h = ( h ^ uint8_t( space_id ) ) * prime;
+   for ( auto c : key )
+      h = ( h ^ uint8_t( c ) ) * prime;
+   return h;
+}
+
+namespace detail {
+
+// The splitmix64 finalizer
+constexpr uint64_t mix( uint64_t x )
+{
+   x = ( x ^ ( x >> 30 ) ) * 0xbf58476d1ce4e5b9;
+   x = ( x ^ ( x >> 27 ) ) * 0x94d049bb133111eb;
+   return x ^ ( x >> 31 );
+}
+
+} // detail
+
+constexpr uint256 weight( uint64_t key_hash )
+{
+   constexpr uint64_t golden = 0x9e3779b97f4a7c15;
+
+   uint256 w;
+   for ( std::size_t i = 4; i-- > 0; )
+      w = w << 64 | uint256( detail::mix( key_hash + ( i + 1 ) * golden ) );
+   return w | uint256( 1 );
+}
+
+constexpr std::size_t stripe( uint64_t key_hash, uint32_t stripes )
+{
+   return std::size_t( ( key_hash >> 32 ) % stripes );
+}
+
+constexpr void add( state& s, uint64_t value, const uint256& weight )
+{
+   s.sum         += value;
+   s.fingerprint += weight * uint256( value );
+}
+
+constexpr void remove( state& s, uint64_t value, const uint256& weight )
+{
+   s.sum         -= value;
+   s.fingerprint -= weight * uint256( value );
+}
+
+constexpr void combine( state& s, const state& other )
+{
+   s.sum         += other.sum;
+   s.fingerprint += other.fingerprint;
+}
+
+constexpr bool empty( const state& s )
+{
+   return !s.sum && !s.fingerprint;
+}
+
+// Stored with the sum little endian and the fingerprint big endian:
+//
+//    0x00 0x01 sum(8) fingerprint(32)
+//
+// A missing stripe decodes as zero.
+constexpr std::size_t encoded_size = 2 + 8 + uint256::bytes;
+
+constexpr void encode( const state& s, uint8_t* out )
+{
+   out[0] = envelope_tag;
+   out[1] = fixed_layout_version;
+   fixed_layout::put_u64( out + 2, s.sum );
+   s.fingerprint.to_big_endian( out + 10 );
+}
+
+constexpr bool decode( const uint8_t* data, std::size_t len, state& s )
+{
+   s = state();
+
+   if ( !len )
+      return true;
+
+   if ( len != encoded_size || data[0] != envelope_tag || data[1] != fixed_layout_version )
+      return false;
+
+   s.sum         = fixed_layout::get_u64( data + 2 );
+   s.fingerprint = uint256::from_big_endian( data + 10 );
+   return true;
+}
+
+namespace detail {
+
+constexpr bool example_order_independent()
+{
+   auto a = weight( key_hash( 1, "alice" ) ), b = weight( key_hash( 1, "bob" ) );
+
+   state s1, s2;
+   add( s1, 5, a );
+   add( s1, 7, b );
+   add( s2, 7, b );
+   add( s2, 5, a );
+   remove( s2, 5, a );
+   add( s2, 5, a );
+
+   return s1.sum == 12 && s1.fingerprint == s2.fingerprint;
+}
+
+// Moving value between two objects keeps the sum but not the fingerprint
+constexpr bool example_detects_moves()
+{
+   auto a = weight( key_hash( 1, "alice" ) ), b = weight( key_hash( 1, "bob" ) );
+
+   state s1, s2;
+   add( s1, 5, a );
+   add( s1, 7, b );
+   add( s2, 4, a );
+   add( s2, 8, b );
+
+   return s1.sum == s2.sum && s1.fingerprint != s2.fingerprint;
+}
+
+} // detail
+
+static_assert( detail::example_order_independent() );
+static_assert( detail::example_detects_moves() );
+
+} // koinos::system_contracts::checksum
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace koinos::system_contracts::fixed_layout {
+
+constexpr void put_u64( uint8_t* p, uint64_t v )
+{
+   for ( std::size_t i = 0; i < sizeof( uint64_t ); i++ )
+      p[i] = uint8_t( v >> ( 8 * i ) );
+}
+
+constexpr uint64_t get_u64( const uint8_t* p )
+{
+   uint64_t v = 0;
+   for ( std::size_t i = 0; i < sizeof( uint64_t ); i++ )
+      v |= uint64_t( p[i] ) << ( 8 * i );
+   return v;
+}
+
+// Specialized for each object that has a fixed layout. A specialization
+// provides:
+//
+//    static constexpr std::size_t size;                 // Encoded size
+//    static void encode( const T& obj, uint8_t* out );  // Writes exactly `size` bytes
+//    static bool decode( const uint8_t* in, std::size_t len, T& obj );
+template< typename T >
+struct layout;
+
+template< typename T, typename = void >
+struct has_layout : std::false_type {};
+
+template< typename T >
+struct has_layout< T, std::void_t< decltype( layout< T >::size ) > > : std::true_type {};
+
+} // koinos::system_contracts::fixed_layout
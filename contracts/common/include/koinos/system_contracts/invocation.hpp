@@ -0,0 +1,155 @@
+#pragma once
+
+#include <koinos/system/system_calls.hpp>
+
+#include <koinos/buffer.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <tuple>
+
+// Per-invocation state.
+//
+// What a contract fetches or caches while it runs lives in an
+// invocation_context, not in globals or function statics: the argument
+// buffer and its parsed view, the buffer for the system calls the contract
+// library makes itself, the contract id and the object spaces built from
+// it. An entry function receives the context.
+//
+// The entry function installs the context with an invocation_scope, and
+// helpers that would otherwise need it as an extra parameter on every call
+// reach it through current_invocation(). The pointer is thread local in
+// native builds. In wasm, where each invocation gets a fresh instance, it is
+// a plain global and the contract behaves as before.
+//
+// Native invocations cannot yet run concurrently. The SDK's own wrappers,
+// such as system::get_head_info, get_caller, get_contract_id, hash, event,
+// log, get_object, put_object and the exit behind fail and revert, still
+// write the SDK's single global system call buffer. Only the calls made
+// through the context's buffer (arguments, object batches, results,
+// check_authority and the token engine's transaction reads) are safe to run
+// on several threads at once.
+#if defined( __wasm__ )
+#define KOINOS_INVOCATION_LOCAL
+#else
+#define KOINOS_INVOCATION_LOCAL thread_local
+#endif
+
+namespace koinos::system_contracts {
+
+// Read-only view of the contract arguments. The data points into the
+// context's argument buffer, which the get_arguments system call wrote and
+// which stays valid for the whole invocation.
+struct argument_view
+{
+   uint32_t       entry_point = 0;
+   const uint8_t* data        = nullptr;
+   std::size_t    size        = 0;
+
+   koinos::read_buffer reader() const
+   {
+      return koinos::read_buffer( const_cast< uint8_t* >( data ), size );
+   }
+};
+
+constexpr std::size_t syscall_buffer_size  = std::tuple_size_v< decltype( system::detail::syscall_buffer ) >;
+constexpr std::size_t argument_buffer_size = syscall_buffer_size;
+
+class invocation_context
+{
+public:
+   // Object spaces with ids below this are cached
+   static constexpr uint32_t max_cached_spaces = 32;
+
+   std::array< uint8_t, argument_buffer_size > argument_buffer;
+   argument_view                               arguments;
+   bool                                        arguments_fetched = false;
+
+   // Fetched on first use
+   const std::string& contract_id()
+   {
+      if ( !_contract_id_fetched )
+      {
+         _contract_id = system::get_contract_id();
+         _contract_id_fetched = true;
+      }
+      return _contract_id;
+   }
+
+   // Output buffer for the system calls the contract library makes directly.
+   // A wasm instance runs one invocation, so there it is the SDK's buffer.
+   std::array< uint8_t, syscall_buffer_size >& syscall_buffer()
+   {
+#if defined( __wasm__ )
+      return system::detail::syscall_buffer;
+#else
+      return _syscall_buffer;
+#endif
+   }
+
+   // The contract's system object space with the given id, built on first use
+   const system::object_space& space( uint32_t id )
+   {
+      if ( id >= max_cached_spaces )
+         system::fail( "object space id is too large to cache" );
+
+      if ( !( _spaces_built & ( uint32_t( 1 ) << id ) ) )
+      {
+         const auto& zone = contract_id();
+         auto& space = _spaces[ id ];
+         space.mutable_zone().set( reinterpret_cast< const uint8_t* >( zone.data() ), zone.size() );
+         space.set_id( id );
+         space.set_system( true );
+         _spaces_built |= uint32_t( 1 ) << id;
+      }
+      return _spaces[ id ];
+   }
+
+private:
+   std::string                                           _contract_id;
+   bool                                                  _contract_id_fetched = false;
+   std::array< system::object_space, max_cached_spaces > _spaces;
+   uint32_t                                              _spaces_built        = 0;
+#if !defined( __wasm__ )
+   std::array< uint8_t, syscall_buffer_size >            _syscall_buffer;
+#endif
+};
+
+namespace detail {
+
+inline KOINOS_INVOCATION_LOCAL invocation_context* current_context = nullptr;
+
+} // detail
+
+// Makes a context current on this thread for its lifetime
+class invocation_scope
+{
+public:
+   explicit invocation_scope( invocation_context& ctx ) : _previous( detail::current_context )
+   {
+      detail::current_context = &ctx;
+   }
+
+   ~invocation_scope()
+   {
+      detail::current_context = _previous;
+   }
+
+   invocation_scope( const invocation_scope& ) = delete;
+   invocation_scope& operator =( const invocation_scope& ) = delete;
+
+private:
+   invocation_context* _previous;
+};
+
+inline invocation_context& current_invocation()
+{
+   if ( !detail::current_context )
+      system::fail( "no invocation in progress" );
+
+   return *detail::current_context;
+}
+
+} // koinos::system_contracts
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <koinos/system_contracts/fixed_layout.hpp>
+#include <koinos/system_contracts/schema.hpp>
+#include <koinos/system_contracts/uint.hpp>
+#include <koinos/system_contracts/wire.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// Mana regeneration as computed by the koin contract. It depends only on the
+// standard library so node code can compute an account's current mana from a
+// raw mana_balance_object read instead of invoking get_account_rc.
+namespace koinos::system_contracts::mana {
+
+constexpr uint64_t mana_regen_time_ms = 432'000'000; // 5 days
+
+struct balance_state
+{
+   uint64_t balance          = 0;
+   uint64_t mana             = 0;
+   uint64_t last_mana_update = 0;
+};
+
+// Mana regenerates linearly from zero to the full balance over regen_time_ms.
+constexpr balance_state regenerate( balance_state bal, uint64_t head_block_time, uint64_t regen_time_ms = mana_regen_time_ms )
+{
+   auto delta = std::min( head_block_time - bal.last_mana_update, regen_time_ms );
+   if ( delta )
+   {
+      auto new_mana = bal.mana + ( ( uint128( delta ) * bal.balance ) / regen_time_ms ).convert_to< uint64_t >();
+      bal.mana = std::min( new_mana, bal.balance );
+      bal.last_mana_update = head_block_time;
+   }
+
+   return bal;
+}
+
+constexpr uint64_t available_mana( const balance_state& bal, uint64_t head_block_time, uint64_t regen_time_ms = mana_regen_time_ms )
+{
+   return regenerate( bal, head_block_time, regen_time_ms ).mana;
+}
+
+namespace detail {
+
+constexpr std::size_t fixed_size = 3 * 8;
+
+} // detail
+
+// Decodes a stored koin::mana_balance_object, either bare protobuf
+// { uint64 balance = 1; uint64 mana = 2; uint64 last_mana_update = 3; } or
+// the version 1 fixed layout. An empty value is a zero balance.
+inline bool decode( const uint8_t* data, std::size_t len, balance_state& bal )
+{
+   bal = balance_state();
+
+   if ( len >= 2 && data[0] == envelope_tag )
+   {
+      if ( data[1] != fixed_layout_version || len != 2 + detail::fixed_size )
+         return false;
+
+      bal.balance          = fixed_layout::get_u64( data + 2 );
+      bal.mana             = fixed_layout::get_u64( data + 10 );
+      bal.last_mana_update = fixed_layout::get_u64( data + 18 );
+      return true;
+   }
+
+   wire::reader rdr( data, len );
+   while ( !rdr.eof() )
+   {
+      uint32_t field;
+      wire::wire_type type;
+      if ( !rdr.read_tag( field, type ) )
+         return false;
+
+      if ( type == wire::wire_type::varint && field >= 1 && field <= 3 )
+      {
+         uint64_t v;
+         if ( !rdr.read_varint( v ) )
+            return false;
+
+         if ( field == 1 )
+            bal.balance = v;
+         else if ( field == 2 )
+            bal.mana = v;
+         else
+            bal.last_mana_update = v;
+      }
+      else if ( !rdr.skip( type ) )
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+static_assert( available_mana( { 1000, 0, 0 }, mana_regen_time_ms / 2 ) == 500 );
+static_assert( available_mana( { 1000, 900, 0 }, mana_regen_time_ms / 2 ) == 1000 );
+static_assert( available_mana( { 1000, 0, 0 }, 10 * mana_regen_time_ms ) == 1000 );
+static_assert( available_mana( { 3, 0, 0 }, mana_regen_time_ms - 1 ) == 2 );
+static_assert( available_mana( { 1000, 10, 5 }, 5 ) == 10 );
+
+} // koinos::system_contracts::mana
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <koinos/system_contracts/fixed_layout.hpp>
+#include <koinos/system_contracts/schema.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Merkle airdrops.
+//
+// An issuer commits to a list of (address, amount) allocations with the root
+// of a binary sha256 tree over them, and each recipient later claims its
+// allocation with an inclusion proof. Leaf i of a tree of n leaves is
+//
+//    sha256( 0x00 index(8) size(1) address(size) amount(8) )
+//
+// and an inner node is sha256( 0x01 left right ). The tree is padded to a
+// power of two with 32 zero bytes, so a proof is exactly depth( n ) sibling
+// hashes, leaf level first, and bit k of the index says whether the node is
+// the right child at level k. The prefixes keep a leaf from ever verifying as
+// an inner node.
+//
+// Claimed leaves are recorded in a bitmap of claim_word_bits per object.
+//
+// Hashing is left to the caller, so that native code can build trees and
+// proofs with the same functions the contract verifies them with.
+namespace koinos::system_contracts::merkle {
+
+constexpr std::size_t digest_size     = 32;
+constexpr std::size_t max_depth       = 32;
+constexpr std::size_t claim_word_bits = 256;
+constexpr std::size_t claim_word_size = claim_word_bits / 8;
+
+using digest = std::array< uint8_t, digest_size >;
+
+constexpr uint8_t leaf_prefix = 0x00;
+constexpr uint8_t node_prefix = 0x01;
+
+// Levels above the leaves in a tree of `leaves` leaves
+constexpr std::size_t depth( uint64_t leaves )
+{
+   std::size_t d = 0;
+   while ( ( uint64_t( 1 ) << d ) < leaves )
+      d++;
+   return d;
+}
+
+inline std::string leaf_message( uint64_t index, const std::string& address, uint64_t amount )
+{
+   std::string msg( 1 + 8 + 1 + address.size() + 8, '\0' );
+   auto* p = reinterpret_cast< uint8_t* >( msg.data() );
+   p[0] = leaf_prefix;
+   fixed_layout::put_u64( p + 1, index );
+   p[9] = uint8_t( address.size() );
+   for ( std::size_t i = 0; i < address.size(); i++ )
+      p[10 + i] = uint8_t( address[i] );
+   fixed_layout::put_u64( p + 10 + address.size(), amount );
+   return msg;
+}
+
+inline std::string node_message( const digest& left, const digest& right )
+{
+   std::string msg( 1 + 2 * digest_size, '\0' );
+   msg[0] = char( node_prefix );
+   for ( std::size_t i = 0; i < digest_size; i++ )
+   {
+      msg[1 + i]               = char( left[i] );
+      msg[1 + digest_size + i] = char( right[i] );
+   }
+   return msg;
+}
+
+// The root that a leaf and its proof hash up to. Hash is called as
+// digest hash( const std::string& message ).
+template< typename Hash, typename Proof >
+digest compute_root( Hash&& hash, digest node, uint64_t index, const Proof& proof )
+{
+   for ( const auto& sibling : proof )
+   {
+      node = index & 1 ? hash( node_message( sibling, node ) ) : hash( node_message( node, sibling ) );
+      index >>= 1;
+   }
+   return node;
+}
+
+// Stored objects:
+//
+//    airdrop      0x00 0x01 leaves(8) remaining(8) expiry(8) size(1) creator(size)
+//    claim word   0x00 0x01 bits(32), bit i = index % 256 is bit i % 8 of byte i / 8
+//
+// A missing claim word has no leaves claimed.
+struct airdrop
+{
+   uint64_t    leaves    = 0;
+   uint64_t    remaining = 0;   // Allocated but not yet claimed or reclaimed
+   uint64_t    expiry    = 0;   // Head block time from which it can be reclaimed, 0 for never
+   std::string creator;         // Account the remainder is reclaimed to
+};
+
+constexpr std::size_t airdrop_size           = 2 + 8 + 8 + 8 + 1;   // Without the creator
+constexpr std::size_t claim_word_object_size = 2 + claim_word_size;
+
+inline std::string encode( const airdrop& a )
+{
+   std::string bytes( airdrop_size + a.creator.size(), '\0' );
+   auto* p = reinterpret_cast< uint8_t* >( bytes.data() );
+   p[0] = envelope_tag;
+   p[1] = fixed_layout_version;
+   fixed_layout::put_u64( p + 2, a.leaves );
+   fixed_layout::put_u64( p + 10, a.remaining );
+   fixed_layout::put_u64( p + 18, a.expiry );
+   p[26] = uint8_t( a.creator.size() );
+   for ( std::size_t i = 0; i < a.creator.size(); i++ )
+      p[27 + i] = uint8_t( a.creator[i] );
+   return bytes;
+}
+
+inline bool decode( const std::string& bytes, airdrop& a )
+{
+   const auto* p = reinterpret_cast< const uint8_t* >( bytes.data() );
+   if ( bytes.size() < airdrop_size || p[0] != envelope_tag || p[1] != fixed_layout_version
+      || bytes.size() != airdrop_size + p[26] )
+      return false;
+
+   a.leaves    = fixed_layout::get_u64( p + 2 );
+   a.remaining = fixed_layout::get_u64( p + 10 );
+   a.expiry    = fixed_layout::get_u64( p + 18 );
+   a.creator.assign( bytes, airdrop_size, p[26] );
+   return true;
+}
+
+// Key of the claim word holding leaf index, under the airdrop's root
+inline std::string claim_word_key( const std::string& root, uint64_t index )
+{
+   auto word = uint32_t( index / claim_word_bits );
+   std::string key( root );
+   for ( int shift = 24; shift >= 0; shift -= 8 )
+      key.push_back( char( word >> shift ) );
+   return key;
+}
+
+inline bool is_claimed( const std::string& word, uint64_t index )
+{
+   if ( word.empty() )
+      return false;
+
+   auto bit = index % claim_word_bits;
+   return uint8_t( word[2 + bit / 8] ) & ( 1 << ( bit % 8 ) );
+}
+
+// Sets a leaf's bit in its claim word, creating the word if it is missing
+inline void set_claimed( std::string& word, uint64_t index )
+{
+   if ( word.empty() )
+   {
+      word.assign( claim_word_object_size, '\0' );
+      word[0] = char( envelope_tag );
+      word[1] = char( fixed_layout_version );
+   }
+
+   auto bit = index % claim_word_bits;
+   word[2 + bit / 8] = char( uint8_t( word[2 + bit / 8] ) | ( 1 << ( bit % 8 ) ) );
+}
+
+inline bool valid_claim_word( const std::string& word )
+{
+   return word.empty() || ( word.size() == claim_word_object_size
+      && uint8_t( word[0] ) == envelope_tag && uint8_t( word[1] ) == fixed_layout_version );
+}
+
+static_assert( depth( 0 ) == 0 && depth( 1 ) == 0 && depth( 2 ) == 1 && depth( 3 ) == 2 && depth( 1ull << 32 ) == max_depth );
+
+} // koinos::system_contracts::merkle
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <koinos/system_contracts/schema.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Multisig records.
+//
+// An account can register a threshold and a set of signer addresses, and a
+// transaction signed by at least threshold of them counts as the account's
+// authorization. The token checks the record against the transaction's
+// signatures itself, instead of calling the account's authority contract,
+// which would parse the call's arguments again in a nested call.
+//
+// A record only adds a way for the account to authorize. When it is not met
+// the token still asks the account's authority.
+//
+// Recovering signer addresses from signatures is left to the caller.
+namespace koinos::system_contracts::multisig {
+
+constexpr std::size_t max_address_size = 25;
+
+struct record
+{
+   uint32_t                   threshold = 0;
+   std::vector< std::string > signers;
+};
+
+// At least one signer is required, no more than max_signers, each a distinct
+// address
+inline bool valid( const record& r, std::size_t max_signers )
+{
+   if ( !r.threshold || r.threshold > r.signers.size() || r.signers.size() > max_signers )
+      return false;
+
+   for ( std::size_t i = 0; i < r.signers.size(); i++ )
+   {
+      if ( r.signers[i].empty() || r.signers[i].size() > max_address_size )
+         return false;
+
+      for ( std::size_t j = 0; j < i; j++ )
+         if ( r.signers[i] == r.signers[j] )
+            return false;
+   }
+
+   return true;
+}
+
+// Whether address is one of the record's signers. Returns its index in
+// `index`.
+inline bool find_signer( const record& r, const std::string& address, std::size_t& index )
+{
+   for ( index = 0; index < r.signers.size(); index++ )
+      if ( r.signers[index] == address )
+         return true;
+   return false;
+}
+
+// A stored record, one size-prefixed address per signer:
+//
+//    0x00 0x01 threshold(1) count(1) { size(1) address(size) } * count
+inline std::string encode( const record& r )
+{
+   std::string bytes;
+   bytes.push_back( char( envelope_tag ) );
+   bytes.push_back( char( fixed_layout_version ) );
+   bytes.push_back( char( r.threshold ) );
+   bytes.push_back( char( r.signers.size() ) );
+   for ( const auto& signer : r.signers )
+   {
+      bytes.push_back( char( signer.size() ) );
+      bytes.append( signer );
+   }
+   return bytes;
+}
+
+inline bool decode( const std::string& bytes, record& r )
+{
+   r = record();
+
+   const auto* p = reinterpret_cast< const uint8_t* >( bytes.data() );
+   if ( bytes.size() < 4 || p[0] != envelope_tag || p[1] != fixed_layout_version )
+      return false;
+
+   r.threshold = p[2];
+
+   std::size_t pos = 4;
+   for ( std::size_t i = 0; i < p[3]; i++ )
+   {
+      if ( pos >= bytes.size() || p[pos] > max_address_size || bytes.size() - pos - 1 < p[pos] )
+         return false;
+
+      r.signers.emplace_back( bytes, pos + 1, p[pos] );
+      pos += 1 + p[pos];
+   }
+
+   return pos == bytes.size();
+}
+
+} // koinos::system_contracts::multisig
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <koinos/system/system_calls.hpp>
+#include <koinos/system_contracts/invocation.hpp>
+#include <koinos/system_contracts/versioned_object.hpp>
+#include <koinos/system_contracts/wire.hpp>
+
+#include <koinos/buffer.hpp>
+
+#include <array>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace koinos::system_contracts {
+
+// Gathers object reads and writes. Builds with BATCHED_OBJECT_CALLS issue
+// each set as a single get_objects/put_objects system call, other builds make
+// one get_object/put_object call per key.
+//
+// The batch calls are not part of the Koinos system call set. A host that
+// does not implement them aborts the transaction on the first batch, so
+// BATCHED_OBJECT_CALLS builds run only on hosts that do, with the ids given
+// at configure time. The native host and wasm_meter -b serve the default ids.
+//
+// The batch calls take and return protobuf messages:
+//
+//    message get_objects_arguments { repeated get_object_arguments objects = 1; }
+//    message get_objects_result    { repeated database_object values = 1; }
+//    message put_objects_arguments { repeated put_object_arguments objects = 1; }
+#ifdef GET_OBJECTS_CALL_ID
+constexpr uint32_t get_objects_call_id   = GET_OBJECTS_CALL_ID;
+#else
+constexpr uint32_t get_objects_call_id   = 0x1000'0001;
+#endif
+#ifdef PUT_OBJECTS_CALL_ID
+constexpr uint32_t put_objects_call_id   = PUT_OBJECTS_CALL_ID;
+#else
+constexpr uint32_t put_objects_call_id   = 0x1000'0002;
+#endif
+constexpr std::size_t max_object_size    = 1024;
+
+namespace detail {
+
+inline std::string encode_object_space( const system::object_space& space )
+{
+   std::string bytes;
+   if ( space.system() )
+      wire::append_bool( bytes, 1, true );
+   wire::append_bytes( bytes, 2, space.zone().get_const(), space.zone().get_length() );
+   if ( space.id() )
+      wire::append_uint64( bytes, 3, space.id() );
+   return bytes;
+}
+
+template< typename T >
+std::string encode_object( const T& obj )
+{
+   if constexpr ( schema< T >::write_version == protobuf_version )
+   {
+      std::array< uint8_t, max_object_size > buf;
+      koinos::write_buffer wbuf( buf.data(), buf.size() );
+      obj.serialize( wbuf );
+      return std::string( reinterpret_cast< const char* >( buf.data() ), wbuf.get_size() );
+   }
+   else
+   {
+      return encode_versioned( obj );
+   }
+}
+
+// Makes a batch call into the invocation's system call buffer
+inline uint32_t invoke_batch( uint32_t call_id, std::string& args, const char* message )
+{
+   auto& buffer = current_invocation().syscall_buffer();
+   uint32_t bytes_written = 0;
+   auto code = invoke_system_call(
+      call_id,
+      reinterpret_cast< char* >( buffer.data() ),
+      std::size( buffer ),
+      args.data(),
+      args.size(),
+      &bytes_written
+   );
+
+   if ( code )
+      system::fail( message );
+
+   return bytes_written;
+}
+
+} // detail
+
+class object_batch
+{
+public:
+   // Queues a read and returns its index for get_value and get_object
+   std::size_t get( const system::object_space& space, const std::string& key )
+   {
+      _reads.push_back( { space, key } );
+      return _reads.size() - 1;
+   }
+
+   // Reads every queued key
+   void load()
+   {
+      _values.assign( _reads.size(), std::string() );
+
+      if ( _reads.empty() )
+         return;
+
+#ifdef BATCHED_OBJECT_CALLS
+      load_batched();
+#else
+      for ( std::size_t i = 0; i < _reads.size(); i++ )
+         _values[i] = system::detail::get_object( _reads[i].space, _reads[i].key );
+#endif
+   }
+
+   // The raw bytes read for a key, empty if the object does not exist
+   const std::string& get_value( std::size_t i ) const
+   {
+      return _values.at( i );
+   }
+
+   // Decodes the object read for a key. Returns false if it does not exist.
+   template< typename T >
+   bool get_object( std::size_t i, T& obj ) const
+   {
+      const auto& bytes = get_value( i );
+      if ( !bytes.size() )
+         return false;
+
+      if ( !decode_versioned( reinterpret_cast< const uint8_t* >( bytes.data() ), bytes.size(), obj ) )
+         system::fail( "unrecognized object schema version" );
+
+      return true;
+   }
+
+   // Queues a write of an object in its schema's write version
+   template< typename T >
+   void put_object( const system::object_space& space, const std::string& key, const T& obj )
+   {
+      _writes.push_back( { space, key, detail::encode_object( obj ) } );
+   }
+
+   // Queues a write of an object that is already encoded
+   void put_value( const system::object_space& space, const std::string& key, std::string value )
+   {
+      _writes.push_back( { space, key, std::move( value ) } );
+   }
+
+   // Writes every queued object, in the order they were queued
+   void store()
+   {
+      if ( _writes.empty() )
+         return;
+
+#ifdef BATCHED_OBJECT_CALLS
+      store_batched();
+#else
+      for ( const auto& w : _writes )
+         system::detail::put_object( w.space, w.key, w.value );
+#endif
+
+      _writes.clear();
+   }
+
+private:
+   struct read_request
+   {
+      system::object_space space;
+      std::string          key;
+   };
+
+   struct write_request
+   {
+      system::object_space space;
+      std::string          key;
+      std::string          value;
+   };
+
+   void load_batched()
+   {
+      std::string args;
+      for ( const auto& r : _reads )
+      {
+         std::string request;
+         wire::append_bytes( request, 1, detail::encode_object_space( r.space ) );
+         wire::append_bytes( request, 2, r.key );
+         wire::append_bytes( args, 1, request );
+      }
+
+      auto bytes_written = detail::invoke_batch( get_objects_call_id, args, "get_objects failed" );
+      wire::reader rdr( current_invocation().syscall_buffer().data(), bytes_written );
+      std::size_t i = 0;
+
+      while ( !rdr.eof() )
+      {
+         uint32_t field;
+         wire::wire_type type;
+         const uint8_t* data;
+         std::size_t len;
+
+         if ( !rdr.read_tag( field, type ) || field != 1 || type != wire::wire_type::length_delimited
+            || !rdr.read_bytes( data, len ) || i >= _values.size() )
+            system::fail( "malformed get_objects result" );
+
+         wire::reader obj_rdr( data, len );
+         while ( !obj_rdr.eof() )
+         {
+            if ( !obj_rdr.read_tag( field, type ) )
+               system::fail( "malformed get_objects result" );
+
+            if ( field == 2 && type == wire::wire_type::length_delimited )
+            {
+               if ( !obj_rdr.read_bytes( _values[i] ) )
+                  system::fail( "malformed get_objects result" );
+            }
+            else if ( !obj_rdr.skip( type ) )
+            {
+               system::fail( "malformed get_objects result" );
+            }
+         }
+
+         i++;
+      }
+
+      if ( i != _values.size() )
+         system::fail( "get_objects returned the wrong number of objects" );
+   }
+
+   void store_batched()
+   {
+      std::string args;
+      for ( const auto& w : _writes )
+      {
+         std::string request;
+         wire::append_bytes( request, 1, detail::encode_object_space( w.space ) );
+         wire::append_bytes( request, 2, w.key );
+         wire::append_bytes( request, 3, w.value );
+         wire::append_bytes( args, 1, request );
+      }
+
+      detail::invoke_batch( put_objects_call_id, args, "put_objects failed" );
+   }
+
+   std::vector< read_request >  _reads;
+   std::vector< std::string >   _values;
+   std::vector< write_request > _writes;
+};
+
+} // koinos::system_contracts
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <koinos/system_contracts/fixed_layout.hpp>
+#include <koinos/system_contracts/wire.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Packed transfer arguments. The record is the canonical protobuf encoding of
+//
+//    message transfer_packed_arguments {
+//       bytes from = 1;
+//       bytes to = 2;
+//       fixed64 value = 3;
+//    }
+//
+// with every field present and in order:
+//
+//    0x0a len from[len] 0x12 len to[len] 0x19 value (8 bytes, little endian)
+//
+// Addresses are at most max_address_size bytes, so each length is a single
+// byte and the decoder only compares tags and copies pointers. Any protobuf
+// library produces this encoding for a non-empty from and to and a non-zero
+// value. The header has no dependencies so native callers can share it.
+namespace koinos::system_contracts::packed {
+
+constexpr std::size_t max_address_size = 25;
+
+constexpr uint8_t from_tag  = uint8_t( wire::make_tag( 1, wire::wire_type::length_delimited ) );
+constexpr uint8_t to_tag    = uint8_t( wire::make_tag( 2, wire::wire_type::length_delimited ) );
+constexpr uint8_t value_tag = uint8_t( wire::make_tag( 3, wire::wire_type::fixed64 ) );
+
+constexpr std::size_t max_transfer_size = 2 + max_address_size + 2 + max_address_size + 1 + sizeof( uint64_t );
+
+static_assert( from_tag == 0x0a && to_tag == 0x12 && value_tag == 0x19 );
+static_assert( max_address_size < 0x80 );
+
+struct transfer_record
+{
+   const uint8_t* from      = nullptr;
+   std::size_t    from_size = 0;
+   const uint8_t* to        = nullptr;
+   std::size_t    to_size   = 0;
+   uint64_t       value     = 0;
+};
+
+inline bool decode_transfer( const uint8_t* data, std::size_t len, transfer_record& rec )
+{
+   std::size_t pos = 0;
+
+   if ( len < 2 || data[pos++] != from_tag )
+      return false;
+
+   rec.from_size = data[pos++];
+   if ( rec.from_size == 0 || rec.from_size > max_address_size || len < pos + rec.from_size + 2 )
+      return false;
+
+   rec.from = data + pos;
+   pos += rec.from_size;
+
+   if ( data[pos++] != to_tag )
+      return false;
+
+   rec.to_size = data[pos++];
+   if ( rec.to_size == 0 || rec.to_size > max_address_size || len != pos + rec.to_size + 1 + sizeof( uint64_t ) )
+      return false;
+
+   rec.to = data + pos;
+   pos += rec.to_size;
+
+   if ( data[pos++] != value_tag )
+      return false;
+
+   rec.value = fixed_layout::get_u64( data + pos );
+   return true;
+}
+
+inline void encode_transfer( std::string& out, const std::string& from, const std::string& to, uint64_t value )
+{
+   wire::append_bytes( out, 1, from.data(), from.size() );
+   wire::append_bytes( out, 2, to.data(), to.size() );
+   wire::append_fixed64( out, 3, value );
+}
+
+} // koinos::system_contracts::packed
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <koinos/system/system_calls.hpp>
+#include <koinos/system_contracts/invocation.hpp>
+#include <koinos/system_contracts/wire.hpp>
+
+#include <koinos/buffer.hpp>
+
+#include <cstring>
+#include <vector>
+
+namespace koinos::system_contracts {
+
+// Upper bound on a serialized result. Raise it together with the host's limit.
+constexpr std::size_t max_result_size     = 0x10000;
+constexpr std::size_t initial_result_size = 256;
+
+// Write buffer that results are serialized into directly, replacing a fixed
+// size return buffer. It grows as needed up to max_result_size.
+//
+// The buffer also serves as the argument of the exit system call. Room is
+// reserved in front of the result for the exit_arguments framing, which
+// exit() fills in once the result size is known, so the result is never
+// copied:
+//
+//    exit_arguments { int32 code = 1; result res = 2; }
+//    result         { bytes object = 1; ... }
+class result_writer : public ::EmbeddedProto::WriteBufferInterface
+{
+public:
+   // Code field (1 + 10), res field (1 + 5) and object field (1 + 5)
+   static constexpr std::size_t header_reserve = 23;
+
+   result_writer()
+   {
+      _buffer.reserve( header_reserve + initial_result_size );
+      _buffer.resize( header_reserve );
+   }
+
+   void clear() override
+   {
+      _buffer.resize( header_reserve );
+      _overflow = false;
+   }
+
+   uint32_t get_size() const override
+   {
+      return uint32_t( _buffer.size() - header_reserve );
+   }
+
+   uint32_t get_max_size() const override
+   {
+      return uint32_t( max_result_size );
+   }
+
+   uint32_t get_available_size() const override
+   {
+      return get_max_size() - get_size();
+   }
+
+   bool push( const uint8_t byte ) override
+   {
+      if ( !get_available_size() )
+      {
+         _overflow = true;
+         return false;
+      }
+
+      _buffer.push_back( byte );
+      return true;
+   }
+
+   bool push( const uint8_t* bytes, const uint32_t length ) override
+   {
+      if ( length > get_available_size() )
+      {
+         _overflow = true;
+         return false;
+      }
+
+      _buffer.insert( _buffer.end(), bytes, bytes + length );
+      return true;
+   }
+
+   const uint8_t* data() const
+   {
+      return _buffer.data() + header_reserve;
+   }
+
+   // Exits the contract with the serialized result
+   void exit( int32_t code = 0 )
+   {
+      if ( _overflow )
+         system::fail( "result exceeds maximum size" );
+
+      uint64_t object_size = get_size();
+      uint64_t result_size = 1 + wire::varint_size( object_size ) + object_size;
+
+      // Sign extended, as protobuf encodes negative int32 values
+      uint64_t code_value = uint64_t( int64_t( code ) );
+
+      std::size_t prefix_size = 1 + wire::varint_size( result_size ) + 1 + wire::varint_size( object_size );
+      if ( code )
+         prefix_size += 1 + wire::varint_size( code_value );
+
+      auto start = _buffer.data() + header_reserve - prefix_size;
+      auto p = start;
+
+      if ( code )
+      {
+         *p++ = uint8_t( wire::make_tag( 1, wire::wire_type::varint ) );
+         p = wire::write_varint( p, code_value );
+      }
+
+      *p++ = uint8_t( wire::make_tag( 2, wire::wire_type::length_delimited ) );
+      p = wire::write_varint( p, result_size );
+      *p++ = uint8_t( wire::make_tag( 1, wire::wire_type::length_delimited ) );
+      wire::write_varint( p, object_size );
+
+      auto& output = current_invocation().syscall_buffer();
+      uint32_t bytes_written = 0;
+      invoke_system_call(
+         std::underlying_type_t< chain::system_call_id >( chain::system_call_id::exit ),
+         reinterpret_cast< char* >( output.data() ),
+         std::size( output ),
+         reinterpret_cast< char* >( start ),
+         uint32_t( _buffer.size() - ( start - _buffer.data() ) ),
+         &bytes_written
+      );
+   }
+
+private:
+   std::vector< uint8_t > _buffer;
+   bool                   _overflow = false;
+};
+
+} // koinos::system_contracts
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <koinos/system_contracts/fixed_layout.hpp>
+#include <koinos/system_contracts/schema.hpp>
+#include <koinos/system_contracts/uint.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+// Pro-rata reward distribution by a reward-per-token accumulator.
+//
+// A distribution of `value` to holders of `eligible` tokens adds
+// value / eligible to a global accumulator instead of crediting every
+// holder. Each account keeps a checkpoint of the accumulator it was last
+// settled at; its share since then is balance * ( accumulator - checkpoint ).
+// Settling before every change to the balance keeps that product exact, so
+// a distribution costs the same for any number of holders.
+//
+// The accumulator is fixed point with 64 fractional bits. Nothing is lost to
+// rounding: the part of a distribution below the accumulator's precision is
+// carried into the next one, and the fraction of a token an account's share
+// rounds down by is carried in its checkpoint until it adds up to a whole
+// token. The sum paid out never exceeds what was distributed.
+namespace koinos::system_contracts::rewards {
+
+constexpr std::size_t fraction_bits = 64;
+
+struct pool_state
+{
+   uint128  reward_per_token;     // Accumulated reward per token, 64.64 fixed point
+   uint64_t distributed = 0;      // Total ever distributed
+   uint64_t carry       = 0;      // Undistributed remainder, in 2^-64 tokens
+};
+
+struct checkpoint
+{
+   uint128  reward_per_token_paid;   // Accumulator value the account was last settled at
+   uint64_t pending  = 0;            // Settled but unclaimed
+   uint64_t fraction = 0;            // Settled below a whole token, in 2^-64 tokens
+};
+
+// Reward per token for distributing value over eligible tokens. Returns false
+// if eligible is zero or the accumulator would overflow.
+constexpr bool add_distribution( pool_state& pool, uint64_t value, uint64_t eligible )
+{
+   if ( !eligible )
+      return false;
+
+   auto amount    = ( uint128( value ) << fraction_bits ) + pool.carry;
+   auto increment = amount / eligible;
+   if ( uint128::max() - pool.reward_per_token < increment )
+      return false;
+
+   pool.reward_per_token += increment;
+   pool.distributed      += value;
+   pool.carry             = ( amount % eligible ).convert_to< uint64_t >();
+   return true;
+}
+
+// Moves the account's share since its checkpoint into pending. Call with the
+// balance it held before any change.
+constexpr checkpoint settle( checkpoint cp, uint64_t balance, const pool_state& pool )
+{
+   auto delta = uint256( pool.reward_per_token - cp.reward_per_token_paid );
+   auto share = delta * balance + cp.fraction;
+
+   // Shares are bounded by the distributed total, which is a token amount
+   auto total = ( share >> fraction_bits ) + cp.pending;
+   cp.pending               = total > uint256( ~uint64_t( 0 ) ) ? ~uint64_t( 0 ) : total.convert_to< uint64_t >();
+   cp.fraction              = share.convert_to< uint64_t >();
+   cp.reward_per_token_paid = pool.reward_per_token;
+   return cp;
+}
+
+// The account's claimable rewards, had it held balance since its checkpoint
+constexpr uint64_t claimable( const checkpoint& cp, uint64_t balance, const pool_state& pool )
+{
+   return settle( cp, balance, pool ).pending;
+}
+
+// Adds a checkpoint settled at the same accumulator value into another, as
+// when a balance shard slot is folded into its account
+constexpr checkpoint merge( checkpoint into, const checkpoint& from )
+{
+   auto fraction = into.fraction + from.fraction;
+   auto pending  = uint128( into.pending ) + from.pending + ( fraction < into.fraction ? 1 : 0 );
+
+   into.pending  = pending > uint128( ~uint64_t( 0 ) ) ? ~uint64_t( 0 ) : pending.convert_to< uint64_t >();
+   into.fraction = fraction;
+   return into;
+}
+
+// Stored little endian, the accumulator low limb first:
+//
+//    pool_state    0x00 0x01 reward_per_token(16) distributed(8) carry(8)
+//    checkpoint    0x00 0x01 reward_per_token_paid(16) pending(8) fraction(8)
+//
+// A missing object decodes as zero.
+constexpr std::size_t encoded_size = 2 + 16 + 8 + 8;
+
+constexpr void encode( const uint128& acc, uint64_t amount, uint64_t remainder, uint8_t* out )
+{
+   out[0] = envelope_tag;
+   out[1] = fixed_layout_version;
+   fixed_layout::put_u64( out + 2, acc.limb( 0 ) );
+   fixed_layout::put_u64( out + 10, acc.limb( 1 ) );
+   fixed_layout::put_u64( out + 18, amount );
+   fixed_layout::put_u64( out + 26, remainder );
+}
+
+constexpr bool decode( const uint8_t* data, std::size_t len, uint128& acc, uint64_t& amount, uint64_t& remainder )
+{
+   acc       = 0;
+   amount    = 0;
+   remainder = 0;
+
+   if ( !len )
+      return true;
+
+   if ( len != encoded_size || data[0] != envelope_tag || data[1] != fixed_layout_version )
+      return false;
+
+   acc       = ( uint128( fixed_layout::get_u64( data + 10 ) ) << 64 ) | fixed_layout::get_u64( data + 2 );
+   amount    = fixed_layout::get_u64( data + 18 );
+   remainder = fixed_layout::get_u64( data + 26 );
+   return true;
+}
+
+inline void encode( const pool_state& pool, uint8_t* out )   { encode( pool.reward_per_token, pool.distributed, pool.carry, out ); }
+inline void encode( const checkpoint& cp, uint8_t* out )     { encode( cp.reward_per_token_paid, cp.pending, cp.fraction, out ); }
+
+inline bool decode( const uint8_t* data, std::size_t len, pool_state& pool )
+{
+   return decode( data, len, pool.reward_per_token, pool.distributed, pool.carry );
+}
+
+inline bool decode( const uint8_t* data, std::size_t len, checkpoint& cp )
+{
+   return decode( data, len, cp.reward_per_token_paid, cp.pending, cp.fraction );
+}
+
+namespace detail {
+
+constexpr uint64_t example_claim()
+{
+   // 300 to 1000 eligible tokens, then 100 more to 400: a holder of 250
+   // since the start is owed 75 + 62.5, rounded down
+   pool_state pool;
+   add_distribution( pool, 300, 1000 );
+   add_distribution( pool, 100, 400 );
+   return claimable( checkpoint(), 250, pool );
+}
+
+constexpr uint64_t example_settled()
+{
+   // Settling at 250 then holding 500 for a later distribution of 100 over
+   // 1000. The first settlement is a hair under 75, and the fraction it
+   // carries makes up the second: 75 + 50.
+   pool_state pool;
+   add_distribution( pool, 300, 1000 );
+   auto cp = settle( checkpoint(), 250, pool );
+   add_distribution( pool, 100, 1000 );
+   return claimable( cp, 500, pool );
+}
+
+constexpr uint64_t example_carried()
+{
+   // 1 over 3 eligible, three times, settling a holder of 1 after each.
+   // Each distribution and settlement alone rounds down to nothing.
+   pool_state pool;
+   checkpoint cp;
+   for ( int i = 0; i < 3; i++ )
+   {
+      add_distribution( pool, 1, 3 );
+      cp = settle( cp, 1, pool );
+   }
+   return cp.pending;
+}
+
+constexpr uint64_t example_merged()
+{
+   // A balance and a shard slot of 1 each, settled separately and merged,
+   // earn what one balance of 2 would: 2 of 3 over 3
+   pool_state pool;
+   add_distribution( pool, 2, 3 );
+   auto balance = settle( checkpoint(), 1, pool );
+   auto slot    = settle( checkpoint(), 1, pool );
+   add_distribution( pool, 1, 3 );
+   return claimable( merge( balance, slot ), 2, pool );
+}
+
+} // detail
+
+static_assert( detail::example_claim() == 137 );
+static_assert( detail::example_settled() == 75 + 50 );
+static_assert( detail::example_carried() == 1 );
+static_assert( detail::example_merged() == 2 );
+
+} // koinos::system_contracts::rewards
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <koinos/system_contracts/fixed_layout.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+namespace koinos::system_contracts {
+
+// Every stored object carries a schema version. A bare protobuf encoding is
+// version 0, which is how all objects were written before versioning. Any
+// other version is stored in an envelope: a zero byte, the version, and then
+// that version's encoding. A protobuf encoding can never start with a zero
+// byte because field number 0 is reserved, so the two cannot be confused.
+//
+// Old versions stay decodable for as long as their codec is listed in the
+// object's schema. An object is upgraded when it is next written, because
+// writes always use the schema's write version. No migration pass over the
+// existing state is needed.
+//
+// Fixed layouts are version 1. The stand-alone headers for node code, such
+// as mana.hpp and rewards.hpp, encode their objects with these constants
+// directly, so this header depends only on the standard library.
+constexpr uint8_t envelope_tag               = 0x00;
+constexpr std::size_t envelope_header_size   = 2;
+constexpr uint8_t protobuf_version           = 0;
+constexpr uint8_t fixed_layout_version       = 1;
+
+// A codec decodes one schema version into the current in-memory type. Codecs
+// for retired layouts decode into the current type directly, converting
+// fields as needed, so callers only ever see the current type.
+//
+//    static constexpr uint8_t version;
+//    static bool decode( const uint8_t* data, std::size_t len, T& obj );
+//    static constexpr std::size_t size;                 // Envelope codecs only
+//    static void encode( const T& obj, uint8_t* out );  // Envelope codecs only
+//
+// protobuf_codec decodes the bare protobuf encoding. It is defined in
+// state_schemas.hpp, next to the SDK's read buffer.
+template< typename T >
+struct protobuf_codec;
+
+template< typename T, uint8_t VERSION >
+struct fixed_layout_codec
+{
+   static_assert( VERSION != protobuf_version );
+
+   static constexpr uint8_t version  = VERSION;
+   static constexpr std::size_t size = fixed_layout::layout< T >::size;
+
+   static bool decode( const uint8_t* data, std::size_t len, T& obj )
+   {
+      return fixed_layout::layout< T >::decode( data, len, obj );
+   }
+
+   static void encode( const T& obj, uint8_t* out )
+   {
+      fixed_layout::layout< T >::encode( obj, out );
+   }
+};
+
+// The schema of a stored object. The default is protobuf only. Objects with
+// other layouts specialize this with their codecs and the version to write:
+//
+//    template<>
+//    struct schema< my_object >
+//    {
+//       using codecs = std::tuple< protobuf_codec< my_object >, fixed_layout_codec< my_object, 1 > >;
+//       static constexpr uint8_t write_version = 1;
+//    };
+template< typename T >
+struct schema
+{
+   using codecs = std::tuple< protobuf_codec< T > >;
+   static constexpr uint8_t write_version = protobuf_version;
+};
+
+namespace detail {
+
+template< uint8_t VERSION, typename Codecs >
+struct codec_for;
+
+template< uint8_t VERSION >
+struct codec_for< VERSION, std::tuple<> >
+{
+   using type = void;
+};
+
+template< uint8_t VERSION, typename Codec, typename... Codecs >
+struct codec_for< VERSION, std::tuple< Codec, Codecs... > >
+{
+   using type = std::conditional_t<
+      Codec::version == VERSION,
+      Codec,
+      typename codec_for< VERSION, std::tuple< Codecs... > >::type
+   >;
+};
+
+template< typename T, typename... Codecs >
+bool decode_version( uint8_t version, const uint8_t* data, std::size_t len, T& obj, std::tuple< Codecs... >* )
+{
+   return ( ( Codecs::version == version && Codecs::decode( data, len, obj ) ) || ... );
+}
+
+} // detail
+
+template< typename T >
+using write_codec = typename detail::codec_for< schema< T >::write_version, typename schema< T >::codecs >::type;
+
+// Decodes a stored object of any version listed in its schema.
+template< typename T >
+bool decode_versioned( const uint8_t* data, std::size_t len, T& obj )
+{
+   uint8_t version = protobuf_version;
+
+   if ( len && data[0] == envelope_tag )
+   {
+      if ( len < envelope_header_size )
+         return false;
+
+      version = data[1];
+      data += envelope_header_size;
+      len  -= envelope_header_size;
+   }
+
+   return detail::decode_version( version, data, len, obj, static_cast< typename schema< T >::codecs* >( nullptr ) );
+}
+
+// Encodes an object in its schema's write version. Only valid for objects
+// whose write version is not protobuf.
+template< typename T >
+std::string encode_versioned( const T& obj )
+{
+   using codec = write_codec< T >;
+   static_assert( !std::is_void_v< codec >, "schema has no codec for its write version" );
+   static_assert( codec::version != protobuf_version );
+
+   std::string bytes( envelope_header_size + codec::size, '\0' );
+   auto out = reinterpret_cast< uint8_t* >( bytes.data() );
+   out[0] = envelope_tag;
+   out[1] = codec::version;
+   codec::encode( obj, out + envelope_header_size );
+   return bytes;
+}
+
+} // koinos::system_contracts
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <koinos/system_contracts/fixed_layout.hpp>
+
+#include <koinos/contracts/koin/koin.h>
+#include <koinos/contracts/pow/pow.h>
+#include <koinos/contracts/resources/resources.h>
+#include <koinos/contracts/token/token.h>
+
+#include <algorithm>
+
+namespace koinos::system_contracts::fixed_layout {
+
+template<>
+struct layout< contracts::token::balance_object >
+{
+   static constexpr std::size_t size = 8;
+
+   static void encode( const contracts::token::balance_object& obj, uint8_t* out )
+   {
+      put_u64( out, obj.value() );
+   }
+
+   static bool decode( const uint8_t* in, std::size_t len, contracts::token::balance_object& obj )
+   {
+      if ( len != size )
+         return false;
+
+      obj.set_value( get_u64( in ) );
+      return true;
+   }
+};
+
+template<>
+struct layout< contracts::koin::mana_balance_object >
+{
+   static constexpr std::size_t size = 3 * 8;
+
+   static void encode( const contracts::koin::mana_balance_object& obj, uint8_t* out )
+   {
+      put_u64( out,      obj.balance() );
+      put_u64( out + 8,  obj.mana() );
+      put_u64( out + 16, obj.last_mana_update() );
+   }
+
+   static bool decode( const uint8_t* in, std::size_t len, contracts::koin::mana_balance_object& obj )
+   {
+      if ( len != size )
+         return false;
+
+      obj.set_balance( get_u64( in ) );
+      obj.set_mana( get_u64( in + 8 ) );
+      obj.set_last_mana_update( get_u64( in + 16 ) );
+      return true;
+   }
+};
+
+template<>
+struct layout< contracts::resources::resource_markets >
+{
+   static constexpr std::size_t market_size = 3 * 8;
+   static constexpr std::size_t size = 3 * market_size;
+
+   static void encode( const contracts::resources::resource_markets& obj, uint8_t* out )
+   {
+      encode_market( obj.disk_storage(),      out );
+      encode_market( obj.network_bandwidth(), out + market_size );
+      encode_market( obj.compute_bandwidth(), out + 2 * market_size );
+   }
+
+   static bool decode( const uint8_t* in, std::size_t len, contracts::resources::resource_markets& obj )
+   {
+      if ( len != size )
+         return false;
+
+      decode_market( in,                   obj.mutable_disk_storage() );
+      decode_market( in + market_size,     obj.mutable_network_bandwidth() );
+      decode_market( in + 2 * market_size, obj.mutable_compute_bandwidth() );
+      return true;
+   }
+
+private:
+   static void encode_market( const contracts::resources::market& m, uint8_t* out )
+   {
+      put_u64( out,      m.resource_supply() );
+      put_u64( out + 8,  m.block_budget() );
+      put_u64( out + 16, m.block_limit() );
+   }
+
+   static void decode_market( const uint8_t* in, contracts::resources::market& m )
+   {
+      m.set_resource_supply( get_u64( in ) );
+      m.set_block_budget( get_u64( in + 8 ) );
+      m.set_block_limit( get_u64( in + 16 ) );
+   }
+};
+
+// Byte fields are stored as a length byte followed by the field padded to its
+// maximum length, so that the record stays fixed size.
+template< uint32_t TARGET_LENGTH, uint32_t DIFFICULTY_LENGTH >
+struct layout< contracts::pow::difficulty_metadata< TARGET_LENGTH, DIFFICULTY_LENGTH > >
+{
+   using object_type = contracts::pow::difficulty_metadata< TARGET_LENGTH, DIFFICULTY_LENGTH >;
+
+   static_assert( TARGET_LENGTH < 256 && DIFFICULTY_LENGTH < 256 );
+
+   static constexpr std::size_t target_offset     = 0;
+   static constexpr std::size_t difficulty_offset = target_offset + 1 + TARGET_LENGTH;
+   static constexpr std::size_t times_offset      = difficulty_offset + 1 + DIFFICULTY_LENGTH;
+   static constexpr std::size_t size              = times_offset + 2 * 8;
+
+   static void encode( const object_type& obj, uint8_t* out )
+   {
+      encode_bytes( obj.get_target().get_const(), obj.get_target().get_length(), TARGET_LENGTH, out + target_offset );
+      encode_bytes( obj.get_difficulty().get_const(), obj.get_difficulty().get_length(), DIFFICULTY_LENGTH, out + difficulty_offset );
+      put_u64( out + times_offset,     obj.last_block_time() );
+      put_u64( out + times_offset + 8, obj.target_block_interval() );
+   }
+
+   static bool decode( const uint8_t* in, std::size_t len, object_type& obj )
+   {
+      if ( len != size || in[target_offset] > TARGET_LENGTH || in[difficulty_offset] > DIFFICULTY_LENGTH )
+         return false;
+
+      obj.mutable_target().set( in + target_offset + 1, in[target_offset] );
+      obj.mutable_difficulty().set( in + difficulty_offset + 1, in[difficulty_offset] );
+      obj.set_last_block_time( get_u64( in + times_offset ) );
+      obj.set_target_block_interval( get_u64( in + times_offset + 8 ) );
+      return true;
+   }
+
+private:
+   static void encode_bytes( const uint8_t* data, std::size_t len, std::size_t max_len, uint8_t* out )
+   {
+      out[0] = uint8_t( len );
+      std::copy( data, data + len, out + 1 );
+      std::fill( out + 1 + len, out + 1 + max_len, 0 );
+   }
+};
+
+} // koinos::system_contracts::fixed_layout
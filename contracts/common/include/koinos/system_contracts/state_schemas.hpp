@@ -0,0 +1,48 @@
+#pragma once
+
+#include <koinos/system_contracts/schema.hpp>
+#include <koinos/system_contracts/state_layouts.hpp>
+
+#include <koinos/buffer.hpp>
+
+namespace koinos::system_contracts {
+
+template< typename T >
+struct protobuf_codec
+{
+   static constexpr uint8_t version = protobuf_version;
+
+   static bool decode( const uint8_t* data, std::size_t len, T& obj )
+   {
+      koinos::read_buffer rdbuf( const_cast< uint8_t* >( data ), len );
+      return obj.deserialize( rdbuf ) == ::EmbeddedProto::Error::NO_ERRORS;
+   }
+};
+
+// Objects that have a fixed layout accept protobuf and the fixed layout, and
+// are written in the fixed layout when built with FIXED_LAYOUT_STATE.
+template< typename T >
+struct fixed_layout_schema
+{
+   using codecs = std::tuple< protobuf_codec< T >, fixed_layout_codec< T, fixed_layout_version > >;
+#ifdef FIXED_LAYOUT_STATE
+   static constexpr uint8_t write_version = fixed_layout_version;
+#else
+   static constexpr uint8_t write_version = protobuf_version;
+#endif
+};
+
+template<>
+struct schema< contracts::token::balance_object > : fixed_layout_schema< contracts::token::balance_object > {};
+
+template<>
+struct schema< contracts::koin::mana_balance_object > : fixed_layout_schema< contracts::koin::mana_balance_object > {};
+
+template<>
+struct schema< contracts::resources::resource_markets > : fixed_layout_schema< contracts::resources::resource_markets > {};
+
+template< uint32_t TARGET_LENGTH, uint32_t DIFFICULTY_LENGTH >
+struct schema< contracts::pow::difficulty_metadata< TARGET_LENGTH, DIFFICULTY_LENGTH > >
+   : fixed_layout_schema< contracts::pow::difficulty_metadata< TARGET_LENGTH, DIFFICULTY_LENGTH > > {};
+
+} // koinos::system_contracts
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <koinos/system_contracts/fixed_layout.hpp>
+#include <koinos/system_contracts/schema.hpp>
+#include <koinos/system_contracts/uint.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Payment streams.
+//
+// A stream pays `rate` tokens per millisecond from one account to another
+// between start and stop. The sender escrows the whole deposit up front, and
+// what has streamed by time t is computed in closed form,
+//
+//    rate * ( min( max( t, start ), stop ) - start )
+//
+// the same way mana regenerates, so nothing is written while the stream
+// runs. The recipient withdraws what has streamed whenever it likes, and
+// either party can cancel, which pays out what has streamed and refunds the
+// rest.
+namespace koinos::system_contracts::stream {
+
+constexpr std::size_t max_address_size = 25;
+
+struct stream_state
+{
+   std::string from;
+   std::string to;
+   uint64_t    rate      = 0;   // Tokens per ms
+   uint64_t    start     = 0;   // ms
+   uint64_t    stop      = 0;   // ms
+   uint64_t    withdrawn = 0;   // Paid to the recipient so far
+};
+
+// The escrowed total. Returns false if it does not fit in 64 bits.
+constexpr bool deposit( uint64_t rate, uint64_t start, uint64_t stop, uint64_t& value )
+{
+   if ( stop < start )
+      return false;
+
+   auto total = uint128( rate ) * ( stop - start );
+   if ( total > uint128( ~uint64_t( 0 ) ) )
+      return false;
+
+   value = total.convert_to< uint64_t >();
+   return true;
+}
+
+// Streamed by now, including what was already withdrawn. Never more than the
+// deposit.
+constexpr uint64_t streamed( uint64_t rate, uint64_t start, uint64_t stop, uint64_t now )
+{
+   auto t = std::min( std::max( now, start ), stop );
+   return rate * ( t - start );
+}
+
+inline uint64_t withdrawable( const stream_state& s, uint64_t now )
+{
+   return streamed( s.rate, s.start, s.stop, now ) - s.withdrawn;
+}
+
+// Stored little endian, addresses zero padded:
+//
+//    0x00 0x01 from_size(1) from(25) to_size(1) to(25) rate(8) start(8) stop(8) withdrawn(8)
+constexpr std::size_t encoded_size = 2 + 2 * ( 1 + max_address_size ) + 4 * 8;
+
+inline std::string encode( const stream_state& s )
+{
+   std::string bytes( encoded_size, '\0' );
+   auto* p = reinterpret_cast< uint8_t* >( bytes.data() );
+   p[0] = envelope_tag;
+   p[1] = fixed_layout_version;
+   p[2] = uint8_t( s.from.size() );
+   std::memcpy( p + 3, s.from.data(), s.from.size() );
+   p[28] = uint8_t( s.to.size() );
+   std::memcpy( p + 29, s.to.data(), s.to.size() );
+   fixed_layout::put_u64( p + 54, s.rate );
+   fixed_layout::put_u64( p + 62, s.start );
+   fixed_layout::put_u64( p + 70, s.stop );
+   fixed_layout::put_u64( p + 78, s.withdrawn );
+   return bytes;
+}
+
+inline bool decode( const std::string& bytes, stream_state& s )
+{
+   const auto* p = reinterpret_cast< const uint8_t* >( bytes.data() );
+   if ( bytes.size() != encoded_size || p[0] != envelope_tag || p[1] != fixed_layout_version
+      || p[2] > max_address_size || p[28] > max_address_size )
+      return false;
+
+   s.from.assign( reinterpret_cast< const char* >( p + 3 ), p[2] );
+   s.to.assign( reinterpret_cast< const char* >( p + 29 ), p[28] );
+   s.rate      = fixed_layout::get_u64( p + 54 );
+   s.start     = fixed_layout::get_u64( p + 62 );
+   s.stop      = fixed_layout::get_u64( p + 70 );
+   s.withdrawn = fixed_layout::get_u64( p + 78 );
+   return true;
+}
+
+static_assert( streamed( 3, 1000, 2000, 500 ) == 0 );
+static_assert( streamed( 3, 1000, 2000, 1500 ) == 1500 );
+static_assert( streamed( 3, 1000, 2000, 9000 ) == 3000 );
+
+} // koinos::system_contracts::stream
@@ -0,0 +1,2350 @@
+#pragma once
+
+#include <koinos/system/system_calls.hpp>
+
+#include <koinos/crypto.hpp>
+#include <koinos/contracts/koin/koin.h>
+#include <koinos/contracts/koin/koin_extensions.h>
+#include <koinos/contracts/token/token.h>
+#include <koinos/system_contracts/arguments.hpp>
+#include <koinos/system_contracts/checksum.hpp>
+#include <koinos/system_contracts/mana.hpp>
+#include <koinos/system_contracts/merkle.hpp>
+#include <koinos/system_contracts/multisig.hpp>
+#include <koinos/system_contracts/object_batch.hpp>
+#include <koinos/system_contracts/packed_transfer.hpp>
+#include <koinos/system_contracts/result_writer.hpp>
+#include <koinos/system_contracts/rewards.hpp>
+#include <koinos/system_contracts/stream.hpp>
+#include <koinos/system_contracts/twab.hpp>
+#include <koinos/system_contracts/versioned_object.hpp>
+
+#include <koinos/buffer.hpp>
+
+#include <algorithm>
+#include <array>
+#include <initializer_list>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace koinos::system_contracts {
+
+static_assert( mana::detail::fixed_size == fixed_layout::layout< contracts::koin::mana_balance_object >::size );
+
+// Mana policies. A policy selects the balance object stored per account and,
+// when enabled, how mana regenerates. Tokens without mana store a plain
+// token::balance_object and never instantiate any of the regen code.
+
+struct no_mana
+{
+   static constexpr bool enabled = false;
+   using balance_object = contracts::token::balance_object;
+};
+
+template< uint64_t RegenTimeMs >
+struct regenerating_mana
+{
+   static_assert( RegenTimeMs > 0 );
+
+   static constexpr bool enabled = true;
+   static constexpr uint64_t regen_time_ms = RegenTimeMs;
+   using balance_object = contracts::koin::mana_balance_object;
+
+   static void regenerate( balance_object& bal, uint64_t head_block_time )
+   {
+      auto state = mana::regenerate( { bal.balance(), bal.mana(), bal.last_mana_update() }, head_block_time, regen_time_ms );
+      bal.set_mana( state.mana );
+      bal.set_last_mana_update( state.last_mana_update );
+   }
+};
+
+// Balance shard policies. With balance_shards an account can opt in to
+// having credits land in one of up to MaxSlots sub-balance slots, chosen by
+// a hash of the transaction, so that transactions crediting the same hot
+// account write different objects. Debits and mana fold the slots back into
+// the balance object first and so always see the total.
+
+struct no_balance_shards
+{
+   static constexpr bool enabled = false;
+   static constexpr uint32_t max_slots = 0;
+};
+
+template< uint32_t MaxSlots >
+struct balance_shards
+{
+   // The slot is a single byte of the slot key
+   static_assert( MaxSlots >= 2 && MaxSlots <= 256 );
+
+   static constexpr bool enabled = true;
+   static constexpr uint32_t max_slots = MaxSlots;
+};
+
+// Reward policies. With pro_rata_rewards holders can be paid pro rata from
+// a reward pool at O(1) cost per distribution, see rewards.hpp. The pool is
+// the token contract's own account.
+
+struct no_rewards
+{
+   static constexpr bool enabled = false;
+};
+
+struct pro_rata_rewards
+{
+   static constexpr bool enabled = true;
+};
+
+// Airdrop policies. With merkle_airdrops an issuer escrows an airdrop's total
+// in the pool under the Merkle root of its allocations, and each recipient
+// claims its own allocation with a proof, see merkle.hpp.
+
+struct no_airdrops
+{
+   static constexpr bool enabled = false;
+};
+
+struct merkle_airdrops
+{
+   static constexpr bool enabled = true;
+};
+
+// Time-weighted balance policies. With time_weighted_balances every account
+// carries the integral of its balance over time, see twab.hpp.
+
+struct no_time_weighted_balances
+{
+   static constexpr bool enabled = false;
+};
+
+struct time_weighted_balances
+{
+   static constexpr bool enabled = true;
+};
+
+// Stream policies. With payment_streams a sender escrows a deposit in the
+// pool that streams to a recipient at a fixed rate, see stream.hpp.
+
+struct no_streams
+{
+   static constexpr bool enabled = false;
+};
+
+struct payment_streams
+{
+   static constexpr bool enabled = true;
+};
+
+// Balance checksum policies. With striped_balance_checksum the engine keeps
+// the checksum of checksum.hpp over every balance object and shard slot, in
+// Stripes stripes chosen by the hash of each object's key.
+
+struct no_balance_checksum
+{
+   static constexpr bool enabled = false;
+   static constexpr uint32_t stripes = 0;
+};
+
+template< uint32_t Stripes >
+struct striped_balance_checksum
+{
+   // The stripe is the single byte of its key
+   static_assert( Stripes >= 1 && Stripes <= 256 );
+
+   static constexpr bool enabled = true;
+   static constexpr uint32_t stripes = Stripes;
+};
+
+// Multisig policies. With multisig_records an account can register a
+// threshold of up to MaxSigners signer addresses, see multisig.hpp, and a
+// transaction signed by enough of them authorizes the account without a
+// call to its authority contract.
+
+struct no_multisig_records
+{
+   static constexpr bool enabled = false;
+   static constexpr uint32_t max_signers = 0;
+};
+
+template< uint32_t MaxSigners >
+struct multisig_records
+{
+   // The threshold and signer count are single bytes of the record
+   static_assert( MaxSigners >= 1 && MaxSigners <= 255 );
+
+   static constexpr bool enabled = true;
+   static constexpr uint32_t max_signers = MaxSigners;
+};
+
+namespace token_entries {
+
+constexpr uint32_t name         = 0x82a3537f;
+constexpr uint32_t symbol       = 0xb76a7ca1;
+constexpr uint32_t decimals     = 0xee80fd2f;
+constexpr uint32_t total_supply = 0xb0da3934;
+constexpr uint32_t balance_of   = 0x5c721497;
+constexpr uint32_t transfer     = 0x27f576ca;
+constexpr uint32_t mint         = 0xdc6f17bb;
+constexpr uint32_t burn         = 0x859facc5;
+
+constexpr uint32_t transfer_packed       = 0xd7beb5f0;
+constexpr uint32_t set_balance_shards    = 0x7e0db121;
+constexpr uint32_t distribute            = 0xc2ef5060;
+constexpr uint32_t claim                 = 0xdd1b3c31;
+constexpr uint32_t pending_rewards       = 0xeead99c1;
+constexpr uint32_t create_airdrop        = 0x37de56c1;
+constexpr uint32_t claim_airdrop         = 0xed10c904;
+constexpr uint32_t airdrop_claimed       = 0xcaf506ac;
+constexpr uint32_t reclaim_airdrop       = 0xccdf9941;
+constexpr uint32_t balance_integral      = 0x318a8cbd;
+constexpr uint32_t create_stream         = 0xcb6411f3;
+constexpr uint32_t withdraw_stream       = 0xa3edf378;
+constexpr uint32_t cancel_stream         = 0x351a98ff;
+constexpr uint32_t get_stream            = 0xa4f4746b;
+constexpr uint32_t balance_checksum      = 0xb0b8067b;
+constexpr uint32_t seed_balance_checksum = 0xdca0c716;
+constexpr uint32_t set_multisig          = 0xfe047f69;
+constexpr uint32_t get_multisig          = 0xfeb6e74f;
+
+} // token_entries
+
+namespace detail {
+
+struct airdrop_claim
+{
+   std::string                  root;
+   uint64_t                     index = 0;
+   std::string                  account;
+   uint64_t                     value = 0;
+   std::vector< merkle::digest > proof;
+};
+
+} // detail
+
+// Balances, supply, transfer/mint/burn and their events for a token whose
+// parameters are fixed at compile time. Traits provides:
+//
+//    static constexpr char name[];
+//    static constexpr char symbol[];
+//    static constexpr uint32_t decimals;
+//    static constexpr std::size_t max_address_size;
+//    static constexpr std::size_t max_name_size;
+//    static constexpr std::size_t max_symbol_size;
+//    using mana_policy = no_mana;                     // Or regenerating_mana< ms >
+//    using shard_policy = no_balance_shards;          // Or balance_shards< max slots >
+//    using reward_policy = no_rewards;                // Or pro_rata_rewards
+//    using airdrop_policy = no_airdrops;              // Or merkle_airdrops
+//    using twab_policy = no_time_weighted_balances;   // Or time_weighted_balances
+//    using stream_policy = no_streams;                // Or payment_streams
+//    using checksum_policy = no_balance_checksum;     // Or striped_balance_checksum< stripes >
+//    using multisig_policy = no_multisig_records;     // Or multisig_records< max signers >
+//    static void check_mint_authority();              // Fails the transaction if minting is not allowed
+template< typename Traits >
+class token_engine
+{
+public:
+   using mana_policy     = typename Traits::mana_policy;
+   using shard_policy    = typename Traits::shard_policy;
+   using reward_policy   = typename Traits::reward_policy;
+   using airdrop_policy  = typename Traits::airdrop_policy;
+   using twab_policy     = typename Traits::twab_policy;
+   using stream_policy   = typename Traits::stream_policy;
+   using checksum_policy = typename Traits::checksum_policy;
+   using multisig_policy = typename Traits::multisig_policy;
+   using balance_object  = typename mana_policy::balance_object;
+
+   static constexpr bool has_mana     = mana_policy::enabled;
+   static constexpr bool has_shards   = shard_policy::enabled;
+   static constexpr bool has_rewards  = reward_policy::enabled;
+   static constexpr bool has_airdrops = airdrop_policy::enabled;
+   static constexpr bool has_twab     = twab_policy::enabled;
+   static constexpr bool has_streams  = stream_policy::enabled;
+   static constexpr bool has_checksum = checksum_policy::enabled;
+   static constexpr bool has_multisig = multisig_policy::enabled;
+   static constexpr bool has_pool     = has_rewards || has_airdrops || has_streams;
+
+   static constexpr std::size_t max_address_size     = Traits::max_address_size;
+   static constexpr uint32_t supply_id               = 0;
+   static constexpr uint32_t balance_id              = 1;
+   static constexpr uint32_t shard_config_id         = 2;
+   static constexpr uint32_t shard_slot_id           = 3;
+   static constexpr uint32_t reward_pool_id          = 4;
+   static constexpr uint32_t reward_checkpoint_id    = 5;
+   static constexpr uint32_t airdrop_id              = 6;
+   static constexpr uint32_t airdrop_claims_id       = 7;
+   static constexpr uint32_t twab_id                 = 8;
+   static constexpr uint32_t stream_id               = 9;
+   static constexpr uint32_t checksum_id             = 10;
+   static constexpr uint32_t multisig_id             = 11;
+   static constexpr uint32_t shard_checkpoint_id     = 12;
+   static constexpr uint32_t shard_twab_id           = 13;
+   static constexpr uint32_t first_contract_space_id = 16;
+
+   using name_result          = contracts::token::name_result< Traits::max_name_size >;
+   using symbol_result        = contracts::token::symbol_result< Traits::max_symbol_size >;
+   using balance_of_arguments = contracts::token::balance_of_arguments< max_address_size >;
+   using transfer_arguments   = contracts::token::transfer_arguments< max_address_size, max_address_size >;
+   using mint_arguments       = contracts::token::mint_arguments< max_address_size >;
+   using burn_arguments       = contracts::token::burn_arguments< max_address_size >;
+
+   // Stream ids are sha256 digests
+   static constexpr std::size_t stream_id_size = merkle::digest_size;
+
+   // The extension entries' types, generated from koin_extensions.proto
+   using set_balance_shards_arguments    = contracts::koin::set_balance_shards_arguments< max_address_size >;
+   using distribute_arguments            = contracts::koin::distribute_arguments< max_address_size >;
+   using claim_arguments                 = contracts::koin::claim_arguments< max_address_size >;
+   using pending_rewards_arguments       = contracts::koin::pending_rewards_arguments< max_address_size >;
+   using create_airdrop_arguments        = contracts::koin::create_airdrop_arguments< max_address_size, merkle::digest_size >;
+   using claim_airdrop_arguments         = contracts::koin::claim_airdrop_arguments< merkle::digest_size, max_address_size, merkle::max_depth, merkle::digest_size >;
+   using airdrop_claimed_arguments       = contracts::koin::airdrop_claimed_arguments< merkle::digest_size >;
+   using reclaim_airdrop_arguments       = contracts::koin::reclaim_airdrop_arguments< merkle::digest_size >;
+   using balance_integral_arguments      = contracts::koin::balance_integral_arguments< max_address_size >;
+   using create_stream_arguments         = contracts::koin::create_stream_arguments< max_address_size, max_address_size >;
+   using create_stream_result            = contracts::koin::create_stream_result< stream_id_size >;
+   using withdraw_stream_arguments       = contracts::koin::withdraw_stream_arguments< stream_id_size >;
+   using cancel_stream_arguments         = contracts::koin::cancel_stream_arguments< stream_id_size >;
+   using get_stream_arguments            = contracts::koin::get_stream_arguments< stream_id_size >;
+   using get_stream_result               = contracts::koin::get_stream_result< max_address_size, max_address_size >;
+   using balance_checksum_result         = contracts::koin::balance_checksum_result< uint256::bytes >;
+   using seed_balance_checksum_arguments = contracts::koin::seed_balance_checksum_arguments< uint256::bytes >;
+   using set_multisig_arguments          = contracts::koin::set_multisig_arguments< max_address_size, multisig_policy::max_signers, max_address_size >;
+   using get_multisig_arguments          = contracts::koin::get_multisig_arguments< max_address_size >;
+   using get_multisig_result             = contracts::koin::get_multisig_result< multisig_policy::max_signers, max_address_size >;
+
+   static const system::object_space& supply_space()
+   {
+      return current_invocation().space( supply_id );
+   }
+
+   static const system::object_space& balance_space()
+   {
+      return current_invocation().space( balance_id );
+   }
+
+   static const std::string& supply_key()
+   {
+      static const std::string key;
+      return key;
+   }
+
+   // Per account token::balance_object whose value is the account's slot
+   // count. Accounts without one are not sharded.
+   static const system::object_space& shard_config_space()
+   {
+      return current_invocation().space( shard_config_id );
+   }
+
+   // Per slot token::balance_object holding credits not yet folded into the
+   // account's balance object, keyed by the owner followed by the slot byte
+   static const system::object_space& shard_slot_space()
+   {
+      return current_invocation().space( shard_slot_id );
+   }
+
+   // The rewards::pool_state, under supply_key()
+   static const system::object_space& reward_pool_space()
+   {
+      return current_invocation().space( reward_pool_id );
+   }
+
+   // Per account rewards::checkpoint, keyed like the balance space
+   static const system::object_space& reward_checkpoint_space()
+   {
+      return current_invocation().space( reward_checkpoint_id );
+   }
+
+   // Per slot rewards::checkpoint of the credits in it, keyed like the slot
+   // space
+   static const system::object_space& shard_checkpoint_space()
+   {
+      return current_invocation().space( shard_checkpoint_id );
+   }
+
+   // Per airdrop merkle::airdrop, keyed by the root
+   static const system::object_space& airdrop_space()
+   {
+      return current_invocation().space( airdrop_id );
+   }
+
+   // Claim words of merkle.hpp, keyed by merkle::claim_word_key
+   static const system::object_space& airdrop_claims_space()
+   {
+      return current_invocation().space( airdrop_claims_id );
+   }
+
+   // A space for the contract's own objects. Ids below
+   // first_contract_space_id are the engine's, and ids from
+   // invocation_context::max_cached_spaces up are not supported.
+   static system::object_space contract_space( uint32_t id )
+   {
+      if ( id < first_contract_space_id )
+         system::fail( "object space is reserved for the token engine" );
+
+      return current_invocation().space( id );
+   }
+
+   // Per account twab::accumulator, keyed like the balance space
+   static const system::object_space& twab_space()
+   {
+      return current_invocation().space( twab_id );
+   }
+
+   // Per slot twab::accumulator of the credits in it, keyed like the slot
+   // space
+   static const system::object_space& shard_twab_space()
+   {
+      return current_invocation().space( shard_twab_id );
+   }
+
+   // Per stream stream::stream_state, keyed by the stream id
+   static const system::object_space& stream_space()
+   {
+      return current_invocation().space( stream_id );
+   }
+
+   // Per stripe checksum::state, keyed by the stripe byte, and the seed
+   // under checksum_seed_key()
+   static const system::object_space& checksum_space()
+   {
+      return current_invocation().space( checksum_id );
+   }
+
+   // Longer than a stripe key, so it cannot collide with one
+   static const std::string& checksum_seed_key()
+   {
+      static const std::string key( "seed" );
+      return key;
+   }
+
+   // Per account multisig::record, keyed like the balance space
+   static const system::object_space& multisig_space()
+   {
+      return current_invocation().space( multisig_id );
+   }
+
+   // The token contract's own account, holding undistributed and unclaimed
+   // rewards, unclaimed airdrops and stream deposits. It cannot transfer or
+   // burn.
+   static const std::string& pool_owner()
+   {
+      return contract_id_str();
+   }
+
+   static std::string slot_key( const std::string& owner, uint32_t slot )
+   {
+      std::string key;
+      key.reserve( owner.size() + 1 );
+      key.append( owner );
+      key.push_back( char( slot ) );
+      return key;
+   }
+
+   static void regenerate_mana( balance_object& bal )
+   {
+      static_assert( has_mana, "token has no mana" );
+      mana_policy::regenerate( bal, system::get_head_info().head_block_time() );
+   }
+
+   // The account's balance object, with the credits waiting in its slots
+   // folded in if it is sharded. Only the balance object and, for a sharded
+   // account, its slots are read, and nothing is written.
+   static balance_object get_balance( const std::string& owner )
+   {
+      object_batch batch;
+      balance_object bal_obj;
+      add_credits( bal_obj, load_balance( batch, owner, bal_obj ) );
+      return bal_obj;
+   }
+
+   // Spends mana without moving any balance. Returns false, writing nothing,
+   // if the account has too little mana.
+   //
+   // Only the balance object's mana is written, so rewards and the balance
+   // integral are not touched. The credits in a sharded account's slots only
+   // add their mana when folded in, which changes the balance object, so the
+   // slots are folded as a debit would fold them only when the balance
+   // object's own mana falls short.
+   static bool consume_mana( const std::string& owner, uint64_t value )
+   {
+      static_assert( has_mana, "token has no mana" );
+
+      object_batch batch;
+      balance_object bal_obj;
+      auto credits = load_balance( batch, owner, bal_obj );
+      regenerate_mana( bal_obj );
+
+      if ( bal_obj.mana() >= value )
+      {
+         bal_obj.set_mana( bal_obj.mana() - value );
+         batch.put_object( balance_space(), owner, bal_obj );
+         batch.store();
+         return true;
+      }
+
+      if ( bal_obj.mana() + credits < value )
+         return false;
+
+      account_access acc{ &owner, true };
+      balance_batch folded;
+      load_accounts( folded, { &acc } );
+
+      bal_obj = load_debited( folded, acc );
+      regenerate_mana( bal_obj );
+      bal_obj.set_mana( bal_obj.mana() - value );
+
+      store_debited( folded, acc, bal_obj );
+      store( folded );
+      return true;
+   }
+
+   static name_result name()
+   {
+      name_result res;
+      res.mutable_value() = Traits::name;
+      return res;
+   }
+
+   static symbol_result symbol()
+   {
+      symbol_result res;
+      res.mutable_value() = Traits::symbol;
+      return res;
+   }
+
+   static contracts::token::decimals_result decimals()
+   {
+      contracts::token::decimals_result res;
+      res.mutable_value() = Traits::decimals;
+      return res;
+   }
+
+   static contracts::token::total_supply_result total_supply()
+   {
+      contracts::token::total_supply_result res;
+
+      contracts::token::balance_object bal_obj;
+      get_versioned_object( supply_space(), supply_key(), bal_obj );
+
+      res.mutable_value() = bal_obj.get_value();
+      return res;
+   }
+
+   static contracts::token::balance_of_result balance_of( const balance_of_arguments& args )
+   {
+      contracts::token::balance_of_result res;
+
+      std::string owner( reinterpret_cast< const char* >( args.get_owner().get_const() ), args.get_owner().get_length() );
+      res.set_value( balance_value( get_balance( owner ) ) );
+      return res;
+   }
+
+   // The transfer core shared by every transfer entry point
+   static void transfer( const std::string& from, const std::string& to, uint64_t value )
+   {
+      check_transfer( from, to );
+
+      if ( !authorized( from ) )
+         system::fail( "from has not authorized transfer", chain::error_code::authorization_failure );
+
+      move( from, to, value );
+   }
+
+   // A transfer whose authorization the contract has already established
+   // some other way, such as a signed permit
+   static void transfer_authorized( const std::string& from, const std::string& to, uint64_t value )
+   {
+      check_transfer( from, to );
+      move( from, to, value );
+   }
+
+   static contracts::token::transfer_result transfer( const transfer_arguments& args )
+   {
+      std::string from( reinterpret_cast< const char* >( args.get_from().get_const() ), args.get_from().get_length() );
+      std::string to( reinterpret_cast< const char* >( args.get_to().get_const() ), args.get_to().get_length() );
+
+      transfer( from, to, args.get_value() );
+
+      return contracts::token::transfer_result();
+   }
+
+   // Takes the fixed-layout record from packed_transfer.hpp instead of
+   // token::transfer_arguments
+   static contracts::token::transfer_result transfer_packed( const argument_view& args )
+   {
+      static_assert( max_address_size <= packed::max_address_size );
+
+      packed::transfer_record rec;
+      if ( !packed::decode_transfer( args.data, args.size, rec ) || rec.from_size > max_address_size || rec.to_size > max_address_size )
+         system::revert( "malformed packed transfer arguments" );
+
+      std::string from( reinterpret_cast< const char* >( rec.from ), rec.from_size );
+      std::string to( reinterpret_cast< const char* >( rec.to ), rec.to_size );
+
+      transfer( from, to, rec.value );
+
+      return contracts::token::transfer_result();
+   }
+
+   static contracts::token::mint_result mint( const mint_arguments& args )
+   {
+      std::string to( reinterpret_cast< const char* >( args.get_to().get_const() ), args.get_to().get_length() );
+      uint64_t amount = args.get_value();
+
+      Traits::check_mint_authority();
+
+      account_access to_acc{ &to, false };
+      balance_batch batch;
+      auto supply_index = batch.objects.get( supply_space(), supply_key() );
+      load_accounts( batch, { &to_acc } );
+
+      contracts::token::balance_object supply_obj;
+      batch.objects.get_object( supply_index, supply_obj );
+
+      auto supply = supply_obj.get_value();
+      auto new_supply = supply + amount;
+
+      // Check overflow
+      if ( new_supply < supply )
+         system::revert( "mint would overflow supply" );
+
+      supply_obj.set_value( new_supply );
+
+      batch.objects.put_object( supply_space(), supply_key(), supply_obj );
+      credit( batch, to_acc, amount );
+      store( batch );
+
+      contracts::token::mint_event< max_address_size > mint_event;
+      mint_event.mutable_to().set( args.get_to().get_const(), args.get_to().get_length() );
+      mint_event.set_value( amount );
+
+      std::vector< std::string > impacted;
+      impacted.push_back( to );
+      system::event( "koinos.contracts.token.mint_event", mint_event, impacted );
+
+      return contracts::token::mint_result();
+   }
+
+   static contracts::token::burn_result burn( const burn_arguments& args )
+   {
+      std::string from( reinterpret_cast< const char* >( args.get_from().get_const() ), args.get_from().get_length() );
+      uint64_t value = args.get_value();
+
+      if constexpr ( has_pool )
+      {
+         if ( from == pool_owner() )
+            system::fail( "cannot burn from the pool" );
+      }
+
+      if ( !authorized( from ) )
+         system::fail( "from has not authorized burn", chain::error_code::authorization_failure );
+
+      account_access from_acc{ &from, true };
+      balance_batch batch;
+      auto supply_index = batch.objects.get( supply_space(), supply_key() );
+      load_accounts( batch, { &from_acc } );
+
+      auto from_bal_obj = load_debited( batch, from_acc );
+
+      debit( from_bal_obj, value, "account 'from' has insufficient mana for burn" );
+
+      contracts::token::balance_object supply_obj;
+      batch.objects.get_object( supply_index, supply_obj );
+
+      auto supply = supply_obj.get_value();
+
+      // Check underflow
+      if ( value > supply )
+         system::revert( "burn would underflow supply" );
+
+      supply_obj.set_value( supply - value );
+
+      batch.objects.put_object( supply_space(), supply_key(), supply_obj );
+      store_debited( batch, from_acc, from_bal_obj );
+      store( batch );
+
+      contracts::token::burn_event< max_address_size > burn_event;
+      burn_event.mutable_from().set( args.get_from().get_const(), args.get_from().get_length() );
+      burn_event.set_value( value );
+
+      std::vector< std::string > impacted;
+      impacted.push_back( from );
+      system::event( "koinos.contracts.token.burn_event", burn_event, impacted );
+
+      return contracts::token::burn_result();
+   }
+
+   // Opts owner in to spreading its credits over `slots` slots, or out with
+   // 0. Credits already in slots are folded into the balance object first.
+   static void set_balance_shards( const std::string& owner, uint32_t slots )
+   {
+      static_assert( has_shards, "token has no balance shards" );
+
+      if ( slots == 1 || slots > shard_policy::max_slots )
+         system::revert( "invalid balance shard count" );
+
+      if constexpr ( has_pool )
+      {
+         if ( owner == pool_owner() )
+            system::fail( "the pool cannot be sharded" );
+      }
+
+      if ( !authorized( owner ) )
+         system::fail( "owner has not authorized balance shards", chain::error_code::authorization_failure );
+
+      account_access acc{ &owner, true };
+      balance_batch batch;
+      load_accounts( batch, { &acc } );
+
+      if ( acc.slots )
+         store_debited( batch, acc, load_debited( batch, acc ) );
+
+      contracts::token::balance_object config;
+      config.set_value( slots );
+      batch.objects.put_object( shard_config_space(), owner, config );
+      store( batch );
+   }
+
+   static void set_balance_shards( const argument_view& args )
+   {
+      auto arg = decode_arguments< set_balance_shards_arguments >( args, "malformed set_balance_shards arguments" );
+      set_balance_shards( bytes_string( arg.get_owner() ), arg.get_slots() );
+   }
+
+   // Pays value from `from` into the reward pool, to be shared among all
+   // other holders in proportion to their balances
+   static void distribute( const std::string& from, uint64_t value )
+   {
+      static_assert( has_rewards, "token has no rewards" );
+
+      const auto& pool = pool_owner();
+      if ( from == pool )
+         system::fail( "cannot distribute from the pool" );
+
+      if ( !authorized( from ) )
+         system::fail( "from has not authorized distribution", chain::error_code::authorization_failure );
+
+      account_access from_acc{ &from, true };
+      account_access pool_acc{ &pool, false };
+      balance_batch batch;
+      auto supply_index = batch.objects.get( supply_space(), supply_key() );
+      load_accounts( batch, { &from_acc, &pool_acc } );
+
+      auto from_bal_obj = load_debited( batch, from_acc );
+
+      debit( from_bal_obj, value, "account 'from' has insufficient mana for distribution" );
+
+      // Every token outside the pool is eligible, including this one's
+      // remaining balance
+      contracts::token::balance_object supply_obj;
+      batch.objects.get_object( supply_index, supply_obj );
+
+      balance_object pool_bal_obj;
+      batch.objects.get_object( pool_acc.index, pool_bal_obj );
+
+      auto eligible = supply_obj.get_value() - balance_value( pool_bal_obj ) - value;
+      if ( !rewards::add_distribution( batch.pool, value, eligible ) )
+         system::revert( "nothing to distribute to" );
+
+      store_debited( batch, from_acc, from_bal_obj );
+      credit( batch, pool_acc, value );
+      store_pool( batch );
+      store( batch );
+
+      emit_transfer( from, pool, value );
+   }
+
+   static void distribute( const argument_view& args )
+   {
+      auto arg = decode_arguments< distribute_arguments >( args, "malformed distribute arguments" );
+      distribute( bytes_string( arg.get_from() ), arg.get_value() );
+   }
+
+   // Pays owner its rewards from the pool. Returns the amount paid.
+   static uint64_t claim( const std::string& owner )
+   {
+      static_assert( has_rewards, "token has no rewards" );
+
+      const auto& pool = pool_owner();
+      if ( owner == pool )
+         system::fail( "the pool cannot claim" );
+
+      if ( !authorized( owner ) )
+         system::fail( "owner has not authorized claim", chain::error_code::authorization_failure );
+
+      // Loaded as a debit so that a sharded owner's slots are folded, and
+      // their rewards with them
+      account_access owner_acc{ &owner, true };
+      account_access pool_acc{ &pool, true };
+      balance_batch batch;
+      load_accounts( batch, { &owner_acc, &pool_acc } );
+
+      auto value = owner_acc.checkpoint.pending;
+      if ( !value )
+         return 0;
+
+      owner_acc.checkpoint.pending = 0;
+      owner_acc.checkpoint_dirty   = true;
+
+      debit_pool( batch, pool_acc, value );
+
+      auto owner_bal_obj = load_debited( batch, owner_acc );
+      if constexpr ( has_mana )
+      {
+         regenerate_mana( owner_bal_obj );
+         owner_bal_obj.set_mana( owner_bal_obj.mana() + value );
+      }
+      set_balance_value( owner_bal_obj, balance_value( owner_bal_obj ) + value );
+
+      store_debited( batch, owner_acc, owner_bal_obj );
+      store( batch );
+
+      emit_transfer( pool, owner, value );
+      return value;
+   }
+
+   // Rewards owner could claim now
+   static uint64_t pending_rewards( const std::string& owner )
+   {
+      static_assert( has_rewards, "token has no rewards" );
+
+      if ( owner == pool_owner() )
+         return 0;
+
+      // Settled and folded as claim would, without writing
+      account_access acc{ &owner, true };
+      balance_batch batch;
+      load_accounts( batch, { &acc } );
+      return acc.checkpoint.pending;
+   }
+
+   // Escrows value from `from` in the pool for the allocations committed to
+   // by root, a tree of `leaves` leaves, until the head block time reaches
+   // expiry
+   static void create_airdrop( const std::string& from, const std::string& root, uint64_t leaves, uint64_t value, uint64_t expiry )
+   {
+      static_assert( has_airdrops, "token has no airdrops" );
+
+      if ( root.size() != merkle::digest_size )
+         system::revert( "invalid airdrop root" );
+
+      if ( !leaves || leaves > ( uint64_t( 1 ) << merkle::max_depth ) )
+         system::revert( "invalid airdrop leaf count" );
+
+      if ( expiry <= system::get_head_info().head_block_time() )
+         system::revert( "invalid airdrop expiry" );
+
+      const auto& pool = pool_owner();
+      if ( from == pool )
+         system::fail( "cannot airdrop from the pool" );
+
+      if ( !authorized( from ) )
+         system::fail( "from has not authorized airdrop", chain::error_code::authorization_failure );
+
+      account_access from_acc{ &from, true };
+      account_access pool_acc{ &pool, false };
+      balance_batch batch;
+      auto airdrop_index = batch.objects.get( airdrop_space(), root );
+      load_accounts( batch, { &from_acc, &pool_acc } );
+
+      if ( batch.objects.get_value( airdrop_index ).size() )
+         system::fail( "airdrop already exists" );
+
+      auto from_bal_obj = load_debited( batch, from_acc );
+      debit( from_bal_obj, value, "account 'from' has insufficient mana for airdrop" );
+
+      store_debited( batch, from_acc, from_bal_obj );
+      credit( batch, pool_acc, value );
+      batch.objects.put_value( airdrop_space(), root, merkle::encode( merkle::airdrop{ leaves, value, expiry, from } ) );
+      store( batch );
+
+      emit_transfer( from, pool, value );
+   }
+
+   static void create_airdrop( const argument_view& args )
+   {
+      auto arg = decode_arguments< create_airdrop_arguments >( args, "malformed create_airdrop arguments" );
+      create_airdrop( bytes_string( arg.get_from() ), bytes_string( arg.get_root() ), arg.get_leaves(), arg.get_value(), arg.get_expiry() );
+   }
+
+   // Pays a leaf's allocation to its account. Anyone may submit the claim.
+   static void claim_airdrop( const detail::airdrop_claim& claim )
+   {
+      static_assert( has_airdrops, "token has no airdrops" );
+
+      const auto& pool = pool_owner();
+      if ( claim.account == pool )
+         system::fail( "the pool cannot claim an airdrop" );
+
+      account_access to_acc{ &claim.account, false };
+      account_access pool_acc{ &pool, true };
+      balance_batch batch;
+      auto airdrop_index = batch.objects.get( airdrop_space(), claim.root );
+      auto word_key      = merkle::claim_word_key( claim.root, claim.index );
+      auto word_index    = batch.objects.get( airdrop_claims_space(), word_key );
+      load_accounts( batch, { &to_acc, &pool_acc } );
+
+      merkle::airdrop drop;
+      if ( !merkle::decode( batch.objects.get_value( airdrop_index ), drop ) )
+         system::fail( "airdrop does not exist" );
+
+      if ( drop.expiry && drop.expiry <= system::get_head_info().head_block_time() )
+         system::fail( "airdrop has expired" );
+
+      if ( claim.index >= drop.leaves || claim.proof.size() != merkle::depth( drop.leaves ) )
+         system::fail( "invalid airdrop proof" );
+
+      auto leaf = hash_digest( merkle::leaf_message( claim.index, claim.account, claim.value ) );
+      auto root = merkle::compute_root( hash_digest, leaf, claim.index, claim.proof );
+      if ( std::string( root.begin(), root.end() ) != claim.root )
+         system::fail( "invalid airdrop proof" );
+
+      auto word = batch.objects.get_value( word_index );
+      if ( !merkle::valid_claim_word( word ) )
+         system::fail( "unrecognized object schema version" );
+
+      if ( merkle::is_claimed( word, claim.index ) )
+         system::fail( "airdrop already claimed" );
+
+      // Only an issuer that committed to more than it escrowed gets here
+      if ( claim.value > drop.remaining )
+         system::fail( "airdrop has insufficient funds" );
+
+      drop.remaining -= claim.value;
+      merkle::set_claimed( word, claim.index );
+
+      debit_pool( batch, pool_acc, claim.value );
+      credit( batch, to_acc, claim.value );
+      batch.objects.put_value( airdrop_space(), claim.root, merkle::encode( drop ) );
+      batch.objects.put_value( airdrop_claims_space(), word_key, std::move( word ) );
+      store( batch );
+
+      emit_transfer( pool, claim.account, claim.value );
+   }
+
+   static bool airdrop_claimed( const std::string& root, uint64_t index )
+   {
+      static_assert( has_airdrops, "token has no airdrops" );
+
+      object_batch batch;
+      auto word_index = batch.get( airdrop_claims_space(), merkle::claim_word_key( root, index ) );
+      batch.load();
+
+      const auto& word = batch.get_value( word_index );
+      if ( !merkle::valid_claim_word( word ) )
+         system::fail( "unrecognized object schema version" );
+
+      return merkle::is_claimed( word, index );
+   }
+
+   // Returns what was not claimed of an expired airdrop to its creator. The
+   // airdrop is kept, with nothing remaining, so its root cannot be reused.
+   // Returns the amount reclaimed.
+   static uint64_t reclaim_airdrop( const std::string& root )
+   {
+      static_assert( has_airdrops, "token has no airdrops" );
+
+      // The creator, and so the accounts to load, are in the airdrop
+      object_batch drop_batch;
+      auto airdrop_index = drop_batch.get( airdrop_space(), root );
+      drop_batch.load();
+
+      merkle::airdrop drop;
+      if ( !merkle::decode( drop_batch.get_value( airdrop_index ), drop ) )
+         system::fail( "airdrop does not exist" );
+
+      if ( !drop.expiry || drop.expiry > system::get_head_info().head_block_time() )
+         system::fail( "airdrop has not expired" );
+
+      if ( !authorized( drop.creator ) )
+         system::fail( "creator has not authorized reclaim", chain::error_code::authorization_failure );
+
+      auto value = drop.remaining;
+      if ( !value )
+         return 0;
+
+      const auto& pool = pool_owner();
+      account_access to_acc{ &drop.creator, false };
+      account_access pool_acc{ &pool, true };
+      balance_batch batch;
+      load_accounts( batch, { &to_acc, &pool_acc } );
+
+      drop.remaining = 0;
+
+      debit_pool( batch, pool_acc, value );
+      credit( batch, to_acc, value );
+      batch.objects.put_value( airdrop_space(), root, merkle::encode( drop ) );
+      store( batch );
+
+      emit_transfer( pool, drop.creator, value );
+      return value;
+   }
+
+   // Escrows rate * ( stop - start ) from `from` in the pool, streaming to
+   // `to` from start, or now if start is zero, until stop. Returns the
+   // stream id.
+   static std::string create_stream( stream::stream_state s )
+   {
+      static_assert( has_streams, "token has no streams" );
+      static_assert( max_address_size <= stream::max_address_size );
+
+      if ( s.from.size() > max_address_size || s.to.size() > max_address_size )
+         system::revert( "malformed create_stream arguments" );
+
+      auto now = system::get_head_info().head_block_time();
+      if ( !s.start )
+         s.start = now;
+
+      uint64_t value;
+      if ( !s.rate || s.start < now || s.stop <= s.start )
+         system::revert( "invalid stream schedule" );
+
+      if ( !stream::deposit( s.rate, s.start, s.stop, value ) )
+         system::revert( "stream deposit would overflow" );
+
+      if ( s.from == s.to )
+         system::fail( "cannot stream to self" );
+
+      const auto& pool = pool_owner();
+      if ( s.from == pool || s.to == pool )
+         system::fail( "cannot stream to or from the pool" );
+
+      if ( !authorized( s.from ) )
+         system::fail( "from has not authorized stream", chain::error_code::authorization_failure );
+
+      s.withdrawn = 0;
+
+      // Ids are unique per transaction and stream, without a shared counter
+      std::string id_message;
+      auto tx_id = system::get_transaction_field( "id" );
+      wire::append_bytes( id_message, 1, tx_id.get_bytes_value().get_const(), tx_id.get_bytes_value().get_length() );
+      wire::append_bytes( id_message, 2, stream::encode( s ) );
+      auto digest = hash_digest( id_message );
+      std::string id( digest.begin(), digest.end() );
+
+      account_access from_acc{ &s.from, true };
+      account_access pool_acc{ &pool, false };
+      balance_batch batch;
+      auto stream_index = batch.objects.get( stream_space(), id );
+      load_accounts( batch, { &from_acc, &pool_acc } );
+
+      if ( batch.objects.get_value( stream_index ).size() )
+         system::fail( "stream already exists" );
+
+      auto from_bal_obj = load_debited( batch, from_acc );
+      debit( from_bal_obj, value, "account 'from' has insufficient mana for stream" );
+
+      store_debited( batch, from_acc, from_bal_obj );
+      credit( batch, pool_acc, value );
+      batch.objects.put_value( stream_space(), id, stream::encode( s ) );
+      store( batch );
+
+      emit_transfer( s.from, pool, value );
+      return id;
+   }
+
+   // Pays the recipient what has streamed and not been withdrawn. Anyone may
+   // call it. Returns the amount paid.
+   static uint64_t withdraw_stream( const std::string& id )
+   {
+      static_assert( has_streams, "token has no streams" );
+
+      auto s   = load_stream( id );
+      auto now = system::get_head_info().head_block_time();
+
+      auto value = stream::withdrawable( s, now );
+      if ( !value )
+         return 0;
+
+      s.withdrawn += value;
+      pay_stream( id, s, value, 0 );
+      return value;
+   }
+
+   // Ends a stream, paying the recipient what has streamed and refunding the
+   // rest to the sender. Either party may cancel.
+   static void cancel_stream( const std::string& id )
+   {
+      static_assert( has_streams, "token has no streams" );
+
+      auto s = load_stream( id );
+
+      if ( !authorized( s.from ) && !authorized( s.to ) )
+         system::fail( "stream party has not authorized cancel", chain::error_code::authorization_failure );
+
+      uint64_t deposit;
+      stream::deposit( s.rate, s.start, s.stop, deposit );
+
+      auto now   = system::get_head_info().head_block_time();
+      auto value = stream::withdrawable( s, now );
+
+      s.withdrawn += value;
+      pay_stream( id, s, value, deposit - s.withdrawn );
+   }
+
+   static stream::stream_state get_stream( const std::string& id )
+   {
+      static_assert( has_streams, "token has no streams" );
+      return load_stream( id );
+   }
+
+   // owner's balance integral at the head block time. Returns that time in
+   // `now`.
+   static uint128 balance_integral( const std::string& owner, uint64_t& now )
+   {
+      static_assert( has_twab, "token has no time-weighted balances" );
+
+      account_access acc{ &owner, true };
+      balance_batch batch;
+      load_accounts( batch, { &acc } );
+
+      balance_object bal_obj;
+      batch.objects.get_object( acc.index, bal_obj );
+
+      now = batch.now;
+      return twab::integral( acc.twab, balance_value( bal_obj ), now ) + slot_integrals( batch, acc );
+   }
+
+   // Registers a multisig record for owner, or removes it with a threshold of
+   // zero and no signers
+   static void set_multisig( const std::string& owner, const multisig::record& r )
+   {
+      static_assert( has_multisig, "token has no multisig records" );
+
+      bool remove = !r.threshold && r.signers.empty();
+      if ( !remove && !multisig::valid( r, multisig_policy::max_signers ) )
+         system::revert( "invalid multisig record" );
+
+      if ( !authorized( owner ) )
+         system::fail( "owner has not authorized multisig", chain::error_code::authorization_failure );
+
+      if ( remove )
+      {
+         system::remove_object( multisig_space(), owner );
+         return;
+      }
+
+      object_batch batch;
+      batch.put_value( multisig_space(), owner, multisig::encode( r ) );
+      batch.store();
+   }
+
+   // owner's multisig record. Its threshold is zero if it has none.
+   static multisig::record get_multisig( const std::string& owner )
+   {
+      static_assert( has_multisig, "token has no multisig records" );
+
+      multisig::record r;
+      load_multisig( owner, r );
+      return r;
+   }
+
+   // The checksum of every balance object and shard slot, with the supply
+   // its sum should equal in `supply`
+   static checksum::state balance_checksum( uint64_t& supply )
+   {
+      static_assert( has_checksum, "token has no balance checksum" );
+
+      object_batch batch;
+      checksum::state total;
+      load_checksum( batch, supply, total );
+      return total;
+   }
+
+   // Adds the checksum of the balances that existed before the checksum was
+   // enabled, which no stripe covers. It can be seeded once, by the mint
+   // authority, and only so that the checksum's sum equals the supply.
+   static void seed_balance_checksum( const checksum::state& seed )
+   {
+      static_assert( has_checksum, "token has no balance checksum" );
+
+      Traits::check_mint_authority();
+
+      object_batch batch;
+      uint64_t supply;
+      checksum::state total;
+      auto seed_index = load_checksum( batch, supply, total );
+
+      if ( batch.get_value( seed_index ).size() )
+         system::fail( "balance checksum is already seeded" );
+
+      checksum::combine( total, seed );
+      if ( total.sum != supply )
+         system::fail( "seed does not match the supply" );
+
+      std::string bytes( checksum::encoded_size, '\0' );
+      checksum::encode( seed, reinterpret_cast< uint8_t* >( bytes.data() ) );
+      batch.put_value( checksum_space(), checksum_seed_key(), std::move( bytes ) );
+      batch.store();
+   }
+
+   // Handles the standard token entry points. Returns false if entry_point is
+   // not one of them so the contract can handle its own entries.
+   static bool dispatch( const argument_view& arguments, result_writer& buffer )
+   {
+      auto rdbuf = arguments.reader();
+
+      switch ( arguments.entry_point )
+      {
+         case token_entries::name:
+         {
+            auto res = name();
+            res.serialize( buffer );
+            break;
+         }
+         case token_entries::symbol:
+         {
+            auto res = symbol();
+            res.serialize( buffer );
+            break;
+         }
+         case token_entries::decimals:
+         {
+            auto res = decimals();
+            res.serialize( buffer );
+            break;
+         }
+         case token_entries::total_supply:
+         {
+            auto res = total_supply();
+            res.serialize( buffer );
+            break;
+         }
+         case token_entries::balance_of:
+         {
+            balance_of_arguments arg;
+            arg.deserialize( rdbuf );
+
+            auto res = balance_of( arg );
+            res.serialize( buffer );
+            break;
+         }
+         case token_entries::transfer:
+         {
+            transfer_arguments arg;
+            arg.deserialize( rdbuf );
+
+            auto res = transfer( arg );
+            res.serialize( buffer );
+            break;
+         }
+         case token_entries::transfer_packed:
+         {
+            auto res = transfer_packed( arguments );
+            res.serialize( buffer );
+            break;
+         }
+         case token_entries::set_balance_shards:
+         {
+            if constexpr ( !has_shards )
+               return false;
+            else
+               set_balance_shards( arguments );
+            break;
+         }
+         case token_entries::distribute:
+         {
+            if constexpr ( !has_rewards )
+               return false;
+            else
+               distribute( arguments );
+            break;
+         }
+         case token_entries::claim:
+         {
+            if constexpr ( !has_rewards )
+               return false;
+            else
+            {
+               auto arg = decode_arguments< claim_arguments >( arguments, "malformed claim arguments" );
+
+               contracts::koin::claim_result res;
+               res.set_value( claim( bytes_string( arg.get_owner() ) ) );
+               res.serialize( buffer );
+            }
+            break;
+         }
+         case token_entries::pending_rewards:
+         {
+            if constexpr ( !has_rewards )
+               return false;
+            else
+            {
+               auto arg = decode_arguments< pending_rewards_arguments >( arguments, "malformed pending_rewards arguments" );
+
+               contracts::koin::pending_rewards_result res;
+               res.set_value( pending_rewards( bytes_string( arg.get_owner() ) ) );
+               res.serialize( buffer );
+            }
+            break;
+         }
+         case token_entries::create_airdrop:
+         {
+            if constexpr ( !has_airdrops )
+               return false;
+            else
+               create_airdrop( arguments );
+            break;
+         }
+         case token_entries::claim_airdrop:
+         {
+            if constexpr ( !has_airdrops )
+               return false;
+            else
+            {
+               auto arg = decode_arguments< claim_airdrop_arguments >( arguments, "malformed claim_airdrop arguments" );
+
+               detail::airdrop_claim claim;
+               claim.root    = bytes_string( arg.get_root() );
+               claim.index   = arg.get_index();
+               claim.account = bytes_string( arg.get_account() );
+               claim.value   = arg.get_value();
+               for ( uint32_t i = 0; i < arg.proof_length(); i++ )
+               {
+                  const auto& sibling = arg.proof( i );
+                  if ( sibling.get_length() != merkle::digest_size )
+                     system::revert( "malformed claim_airdrop arguments" );
+
+                  std::copy( sibling.get_const(), sibling.get_const() + merkle::digest_size, claim.proof.emplace_back().begin() );
+               }
+
+               claim_airdrop( claim );
+            }
+            break;
+         }
+         case token_entries::airdrop_claimed:
+         {
+            if constexpr ( !has_airdrops )
+               return false;
+            else
+            {
+               auto arg = decode_arguments< airdrop_claimed_arguments >( arguments, "malformed airdrop_claimed arguments" );
+
+               contracts::koin::airdrop_claimed_result res;
+               res.set_value( airdrop_claimed( bytes_string( arg.get_root() ), arg.get_index() ) );
+               res.serialize( buffer );
+            }
+            break;
+         }
+         case token_entries::reclaim_airdrop:
+         {
+            if constexpr ( !has_airdrops )
+               return false;
+            else
+            {
+               auto arg = decode_arguments< reclaim_airdrop_arguments >( arguments, "malformed reclaim_airdrop arguments" );
+
+               contracts::koin::reclaim_airdrop_result res;
+               res.set_value( reclaim_airdrop( bytes_string( arg.get_root() ) ) );
+               res.serialize( buffer );
+            }
+            break;
+         }
+         case token_entries::balance_integral:
+         {
+            if constexpr ( !has_twab )
+               return false;
+            else
+            {
+               auto arg = decode_arguments< balance_integral_arguments >( arguments, "malformed balance_integral arguments" );
+
+               uint64_t now;
+               auto value = balance_integral( bytes_string( arg.get_owner() ), now );
+
+               contracts::koin::balance_integral_result res;
+               res.set_low( value.limb( 0 ) );
+               res.set_high( value.limb( 1 ) );
+               res.set_timestamp( now );
+               res.serialize( buffer );
+            }
+            break;
+         }
+         case token_entries::create_stream:
+         {
+            if constexpr ( !has_streams )
+               return false;
+            else
+            {
+               auto arg = decode_arguments< create_stream_arguments >( arguments, "malformed create_stream arguments" );
+
+               stream::stream_state s;
+               s.from  = bytes_string( arg.get_from() );
+               s.to    = bytes_string( arg.get_to() );
+               s.rate  = arg.get_rate();
+               s.start = arg.get_start();
+               s.stop  = arg.get_stop();
+
+               auto id = create_stream( s );
+
+               create_stream_result res;
+               res.mutable_id().set( reinterpret_cast< const uint8_t* >( id.data() ), id.size() );
+               res.serialize( buffer );
+            }
+            break;
+         }
+         case token_entries::withdraw_stream:
+         {
+            if constexpr ( !has_streams )
+               return false;
+            else
+            {
+               contracts::koin::withdraw_stream_result res;
+               res.set_value( withdraw_stream( decode_stream_id< withdraw_stream_arguments >( arguments ) ) );
+               res.serialize( buffer );
+            }
+            break;
+         }
+         case token_entries::cancel_stream:
+         {
+            if constexpr ( !has_streams )
+               return false;
+            else
+               cancel_stream( decode_stream_id< cancel_stream_arguments >( arguments ) );
+            break;
+         }
+         case token_entries::get_stream:
+         {
+            if constexpr ( !has_streams )
+               return false;
+            else
+            {
+               auto s = get_stream( decode_stream_id< get_stream_arguments >( arguments ) );
+
+               get_stream_result res;
+               res.mutable_from().set( reinterpret_cast< const uint8_t* >( s.from.data() ), s.from.size() );
+               res.mutable_to().set( reinterpret_cast< const uint8_t* >( s.to.data() ), s.to.size() );
+               res.set_rate( s.rate );
+               res.set_start( s.start );
+               res.set_stop( s.stop );
+               res.set_withdrawn( s.withdrawn );
+               res.set_withdrawable( stream::withdrawable( s, system::get_head_info().head_block_time() ) );
+               res.serialize( buffer );
+            }
+            break;
+         }
+         case token_entries::seed_balance_checksum:
+         {
+            if constexpr ( !has_checksum )
+               return false;
+            else
+            {
+               auto arg = decode_arguments< seed_balance_checksum_arguments >( arguments, "malformed seed_balance_checksum arguments" );
+               if ( arg.get_fingerprint().get_length() != uint256::bytes )
+                  system::revert( "malformed seed_balance_checksum arguments" );
+
+               checksum::state seed;
+               seed.sum         = arg.get_sum();
+               seed.fingerprint = uint256::from_big_endian( arg.get_fingerprint().get_const() );
+               seed_balance_checksum( seed );
+            }
+            break;
+         }
+         case token_entries::balance_checksum:
+         {
+            if constexpr ( !has_checksum )
+               return false;
+            else
+            {
+               uint64_t supply;
+               auto total = balance_checksum( supply );
+
+               std::array< uint8_t, uint256::bytes > fingerprint;
+               total.fingerprint.to_big_endian( fingerprint.data() );
+
+               balance_checksum_result res;
+               res.set_supply( supply );
+               res.set_sum( total.sum );
+               res.mutable_fingerprint().set( fingerprint.data(), fingerprint.size() );
+               res.serialize( buffer );
+            }
+            break;
+         }
+         case token_entries::set_multisig:
+         {
+            if constexpr ( !has_multisig )
+               return false;
+            else
+            {
+               auto arg = decode_arguments< set_multisig_arguments >( arguments, "malformed set_multisig arguments" );
+
+               multisig::record r;
+               r.threshold = arg.get_threshold();
+               for ( uint32_t i = 0; i < arg.signers_length(); i++ )
+                  r.signers.push_back( bytes_string( arg.signers( i ) ) );
+
+               set_multisig( bytes_string( arg.get_owner() ), r );
+            }
+            break;
+         }
+         case token_entries::get_multisig:
+         {
+            if constexpr ( !has_multisig )
+               return false;
+            else
+            {
+               auto arg = decode_arguments< get_multisig_arguments >( arguments, "malformed get_multisig arguments" );
+               auto r = get_multisig( bytes_string( arg.get_owner() ) );
+
+               get_multisig_result res;
+               res.set_threshold( r.threshold );
+               for ( const auto& signer : r.signers )
+               {
+                  ::EmbeddedProto::FieldBytes< max_address_size > field;
+                  field.set( reinterpret_cast< const uint8_t* >( signer.data() ), signer.size() );
+                  res.add_signers( field );
+               }
+               res.serialize( buffer );
+            }
+            break;
+         }
+         case token_entries::mint:
+         {
+            mint_arguments arg;
+            arg.deserialize( rdbuf );
+
+            auto res = mint( arg );
+            res.serialize( buffer );
+            break;
+         }
+         case token_entries::burn:
+         {
+            burn_arguments arg;
+            arg.deserialize( rdbuf );
+
+            auto res = burn( arg );
+            res.serialize( buffer );
+            break;
+         }
+         default:
+            return false;
+      }
+
+      return true;
+   }
+
+private:
+   // How one operation touches an account. A plain account is its balance
+   // object. A credit to a sharded account touches one slot, and a debit
+   // touches the balance object and every slot, folding them in.
+   //
+   // With rewards, an account whose balance object is about to change is
+   // settled as it is loaded, and its checkpoint is written with it. Its
+   // balance integral is only read as it is loaded, and brought up to date
+   // when the balance changes. Each slot has its own checkpoint and
+   // integral, brought up to date when the slot is credited and merged into
+   // the account's when it is folded.
+   struct account_access
+   {
+      const std::string*  owner            = nullptr;
+      bool                debit            = false;
+      uint32_t            slots            = 0;      // 0 if not sharded
+      uint32_t            slot             = 0;      // The credited slot
+      std::size_t         index            = 0;      // Balance object, in objects
+      std::size_t         config_index     = 0;      // Shard config, in objects
+      std::size_t         slot_index       = 0;      // Credited or first folded slot, in slots
+      std::size_t         checkpoint_index = 0;      // Reward checkpoint, in objects
+      rewards::checkpoint checkpoint;
+      bool                checkpoint_dirty = false;
+      std::size_t         twab_index       = 0;      // Balance integral, in objects
+      twab::accumulator   twab;
+   };
+
+   // Balance objects, shard configs and reward state are read in one round.
+   // Only when an account turns out to be sharded are its slots read in a
+   // second.
+   //
+   // With a balance checksum, every balance object and slot written adds its
+   // change to the delta of its key's stripe, which store() adds to the
+   // stripe object. A transaction only writes the stripes of the objects it
+   // changes, and reads and unchanged writes touch no stripe at all.
+   // Objects read per slot into balance_batch::slots: the slot, then its
+   // reward checkpoint and its balance integral
+   static constexpr std::size_t slot_checkpoint_offset = 1;
+   static constexpr std::size_t slot_twab_offset       = 1 + ( has_rewards ? 1 : 0 );
+   static constexpr std::size_t slot_stride            = slot_twab_offset + ( has_twab ? 1 : 0 );
+
+   struct stripe_delta
+   {
+      std::size_t     stripe = 0;
+      checksum::state delta;
+   };
+
+   struct balance_batch
+   {
+      object_batch        objects;   // Also queues every write
+      object_batch        slots;
+      std::size_t         pool_index = 0;
+      rewards::pool_state pool;
+      std::vector< stripe_delta > checksum_deltas;
+      uint64_t            now = 0;   // Head block time, with time-weighted balances
+   };
+
+   static void load_accounts( balance_batch& batch, std::initializer_list< account_access* > accounts )
+   {
+      if constexpr ( has_rewards )
+         batch.pool_index = batch.objects.get( reward_pool_space(), supply_key() );
+
+      for ( auto* acc : accounts )
+      {
+         acc->index = batch.objects.get( balance_space(), *acc->owner );
+         if constexpr ( has_shards )
+            acc->config_index = batch.objects.get( shard_config_space(), *acc->owner );
+         if constexpr ( has_rewards )
+            acc->checkpoint_index = batch.objects.get( reward_checkpoint_space(), *acc->owner );
+         if constexpr ( has_twab )
+            acc->twab_index = batch.objects.get( twab_space(), *acc->owner );
+      }
+      batch.objects.load();
+
+      if constexpr ( has_shards )
+      {
+         bool sharded = false;
+         for ( auto* acc : accounts )
+         {
+            acc->slots = slot_count( batch.objects, acc->config_index );
+            if ( !acc->slots )
+               continue;
+
+            sharded = true;
+            if ( acc->debit )
+            {
+               acc->slot_index = get_slot( batch, *acc->owner, 0 );
+               for ( uint32_t s = 1; s < acc->slots; s++ )
+                  get_slot( batch, *acc->owner, s );
+            }
+            else
+            {
+               acc->slot       = transaction_slot( acc->slots );
+               acc->slot_index = get_slot( batch, *acc->owner, acc->slot );
+            }
+         }
+
+         if ( sharded )
+            batch.slots.load();
+      }
+
+      if constexpr ( has_rewards )
+      {
+         decode_reward_object( batch.objects.get_value( batch.pool_index ), batch.pool );
+
+         for ( auto* acc : accounts )
+         {
+            decode_reward_object( batch.objects.get_value( acc->checkpoint_index ), acc->checkpoint );
+
+            // A credit to a sharded account leaves its balance object alone
+            if ( acc->debit || !acc->slots )
+               settle( batch, *acc );
+
+            if ( acc->debit )
+               merge_slot_rewards( batch, *acc );
+         }
+      }
+
+      if constexpr ( has_twab )
+      {
+         batch.now = system::get_head_info().head_block_time();
+         for ( auto* acc : accounts )
+         {
+            if ( acc->debit || !acc->slots )
+               decode_twab( batch.objects.get_value( acc->twab_index ), acc->twab );
+         }
+      }
+   }
+
+   // Queues the reads of one slot, returning the index of the first
+   static std::size_t get_slot( balance_batch& batch, const std::string& owner, uint32_t slot )
+   {
+      auto key   = slot_key( owner, slot );
+      auto index = batch.slots.get( shard_slot_space(), key );
+      if constexpr ( has_rewards )
+         batch.slots.get( shard_checkpoint_space(), key );
+      if constexpr ( has_twab )
+         batch.slots.get( shard_twab_space(), key );
+      return index;
+   }
+
+   // Brings an account's checkpoint up to the pool's accumulator. The pool
+   // itself never earns.
+   static void settle( const balance_batch& batch, account_access& acc )
+   {
+      if ( *acc.owner == pool_owner() || acc.checkpoint.reward_per_token_paid == batch.pool.reward_per_token )
+         return;
+
+      balance_object bal_obj;
+      batch.objects.get_object( acc.index, bal_obj );
+
+      acc.checkpoint       = rewards::settle( acc.checkpoint, balance_value( bal_obj ), batch.pool );
+      acc.checkpoint_dirty = true;
+   }
+
+   // Settles a debited account's slots and adds their rewards to its
+   // checkpoint. store_debited clears the slots' checkpoints.
+   static void merge_slot_rewards( const balance_batch& batch, account_access& acc )
+   {
+      for ( uint32_t s = 0; s < acc.slots; s++ )
+      {
+         auto index = acc.slot_index + s * slot_stride;
+
+         contracts::token::balance_object slot;
+         batch.slots.get_object( index, slot );
+
+         rewards::checkpoint cp;
+         decode_reward_object( batch.slots.get_value( index + slot_checkpoint_offset ), cp );
+         cp = rewards::settle( cp, slot.value(), batch.pool );
+
+         if ( cp.pending || cp.fraction )
+         {
+            acc.checkpoint       = rewards::merge( acc.checkpoint, cp );
+            acc.checkpoint_dirty = true;
+         }
+      }
+   }
+
+   static void put_checkpoint( balance_batch& batch, const system::object_space& space, const std::string& key, const rewards::checkpoint& cp )
+   {
+      std::string bytes( rewards::encoded_size, '\0' );
+      rewards::encode( cp, reinterpret_cast< uint8_t* >( bytes.data() ) );
+      batch.objects.put_value( space, key, std::move( bytes ) );
+   }
+
+   static void store_checkpoint( balance_batch& batch, account_access& acc )
+   {
+      if ( !acc.checkpoint_dirty )
+         return;
+
+      put_checkpoint( batch, reward_checkpoint_space(), *acc.owner, acc.checkpoint );
+      acc.checkpoint_dirty = false;
+   }
+
+   static void store_pool( balance_batch& batch )
+   {
+      std::string bytes( rewards::encoded_size, '\0' );
+      rewards::encode( batch.pool, reinterpret_cast< uint8_t* >( bytes.data() ) );
+      batch.objects.put_value( reward_pool_space(), supply_key(), std::move( bytes ) );
+   }
+
+   // The integrals of a debited account's slots up to now
+   static uint128 slot_integrals( const balance_batch& batch, const account_access& acc )
+   {
+      uint128 total;
+      for ( uint32_t s = 0; s < acc.slots; s++ )
+      {
+         auto index = acc.slot_index + s * slot_stride;
+
+         contracts::token::balance_object slot;
+         batch.slots.get_object( index, slot );
+
+         twab::accumulator slot_twab;
+         decode_twab( batch.slots.get_value( index + slot_twab_offset ), slot_twab );
+         total += twab::integral( slot_twab, slot.value(), batch.now );
+      }
+      return total;
+   }
+
+   static void put_twab( balance_batch& batch, const system::object_space& space, const std::string& key, const twab::accumulator& acc )
+   {
+      std::string bytes( twab::encoded_size, '\0' );
+      twab::encode( acc, reinterpret_cast< uint8_t* >( bytes.data() ) );
+      batch.objects.put_value( space, key, std::move( bytes ) );
+   }
+
+   // Brings an account's integral up to now before its balance changes from
+   // `balance`. A debited account's integral takes in its slots', which
+   // store_debited clears.
+   static void store_twab( balance_batch& batch, const account_access& acc, uint64_t balance )
+   {
+      auto advanced = twab::advance( acc.twab, balance, batch.now );
+      if ( acc.debit )
+         advanced.cumulative += slot_integrals( batch, acc );
+
+      if ( advanced.last_update != acc.twab.last_update || advanced.cumulative != acc.twab.cumulative )
+         put_twab( batch, twab_space(), *acc.owner, advanced );
+   }
+
+   static void decode_twab( const std::string& bytes, twab::accumulator& acc )
+   {
+      if ( !twab::decode( reinterpret_cast< const uint8_t* >( bytes.data() ), bytes.size(), acc ) )
+         system::fail( "unrecognized object schema version" );
+   }
+
+   template< typename T >
+   static void decode_reward_object( const std::string& bytes, T& obj )
+   {
+      if ( !rewards::decode( reinterpret_cast< const uint8_t* >( bytes.data() ), bytes.size(), obj ) )
+         system::fail( "unrecognized object schema version" );
+   }
+
+   // Spreads writes by transaction, so that one transaction's credits to an
+   // account land in one slot and different transactions' rarely collide.
+   // Checksum stripes are chosen the same way. Outside a transaction, as when
+   // the block reward is minted, there is no id to read and the head block
+   // height is used instead.
+   static uint32_t transaction_slot( uint32_t slots )
+   {
+      // get_transaction_field_arguments { string field = 1; }
+      static constexpr char id_field[] = "\x0a\x02id";
+
+      std::string key;
+      auto& buffer = current_invocation().syscall_buffer();
+      uint32_t bytes_written = 0;
+      if ( invoke_system_call(
+            std::underlying_type_t< chain::system_call_id >( chain::system_call_id::get_transaction_field ),
+            reinterpret_cast< char* >( buffer.data() ),
+            std::size( buffer ),
+            const_cast< char* >( id_field ),
+            sizeof( id_field ) - 1,
+            &bytes_written ) == 0 )
+      {
+         if ( !detail::parse_transaction_id( buffer.data(), bytes_written, key ) )
+            system::fail( "malformed get_transaction_field result" );
+      }
+
+      if ( key.empty() )
+      {
+         auto height = system::get_head_info().get_head_topology().get_height();
+         for ( int i = 0; i < 8; i++ )
+            key.push_back( char( height >> ( 8 * i ) ) );
+      }
+
+      uint32_t h = 2166136261u;
+      for ( auto c : key )
+      {
+         h ^= uint8_t( c );
+         h *= 16777619u;
+      }
+
+      return h % slots;
+   }
+
+   // The slot count in a shard config read into batch, 0 if not sharded
+   static uint32_t slot_count( const object_batch& batch, std::size_t config_index )
+   {
+      contracts::token::balance_object config;
+      batch.get_object( config_index, config );
+      return config.value() >= 2 ? uint32_t( std::min< uint64_t >( config.value(), shard_policy::max_slots ) ) : 0;
+   }
+
+   // Reads owner's balance object into bal_obj and returns the credits
+   // waiting in its slots, without the reward and integral state that
+   // load_accounts reads for a debit. The balance object is queued in batch
+   // so that it can be written back with it.
+   static uint64_t load_balance( object_batch& batch, const std::string& owner, balance_object& bal_obj )
+   {
+      auto index = batch.get( balance_space(), owner );
+      std::size_t config_index = 0;
+      if constexpr ( has_shards )
+         config_index = batch.get( shard_config_space(), owner );
+      batch.load();
+      batch.get_object( index, bal_obj );
+
+      uint64_t credits = 0;
+      if constexpr ( has_shards )
+      {
+         auto slots = slot_count( batch, config_index );
+         if ( !slots )
+            return 0;
+
+         object_batch slot_batch;
+         for ( uint32_t s = 0; s < slots; s++ )
+            slot_batch.get( shard_slot_space(), slot_key( owner, s ) );
+         slot_batch.load();
+
+         for ( uint32_t s = 0; s < slots; s++ )
+         {
+            contracts::token::balance_object slot;
+            slot_batch.get_object( s, slot );
+            credits += slot.value();
+         }
+      }
+
+      return credits;
+   }
+
+   // Folds slot credits into a balance object. Mana is regenerated before
+   // the credits are added, as a credit would.
+   static void add_credits( balance_object& bal_obj, uint64_t credits )
+   {
+      if ( !credits )
+         return;
+
+      if constexpr ( has_mana )
+      {
+         regenerate_mana( bal_obj );
+         bal_obj.set_mana( bal_obj.mana() + credits );
+      }
+
+      set_balance_value( bal_obj, balance_value( bal_obj ) + credits );
+   }
+
+   // A debited account's balance object with its slots folded in
+   static balance_object load_debited( const balance_batch& batch, const account_access& acc )
+   {
+      balance_object bal_obj;
+      batch.objects.get_object( acc.index, bal_obj );
+
+      if constexpr ( has_shards )
+      {
+         uint64_t credits = 0;
+         for ( uint32_t s = 0; s < acc.slots; s++ )
+         {
+            contracts::token::balance_object slot;
+            batch.slots.get_object( acc.slot_index + s * slot_stride, slot );
+            credits += slot.value();
+         }
+
+         add_credits( bal_obj, credits );
+      }
+
+      return bal_obj;
+   }
+
+   // Writes a debited account's balance object and empties the slots that
+   // load_debited folded into it, with their checkpoints
+   static void store_debited( balance_batch& batch, account_access& acc, const balance_object& bal_obj )
+   {
+      balance_object old_obj;
+      batch.objects.get_object( acc.index, old_obj );
+
+      if constexpr ( has_checksum )
+         update_checksum( batch, balance_id, *acc.owner, balance_value( old_obj ), balance_value( bal_obj ) );
+
+      batch.objects.put_object( balance_space(), *acc.owner, bal_obj );
+
+      // Settling and advancing are exact at any later time while the balance
+      // stays the same, so they are only written when it changes
+      if ( balance_value( old_obj ) != balance_value( bal_obj ) )
+      {
+         if constexpr ( has_rewards )
+            store_checkpoint( batch, acc );
+
+         if constexpr ( has_twab )
+            store_twab( batch, acc, balance_value( old_obj ) );
+      }
+
+      if constexpr ( has_shards )
+      {
+         for ( uint32_t s = 0; s < acc.slots; s++ )
+         {
+            contracts::token::balance_object slot;
+            if ( batch.slots.get_object( acc.slot_index + s * slot_stride, slot ) && slot.value() )
+            {
+               auto key = slot_key( *acc.owner, s );
+
+               if constexpr ( has_checksum )
+                  update_checksum( batch, shard_slot_id, key, slot.value(), 0 );
+
+               batch.objects.put_object( shard_slot_space(), key, contracts::token::balance_object() );
+
+               // A slot only earns and accumulates while it holds credits,
+               // so an empty one has nothing left in either
+               if constexpr ( has_rewards )
+                  batch.objects.put_value( shard_checkpoint_space(), key, std::string() );
+
+               if constexpr ( has_twab )
+                  batch.objects.put_value( shard_twab_space(), key, std::string() );
+            }
+         }
+      }
+   }
+
+   // Whether account authorized this call: it is the caller, enough of its
+   // multisig signers signed the transaction, or its authority approves
+   static bool authorized( const std::string& account )
+   {
+      const auto [ caller, privilege ] = system::get_caller();
+      if ( caller == account )
+         return true;
+
+      if constexpr ( has_multisig )
+      {
+         if ( multisig_authorized( account ) )
+            return true;
+      }
+
+      return check_authority( account, get_arguments() );
+   }
+
+   // Counts the record's signers among the transaction's signatures. A
+   // transaction too large to read here falls back to the authority.
+   static bool multisig_authorized( const std::string& account )
+   {
+      multisig::record r;
+      if ( !load_multisig( account, r ) )
+         return false;
+
+      auto& buffer = current_invocation().syscall_buffer();
+      uint32_t bytes_written = 0;
+      if ( invoke_system_call(
+            std::underlying_type_t< chain::system_call_id >( chain::system_call_id::get_transaction ),
+            reinterpret_cast< char* >( buffer.data() ),
+            std::size( buffer ),
+            nullptr,
+            0,
+            &bytes_written ) )
+         return false;
+
+      std::string id;
+      std::vector< std::string > signatures;
+      if ( !detail::parse_transaction_signatures( buffer.data(), bytes_written, id, signatures ) )
+         system::fail( "malformed get_transaction result" );
+
+      std::vector< bool > signed_by( r.signers.size(), false );
+      uint32_t approvals = 0;
+      for ( const auto& signature : signatures )
+      {
+         auto key = system::recover_public_key( signature, id );
+         if ( key.empty() )
+            continue;
+
+         std::size_t index;
+         if ( !multisig::find_signer( r, koinos::address_from_public_key( key ), index ) || signed_by[index] )
+            continue;
+
+         signed_by[index] = true;
+         if ( ++approvals == r.threshold )
+            return true;
+      }
+
+      return false;
+   }
+
+   static bool load_multisig( const std::string& owner, multisig::record& r )
+   {
+      r = multisig::record();
+
+      object_batch batch;
+      auto index = batch.get( multisig_space(), owner );
+      batch.load();
+
+      const auto& bytes = batch.get_value( index );
+      if ( bytes.empty() )
+         return false;
+
+      if ( !multisig::decode( bytes, r ) )
+         system::fail( "unrecognized object schema version" );
+
+      return true;
+   }
+
+   static void check_transfer( const std::string& from, const std::string& to )
+   {
+      if ( from == to )
+         system::fail( "cannot transfer to self" );
+
+      if constexpr ( has_pool )
+      {
+         if ( from == pool_owner() )
+            system::fail( "cannot transfer from the pool" );
+      }
+   }
+
+   // Moves value, and with mana as much mana, from `from` to `to`
+   static void move( const std::string& from, const std::string& to, uint64_t value )
+   {
+      account_access from_acc{ &from, true };
+      account_access to_acc{ &to, false };
+      balance_batch batch;
+      load_accounts( batch, { &from_acc, &to_acc } );
+
+      auto from_bal_obj = load_debited( batch, from_acc );
+
+      debit( from_bal_obj, value, "account 'from' has insufficient mana for transfer" );
+
+      store_debited( batch, from_acc, from_bal_obj );
+      credit( batch, to_acc, value );
+      store( batch );
+
+      emit_transfer( from, to, value );
+   }
+
+   // The id in the { bytes id = 1; } arguments of the stream entries
+   template< typename Arguments >
+   static std::string decode_stream_id( const argument_view& args )
+   {
+      return bytes_string( decode_arguments< Arguments >( args, "malformed stream arguments" ).get_id() );
+   }
+
+   static stream::stream_state load_stream( const std::string& id )
+   {
+      object_batch batch;
+      auto stream_index = batch.get( stream_space(), id );
+      batch.load();
+
+      const auto& bytes = batch.get_value( stream_index );
+      if ( bytes.empty() )
+         system::fail( "stream does not exist" );
+
+      stream::stream_state s;
+      if ( !stream::decode( bytes, s ) )
+         system::fail( "unrecognized object schema version" );
+
+      return s;
+   }
+
+   // Pays out of a stream's deposit: `paid` to the recipient and `refund` to
+   // the sender. A stream with nothing left, or any refund, is removed.
+   static void pay_stream( const std::string& id, const stream::stream_state& s, uint64_t paid, uint64_t refund )
+   {
+      const auto& pool = pool_owner();
+
+      account_access to_acc{ &s.to, false };
+      account_access from_acc{ &s.from, false };
+      account_access pool_acc{ &pool, true };
+      balance_batch batch;
+      load_accounts( batch, { &to_acc, &from_acc, &pool_acc } );
+
+      debit_pool( batch, pool_acc, paid + refund );
+      if ( paid )
+         credit( batch, to_acc, paid );
+      if ( refund )
+         credit( batch, from_acc, refund );
+
+      uint64_t deposit;
+      stream::deposit( s.rate, s.start, s.stop, deposit );
+      bool done = refund || s.withdrawn == deposit;
+      if ( !done )
+         batch.objects.put_value( stream_space(), id, stream::encode( s ) );
+
+      store( batch );
+
+      if ( done )
+         system::remove_object( stream_space(), id );
+
+      if ( paid )
+         emit_transfer( pool, s.to, paid );
+      if ( refund )
+         emit_transfer( pool, s.from, refund );
+   }
+
+   // Takes value and, with mana, as much mana from a debited account
+   static void debit( balance_object& bal_obj, uint64_t value, const char* mana_error )
+   {
+      if ( balance_value( bal_obj ) < value )
+         system::fail( "account 'from' has insufficient balance" );
+
+      if constexpr ( has_mana )
+      {
+         regenerate_mana( bal_obj );
+
+         if ( bal_obj.mana() < value )
+            system::fail( mana_error );
+
+         bal_obj.set_mana( bal_obj.mana() - value );
+      }
+
+      set_balance_value( bal_obj, balance_value( bal_obj ) - value );
+   }
+
+   // Pays value out of the pool. The pool's mana is not charged, only kept
+   // within its balance.
+   static void debit_pool( balance_batch& batch, account_access& pool_acc, uint64_t value )
+   {
+      auto pool_bal_obj = load_debited( batch, pool_acc );
+      if ( balance_value( pool_bal_obj ) < value )
+         system::fail( "pool has insufficient balance" );
+
+      set_balance_value( pool_bal_obj, balance_value( pool_bal_obj ) - value );
+      if constexpr ( has_mana )
+         pool_bal_obj.set_mana( std::min( pool_bal_obj.mana(), balance_value( pool_bal_obj ) ) );
+
+      store_debited( batch, pool_acc, pool_bal_obj );
+   }
+
+   // Credits a plain account's balance object and mana, or a sharded
+   // account's slot
+   static void credit( balance_batch& batch, account_access& acc, uint64_t value )
+   {
+      if constexpr ( has_rewards )
+         store_checkpoint( batch, acc );
+
+      if constexpr ( has_shards )
+      {
+         if ( acc.slots )
+         {
+            auto key = slot_key( *acc.owner, acc.slot );
+
+            contracts::token::balance_object slot;
+            batch.slots.get_object( acc.slot_index, slot );
+
+            // The slot earns on what it held until now
+            if constexpr ( has_rewards )
+            {
+               rewards::checkpoint cp;
+               decode_reward_object( batch.slots.get_value( acc.slot_index + slot_checkpoint_offset ), cp );
+               if ( cp.reward_per_token_paid != batch.pool.reward_per_token )
+                  put_checkpoint( batch, shard_checkpoint_space(), key, rewards::settle( cp, slot.value(), batch.pool ) );
+            }
+
+            if constexpr ( has_twab )
+            {
+               twab::accumulator slot_twab;
+               decode_twab( batch.slots.get_value( acc.slot_index + slot_twab_offset ), slot_twab );
+               if ( slot_twab.last_update < batch.now )
+                  put_twab( batch, shard_twab_space(), key, twab::advance( slot_twab, slot.value(), batch.now ) );
+            }
+
+            if constexpr ( has_checksum )
+               update_checksum( batch, shard_slot_id, key, slot.value(), slot.value() + value );
+
+            slot.set_value( slot.value() + value );
+            batch.objects.put_object( shard_slot_space(), key, slot );
+            return;
+         }
+      }
+
+      balance_object bal_obj;
+      batch.objects.get_object( acc.index, bal_obj );
+
+      if constexpr ( has_twab )
+      {
+         if ( value )
+            store_twab( batch, acc, balance_value( bal_obj ) );
+      }
+
+      if constexpr ( has_mana )
+      {
+         regenerate_mana( bal_obj );
+         bal_obj.set_mana( bal_obj.mana() + value );
+      }
+
+      if constexpr ( has_checksum )
+         update_checksum( batch, balance_id, *acc.owner, balance_value( bal_obj ), balance_value( bal_obj ) + value );
+
+      set_balance_value( bal_obj, balance_value( bal_obj ) + value );
+      batch.objects.put_object( balance_space(), *acc.owner, bal_obj );
+   }
+
+   // Replaces an object's value in the checksum change of its key's stripe
+   static void update_checksum( balance_batch& batch, uint32_t space_id, const std::string& key, uint64_t old_value, uint64_t new_value )
+   {
+      if ( old_value == new_value )
+         return;
+
+      auto h      = checksum::key_hash( space_id, key );
+      auto weight = checksum::weight( h );
+      auto stripe = checksum::stripe( h, checksum_policy::stripes );
+
+      auto it = std::find_if( batch.checksum_deltas.begin(), batch.checksum_deltas.end(), [&]( const stripe_delta& d ) { return d.stripe == stripe; } );
+      if ( it == batch.checksum_deltas.end() )
+         it = batch.checksum_deltas.insert( it, stripe_delta{ stripe, checksum::state() } );
+
+      checksum::remove( it->delta, old_value, weight );
+      checksum::add( it->delta, new_value, weight );
+   }
+
+   // Writes everything queued, adding the checksum changes to their stripes
+   static void store( balance_batch& batch )
+   {
+      if constexpr ( has_checksum )
+      {
+         auto& deltas = batch.checksum_deltas;
+         deltas.erase( std::remove_if( deltas.begin(), deltas.end(), []( const stripe_delta& d ) { return checksum::empty( d.delta ); } ), deltas.end() );
+
+         if ( !deltas.empty() )
+         {
+            object_batch stripe_batch;
+            for ( const auto& d : deltas )
+               stripe_batch.get( checksum_space(), std::string( 1, char( d.stripe ) ) );
+            stripe_batch.load();
+
+            for ( std::size_t i = 0; i < deltas.size(); i++ )
+            {
+               checksum::state stripe;
+               decode_checksum( stripe_batch.get_value( i ), stripe );
+               checksum::combine( stripe, deltas[i].delta );
+
+               std::string bytes( checksum::encoded_size, '\0' );
+               checksum::encode( stripe, reinterpret_cast< uint8_t* >( bytes.data() ) );
+               batch.objects.put_value( checksum_space(), std::string( 1, char( deltas[i].stripe ) ), std::move( bytes ) );
+            }
+            deltas.clear();
+         }
+      }
+
+      batch.objects.store();
+   }
+
+   // Queues and loads the supply, the checksum seed and every stripe, and
+   // adds up the seed and stripes. Returns the index of the seed.
+   static std::size_t load_checksum( object_batch& batch, uint64_t& supply, checksum::state& total )
+   {
+      auto supply_index = batch.get( supply_space(), supply_key() );
+      auto seed_index   = batch.get( checksum_space(), checksum_seed_key() );
+      for ( uint32_t s = 0; s < checksum_policy::stripes; s++ )
+         batch.get( checksum_space(), std::string( 1, char( s ) ) );
+      batch.load();
+
+      total = checksum::state();
+      for ( uint32_t s = 0; s <= checksum_policy::stripes; s++ )
+      {
+         checksum::state part;
+         decode_checksum( batch.get_value( seed_index + s ), part );
+         checksum::combine( total, part );
+      }
+
+      contracts::token::balance_object supply_obj;
+      batch.get_object( supply_index, supply_obj );
+      supply = supply_obj.value();
+
+      return seed_index;
+   }
+
+   static void decode_checksum( const std::string& bytes, checksum::state& s )
+   {
+      if ( !checksum::decode( reinterpret_cast< const uint8_t* >( bytes.data() ), bytes.size(), s ) )
+         system::fail( "unrecognized object schema version" );
+   }
+
+   static void emit_transfer( const std::string& from, const std::string& to, uint64_t value )
+   {
+      contracts::token::transfer_event< max_address_size, max_address_size > transfer_event;
+      transfer_event.mutable_from().set( reinterpret_cast< const uint8_t* >( from.data() ), from.size() );
+      transfer_event.mutable_to().set( reinterpret_cast< const uint8_t* >( to.data() ), to.size() );
+      transfer_event.set_value( value );
+
+      std::vector< std::string > impacted;
+      impacted.push_back( to );
+      impacted.push_back( from );
+      system::event( "koinos.contracts.token.transfer_event", transfer_event, impacted );
+   }
+
+   // sha256 through the hash system call, without the multihash prefix
+   static merkle::digest hash_digest( const std::string& message )
+   {
+      constexpr uint64_t sha256_id = 0x12;
+
+      auto multihash = system::hash( sha256_id, message );
+      if ( multihash.size() != 2 + merkle::digest_size )
+         system::fail( "unexpected hash size" );
+
+      merkle::digest d;
+      std::copy( multihash.begin() + 2, multihash.end(), d.begin() );
+      return d;
+   }
+
+   static const std::string& contract_id_str()
+   {
+      return current_invocation().contract_id();
+   }
+
+   // koin::mana_balance_object and token::balance_object name the balance
+   // field differently.
+   static uint64_t balance_value( const balance_object& bal )
+   {
+      if constexpr ( has_mana )
+         return bal.balance();
+      else
+         return bal.value();
+   }
+
+   static void set_balance_value( balance_object& bal, uint64_t value )
+   {
+      if constexpr ( has_mana )
+         bal.set_balance( value );
+      else
+         bal.set_value( value );
+   }
+};
+
+} // koinos::system_contracts
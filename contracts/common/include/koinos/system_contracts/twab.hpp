@@ -0,0 +1,98 @@
+#pragma once
+
+#include <koinos/system_contracts/fixed_layout.hpp>
+#include <koinos/system_contracts/schema.hpp>
+#include <koinos/system_contracts/uint.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+// Time-weighted balances.
+//
+// Each account carries the integral of its balance over time, in token units
+// times milliseconds. The integral is brought up to date lazily, like mana,
+// whenever the balance is about to change, so at any time t it is
+//
+//    cumulative + balance * ( t - last_update )
+//
+// and the average balance over [t1, t2] is the difference of two readings
+// divided by t2 - t1. Only differences are meaningful. An account without an
+// accumulator is read as having held its balance since time zero, which is
+// exact for any interval after the accumulator was introduced.
+//
+// The integral is 128 bits and wraps, so a difference is right as long as
+// the true difference fits, which it always does for a 64-bit balance over
+// any realistic interval.
+namespace koinos::system_contracts::twab {
+
+struct accumulator
+{
+   uint128  cumulative;         // Balance x ms up to last_update
+   uint64_t last_update = 0;    // ms
+};
+
+constexpr uint128 integral( const accumulator& acc, uint64_t balance, uint64_t now )
+{
+   auto elapsed = now > acc.last_update ? now - acc.last_update : 0;
+   return acc.cumulative + uint128( balance ) * elapsed;
+}
+
+// Brings the integral up to now. Call with the balance held before any change.
+constexpr accumulator advance( accumulator acc, uint64_t balance, uint64_t now )
+{
+   if ( now > acc.last_update )
+   {
+      acc.cumulative  = integral( acc, balance, now );
+      acc.last_update = now;
+   }
+   return acc;
+}
+
+// Stored little endian, the integral low limb first:
+//
+//    0x00 0x01 cumulative(16) last_update(8)
+//
+// A missing object decodes as zero.
+constexpr std::size_t encoded_size = 2 + 16 + 8;
+
+constexpr void encode( const accumulator& acc, uint8_t* out )
+{
+   out[0] = envelope_tag;
+   out[1] = fixed_layout_version;
+   fixed_layout::put_u64( out + 2, acc.cumulative.limb( 0 ) );
+   fixed_layout::put_u64( out + 10, acc.cumulative.limb( 1 ) );
+   fixed_layout::put_u64( out + 18, acc.last_update );
+}
+
+constexpr bool decode( const uint8_t* data, std::size_t len, accumulator& acc )
+{
+   acc = accumulator();
+
+   if ( !len )
+      return true;
+
+   if ( len != encoded_size || data[0] != envelope_tag || data[1] != fixed_layout_version )
+      return false;
+
+   acc.cumulative  = ( uint128( fixed_layout::get_u64( data + 10 ) ) << 64 ) | fixed_layout::get_u64( data + 2 );
+   acc.last_update = fixed_layout::get_u64( data + 18 );
+   return true;
+}
+
+namespace detail {
+
+constexpr uint64_t example_average()
+{
+   // 100 held from 1000 to 3000, then 400 until 4000: 200 on average
+   accumulator acc;
+   acc = advance( acc, 100, 1000 );
+   auto start = integral( acc, 100, 1000 );
+   acc = advance( acc, 100, 3000 );
+   return ( ( integral( acc, 400, 4000 ) - start ) / 3000 ).convert_to< uint64_t >();
+}
+
+} // detail
+
+static_assert( detail::example_average() == 200 );
+
+} // koinos::system_contracts::twab
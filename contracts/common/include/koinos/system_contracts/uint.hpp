@@ -0,0 +1,513 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Fixed-width unsigned integers for contract math.
+//
+// basic_uint< N > is an N x 64-bit limb integer with modular (wrapping)
+// arithmetic, matching boost's unchecked uint128_t/uint256_t. Everything is
+// constexpr and allocation free. The two primitives the rest is built on,
+// 64x64->128 multiply and 128/64 divide, use unsigned __int128 on 64-bit
+// hosts and a 32-bit split on wasm32, where __int128 lowers to generic
+// compiler-rt calls.
+
+#if defined( __SIZEOF_INT128__ ) && !defined( __wasm__ )
+#define KOINOS_UINT_HAS_INT128 1
+#endif
+
+namespace koinos::system_contracts {
+
+namespace detail {
+
+[[noreturn]] inline void uint_division_by_zero()
+{
+   __builtin_trap();
+}
+
+constexpr int count_leading_zeros( uint64_t x )
+{
+   if ( x == 0 )
+      return 64;
+
+   int n = 0;
+   if ( !( x & 0xFFFFFFFF00000000ull ) ) { n += 32; x <<= 32; }
+   if ( !( x & 0xFFFF000000000000ull ) ) { n += 16; x <<= 16; }
+   if ( !( x & 0xFF00000000000000ull ) ) { n += 8;  x <<= 8;  }
+   if ( !( x & 0xF000000000000000ull ) ) { n += 4;  x <<= 4;  }
+   if ( !( x & 0xC000000000000000ull ) ) { n += 2;  x <<= 2;  }
+   if ( !( x & 0x8000000000000000ull ) ) { n += 1; }
+   return n;
+}
+
+// Returns the low 64 bits of a * b and stores the high 64 bits in hi.
+constexpr uint64_t mul_wide( uint64_t a, uint64_t b, uint64_t& hi )
+{
+#ifdef KOINOS_UINT_HAS_INT128
+   unsigned __int128 p = static_cast< unsigned __int128 >( a ) * b;
+   hi = uint64_t( p >> 64 );
+   return uint64_t( p );
+#else
+   uint64_t a_lo = a & 0xFFFFFFFF, a_hi = a >> 32;
+   uint64_t b_lo = b & 0xFFFFFFFF, b_hi = b >> 32;
+
+   uint64_t lo_lo = a_lo * b_lo;
+   uint64_t hi_lo = a_hi * b_lo;
+   uint64_t lo_hi = a_lo * b_hi;
+   uint64_t hi_hi = a_hi * b_hi;
+
+   uint64_t cross = ( lo_lo >> 32 ) + ( hi_lo & 0xFFFFFFFF ) + lo_hi;
+   hi = hi_hi + ( hi_lo >> 32 ) + ( cross >> 32 );
+   return ( cross << 32 ) | ( lo_lo & 0xFFFFFFFF );
+#endif
+}
+
+constexpr uint64_t mulhi( uint64_t a, uint64_t b )
+{
+   uint64_t hi = 0;
+   mul_wide( a, b, hi );
+   return hi;
+}
+
+// Divides hi:lo by d, storing the remainder in rem. Requires hi < d so the
+// quotient fits in 64 bits.
+constexpr uint64_t div_wide( uint64_t hi, uint64_t lo, uint64_t d, uint64_t& rem )
+{
+#ifdef KOINOS_UINT_HAS_INT128
+   unsigned __int128 n = ( static_cast< unsigned __int128 >( hi ) << 64 ) | lo;
+   rem = uint64_t( n % d );
+   return uint64_t( n / d );
+#else
+   // Hacker's Delight divlu: two 64/32 steps on the normalized divisor.
+   constexpr uint64_t b = 1ull << 32;
+
+   int s = count_leading_zeros( d );
+   d <<= s;
+   uint64_t vn1 = d >> 32;
+   uint64_t vn0 = d & 0xFFFFFFFF;
+
+   uint64_t un32 = s ? ( hi << s ) | ( lo >> ( 64 - s ) ) : hi;
+   uint64_t un10 = lo << s;
+   uint64_t un1 = un10 >> 32;
+   uint64_t un0 = un10 & 0xFFFFFFFF;
+
+   uint64_t q1 = un32 / vn1;
+   uint64_t rhat = un32 - q1 * vn1;
+   while ( q1 >= b || q1 * vn0 > b * rhat + un1 )
+   {
+      q1--;
+      rhat += vn1;
+      if ( rhat >= b )
+         break;
+   }
+
+   uint64_t un21 = un32 * b + un1 - q1 * d;
+
+   uint64_t q0 = un21 / vn1;
+   rhat = un21 - q0 * vn1;
+   while ( q0 >= b || q0 * vn0 > b * rhat + un0 )
+   {
+      q0--;
+      rhat += vn1;
+      if ( rhat >= b )
+         break;
+   }
+
+   rem = ( un21 * b + un0 - q0 * d ) >> s;
+   return q1 * b + q0;
+#endif
+}
+
+} // detail
+
+template< std::size_t Limbs >
+class basic_uint
+{
+   static_assert( Limbs >= 2 );
+
+public:
+   static constexpr std::size_t limbs = Limbs;
+   static constexpr std::size_t bits  = 64 * Limbs;
+   static constexpr std::size_t bytes = 8 * Limbs;
+
+   constexpr basic_uint() = default;
+   constexpr basic_uint( uint64_t v ) : _limbs{ v } {}
+
+   template< std::size_t M, typename = std::enable_if_t< M != Limbs > >
+   explicit constexpr basic_uint( const basic_uint< M >& o )
+   {
+      for ( std::size_t i = 0; i < Limbs && i < M; i++ )
+         _limbs[i] = o.limb( i );
+   }
+
+   static constexpr basic_uint max()
+   {
+      basic_uint r;
+      for ( auto& l : r._limbs )
+         l = ~uint64_t( 0 );
+      return r;
+   }
+
+   constexpr uint64_t limb( std::size_t i ) const { return _limbs[i]; }
+
+   // Truncates to the low 64 bits, as boost's convert_to does for unchecked
+   // integers.
+   template< typename T >
+   constexpr T convert_to() const
+   {
+      static_assert( std::is_integral_v< T > && sizeof( T ) <= sizeof( uint64_t ) );
+      return T( _limbs[0] );
+   }
+
+   explicit constexpr operator bool() const
+   {
+      for ( auto l : _limbs )
+         if ( l )
+            return true;
+      return false;
+   }
+
+   // Big-endian, exactly `bytes` bytes, zero padded.
+   constexpr void to_big_endian( uint8_t* out ) const
+   {
+      for ( std::size_t i = 0; i < bytes; i++ )
+         out[bytes - 1 - i] = uint8_t( _limbs[i / 8] >> ( 8 * ( i % 8 ) ) );
+   }
+
+   static constexpr basic_uint from_big_endian( const uint8_t* in )
+   {
+      basic_uint r;
+      for ( std::size_t i = 0; i < bytes; i++ )
+         r._limbs[i / 8] |= uint64_t( in[bytes - 1 - i] ) << ( 8 * ( i % 8 ) );
+      return r;
+   }
+
+   // Comparison
+
+   friend constexpr bool operator ==( const basic_uint& a, const basic_uint& b )
+   {
+      for ( std::size_t i = 0; i < Limbs; i++ )
+         if ( a._limbs[i] != b._limbs[i] )
+            return false;
+      return true;
+   }
+
+   friend constexpr bool operator !=( const basic_uint& a, const basic_uint& b ) { return !( a == b ); }
+
+   friend constexpr bool operator <( const basic_uint& a, const basic_uint& b )
+   {
+      for ( std::size_t i = Limbs; i-- > 0; )
+         if ( a._limbs[i] != b._limbs[i] )
+            return a._limbs[i] < b._limbs[i];
+      return false;
+   }
+
+   friend constexpr bool operator >( const basic_uint& a, const basic_uint& b )  { return b < a; }
+   friend constexpr bool operator <=( const basic_uint& a, const basic_uint& b ) { return !( b < a ); }
+   friend constexpr bool operator >=( const basic_uint& a, const basic_uint& b ) { return !( a < b ); }
+
+   // Bitwise
+
+   friend constexpr basic_uint operator ~( const basic_uint& a )
+   {
+      basic_uint r;
+      for ( std::size_t i = 0; i < Limbs; i++ )
+         r._limbs[i] = ~a._limbs[i];
+      return r;
+   }
+
+   friend constexpr basic_uint operator &( basic_uint a, const basic_uint& b ) { return a &= b; }
+   friend constexpr basic_uint operator |( basic_uint a, const basic_uint& b ) { return a |= b; }
+   friend constexpr basic_uint operator ^( basic_uint a, const basic_uint& b ) { return a ^= b; }
+
+   constexpr basic_uint& operator &=( const basic_uint& b )
+   {
+      for ( std::size_t i = 0; i < Limbs; i++ )
+         _limbs[i] &= b._limbs[i];
+      return *this;
+   }
+
+   constexpr basic_uint& operator |=( const basic_uint& b )
+   {
+      for ( std::size_t i = 0; i < Limbs; i++ )
+         _limbs[i] |= b._limbs[i];
+      return *this;
+   }
+
+   constexpr basic_uint& operator ^=( const basic_uint& b )
+   {
+      for ( std::size_t i = 0; i < Limbs; i++ )
+         _limbs[i] ^= b._limbs[i];
+      return *this;
+   }
+
+   // Shifts of `bits` or more yield zero.
+
+   constexpr basic_uint& operator <<=( std::size_t n )
+   {
+      if ( n >= bits )
+         return *this = basic_uint();
+
+      std::size_t words = n / 64, shift = n % 64;
+      for ( std::size_t i = Limbs; i-- > 0; )
+      {
+         uint64_t v = 0;
+         if ( i >= words )
+         {
+            v = _limbs[i - words] << shift;
+            if ( shift && i > words )
+               v |= _limbs[i - words - 1] >> ( 64 - shift );
+         }
+         _limbs[i] = v;
+      }
+      return *this;
+   }
+
+   constexpr basic_uint& operator >>=( std::size_t n )
+   {
+      if ( n >= bits )
+         return *this = basic_uint();
+
+      std::size_t words = n / 64, shift = n % 64;
+      for ( std::size_t i = 0; i < Limbs; i++ )
+      {
+         uint64_t v = 0;
+         if ( i + words < Limbs )
+         {
+            v = _limbs[i + words] >> shift;
+            if ( shift && i + words + 1 < Limbs )
+               v |= _limbs[i + words + 1] << ( 64 - shift );
+         }
+         _limbs[i] = v;
+      }
+      return *this;
+   }
+
+   friend constexpr basic_uint operator <<( basic_uint a, std::size_t n ) { return a <<= n; }
+   friend constexpr basic_uint operator >>( basic_uint a, std::size_t n ) { return a >>= n; }
+
+   // Arithmetic, modulo 2^bits
+
+   constexpr basic_uint& operator +=( const basic_uint& b )
+   {
+      uint64_t carry = 0;
+      for ( std::size_t i = 0; i < Limbs; i++ )
+      {
+         uint64_t s = _limbs[i] + carry;
+         carry = s < carry;
+         _limbs[i] = s + b._limbs[i];
+         carry += _limbs[i] < s;
+      }
+      return *this;
+   }
+
+   constexpr basic_uint& operator -=( const basic_uint& b )
+   {
+      uint64_t borrow = 0;
+      for ( std::size_t i = 0; i < Limbs; i++ )
+      {
+         uint64_t d = _limbs[i] - b._limbs[i];
+         uint64_t next = _limbs[i] < b._limbs[i];
+         next |= d < borrow;
+         _limbs[i] = d - borrow;
+         borrow = next;
+      }
+      return *this;
+   }
+
+   constexpr basic_uint& operator *=( const basic_uint& b ) { return *this = *this * b; }
+   constexpr basic_uint& operator /=( const basic_uint& b ) { return *this = *this / b; }
+   constexpr basic_uint& operator %=( const basic_uint& b ) { return *this = *this % b; }
+
+   friend constexpr basic_uint operator +( basic_uint a, const basic_uint& b ) { return a += b; }
+   friend constexpr basic_uint operator -( basic_uint a, const basic_uint& b ) { return a -= b; }
+
+   friend constexpr basic_uint operator *( const basic_uint& a, const basic_uint& b )
+   {
+      basic_uint r;
+      for ( std::size_t i = 0; i < Limbs; i++ )
+      {
+         if ( !a._limbs[i] )
+            continue;
+
+         uint64_t carry = 0;
+         for ( std::size_t j = 0; i + j < Limbs; j++ )
+         {
+            uint64_t hi = 0;
+            uint64_t lo = detail::mul_wide( a._limbs[i], b._limbs[j], hi );
+            lo += carry;
+            hi += lo < carry;
+            r._limbs[i + j] += lo;
+            hi += r._limbs[i + j] < lo;
+            carry = hi;
+         }
+      }
+      return r;
+   }
+
+   friend constexpr basic_uint operator /( const basic_uint& a, const basic_uint& b )
+   {
+      basic_uint q, r;
+      divmod( a, b, q, r );
+      return q;
+   }
+
+   friend constexpr basic_uint operator %( const basic_uint& a, const basic_uint& b )
+   {
+      basic_uint q, r;
+      divmod( a, b, q, r );
+      return r;
+   }
+
+   // Knuth's algorithm D over 64-bit digits. Division by zero traps.
+   static constexpr void divmod( const basic_uint& u, const basic_uint& v, basic_uint& q, basic_uint& r )
+   {
+      std::size_t n = v.significant_limbs();
+      std::size_t m = u.significant_limbs();
+
+      if ( n == 0 )
+         detail::uint_division_by_zero();
+
+      q = basic_uint();
+      r = basic_uint();
+
+      if ( u < v )
+      {
+         r = u;
+         return;
+      }
+
+      if ( n == 1 )
+      {
+         uint64_t rem = 0;
+         for ( std::size_t i = m; i-- > 0; )
+            q._limbs[i] = detail::div_wide( rem, u._limbs[i], v._limbs[0], rem );
+         r._limbs[0] = rem;
+         return;
+      }
+
+      int s = detail::count_leading_zeros( v._limbs[n - 1] );
+
+      std::array< uint64_t, Limbs > vn{};
+      for ( std::size_t i = n; i-- > 0; )
+         vn[i] = ( v._limbs[i] << s ) | ( s && i ? v._limbs[i - 1] >> ( 64 - s ) : 0 );
+
+      std::array< uint64_t, Limbs + 1 > un{};
+      un[m] = s ? u._limbs[m - 1] >> ( 64 - s ) : 0;
+      for ( std::size_t i = m; i-- > 0; )
+         un[i] = ( u._limbs[i] << s ) | ( s && i ? u._limbs[i - 1] >> ( 64 - s ) : 0 );
+
+      for ( std::size_t j = m - n + 1; j-- > 0; )
+      {
+         uint64_t qhat = 0, rhat = 0;
+         bool rhat_overflow = false;
+
+         if ( un[j + n] >= vn[n - 1] )
+         {
+            qhat = ~uint64_t( 0 );
+            rhat = un[j + n - 1] + vn[n - 1];
+            rhat_overflow = rhat < vn[n - 1];
+         }
+         else
+         {
+            qhat = detail::div_wide( un[j + n], un[j + n - 1], vn[n - 1], rhat );
+         }
+
+         while ( !rhat_overflow )
+         {
+            uint64_t p_hi = 0;
+            uint64_t p_lo = detail::mul_wide( qhat, vn[n - 2], p_hi );
+            if ( p_hi < rhat || ( p_hi == rhat && p_lo <= un[j + n - 2] ) )
+               break;
+
+            qhat--;
+            rhat += vn[n - 1];
+            rhat_overflow = rhat < vn[n - 1];
+         }
+
+         // un[j..j+n] -= qhat * vn
+         uint64_t borrow = 0, carry = 0;
+         for ( std::size_t i = 0; i < n; i++ )
+         {
+            uint64_t p_hi = 0;
+            uint64_t p_lo = detail::mul_wide( qhat, vn[i], p_hi );
+            p_lo += carry;
+            p_hi += p_lo < carry;
+            carry = p_hi;
+
+            uint64_t t = un[i + j] - p_lo;
+            uint64_t b = un[i + j] < p_lo;
+            b |= t < borrow;
+            un[i + j] = t - borrow;
+            borrow = b;
+         }
+
+         uint64_t t = un[j + n] - carry;
+         uint64_t b = un[j + n] < carry;
+         b |= t < borrow;
+         un[j + n] = t - borrow;
+
+         if ( b )
+         {
+            // qhat was one too large, add the divisor back
+            qhat--;
+            uint64_t c = 0;
+            for ( std::size_t i = 0; i < n; i++ )
+            {
+               uint64_t sum = un[i + j] + c;
+               c = sum < c;
+               un[i + j] = sum + vn[i];
+               c += un[i + j] < sum;
+            }
+            un[j + n] += c;
+         }
+
+         q._limbs[j] = qhat;
+      }
+
+      for ( std::size_t i = 0; i < n; i++ )
+         r._limbs[i] = ( un[i] >> s ) | ( s ? un[i + 1] << ( 64 - s ) : 0 );
+   }
+
+private:
+   constexpr std::size_t significant_limbs() const
+   {
+      std::size_t n = Limbs;
+      while ( n > 0 && _limbs[n - 1] == 0 )
+         n--;
+      return n;
+   }
+
+   std::array< uint64_t, Limbs > _limbs{};
+};
+
+using uint128 = basic_uint< 2 >;
+using uint256 = basic_uint< 4 >;
+
+namespace detail {
+
+static_assert( mulhi( ~0ull, ~0ull ) == ~0ull - 1 );
+static_assert( mulhi( 1ull << 32, 1ull << 32 ) == 1 );
+
+constexpr uint64_t div_wide_quotient( uint64_t hi, uint64_t lo, uint64_t d )
+{
+   uint64_t rem = 0;
+   return div_wide( hi, lo, d, rem );
+}
+
+static_assert( div_wide_quotient( 1, 0, 3 ) == 0x5555555555555555ull );
+static_assert( div_wide_quotient( 0xFFFFFFFFFFFFFFFEull, ~0ull, ~0ull ) == ~0ull );
+
+static_assert( uint128( ~0ull ) + 1 == uint128( 1 ) << 64 );
+static_assert( uint128( 0 ) - 1 == uint128::max() );
+static_assert( ( uint128::max() * uint128::max() ) == uint128( 1 ) );
+static_assert( ( ( uint128( 66844 ) << 64 ) / 147989089768795ull ).convert_to< uint64_t >() == 8332061253ull );
+static_assert( uint256::max() / ( 1 << 24 ) == uint256::max() >> 24 );
+static_assert( uint256::max() % ( ( uint256( 1 ) << 192 ) + 1 ) == ( uint256( 1 ) << 192 ) - ( uint256( 1 ) << 64 ) );
+static_assert( ( ( uint256( 3 ) << 200 ) + 7 ) / ( uint256( 3 ) << 100 ) == uint256( 1 ) << 100 );
+
+} // detail
+
+} // koinos::system_contracts
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <koinos/system/system_calls.hpp>
+#include <koinos/system_contracts/schema.hpp>
+#include <koinos/system_contracts/state_schemas.hpp>
+
+#include <string>
+
+namespace koinos::system_contracts {
+
+// Reads an object stored in any version of its schema. Returns false if the
+// object does not exist. Reading never rewrites the object; it is upgraded
+// the next time it is written.
+template< typename T >
+bool get_versioned_object( const system::object_space& space, const std::string& key, T& obj )
+{
+   auto bytes = system::detail::get_object( space, key );
+   if ( !bytes.size() )
+      return false;
+
+   if ( !decode_versioned( reinterpret_cast< const uint8_t* >( bytes.data() ), bytes.size(), obj ) )
+      system::fail( "unrecognized object schema version" );
+
+   return true;
+}
+
+// Writes an object in its schema's write version.
+template< typename T >
+void put_versioned_object( const system::object_space& space, const std::string& key, const T& obj )
+{
+   if constexpr ( schema< T >::write_version == protobuf_version )
+      system::put_object( space, key, obj );
+   else
+      system::detail::put_object( space, key, encode_versioned( obj ) );
+}
+
+} // koinos::system_contracts
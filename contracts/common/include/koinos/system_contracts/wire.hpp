@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Minimal protobuf wire format reader and writer for messages that have no
+// generated EmbeddedProto type. It has no dependencies so that native tools
+// can share it with the contracts.
+namespace koinos::system_contracts::wire {
+
+enum class wire_type : uint8_t
+{
+   varint           = 0,
+   fixed64          = 1,
+   length_delimited = 2,
+   fixed32          = 5
+};
+
+constexpr uint32_t make_tag( uint32_t field, wire_type type )
+{
+   return ( field << 3 ) | uint32_t( type );
+}
+
+constexpr std::size_t varint_size( uint64_t v )
+{
+   std::size_t n = 1;
+   while ( v >= 0x80 )
+   {
+      v >>= 7;
+      n++;
+   }
+   return n;
+}
+
+// Writes a varint at p and returns the position after it
+inline uint8_t* write_varint( uint8_t* p, uint64_t v )
+{
+   while ( v >= 0x80 )
+   {
+      *p++ = uint8_t( v ) | 0x80;
+      v >>= 7;
+   }
+   *p++ = uint8_t( v );
+   return p;
+}
+
+inline void append_varint( std::string& out, uint64_t v )
+{
+   while ( v >= 0x80 )
+   {
+      out.push_back( char( uint8_t( v ) | 0x80 ) );
+      v >>= 7;
+   }
+   out.push_back( char( v ) );
+}
+
+inline void append_uint64( std::string& out, uint32_t field, uint64_t v )
+{
+   append_varint( out, make_tag( field, wire_type::varint ) );
+   append_varint( out, v );
+}
+
+inline void append_bool( std::string& out, uint32_t field, bool v )
+{
+   append_uint64( out, field, v ? 1 : 0 );
+}
+
+inline void append_fixed64( std::string& out, uint32_t field, uint64_t v )
+{
+   append_varint( out, make_tag( field, wire_type::fixed64 ) );
+   for ( std::size_t i = 0; i < sizeof( uint64_t ); i++ )
+      out.push_back( char( uint8_t( v >> ( 8 * i ) ) ) );
+}
+
+inline void append_bytes( std::string& out, uint32_t field, const void* data, std::size_t len )
+{
+   append_varint( out, make_tag( field, wire_type::length_delimited ) );
+   append_varint( out, len );
+   out.append( reinterpret_cast< const char* >( data ), len );
+}
+
+inline void append_bytes( std::string& out, uint32_t field, const std::string& data )
+{
+   append_bytes( out, field, data.data(), data.size() );
+}
+
+class reader
+{
+public:
+   reader( const uint8_t* data, std::size_t len ) : _pos( data ), _end( data + len ) {}
+   reader( const std::string& data ) : reader( reinterpret_cast< const uint8_t* >( data.data() ), data.size() ) {}
+
+   bool eof() const { return _pos == _end; }
+   std::size_t remaining() const { return std::size_t( _end - _pos ); }
+   const uint8_t* position() const { return _pos; }
+
+   bool read_varint( uint64_t& v )
+   {
+      v = 0;
+      for ( uint32_t shift = 0; shift < 64 && _pos != _end; shift += 7 )
+      {
+         uint8_t byte = *_pos++;
+         v |= uint64_t( byte & 0x7f ) << shift;
+         if ( !( byte & 0x80 ) )
+            return true;
+      }
+      return false;
+   }
+
+   bool read_tag( uint32_t& field, wire_type& type )
+   {
+      uint64_t tag;
+      if ( !read_varint( tag ) || tag > UINT32_MAX )
+         return false;
+
+      field = uint32_t( tag >> 3 );
+      type  = wire_type( tag & 0x7 );
+      return field != 0;
+   }
+
+   bool read_fixed64( uint64_t& v )
+   {
+      if ( remaining() < sizeof( uint64_t ) )
+         return false;
+
+      v = 0;
+      for ( std::size_t i = 0; i < sizeof( uint64_t ); i++ )
+         v |= uint64_t( *_pos++ ) << ( 8 * i );
+      return true;
+   }
+
+   bool read_bytes( const uint8_t*& data, std::size_t& len )
+   {
+      uint64_t n;
+      if ( !read_varint( n ) || n > remaining() )
+         return false;
+
+      data = _pos;
+      len  = std::size_t( n );
+      _pos += n;
+      return true;
+   }
+
+   bool read_bytes( std::string& out )
+   {
+      const uint8_t* data;
+      std::size_t len;
+      if ( !read_bytes( data, len ) )
+         return false;
+
+      out.assign( reinterpret_cast< const char* >( data ), len );
+      return true;
+   }
+
+   bool skip( wire_type type )
+   {
+      uint64_t v;
+      const uint8_t* data;
+      std::size_t len;
+
+      switch ( type )
+      {
+         case wire_type::varint:
+            return read_varint( v );
+         case wire_type::fixed64:
+            return read_fixed64( v );
+         case wire_type::length_delimited:
+            return read_bytes( data, len );
+         case wire_type::fixed32:
+            if ( remaining() < sizeof( uint32_t ) )
+               return false;
+            _pos += sizeof( uint32_t );
+            return true;
+         default:
+            return false;
+      }
+   }
+
+private:
+   const uint8_t* _pos;
+   const uint8_t* _end;
+};
+
+} // koinos::system_contracts::wire
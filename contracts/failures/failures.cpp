@@ -1,4 +1,6 @@
 #include <koinos/system/system_calls.hpp>
+#include <koinos/system_contracts/arguments.hpp>
+#include <koinos/system_contracts/result_writer.hpp>
 #include <limits>
 using namespace koinos;
 
@@ -11,12 +13,9 @@ void foo( uint64_t x )
 
 int main()
 {
-   auto [ entry_point, args ] = system::get_arguments();
+   auto entry_point = system_contracts::get_arguments().entry_point;
 
-   std::array< uint8_t, 2048 > retbuf;
-
-   koinos::read_buffer rdbuf( (uint8_t*)args.c_str(), args.size() );
-   koinos::write_buffer buffer( retbuf.data(), retbuf.size() );
+   system_contracts::result_writer buffer;
 
    switch( entry_point )
    {
@@ -71,8 +70,5 @@ int main()
          system::revert( "unknown entry point" );
    }
 
-   system::result r;
-   r.mutable_object().set( buffer.data(), buffer.get_size() );
-
-   system::exit( 0, r );
+   buffer.exit();
 }
@@ -1,15 +1,19 @@
 #include <koinos/contracts.hpp>
+#include <koinos/crypto.hpp>
 #include <koinos/system/system_calls.hpp>
 
 #include <koinos/chain/authority.h>
 #include <koinos/contracts/koin/koin.h>
+#include <koinos/contracts/koin/koin_extensions.h>
 #include <koinos/contracts/token/token.h>
+#include <koinos/system_contracts/arguments.hpp>
+#include <koinos/system_contracts/result_writer.hpp>
+#include <koinos/system_contracts/token.hpp>
 
 #include <koinos/buffer.hpp>
 #include <koinos/common.h>
 
-#include <boost/multiprecision/cpp_int.hpp>
-
+#include <array>
 #include <string>
 
 using namespace koinos;
@@ -17,84 +21,75 @@ using namespace koinos::contracts;
 
 using namespace std::string_literals;
 
-using int128_t = boost::multiprecision::int128_t;
-
 namespace constants {
 
-#ifdef BUILD_FOR_TESTING
-static const std::string koinos_name   = "Test Koin";
-static const std::string koinos_symbol = "tKOIN";
-#else
-static const std::string koinos_name   = "Koin";
-static const std::string koinos_symbol = "KOIN";
-#endif
-constexpr uint32_t koinos_decimals     = 8;
-constexpr uint64_t mana_regen_time_ms  = 432'000'000; // 5 days
-constexpr std::size_t max_address_size = 25;
-constexpr std::size_t max_name_size    = 32;
-constexpr std::size_t max_symbol_size  = 8;
-constexpr std::size_t max_buffer_size  = 2048;
-constexpr uint32_t supply_id           = 0;
-constexpr uint32_t balance_id          = 1;
-std::string supply_key                 = "";
-const auto contract_id                 = system::get_contract_id();
-
-} // constants
-
-namespace state {
-
-namespace detail {
+constexpr uint64_t mana_regen_time_ms    = system_contracts::mana::mana_regen_time_ms;
+constexpr std::size_t max_address_size   = 25;
+constexpr std::size_t max_name_size      = 32;
+constexpr std::size_t max_symbol_size    = 8;
+constexpr uint32_t max_balance_shards    = 16;
+constexpr uint32_t checksum_stripes      = 256;
+constexpr uint32_t max_multisig_signers  = 16;
+constexpr uint64_t sha256_id             = 0x12;
+constexpr std::size_t max_signature_size = 65;
+constexpr std::size_t max_chain_id_size  = 34;   // A sha256 multihash
 
-system::object_space create_supply_space()
-{
-   system::object_space supply_space;
-   supply_space.mutable_zone().set( reinterpret_cast< const uint8_t* >( constants::contract_id.data() ), constants::contract_id.size() );
-   supply_space.set_id( constants::supply_id );
-   supply_space.set_system( true );
-   return supply_space;
-}
-
-system::object_space create_balance_space()
-{
-   system::object_space balance_space;
-   balance_space.mutable_zone().set( reinterpret_cast< const uint8_t* >( constants::contract_id.data() ), constants::contract_id.size() );
-   balance_space.set_id( constants::balance_id );
-   balance_space.set_system( true );
-   return balance_space;
-}
+// transfer_permit_message with every field at its largest
+constexpr std::size_t max_permit_message_size = 4 * 2 + max_chain_id_size + 3 * max_address_size + 3 * 11;
 
-} // detail
-
-const system::object_space& supply_space()
-{
-   static const auto supply_space = detail::create_supply_space();
-   return supply_space;
-}
+} // constants
 
-const system::object_space& balance_space()
+struct koin_traits
 {
-   static const auto balance_space = detail::create_balance_space();
-   return balance_space;
-}
+#ifdef BUILD_FOR_TESTING
+   static constexpr char name[]   = "Test Koin";
+   static constexpr char symbol[] = "tKOIN";
+#else
+   static constexpr char name[]   = "Koin";
+   static constexpr char symbol[] = "KOIN";
+#endif
+   static constexpr uint32_t decimals            = 8;
+   static constexpr std::size_t max_address_size = constants::max_address_size;
+   static constexpr std::size_t max_name_size    = constants::max_name_size;
+   static constexpr std::size_t max_symbol_size  = constants::max_symbol_size;
+
+   using mana_policy     = system_contracts::regenerating_mana< constants::mana_regen_time_ms >;
+   using shard_policy    = system_contracts::balance_shards< constants::max_balance_shards >;
+   using reward_policy   = system_contracts::pro_rata_rewards;
+   using airdrop_policy  = system_contracts::merkle_airdrops;
+   using twab_policy     = system_contracts::time_weighted_balances;
+   using stream_policy   = system_contracts::payment_streams;
+   using checksum_policy = system_contracts::striped_balance_checksum< constants::checksum_stripes >;
+   using multisig_policy = system_contracts::multisig_records< constants::max_multisig_signers >;
+
+   static void check_mint_authority()
+   {
+      const auto [ caller, privilege ] = system::get_caller();
+      if ( privilege != chain::privilege::kernel_mode )
+      {
+#ifdef BUILD_FOR_TESTING
+         if ( !system::check_authority( system::get_contract_id() ) )
+            system::fail( "can only mint token with contract authority", chain::error_code::authorization_failure );
+#else
+         system::fail( "can only mint token from kernel context", chain::error_code::authorization_failure );
+#endif
+      }
+   }
+};
 
-} // state
+using koin_token = system_contracts::token_engine< koin_traits >;
 
 enum entries : uint32_t
 {
-   get_account_rc_entry     = 0x2d464aab,
-   consume_account_rc_entry = 0x80e3f5c9,
-   name_entry               = 0x82a3537f,
-   symbol_entry             = 0xb76a7ca1,
-   decimals_entry           = 0xee80fd2f,
-   total_supply_entry       = 0xb0da3934,
-   balance_of_entry         = 0x5c721497,
-   transfer_entry           = 0x27f576ca,
-   mint_entry               = 0xdc6f17bb,
-   burn_entry               = 0x859facc5,
-   authorize_entry          = 0x4a2dbd90
+   get_account_rc_entry       = 0x2d464aab,
+   consume_account_rc_entry   = 0x80e3f5c9,
+   authorize_entry            = 0x4a2dbd90,
+   transfer_with_permit_entry = 0x84b5d9d3,
+   permit_nonce_entry         = 0xa958c713
 };
 
-std::string arguments; // Declared globally to pass to check_authority
+// Per owner koin::permit_nonce_object
+constexpr uint32_t permit_nonce_id = koin_token::first_contract_space_id;
 
 using get_account_rc_arguments
    = chain::get_account_rc_arguments<
@@ -106,17 +101,25 @@ using consume_account_rc_arguments
       constants::max_name_size
    >;
 
-void regenerate_mana( koin::mana_balance_object& bal )
-{
-   auto head_block_time = system::get_head_info().head_block_time();
-   auto delta = std::min( head_block_time - bal.last_mana_update(), constants::mana_regen_time_ms );
-   if ( delta )
-   {
-      auto new_mana = bal.mana() + ( ( int128_t( delta ) * int128_t( bal.balance() ) ) / constants::mana_regen_time_ms ).convert_to< uint64_t >() ;
-      bal.set_mana( std::min( new_mana, bal.balance() ) );
-      bal.set_last_mana_update( head_block_time );
-   }
-}
+using transfer_with_permit_arguments
+   = koin::transfer_with_permit_arguments<
+      constants::max_address_size,
+      constants::max_address_size,
+      constants::max_signature_size
+   >;
+
+using transfer_permit_message
+   = koin::transfer_permit_message<
+      constants::max_chain_id_size,
+      constants::max_address_size,
+      constants::max_address_size,
+      constants::max_address_size
+   >;
+
+using permit_nonce_arguments
+   = koin::permit_nonce_arguments<
+      constants::max_address_size
+   >;
 
 chain::get_account_rc_result get_account_rc( const get_account_rc_arguments& args )
 {
@@ -129,10 +132,8 @@ chain::get_account_rc_result get_account_rc( const get_account_rc_arguments& arg
       return res;
    }
 
-   koin::mana_balance_object bal_obj;
-   system::get_object( state::balance_space(), owner, bal_obj );
-
-   regenerate_mana( bal_obj );
+   auto bal_obj = koin_token::get_balance( owner );
+   koin_token::regenerate_mana( bal_obj );
 
    res.set_value( bal_obj.get_mana() );
    return res;
@@ -151,226 +152,83 @@ chain::consume_account_rc_result consume_account_rc( const consume_account_rc_ar
    }
 
    std::string owner( reinterpret_cast< const char* >( args.get_account().get_const() ), args.get_account().get_length() );
-   koin::mana_balance_object bal_obj;
-   system::get_object( state::balance_space(), owner, bal_obj );
-
-   regenerate_mana( bal_obj );
-
    // Assumes mana cannot go negative...
-   if ( bal_obj.mana() < args.value() )
+   if ( !koin_token::consume_mana( owner, args.value() ) )
    {
       system::log( "Account has insufficient mana for consumption" );
       return res;
    }
 
-   bal_obj.set_mana( bal_obj.mana() - args.value() );
-
-   system::put_object( state::balance_space(), owner, bal_obj );
-
    res.set_value( true );
    return res;
 }
 
-token::name_result< constants::max_name_size > name()
-{
-   token::name_result< constants::max_name_size > res;
-   res.mutable_value() = constants::koinos_name.c_str();
-   return res;
-}
-
-token::symbol_result< constants::max_symbol_size > symbol()
-{
-   token::symbol_result< constants::max_symbol_size > res;
-   res.mutable_value() = constants::koinos_symbol.c_str();
-   return res;
-}
-
-token::decimals_result decimals()
-{
-   token::decimals_result res;
-   res.mutable_value() = constants::koinos_decimals;
-   return res;
-}
-
-token::total_supply_result total_supply()
-{
-   token::total_supply_result res;
-
-   token::balance_object bal_obj;
-   system::get_object( state::supply_space(), constants::supply_key, bal_obj );
-
-   res.mutable_value() = bal_obj.get_value();
-   return res;
-}
-
-token::balance_of_result balance_of( const token::balance_of_arguments< constants::max_address_size >& args )
-{
-   token::balance_of_result res;
-
-   std::string owner( reinterpret_cast< const char* >( args.get_owner().get_const() ), args.get_owner().get_length() );
-
-   koin::mana_balance_object bal_obj;
-   system::get_object( state::balance_space(), owner, bal_obj );
-
-   res.set_value( bal_obj.get_balance() );
-   return res;
-}
-
-token::transfer_result transfer( const token::transfer_arguments< constants::max_address_size, constants::max_address_size >& args )
+// The digest the owner signs: the sha256 multihash of the canonical encoding
+// of koin::transfer_permit_message, which binds the permit to this chain and
+// this contract.
+std::string permit_digest( const transfer_with_permit_arguments& args )
 {
-   std::string from( reinterpret_cast< const char* >( args.get_from().get_const() ), args.get_from().get_length() );
-   std::string to( reinterpret_cast< const char* >( args.get_to().get_const() ), args.get_to().get_length() );
-   uint64_t value = args.get_value();
-
-   if ( from == to )
-      system::fail( "cannot transfer to self" );
-
-   const auto [ caller, privilege ] = system::get_caller();
-   if ( caller != from && !system::check_authority( from, arguments ) )
-      system::fail( "from has not authorized transfer", chain::error_code::authorization_failure );
-
-   koin::mana_balance_object from_bal_obj;
-   system::get_object( state::balance_space(), from, from_bal_obj );
-
-   if ( from_bal_obj.balance() < value )
-      system::fail( "account 'from' has insufficient balance" );
-
-   regenerate_mana( from_bal_obj );
-
-   if ( from_bal_obj.mana() < value )
-      system::fail( "account 'from' has insufficient mana for transfer" );
-
-   koin::mana_balance_object to_bal_obj;
-   system::get_object( state::balance_space(), to, to_bal_obj );
-
-   regenerate_mana( to_bal_obj );
-
-   from_bal_obj.set_balance( from_bal_obj.balance() - value );
-   from_bal_obj.set_mana( from_bal_obj.mana() - value );
-   to_bal_obj.set_balance( to_bal_obj.balance() + value );
-   to_bal_obj.set_mana( to_bal_obj.mana() + value );
-
-   system::put_object( state::balance_space(), from, from_bal_obj );
-   system::put_object( state::balance_space(), to, to_bal_obj );
-
-   token::transfer_event< constants::max_address_size, constants::max_address_size > transfer_event;
-   transfer_event.mutable_from().set( args.get_from().get_const(), args.get_from().get_length() );
-   transfer_event.mutable_to().set( args.get_to().get_const(), args.get_to().get_length() );
-   transfer_event.set_value( args.get_value() );
-
-   std::vector< std::string > impacted;
-   impacted.push_back( to );
-   impacted.push_back( from );
-   koinos::system::event( "koinos.contracts.token.transfer_event", transfer_event, impacted );
-
-   return token::transfer_result();
+   auto chain_id    = system::get_chain_id();
+   auto contract_id = system::get_contract_id();
+
+   transfer_permit_message msg;
+   msg.mutable_chain_id().set( reinterpret_cast< const uint8_t* >( chain_id.data() ), chain_id.size() );
+   msg.mutable_contract_id().set( reinterpret_cast< const uint8_t* >( contract_id.data() ), contract_id.size() );
+   msg.mutable_from().set( args.get_from().get_const(), args.get_from().get_length() );
+   msg.mutable_to().set( args.get_to().get_const(), args.get_to().get_length() );
+   msg.set_value( args.get_value() );
+   msg.set_nonce( args.get_nonce() );
+   msg.set_deadline( args.get_deadline() );
+
+   std::array< uint8_t, constants::max_permit_message_size > bytes;
+   koinos::write_buffer wbuf( bytes.data(), bytes.size() );
+   msg.serialize( wbuf );
+
+   return system::hash( constants::sha256_id, std::string( reinterpret_cast< const char* >( bytes.data() ), wbuf.get_size() ) );
 }
 
-token::mint_result mint( const token::mint_arguments< constants::max_address_size >& args )
+uint64_t get_permit_nonce( const std::string& owner )
 {
-   std::string to( reinterpret_cast< const char* >( args.get_to().get_const() ), args.get_to().get_length() );
-   uint64_t amount = args.get_value();
-
-   const auto [ caller, privilege ] = system::get_caller();
-   if ( privilege != chain::privilege::kernel_mode )
-   {
-#ifdef BUILD_FOR_TESTING
-      if ( !system::check_authority( constants::contract_id ) )
-         system::fail( "can only mint token with contract authority", chain::error_code::authorization_failure );
-#else
-      system::fail( "can only mint token from kernel context", chain::error_code::authorization_failure );
-#endif
-   }
-
-   auto supply = total_supply().get_value();
-   auto new_supply = supply + amount;
-
-   // Check overflow
-   if ( new_supply < supply )
-      system::revert( "mint would overflow supply" );
-
-   koin::mana_balance_object to_bal_obj;
-   system::get_object( state::balance_space(), to, to_bal_obj );
-
-   regenerate_mana( to_bal_obj );
-
-   to_bal_obj.set_balance( to_bal_obj.balance() + amount );
-   to_bal_obj.set_mana( to_bal_obj.mana() + amount );
-
-   token::balance_object supply_obj;
-   supply_obj.set_value( new_supply );
-
-   system::put_object( state::supply_space(), constants::supply_key, supply_obj );
-   system::put_object( state::balance_space(), to, to_bal_obj );
-
-   token::mint_event< constants::max_address_size > mint_event;
-   mint_event.mutable_to().set( args.get_to().get_const(), args.get_to().get_length() );
-   mint_event.set_value( amount );
-
-   std::vector< std::string > impacted;
-   impacted.push_back( to );
-   koinos::system::event( "koinos.contracts.token.mint_event", mint_event, impacted );
-
-   return token::mint_result();
+   koin::permit_nonce_object nonce;
+   system::get_object( koin_token::contract_space( permit_nonce_id ), owner, nonce );
+   return nonce.value();
 }
 
-token::burn_result burn( const token::burn_arguments< constants::max_address_size >& args )
+// Transfers on the strength of from's signature instead of its authority,
+// so a relayer can move funds in a single transaction. Each permit is good
+// for one transfer before its deadline.
+void transfer_with_permit( const transfer_with_permit_arguments& args )
 {
-   std::string from( reinterpret_cast< const char* >( args.get_from().get_const() ), args.get_from().get_length() );
-   uint64_t value = args.get_value();
-
-   const auto [ caller, privilege ] = system::get_caller();
-   if ( caller != from && !system::check_authority( from, arguments ) )
-      system::fail( "from has not authorized burn", chain::error_code::authorization_failure );
-
-   koin::mana_balance_object from_bal_obj;
-   system::get_object( state::balance_space(), from, from_bal_obj );
-
-   if ( from_bal_obj.balance() < value )
-      system::fail( "account 'from' has insufficient balance" );
-
-   regenerate_mana( from_bal_obj );
-
-   if ( from_bal_obj.mana() < value )
-      system::fail( "account 'from' has insufficient mana for burn" );
-
-   from_bal_obj.set_balance( from_bal_obj.balance() - value );
-   from_bal_obj.set_mana( from_bal_obj.mana() - value );
-
-   auto supply = total_supply().get_value();
-
-   // Check underflow
-   if ( value > supply )
-      system::revert( "burn would underflow supply" );
-
-   auto new_supply = supply - value;
+   auto from = system_contracts::bytes_string( args.get_from() );
+   auto to   = system_contracts::bytes_string( args.get_to() );
 
-   token::balance_object supply_obj;
-   supply_obj.set_value( new_supply );
+   if ( system::get_head_info().head_block_time() > args.get_deadline() )
+      system::fail( "permit has expired" );
 
-   system::put_object( state::supply_space(), constants::supply_key, supply_obj );
-   system::put_object( state::balance_space(), from, from_bal_obj );
+   auto nonce = get_permit_nonce( from );
+   if ( args.get_nonce() != nonce )
+      system::fail( "invalid permit nonce" );
 
-   token::burn_event< constants::max_address_size > burn_event;
-   burn_event.mutable_from().set( args.get_from().get_const(), args.get_from().get_length() );
-   burn_event.set_value( args.get_value() );
+   auto signer_key = system::recover_public_key( system_contracts::bytes_string( args.get_signature() ), permit_digest( args ) );
+   if ( signer_key.empty() || koinos::address_from_public_key( signer_key ) != from )
+      system::fail( "invalid permit signature", chain::error_code::authorization_failure );
 
-   std::vector< std::string > impacted;
-   impacted.push_back( from );
-   koinos::system::event( "koinos.contracts.token.burn_event", burn_event, impacted );
+   koin::permit_nonce_object next;
+   next.set_value( nonce + 1 );
+   system::put_object( koin_token::contract_space( permit_nonce_id ), from, next );
 
-   return token::burn_result();
+   koin_token::transfer_authorized( from, to, args.get_value() );
 }
 
-int main()
+int invoke( system_contracts::invocation_context& ctx )
 {
-   uint32_t entry_point;
-   std::tie( entry_point, arguments ) = system::get_arguments();
+   system_contracts::invocation_scope scope( ctx );
 
-   std::array< uint8_t, constants::max_buffer_size > retbuf;
+   const auto& arguments = system_contracts::get_arguments();
+   auto entry_point = arguments.entry_point;
 
-   koinos::read_buffer rdbuf( (uint8_t*)arguments.c_str(), arguments.size() );
-   koinos::write_buffer buffer( retbuf.data(), retbuf.size() );
+   auto rdbuf = arguments.reader();
+   system_contracts::result_writer buffer;
 
    switch( std::underlying_type_t< entries >( entry_point ) )
    {
@@ -392,63 +250,19 @@ int main()
          res.serialize( buffer );
          break;
       }
-      case entries::name_entry:
-      {
-         auto res = name();
-         res.serialize( buffer );
-         break;
-      }
-      case entries::symbol_entry:
-      {
-         auto res = symbol();
-         res.serialize( buffer );
-         break;
-      }
-      case entries::decimals_entry:
-      {
-         auto res = decimals();
-         res.serialize( buffer );
-         break;
-      }
-      case entries::total_supply_entry:
-      {
-         auto res = total_supply();
-         res.serialize( buffer );
-         break;
-      }
-      case entries::balance_of_entry:
-      {
-         token::balance_of_arguments< constants::max_address_size > arg;
-         arg.deserialize( rdbuf );
-
-         auto res = balance_of( arg );
-         res.serialize( buffer );
-         break;
-      }
-      case entries::transfer_entry:
-      {
-         token::transfer_arguments< constants::max_address_size, constants::max_address_size > arg;
-         arg.deserialize( rdbuf );
-
-         auto res = transfer( arg );
-         res.serialize( buffer );
-         break;
-      }
-      case entries::mint_entry:
+      case entries::transfer_with_permit_entry:
       {
-         token::mint_arguments< constants::max_address_size > arg;
-         arg.deserialize( rdbuf );
+         auto arg = system_contracts::decode_arguments< transfer_with_permit_arguments >( arguments, "malformed transfer_with_permit arguments" );
 
-         auto res = mint( arg );
-         res.serialize( buffer );
+         transfer_with_permit( arg );
          break;
       }
-      case entries::burn_entry:
+      case entries::permit_nonce_entry:
       {
-         token::burn_arguments< constants::max_address_size > arg;
-         arg.deserialize( rdbuf );
+         auto arg = system_contracts::decode_arguments< permit_nonce_arguments >( arguments, "malformed permit_nonce arguments" );
 
-         auto res = burn( arg );
+         koin::permit_nonce_result res;
+         res.set_value( get_permit_nonce( system_contracts::bytes_string( arg.get_owner() ) ) );
          res.serialize( buffer );
          break;
       }
@@ -460,11 +274,20 @@ int main()
          break;
       }
       default:
-         system::revert( "unknown entry point" );
+         if ( !koin_token::dispatch( arguments, buffer ) )
+            system::revert( "unknown entry point" );
    }
 
-   system::result r;
-   r.mutable_object().set( buffer.data(), buffer.get_size() );
+   buffer.exit();
+   return 0;
+}
 
-   system::exit( 0, r );
+#if defined( __wasm__ )
+int main()
+{
+   // An instance runs a single invocation. Its context is kept out of the
+   // small wasm stack.
+   static system_contracts::invocation_context ctx;
+   return invoke( ctx );
 }
+#endif
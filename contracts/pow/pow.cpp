@@ -3,15 +3,17 @@
 #include <koinos/token.hpp>
 
 #include <koinos/contracts/pow/pow.h>
+#include <koinos/system_contracts/arguments.hpp>
+#include <koinos/system_contracts/result_writer.hpp>
+#include <koinos/system_contracts/uint.hpp>
+#include <koinos/system_contracts/versioned_object.hpp>
 
-#include <boost/multiprecision/cpp_int.hpp>
-
-#include <vector>
+#include <cassert>
 
 using namespace koinos;
 using namespace std::string_literals;
 
-using uint256_t = boost::multiprecision::uint256_t;
+using uint256_t = system_contracts::uint256;
 using EmbeddedProto::FieldBytes;
 
 enum class entries : uint32_t
@@ -21,7 +23,6 @@ enum class entries : uint32_t
 
 namespace constants {
 
-constexpr std::size_t max_buffer_size         = 2048;
 constexpr std::size_t max_signature_size      = 65;
 constexpr std::size_t max_proof_size          = 128;
 const std::string difficulty_metadata_key     = "";
@@ -35,24 +36,9 @@ constexpr uint32_t initial_difficulty_bits    = 24;
 
 namespace state {
 
-namespace detail {
-
-system::object_space create_contract_space()
+const system::object_space& contract_space()
 {
-   system::object_space obj_space;
-   auto contract_id = system::get_contract_id();
-   obj_space.mutable_zone().set( reinterpret_cast< const uint8_t* >( contract_id.data() ), contract_id.size() );
-   obj_space.set_id( 0 );
-   obj_space.set_system( true );
-   return obj_space;
-}
-
-} // detail
-
-system::object_space contract_space()
-{
-   static auto space = detail::create_contract_space();
-   return space;
+   return system_contracts::current_invocation().space( 0 );
 }
 
 }
@@ -73,36 +59,32 @@ using process_block_signature_arguments = koinos::chain::process_block_signature
 template< uint32_t MAX_LENGTH >
 void to_binary( FieldBytes< MAX_LENGTH >& f, const uint256_t& n )
 {
-   static_assert( MAX_LENGTH >= 32 );
-   std::vector< uint8_t > bin;
-   bin.reserve( 32 );
-   boost::multiprecision::export_bits( n, std::back_inserter( bin ), 8 );
-
-   std::size_t leading_zeros = 32 - bin.size();
-   for( std::size_t i = 0; i < leading_zeros; i++ )
-      f[i] = 0;
+   static_assert( MAX_LENGTH >= uint256_t::bytes );
+   std::array< uint8_t, uint256_t::bytes > bin;
+   n.to_big_endian( bin.data() );
+
    for( std::size_t i = 0; i < bin.size(); i++ )
-      f[i + leading_zeros] = bin[i];
+      f[i] = bin[i];
 }
 
 template< uint32_t MAX_LENGTH >
 void from_binary( const FieldBytes< MAX_LENGTH >& f, uint256_t& n, size_t start = 0 )
 {
-   assert( MAX_LENGTH >= start + 32 );
-   std::vector< uint8_t > bin;
+   assert( MAX_LENGTH >= start + uint256_t::bytes );
+   std::array< uint8_t, uint256_t::bytes > bin;
 
-   for ( size_t i = start; i < start + 32; i++ )
+   for ( size_t i = 0; i < bin.size(); i++ )
    {
-      bin.push_back( f[i] );
+      bin[i] = f[start + i];
    }
 
-   boost::multiprecision::import_bits( n, bin.begin(), bin.end(), 8 );
+   n = uint256_t::from_big_endian( bin.data() );
 }
 
 
 void initialize_difficulty( difficulty_metadata& diff_meta )
 {
-   uint256_t target = std::numeric_limits< uint256_t >::max() / (1 << constants::initial_difficulty_bits);
+   uint256_t target = uint256_t::max() / (1 << constants::initial_difficulty_bits);
    auto difficulty = 1 << constants::initial_difficulty_bits;
    to_binary( diff_meta.mutable_target(), target );
    diff_meta.set_last_block_time( system::get_head_info().get_head_block_time() );
@@ -113,7 +95,7 @@ void initialize_difficulty( difficulty_metadata& diff_meta )
 difficulty_metadata get_difficulty_meta()
 {
    difficulty_metadata diff_meta;
-   if ( !system::get_object( state::contract_space(), constants::difficulty_metadata_key, diff_meta ) )
+   if ( !system_contracts::get_versioned_object( state::contract_space(), constants::difficulty_metadata_key, diff_meta ) )
    {
       initialize_difficulty( diff_meta );
    }
@@ -125,31 +107,35 @@ void update_difficulty( difficulty_metadata& diff_meta, uint64_t current_block_t
 {
    uint256_t difficulty;
    from_binary( diff_meta.get_difficulty(), difficulty );
-   difficulty = difficulty + difficulty / 2048 * std::max(1 - int64_t((current_block_time - diff_meta.last_block_time()) / 7000), -99ll);
+   auto adjustment = std::max( 1 - int64_t( ( current_block_time - diff_meta.last_block_time() ) / 7000 ), int64_t( -99 ) );
+   if ( adjustment >= 0 )
+      difficulty += difficulty / 2048 * uint64_t( adjustment );
+   else
+      difficulty -= difficulty / 2048 * uint64_t( -adjustment );
    to_binary( diff_meta.mutable_difficulty(), difficulty );
    diff_meta.set_last_block_time( current_block_time );
-   auto target = std::numeric_limits< uint256_t >::max() / difficulty;
+   auto target = uint256_t::max() / difficulty;
    to_binary( diff_meta.mutable_target(), target );
 
-   system::put_object( state::contract_space(), constants::difficulty_metadata_key, diff_meta );
+   system_contracts::put_versioned_object( state::contract_space(), constants::difficulty_metadata_key, diff_meta );
 }
 
-int main()
+int invoke( system_contracts::invocation_context& ctx )
 {
-   auto [entry_point, argstr] = system::get_arguments();
+   system_contracts::invocation_scope scope( ctx );
+
+   const auto& arguments = system_contracts::get_arguments();
+   auto entry_point = arguments.entry_point;
 
-   std::array< uint8_t, constants::max_buffer_size > retbuf;
-   koinos::write_buffer buffer( retbuf.data(), retbuf.size() );
+   system_contracts::result_writer buffer;
 
    if ( entry_point == std::underlying_type_t< entries >( entries::get_difficulty ) )
    {
       get_difficulty_metadata_result res;
       res.set_value( get_difficulty_meta() );
       res.serialize( buffer );
-
-      system::result r;
-      r.mutable_object().set( buffer.data(), buffer.get_size() );
-      system::exit( 0, r );
+      buffer.exit();
+      return 0;
    }
 
    koinos::chain::process_block_signature_result ret;
@@ -167,7 +153,7 @@ int main()
       system::revert( "PoW contract must be called from kernel" );
    }
 
-   koinos::read_buffer rdbuf( (uint8_t*)argstr.c_str(), argstr.size() );
+   auto rdbuf = arguments.reader();
    process_block_signature_arguments args;
    args.deserialize( rdbuf );
 
@@ -211,7 +197,18 @@ int main()
    }
 
    ret.set_value( success );
+   ret.serialize( buffer );
 
-   system::exit( ret );
+   buffer.exit();
    return 0;
 }
+
+#if defined( __wasm__ )
+int main()
+{
+   // An instance runs a single invocation. Its context is kept out of the
+   // small wasm stack.
+   static system_contracts::invocation_context ctx;
+   return invoke( ctx );
+}
+#endif
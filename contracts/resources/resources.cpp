@@ -3,14 +3,16 @@
 
 #include <koinos/chain/authority.h>
 #include <koinos/contracts/resources/resources.h>
-
-#include <boost/multiprecision/cpp_int.hpp>
+#include <koinos/system_contracts/arguments.hpp>
+#include <koinos/system_contracts/result_writer.hpp>
+#include <koinos/system_contracts/uint.hpp>
+#include <koinos/system_contracts/versioned_object.hpp>
 
 using namespace koinos;
 using namespace koinos::contracts::resources;
 using namespace std::string_literals;
 
-using uint128_t = boost::multiprecision::uint128_t;
+using uint128_t = system_contracts::uint128;
 
 enum entries : uint32_t
 {
@@ -25,7 +27,6 @@ enum entries : uint32_t
 
 namespace constants {
 
-constexpr std::size_t max_buffer_size         = 2048;
 constexpr uint64_t num_resources              = 3;
 const std::string markets_key                 = "markets";
 const std::string parameters_keys             = "parameters";
@@ -53,24 +54,9 @@ constexpr uint64_t print_rate_precision_default     = 1000;
 
 namespace state {
 
-namespace detail {
-
-system::object_space create_contract_space()
-{
-   system::object_space obj_space;
-   auto contract_id = system::get_contract_id();
-   obj_space.mutable_zone().set( reinterpret_cast< const uint8_t* >( contract_id.data() ), contract_id.size() );
-   obj_space.set_id( 0 );
-   obj_space.set_system( true );
-   return obj_space;
-}
-
-} // detail
-
-system::object_space contract_space()
+const system::object_space& contract_space()
 {
-   static auto space = detail::create_contract_space();
-   return space;
+   return system_contracts::current_invocation().space( 0 );
 }
 
 }
@@ -79,16 +65,10 @@ using get_resource_limits_result        = chain::get_resource_limits_result;
 using consume_block_resources_arguments = chain::consume_block_resources_arguments;
 using consume_block_resources_result    = chain::consume_block_resources_result;
 
+// Calls KOIN for the total supply, so callers compute it once per invocation
 uint64_t rc_per_block( const resource_parameters& p )
 {
-   static uint64_t rc = 0;
-
-   if ( rc == 0 )
-   {
-      rc = ( ( uint128_t( koinos::token::koin().total_supply() ) * p.block_interval_ms() ) / ( p.rc_regen_ms() * constants::num_resources ) ).convert_to< uint64_t >();
-   }
-
-   return rc;
+   return ( ( uint128_t( koinos::token::koin().total_supply() ) * p.block_interval_ms() ) / ( p.rc_regen_ms() * constants::num_resources ) ).convert_to< uint64_t >();
 }
 
 void initialize_params( resource_parameters& params )
@@ -104,7 +84,7 @@ void initialize_params( resource_parameters& params )
 resource_parameters get_resource_parameters()
 {
    resource_parameters params;
-   if ( !system::get_object( state::contract_space(), constants::parameters_keys, params ) )
+   if ( !system_contracts::get_versioned_object( state::contract_space(), constants::parameters_keys, params ) )
    {
       initialize_params( params );
    }
@@ -133,7 +113,7 @@ void initialize_markets( const resource_parameters& p, resource_markets& markets
 resource_markets get_resource_markets()
 {
    resource_markets markets;
-   if ( !system::get_object( state::contract_space(), constants::markets_key, markets ) )
+   if ( !system_contracts::get_versioned_object( state::contract_space(), constants::markets_key, markets ) )
    {
       initialize_markets( get_resource_parameters(), markets );
    }
@@ -155,7 +135,7 @@ void set_resource_markets( const set_resource_markets_parameters_arguments& para
    markets.mutable_compute_bandwidth().set_block_budget( params.get_compute_bandwidth().get_block_budget() );
    markets.mutable_compute_bandwidth().set_block_limit( params.get_compute_bandwidth().get_block_limit() );
 
-   system::put_object( state::contract_space(), constants::markets_key, markets );
+   system_contracts::put_versioned_object( state::contract_space(), constants::markets_key, markets );
 }
 
 void set_resource_parameters( const set_resource_parameters_arguments& args )
@@ -163,20 +143,20 @@ void set_resource_parameters( const set_resource_parameters_arguments& args )
    if ( !system::check_system_authority() )
       system::fail( "can only set resource parameters with system authority", chain::error_code::authorization_failure );
 
-   system::put_object( state::contract_space(), constants::parameters_keys, args.get_params() );
+   system_contracts::put_versioned_object( state::contract_space(), constants::parameters_keys, args.get_params() );
 }
 
-uint128_t calculate_k( const resource_parameters& p, const market& m )
+uint128_t calculate_k( const resource_parameters& p, uint64_t rc_per_block, const market& m )
 {
    auto block_print_rate = ( p.print_rate_premium() * m.block_budget() ) / p.print_rate_precision();
    auto max_resources = ( uint128_t( block_print_rate - m.block_budget() ) << 64 ) / p.one_minus_decay_constant();
-   return ( ( rc_per_block( p ) * max_resources ) / m.block_budget() ) * ( max_resources - m.block_budget() );
+   return ( ( rc_per_block * max_resources ) / m.block_budget() ) * ( max_resources - m.block_budget() );
 }
 
-std::pair< uint64_t, uint64_t > calculate_market_limit( const resource_parameters& p, const market& m )
+std::pair< uint64_t, uint64_t > calculate_market_limit( const resource_parameters& p, uint64_t rc_per_block, const market& m )
 {
    auto resource_limit = std::min( m.resource_supply() - 1, m.block_limit() );
-   auto k = calculate_k( p, m );
+   auto k = calculate_k( p, rc_per_block, m );
    auto new_supply = m.resource_supply() - resource_limit;
    auto consumed_rc = ( ( k + ( new_supply - 1 ) ) / new_supply ) - ( k / m.resource_supply() );
    auto rc_cost = ( ( consumed_rc + ( resource_limit - 1 ) ) / resource_limit ).convert_to< uint64_t >();
@@ -186,10 +166,11 @@ std::pair< uint64_t, uint64_t > calculate_market_limit( const resource_parameter
 get_resource_limits_result get_resource_limits( const resource_parameters& p )
 {
    auto markets = get_resource_markets();
+   auto rc      = rc_per_block( p );
 
-   auto [disk_limit,    disk_cost]    = calculate_market_limit( p, markets.disk_storage() );
-   auto [network_limit, network_cost] = calculate_market_limit( p, markets.network_bandwidth() );
-   auto [compute_limit, compute_cost] = calculate_market_limit( p, markets.compute_bandwidth() );
+   auto [disk_limit,    disk_cost]    = calculate_market_limit( p, rc, markets.disk_storage() );
+   auto [network_limit, network_cost] = calculate_market_limit( p, rc, markets.network_bandwidth() );
+   auto [compute_limit, compute_cost] = calculate_market_limit( p, rc, markets.compute_bandwidth() );
 
    get_resource_limits_result res;
    res.mutable_value().set_disk_storage_limit( disk_limit );
@@ -238,20 +219,21 @@ consume_block_resources_result consume_block_resources( const consume_block_reso
    update_market( params, markets.mutable_network_bandwidth(), args.network_bandwidth_consumed() );
    update_market( params, markets.mutable_compute_bandwidth(), args.compute_bandwidth_consumed() );
 
-   system::put_object( state::contract_space(), constants::markets_key, markets );
+   system_contracts::put_versioned_object( state::contract_space(), constants::markets_key, markets );
 
    res.set_value( true );
    return res;
 }
 
-int main()
+int invoke( system_contracts::invocation_context& ctx )
 {
-   auto [entry_point, args] = system::get_arguments();
+   system_contracts::invocation_scope scope( ctx );
 
-   std::array< uint8_t, constants::max_buffer_size > retbuf;
+   const auto& args = system_contracts::get_arguments();
+   auto entry_point = args.entry_point;
 
-   koinos::read_buffer rdbuf( (uint8_t*)args.c_str(), args.size() );
-   koinos::write_buffer buffer( retbuf.data(), retbuf.size() );
+   auto rdbuf = args.reader();
+   system_contracts::result_writer buffer;
 
    switch( std::underlying_type_t< entries >( entry_point ) )
    {
@@ -311,10 +293,17 @@ int main()
          return 1;
    }
 
-   system::result r;
-   r.mutable_object().set( buffer.data(), buffer.get_size() );
-
-   system::exit( 0, r );
+   buffer.exit();
 
    return 0;
 }
+
+#if defined( __wasm__ )
+int main()
+{
+   // An instance runs a single invocation. Its context is kept out of the
+   // small wasm stack.
+   static system_contracts::invocation_context ctx;
+   return invoke( ctx );
+}
+#endif
@@ -0,0 +1,251 @@
+#include <koinos/system_contracts/wire.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Checks or updates the descriptors embedded in a contract ABI.
+//
+// An ABI's "types" field is a base64 FileDescriptorSet with an entry per
+// .proto file the contract's methods use. This compares each file of a
+// descriptor set that protoc built from the contract's .proto files against
+// the entry of the same name in the ABI, and with --update replaces the
+// entries that differ, so that the ABI cannot drift from the .proto it is
+// generated from. Entries for files that are not in the descriptor set, such
+// as the token.proto of the SDK, are left as they are.
+
+using namespace koinos;
+
+namespace wire = koinos::system_contracts::wire;
+
+namespace {
+
+constexpr char types_key[] = "\"types\" : \"";
+
+constexpr char base64_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+int usage( const char* argv0 )
+{
+   std::fprintf( stderr,
+      "usage: %s [--update] <abi> <descriptor_set>\n"
+      "\n"
+      "  --update   replace the ABI's entries that differ from the descriptor set\n",
+      argv0 );
+   return 1;
+}
+
+bool read_file( const std::string& path, std::string& out )
+{
+   std::ifstream in( path, std::ios::binary );
+   if ( !in )
+      return false;
+
+   std::ostringstream ss;
+   ss << in.rdbuf();
+   out = ss.str();
+   return true;
+}
+
+std::string to_base64( const std::string& data )
+{
+   std::string out;
+   out.reserve( ( data.size() + 2 ) / 3 * 4 );
+   for ( std::size_t i = 0; i < data.size(); i += 3 )
+   {
+      uint32_t n = uint32_t( uint8_t( data[i] ) ) << 16;
+      if ( i + 1 < data.size() )
+         n |= uint32_t( uint8_t( data[i + 1] ) ) << 8;
+      if ( i + 2 < data.size() )
+         n |= uint8_t( data[i + 2] );
+
+      out.push_back( base64_alphabet[n >> 18 & 0x3f] );
+      out.push_back( base64_alphabet[n >> 12 & 0x3f] );
+      out.push_back( i + 1 < data.size() ? base64_alphabet[n >> 6 & 0x3f] : '=' );
+      out.push_back( i + 2 < data.size() ? base64_alphabet[n & 0x3f] : '=' );
+   }
+   return out;
+}
+
+bool from_base64( const std::string& text, std::string& out )
+{
+   out.clear();
+   uint32_t bits = 0;
+   int count = 0;
+   for ( std::size_t i = 0; i < text.size(); i++ )
+   {
+      if ( text[i] == '=' )
+      {
+         // Padding ends the text after two or three characters of a group
+         if ( text.size() % 4 || count < 2 || text.size() - i != std::size_t( 4 - count ) || text.back() != '=' )
+            return false;
+
+         bits <<= 6 * ( 4 - count );
+         out.push_back( char( bits >> 16 ) );
+         if ( count == 3 )
+            out.push_back( char( bits >> 8 ) );
+         return true;
+      }
+
+      const char* p = std::strchr( base64_alphabet, text[i] );
+      if ( !p || !*p )
+         return false;
+
+      bits = bits << 6 | uint32_t( p - base64_alphabet );
+      if ( ++count == 4 )
+      {
+         out.push_back( char( bits >> 16 ) );
+         out.push_back( char( bits >> 8 ) );
+         out.push_back( char( bits ) );
+         bits  = 0;
+         count = 0;
+      }
+   }
+   return count == 0;
+}
+
+struct file_entry
+{
+   std::string name;
+   std::string bytes;
+};
+
+// Splits a FileDescriptorSet { repeated FileDescriptorProto file = 1; } into
+// its files, named by FileDescriptorProto.name = 1
+bool split_files( const std::string& set, std::vector< file_entry >& files )
+{
+   wire::reader rd( set );
+   while ( !rd.eof() )
+   {
+      uint32_t field;
+      wire::wire_type type;
+      file_entry file;
+      if ( !rd.read_tag( field, type ) || field != 1 || type != wire::wire_type::length_delimited || !rd.read_bytes( file.bytes ) )
+         return false;
+
+      wire::reader frd( file.bytes );
+      while ( !frd.eof() && file.name.empty() )
+      {
+         if ( !frd.read_tag( field, type ) )
+            return false;
+
+         if ( field == 1 && type == wire::wire_type::length_delimited )
+         {
+            if ( !frd.read_bytes( file.name ) )
+               return false;
+         }
+         else if ( !frd.skip( type ) )
+         {
+            return false;
+         }
+      }
+
+      if ( file.name.empty() )
+         return false;
+
+      files.push_back( std::move( file ) );
+   }
+   return true;
+}
+
+std::string join_files( const std::vector< file_entry >& files )
+{
+   std::string set;
+   for ( const auto& file : files )
+      wire::append_bytes( set, 1, file.bytes );
+   return set;
+}
+
+} // anonymous
+
+int main( int argc, char** argv )
+{
+   bool update = false;
+   int arg = 1;
+   if ( arg < argc && !std::strcmp( argv[arg], "--update" ) )
+   {
+      update = true;
+      arg++;
+   }
+
+   if ( argc - arg != 2 )
+      return usage( argv[0] );
+
+   std::string abi_path = argv[arg], abi, descriptors;
+   if ( !read_file( abi_path, abi ) )
+   {
+      std::fprintf( stderr, "cannot read %s\n", abi_path.c_str() );
+      return 1;
+   }
+
+   if ( !read_file( argv[arg + 1], descriptors ) )
+   {
+      std::fprintf( stderr, "cannot read %s\n", argv[arg + 1] );
+      return 1;
+   }
+
+   auto begin = abi.find( types_key );
+   auto end   = begin == std::string::npos ? begin : abi.find( '"', begin + sizeof( types_key ) - 1 );
+   if ( end == std::string::npos )
+   {
+      std::fprintf( stderr, "%s has no types\n", abi_path.c_str() );
+      return 1;
+   }
+   begin += sizeof( types_key ) - 1;
+
+   std::string set;
+   std::vector< file_entry > abi_files, proto_files;
+   if ( !from_base64( abi.substr( begin, end - begin ), set ) || !split_files( set, abi_files ) )
+   {
+      std::fprintf( stderr, "%s: types is not a base64 FileDescriptorSet\n", abi_path.c_str() );
+      return 1;
+   }
+
+   if ( !split_files( descriptors, proto_files ) || proto_files.empty() )
+   {
+      std::fprintf( stderr, "%s is not a FileDescriptorSet\n", argv[arg + 1] );
+      return 1;
+   }
+
+   std::size_t differ = 0;
+   for ( const auto& file : proto_files )
+   {
+      std::size_t i = 0;
+      while ( i < abi_files.size() && abi_files[i].name != file.name )
+         i++;
+
+      if ( i < abi_files.size() && abi_files[i].bytes == file.bytes )
+         continue;
+
+      differ++;
+      std::printf( "%s: %s %s\n", abi_path.c_str(), file.name.c_str(), i < abi_files.size() ? "differs from its .proto" : "is missing" );
+
+      if ( i < abi_files.size() )
+         abi_files[i].bytes = file.bytes;
+      else
+         abi_files.push_back( file );
+   }
+
+   if ( !differ )
+   {
+      std::printf( "%s: types match\n", abi_path.c_str() );
+      return 0;
+   }
+
+   if ( !update )
+      return 1;
+
+   abi.replace( begin, end - begin, to_base64( join_files( abi_files ) ) );
+
+   std::ofstream out( abi_path, std::ios::binary | std::ios::trunc );
+   if ( !( out << abi ) )
+   {
+      std::fprintf( stderr, "cannot write %s\n", abi_path.c_str() );
+      return 1;
+   }
+
+   std::printf( "%s: updated %zu files\n", abi_path.c_str(), differ );
+   return 0;
+}
@@ -0,0 +1,412 @@
+#include <koinos/native_host/block_pipeline.hpp>
+#include <koinos/native_host/latency_store.hpp>
+#include <koinos/system_contracts/fixed_layout.hpp>
+#include <koinos/tools/address.hpp>
+#include <koinos/tools/event_log.hpp>
+#include <koinos/tools/mapped_file.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Replays blocks of KOIN transfers, from an exported event log or a
+// synthetic workload, against a state store that models the latency of
+// production state reads, and reports how much of each block's time goes to
+// waiting on state and how much prefetching the balance objects of upcoming
+// transactions recovers.
+//
+// Each transfer is executed by a model of the token's transfer: it reads the
+// sender's and recipient's balance objects, computes for a fixed time and
+// writes both back. Every block starts with nothing resident.
+
+using namespace koinos;
+using namespace koinos::native_host;
+using namespace koinos::tools;
+
+namespace fixed_layout = koinos::system_contracts::fixed_layout;
+
+namespace {
+
+struct options
+{
+   std::string             log_path;
+   std::string             contract;
+   bool                    synthetic    = false;
+   uint64_t                accounts     = 0;
+   uint64_t                transactions = 0;
+   uint64_t                seed         = 1;
+   std::size_t             block_size   = 500;
+   uint64_t                compute_ns   = 20'000;
+   std::vector< uint64_t > latencies    = { 1'000, 10'000, 50'000, 200'000 };
+   std::vector< uint64_t > depths       = { 0, 1, 2, 4, 8, 16 };
+};
+
+int usage( const char* argv0 )
+{
+   std::fprintf( stderr,
+      "usage: %s [-l latencies] [-p depths] [-e compute] [-c contract] <event_log>\n"
+      "       %s [-l latencies] [-p depths] [-e compute] [-b block_size] --synthetic <accounts> <transactions> [seed]\n"
+      "\n"
+      "  -l latencies  comma separated state read latencies, in ns or with a us or ms\n"
+      "                suffix (default: 1us,10us,50us,200us)\n"
+      "  -p depths     comma separated prefetch depths, in transactions (default: 0,1,2,4,8,16)\n"
+      "  -e compute    time each transfer computes for, as for -l (default: 20us)\n"
+      "  -c contract   only replay transfers from this contract id (base58 or 0x hex)\n"
+      "  -b size       transactions per synthetic block (default: 500)\n",
+      argv0, argv0 );
+   return 1;
+}
+
+bool parse_duration( const std::string& text, uint64_t& ns )
+{
+   char* end;
+   double value = std::strtod( text.c_str(), &end );
+   std::string suffix( end );
+
+   double scale = 1;
+   if ( suffix == "ms" )
+      scale = 1'000'000;
+   else if ( suffix == "us" )
+      scale = 1'000;
+   else if ( !suffix.empty() && suffix != "ns" )
+      return false;
+
+   if ( end == text.c_str() || !( value >= 0 ) )
+      return false;
+
+   ns = uint64_t( value * scale );
+   return true;
+}
+
+template< typename Parse >
+bool parse_list( const std::string& text, std::vector< uint64_t >& values, Parse&& parse )
+{
+   values.clear();
+
+   std::size_t pos = 0;
+   while ( pos <= text.size() )
+   {
+      auto comma = std::min( text.find( ',', pos ), text.size() );
+      uint64_t v;
+      if ( !parse( text.substr( pos, comma - pos ), v ) )
+         return false;
+
+      values.push_back( v );
+      pos = comma + 1;
+   }
+
+   return !values.empty();
+}
+
+bool parse_count( const std::string& text, uint64_t& v )
+{
+   char* end;
+   v = std::strtoull( text.c_str(), &end, 10 );
+   return !text.empty() && *end == '\0';
+}
+
+// Workloads
+
+uint64_t splitmix64( uint64_t& state )
+{
+   uint64_t z = ( state += 0x9e3779b97f4a7c15ull );
+   z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ull;
+   z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebull;
+   return z ^ ( z >> 31 );
+}
+
+double uniform( uint64_t& state )
+{
+   return double( splitmix64( state ) >> 11 ) * ( 1.0 / double( 1ull << 53 ) );
+}
+
+std::string synthetic_address( uint64_t id )
+{
+   std::string address( 8, '\0' );
+   for ( std::size_t i = 0; i < address.size(); i++ )
+      address[i] = char( id >> ( 8 * i ) );
+   return address;
+}
+
+// Senders are skewed towards a few active accounts and receivers are
+// uniform, as in mana_sim
+void synthetic_blocks( const options& opts, const std::string& contract, std::vector< std::vector< transaction > >& blocks )
+{
+   uint64_t state = opts.seed;
+   for ( uint64_t t = 0; t < opts.transactions; t++ )
+   {
+      auto from = std::min( opts.accounts - 1, uint64_t( double( opts.accounts ) * std::pow( uniform( state ), 3 ) ) );
+      auto to   = splitmix64( state ) % opts.accounts;
+      if ( to == from )
+         continue;
+
+      if ( blocks.empty() || blocks.back().size() == opts.block_size )
+         blocks.emplace_back();
+
+      blocks.back().push_back( transaction{ contract, transfer_entry,
+         encode_transfer( synthetic_address( from ), synthetic_address( to ), 1 + splitmix64( state ) % 1'000'000 ) } );
+   }
+}
+
+// A block of the log becomes a block of its transfers
+bool logged_blocks( const uint8_t* log, const std::vector< event_log::record_span >& records, const std::string& contract,
+   std::vector< std::vector< transaction > >& blocks )
+{
+   bool ok = true;
+   for ( const auto& r : records )
+   {
+      std::vector< transaction > block;
+      ok &= event_log::for_each_event( log + r.offset, r.size,
+         [&]( const event_log::block_info&, const event_log::event& ev )
+         {
+            if ( !contract.empty() && ev.source != contract )
+               return;
+
+            event_log::token_event te;
+            if ( !event_log::decode_token_event( ev, te ) || te.type != event_log::token_event_type::transfer )
+               return;
+
+            block.push_back( transaction{ std::string( ev.source ), transfer_entry, encode_transfer( te.from.str(), te.to.str(), te.value ) } );
+         } );
+
+      if ( !block.empty() )
+         blocks.push_back( std::move( block ) );
+   }
+   return ok;
+}
+
+// The transfer model
+
+uint64_t read_balance( const state_store& store, const object_key& k )
+{
+   std::string value;
+   if ( !store.get( k, value ) || value.size() != 8 )
+      return 0;
+
+   return fixed_layout::get_u64( reinterpret_cast< const uint8_t* >( value.data() ) );
+}
+
+void write_balance( state_store& store, const object_key& k, uint64_t balance )
+{
+   std::string value( 8, '\0' );
+   fixed_layout::put_u64( reinterpret_cast< uint8_t* >( value.data() ), balance );
+   store.put( k, value );
+}
+
+// Balances saturate, since a trace need not start from the accounts' first
+// transfers
+void run_transfer( latency_store& store, uint64_t compute_ns, const transaction& tx )
+{
+   std::string from, to;
+   uint64_t value;
+   if ( !decode_transfer( tx.arguments, from, to, value ) )
+      return;
+
+   object_key from_key{ tx.contract, balance_space_id, true, std::move( from ) };
+   object_key to_key{ tx.contract, balance_space_id, true, std::move( to ) };
+
+   auto from_balance = read_balance( store, from_key );
+   auto to_balance   = read_balance( store, to_key );
+   store.advance( compute_ns );
+
+   write_balance( store, from_key, from_balance - std::min( from_balance, value ) );
+   write_balance( store, to_key, to_balance + value );
+}
+
+struct run_totals
+{
+   uint64_t   transactions = 0;
+   uint64_t   elapsed_ns   = 0;
+   read_stats reads;
+
+   void add( const block_timing& t )
+   {
+      transactions     += t.transactions;
+      elapsed_ns       += t.elapsed_ns;
+      reads.reads      += t.reads.reads;
+      reads.misses     += t.reads.misses;
+      reads.late       += t.reads.late;
+      reads.prefetched += t.reads.prefetched;
+      reads.prefetches += t.reads.prefetches;
+      reads.stall_ns   += t.reads.stall_ns;
+   }
+};
+
+run_totals run( const options& opts, const std::vector< std::vector< transaction > >& blocks, state_store& backing, uint64_t latency, std::size_t depth )
+{
+   latency_store store( backing, latency );
+   auto runner = [&]( const transaction& tx ) { run_transfer( store, opts.compute_ns, tx ); };
+
+   run_totals totals;
+   for ( const auto& block : blocks )
+   {
+      store.evict();
+      totals.add( execute_block( store, block, transfer_balance_keys, runner, depth ) );
+   }
+   return totals;
+}
+
+double percent( uint64_t part, uint64_t whole )
+{
+   return whole ? 100.0 * double( part ) / double( whole ) : 0.0;
+}
+
+int bench( const options& opts )
+{
+   std::string error;
+   std::string contract;
+   if ( !opts.contract.empty() && !parse_address( opts.contract, contract ) )
+   {
+      std::fprintf( stderr, "invalid contract id: %s\n", opts.contract.c_str() );
+      return 1;
+   }
+
+   std::vector< std::vector< transaction > > blocks;
+   if ( opts.synthetic )
+   {
+      if ( contract.empty() )
+         parse_address( "15DJN4a8SgrbGhhGksSBASiSYjGnMU8dGL", contract );
+      synthetic_blocks( opts, contract, blocks );
+   }
+   else
+   {
+      mapped_file log;
+      std::vector< event_log::record_span > records;
+      if ( !log.open( opts.log_path, error ) )
+      {
+         std::fprintf( stderr, "%s\n", error.c_str() );
+         return 1;
+      }
+
+      if ( !event_log::split_records( log.data(), log.size(), records, error ) )
+      {
+         std::fprintf( stderr, "%s: %s\n", opts.log_path.c_str(), error.c_str() );
+         return 1;
+      }
+
+      if ( !logged_blocks( log.data(), records, contract, blocks ) )
+      {
+         std::fprintf( stderr, "error: %s has malformed block records\n", opts.log_path.c_str() );
+         return 2;
+      }
+   }
+
+   uint64_t transactions = 0;
+   for ( const auto& block : blocks )
+      transactions += block.size();
+
+   if ( !transactions )
+   {
+      std::fprintf( stderr, "no transfers to replay\n" );
+      return 1;
+   }
+
+   if ( opts.synthetic )
+      std::printf( "trace:         synthetic, %llu accounts, seed %llu\n",
+         (unsigned long long)opts.accounts, (unsigned long long)opts.seed );
+   else
+      std::printf( "trace:         %s\n", opts.log_path.c_str() );
+   std::printf( "transactions:  %llu in %zu blocks\n", (unsigned long long)transactions, blocks.size() );
+   std::printf( "compute:       %.1f us per transfer\n", double( opts.compute_ns ) / 1000 );
+   std::printf( "\n" );
+   std::printf( "   latency  depth  block ms   stalled  in time     late   misses        tx/s  recovered\n" );
+
+   state_store backing;
+   for ( auto latency : opts.latencies )
+   {
+      uint64_t baseline_stall = 0;
+      for ( auto depth : opts.depths )
+      {
+         auto t = run( opts, blocks, backing, latency, std::size_t( depth ) );
+         if ( depth == opts.depths.front() )
+            baseline_stall = t.reads.stall_ns;
+
+         std::printf( "%8.1fus %6llu %9.3f %8.2f%% %7.2f%% %7.2f%% %7.2f%% %11.0f %9.2f%%\n",
+            double( latency ) / 1000,
+            (unsigned long long)depth,
+            double( t.elapsed_ns ) / double( blocks.size() ) / 1e6,
+            percent( t.reads.stall_ns, t.elapsed_ns ),
+            percent( t.reads.prefetched, t.reads.reads ),
+            percent( t.reads.late, t.reads.reads ),
+            percent( t.reads.misses, t.reads.reads ),
+            t.elapsed_ns ? double( t.transactions ) * 1e9 / double( t.elapsed_ns ) : 0.0,
+            baseline_stall ? 100.0 - percent( t.reads.stall_ns, baseline_stall ) : 0.0 );
+      }
+   }
+
+   return 0;
+}
+
+} // anonymous
+
+int main( int argc, char** argv )
+{
+   options opts;
+   std::vector< std::string > positional;
+   for ( int i = 1; i < argc; i++ )
+   {
+      std::string arg = argv[i];
+      if ( ( arg == "-l" || arg == "-p" || arg == "-e" || arg == "-c" || arg == "-b" ) && i + 1 < argc )
+      {
+         std::string value = argv[++i];
+         uint64_t n = 0;
+         bool ok = true;
+         if ( arg == "-l" )
+            ok = parse_list( value, opts.latencies, parse_duration );
+         else if ( arg == "-p" )
+            ok = parse_list( value, opts.depths, parse_count );
+         else if ( arg == "-e" )
+            ok = parse_duration( value, opts.compute_ns );
+         else if ( arg == "-c" )
+            opts.contract = value;
+         else
+         {
+            ok = parse_count( value, n ) && n;
+            opts.block_size = std::size_t( n );
+         }
+
+         if ( !ok )
+            return usage( argv[0] );
+      }
+      else if ( arg == "--synthetic" )
+      {
+         opts.synthetic = true;
+      }
+      else if ( !arg.empty() && arg[0] == '-' )
+      {
+         return usage( argv[0] );
+      }
+      else
+      {
+         positional.push_back( arg );
+      }
+   }
+
+   if ( opts.synthetic )
+   {
+      if ( positional.size() < 2 || positional.size() > 3 )
+         return usage( argv[0] );
+
+      opts.accounts     = std::strtoull( positional[0].c_str(), nullptr, 10 );
+      opts.transactions = std::strtoull( positional[1].c_str(), nullptr, 10 );
+      if ( positional.size() == 3 )
+         opts.seed = std::strtoull( positional[2].c_str(), nullptr, 10 );
+
+      if ( opts.accounts < 2 || !opts.transactions )
+         return usage( argv[0] );
+   }
+   else
+   {
+      if ( positional.size() != 1 )
+         return usage( argv[0] );
+
+      opts.log_path = positional[0];
+      if ( opts.contract.empty() )
+         std::fprintf( stderr, "warning: no contract id given, replaying transfers from every contract\n" );
+   }
+
+   return bench( opts );
+}
@@ -0,0 +1,156 @@
+#include <koinos/buffer.hpp>
+#include <koinos/system_contracts/state_schemas.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace koinos;
+using namespace koinos::contracts;
+using namespace koinos::system_contracts;
+
+using difficulty_metadata = pow::difficulty_metadata< 32, 32 >;
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+constexpr std::size_t default_iterations = 1'000'000;
+constexpr std::size_t max_buffer_size    = 1024;
+
+template< typename T >
+inline void do_not_optimize( const T& value )
+{
+   asm volatile( "" : : "g"( &value ) : "memory" );
+}
+
+double ns_per_op( bench_clock::time_point start, std::size_t iterations )
+{
+   return std::chrono::duration< double, std::nano >( bench_clock::now() - start ).count() / double( iterations );
+}
+
+template< typename T >
+void bench( const char* name, const T& obj, std::size_t iterations )
+{
+   std::array< uint8_t, max_buffer_size > buf;
+   std::size_t proto_size = 0;
+
+   auto start = bench_clock::now();
+   for ( std::size_t i = 0; i < iterations; i++ )
+   {
+      koinos::write_buffer wbuf( buf.data(), buf.size() );
+      obj.serialize( wbuf );
+      proto_size = wbuf.get_size();
+      do_not_optimize( buf );
+   }
+   auto proto_encode = ns_per_op( start, iterations );
+
+   start = bench_clock::now();
+   for ( std::size_t i = 0; i < iterations; i++ )
+   {
+      koinos::read_buffer rbuf( buf.data(), proto_size );
+      T decoded;
+      decoded.deserialize( rbuf );
+      do_not_optimize( decoded );
+   }
+   auto proto_decode = ns_per_op( start, iterations );
+
+   using layout = fixed_layout::layout< T >;
+   constexpr std::size_t fixed_size = envelope_header_size + layout::size;
+
+   start = bench_clock::now();
+   for ( std::size_t i = 0; i < iterations; i++ )
+   {
+      buf[0] = envelope_tag;
+      buf[1] = fixed_layout_version;
+      layout::encode( obj, buf.data() + envelope_header_size );
+      do_not_optimize( buf );
+   }
+   auto fixed_encode = ns_per_op( start, iterations );
+
+   start = bench_clock::now();
+   for ( std::size_t i = 0; i < iterations; i++ )
+   {
+      T decoded;
+      if ( !decode_versioned( buf.data(), fixed_size, decoded ) )
+         std::abort();
+      do_not_optimize( decoded );
+   }
+   auto fixed_decode = ns_per_op( start, iterations );
+
+   std::printf( "%-22s %6zu %6zu %10.1f %10.1f %10.1f %10.1f\n",
+      name, proto_size, fixed_size, proto_encode, proto_decode, fixed_encode, fixed_decode );
+}
+
+token::balance_object make_supply()
+{
+   token::balance_object obj;
+   obj.set_value( 3'200'000'000'000'000ull );
+   return obj;
+}
+
+koin::mana_balance_object make_mana_balance()
+{
+   koin::mana_balance_object obj;
+   obj.set_balance( 1'234'567'890'123ull );
+   obj.set_mana( 987'654'321'000ull );
+   obj.set_last_mana_update( 1'700'000'000'000ull );
+   return obj;
+}
+
+resources::resource_markets make_resource_markets()
+{
+   resources::resource_markets obj;
+   auto set_market = []( resources::market& m, uint64_t supply, uint64_t budget, uint64_t limit )
+   {
+      m.set_resource_supply( supply );
+      m.set_block_budget( budget );
+      m.set_block_limit( limit );
+   };
+   set_market( obj.mutable_disk_storage(),      8'317'003'219ull,          39'600,      524'288 );
+   set_market( obj.mutable_network_bandwidth(), 55'051'206'040ull,         262'144,     1'048'576 );
+   set_market( obj.mutable_compute_bandwidth(), 12'076'170'524'096ull,     57'500'000,  287'500'000 );
+   return obj;
+}
+
+difficulty_metadata make_difficulty_metadata()
+{
+   difficulty_metadata obj;
+   std::array< uint8_t, 32 > target{};
+   std::array< uint8_t, 32 > difficulty{};
+   target[3] = 0xff;
+   for ( std::size_t i = 4; i < target.size(); i++ )
+      target[i] = uint8_t( 0xa5 ^ i );
+   difficulty[28] = 0x01;
+   difficulty[29] = 0x23;
+   obj.mutable_target().set( target.data(), target.size() );
+   obj.mutable_difficulty().set( difficulty.data(), difficulty.size() );
+   obj.set_last_block_time( 1'700'000'000'000ull );
+   obj.set_target_block_interval( 10 );
+   return obj;
+}
+
+} // anonymous
+
+int main( int argc, char** argv )
+{
+   std::size_t iterations = argc > 1 ? std::strtoull( argv[1], nullptr, 10 ) : default_iterations;
+   if ( !iterations )
+   {
+      std::fprintf( stderr, "usage: %s [iterations]\n", argv[0] );
+      return 1;
+   }
+
+   std::printf( "%zu iterations, times in ns/op\n\n", iterations );
+   std::printf( "%-22s %6s %6s %10s %10s %10s %10s\n",
+      "object", "pb B", "fix B", "pb enc", "pb dec", "fix enc", "fix dec" );
+
+   bench( "balance_object",      make_supply(),              iterations );
+   bench( "mana_balance_object", make_mana_balance(),        iterations );
+   bench( "resource_markets",    make_resource_markets(),    iterations );
+   bench( "difficulty_metadata", make_difficulty_metadata(), iterations );
+
+   return 0;
+}
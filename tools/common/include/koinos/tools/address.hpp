@@ -0,0 +1,180 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace koinos::tools {
+
+constexpr std::size_t max_address_size = 25;
+
+// An address stored inline, zero padded to max_address_size. Comparing the
+// padded bytes and then the size gives the same order as comparing the
+// addresses as strings.
+struct address_key
+{
+   uint8_t                                   size  = 0;
+   std::array< uint8_t, max_address_size >   bytes = {};
+
+   static bool from( const uint8_t* data, std::size_t len, address_key& out )
+   {
+      if ( len > max_address_size )
+         return false;
+
+      out.size = uint8_t( len );
+      out.bytes.fill( 0 );
+      if ( len )
+         std::memcpy( out.bytes.data(), data, len );
+      return true;
+   }
+
+   std::string str() const { return std::string( reinterpret_cast< const char* >( bytes.data() ), size ); }
+
+   friend bool operator ==( const address_key& a, const address_key& b )
+   {
+      return a.size == b.size && a.bytes == b.bytes;
+   }
+
+   friend bool operator !=( const address_key& a, const address_key& b ) { return !( a == b ); }
+
+   friend bool operator <( const address_key& a, const address_key& b )
+   {
+      int c = std::memcmp( a.bytes.data(), b.bytes.data(), max_address_size );
+      return c < 0 || ( c == 0 && a.size < b.size );
+   }
+};
+
+struct address_hash
+{
+   // FNV-1a. Addresses end in a checksum, so every byte is already well mixed.
+   std::size_t operator()( const address_key& k ) const
+   {
+      uint64_t h = 0xcbf29ce484222325ull;
+      for ( std::size_t i = 0; i < k.size; i++ )
+      {
+         h ^= k.bytes[i];
+         h *= 0x100000001b3ull;
+      }
+      return std::size_t( h );
+   }
+};
+
+namespace detail {
+
+constexpr char base58_alphabet[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+
+} // detail
+
+inline std::string to_base58( const uint8_t* data, std::size_t len )
+{
+   std::size_t zeros = 0;
+   while ( zeros < len && data[zeros] == 0 )
+      zeros++;
+
+   // log(256) / log(58) < 1.38
+   std::string digits( ( len - zeros ) * 138 / 100 + 1, 0 );
+   std::size_t used = 0;
+   for ( std::size_t i = zeros; i < len; i++ )
+   {
+      int carry = data[i];
+      std::size_t j = 0;
+      for ( auto it = digits.rbegin(); ( carry || j < used ) && it != digits.rend(); ++it, j++ )
+      {
+         carry += 256 * uint8_t( *it );
+         *it = char( carry % 58 );
+         carry /= 58;
+      }
+      used = j;
+   }
+
+   std::string out( zeros, '1' );
+   for ( auto it = digits.end() - used; it != digits.end(); ++it )
+      out.push_back( detail::base58_alphabet[uint8_t( *it )] );
+   return out;
+}
+
+inline bool from_base58( const std::string& text, std::string& out )
+{
+   std::size_t ones = 0;
+   while ( ones < text.size() && text[ones] == '1' )
+      ones++;
+
+   // log(58) / log(256) < 0.733
+   std::string bytes( ( text.size() - ones ) * 733 / 1000 + 1, 0 );
+   std::size_t used = 0;
+   for ( std::size_t i = ones; i < text.size(); i++ )
+   {
+      const char* p = std::strchr( detail::base58_alphabet, text[i] );
+      if ( !p || !*p )
+         return false;
+
+      int carry = int( p - detail::base58_alphabet );
+      std::size_t j = 0;
+      for ( auto it = bytes.rbegin(); ( carry || j < used ) && it != bytes.rend(); ++it, j++ )
+      {
+         carry += 58 * uint8_t( *it );
+         *it = char( carry % 256 );
+         carry /= 256;
+      }
+      used = j;
+   }
+
+   out.assign( ones, '\0' );
+   out.append( bytes.end() - used, bytes.end() );
+   return true;
+}
+
+inline std::string to_hex( const uint8_t* data, std::size_t len )
+{
+   static constexpr char digits[] = "0123456789abcdef";
+   std::string out;
+   out.reserve( 2 * len );
+   for ( std::size_t i = 0; i < len; i++ )
+   {
+      out.push_back( digits[data[i] >> 4] );
+      out.push_back( digits[data[i] & 0xf] );
+   }
+   return out;
+}
+
+inline bool from_hex( const std::string& text, std::string& out )
+{
+   auto nibble = []( char c ) -> int
+   {
+      if ( c >= '0' && c <= '9' ) return c - '0';
+      if ( c >= 'a' && c <= 'f' ) return c - 'a' + 10;
+      if ( c >= 'A' && c <= 'F' ) return c - 'A' + 10;
+      return -1;
+   };
+
+   if ( text.size() % 2 )
+      return false;
+
+   out.clear();
+   for ( std::size_t i = 0; i < text.size(); i += 2 )
+   {
+      int hi = nibble( text[i] ), lo = nibble( text[i + 1] );
+      if ( hi < 0 || lo < 0 )
+         return false;
+      out.push_back( char( hi << 4 | lo ) );
+   }
+   return true;
+}
+
+// Parses a command line address: hex with a 0x prefix, otherwise base58
+inline bool parse_address( const std::string& text, std::string& out )
+{
+   if ( text.size() >= 2 && text[0] == '0' && ( text[1] == 'x' || text[1] == 'X' ) )
+      return from_hex( text.substr( 2 ), out );
+   return from_base58( text, out );
+}
+
+inline std::string format_address( const address_key& k )
+{
+   return to_base58( k.bytes.data(), k.size );
+}
+
+} // koinos::tools
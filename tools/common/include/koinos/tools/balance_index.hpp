@@ -0,0 +1,174 @@
+#pragma once
+
+#include <koinos/system_contracts/fixed_layout.hpp>
+#include <koinos/tools/address.hpp>
+#include <koinos/tools/mapped_file.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Sorted balance index written by event_indexer.
+//
+// The file is a 64 byte header followed by fixed-size records sorted by
+// address, so a reader maps it and binary searches in place. All integers
+// are little endian.
+//
+//    header                         record
+//    0   magic "KOINBIDX"           0   address size
+//    8   format version             1   address, zero padded to 25 bytes
+//    12  record size                26  zero padding
+//    16  record count               32  balance
+//    24  supply (mints - burns)     40  last update, block time ms
+//    32  last block height
+//    40  last block time ms
+//    48  reserved, zero
+namespace koinos::tools::balance_index {
+
+constexpr char magic[8]             = { 'K', 'O', 'I', 'N', 'B', 'I', 'D', 'X' };
+constexpr uint32_t format_version   = 1;
+constexpr std::size_t header_size   = 64;
+constexpr std::size_t record_size   = 48;
+
+struct header
+{
+   uint64_t count            = 0;
+   uint64_t supply           = 0;
+   uint64_t last_height      = 0;
+   uint64_t last_timestamp   = 0;
+};
+
+struct entry
+{
+   address_key address;
+   uint64_t    balance     = 0;
+   uint64_t    last_update = 0;
+};
+
+inline void put_u32( uint8_t* p, uint32_t v )
+{
+   for ( std::size_t i = 0; i < sizeof( uint32_t ); i++ )
+      p[i] = uint8_t( v >> ( 8 * i ) );
+}
+
+inline uint32_t get_u32( const uint8_t* p )
+{
+   uint32_t v = 0;
+   for ( std::size_t i = 0; i < sizeof( uint32_t ); i++ )
+      v |= uint32_t( p[i] ) << ( 8 * i );
+   return v;
+}
+
+inline void write_header( uint8_t* out, const header& h )
+{
+   using system_contracts::fixed_layout::put_u64;
+
+   std::memset( out, 0, header_size );
+   std::memcpy( out, magic, sizeof( magic ) );
+   put_u32( out + 8, format_version );
+   put_u32( out + 12, record_size );
+   put_u64( out + 16, h.count );
+   put_u64( out + 24, h.supply );
+   put_u64( out + 32, h.last_height );
+   put_u64( out + 40, h.last_timestamp );
+}
+
+inline void write_record( uint8_t* out, const entry& e )
+{
+   using system_contracts::fixed_layout::put_u64;
+
+   std::memset( out, 0, record_size );
+   out[0] = e.address.size;
+   std::memcpy( out + 1, e.address.bytes.data(), max_address_size );
+   put_u64( out + 32, e.balance );
+   put_u64( out + 40, e.last_update );
+}
+
+inline void read_record( const uint8_t* in, entry& e )
+{
+   using system_contracts::fixed_layout::get_u64;
+
+   e.address.size = in[0];
+   std::memcpy( e.address.bytes.data(), in + 1, max_address_size );
+   e.balance     = get_u64( in + 32 );
+   e.last_update = get_u64( in + 40 );
+}
+
+// Read-only view of an index file
+class reader
+{
+public:
+   bool open( const std::string& path, std::string& error )
+   {
+      using system_contracts::fixed_layout::get_u64;
+
+      if ( !_file.open( path, error ) )
+         return false;
+
+      const uint8_t* p = _file.data();
+      if ( _file.size() < header_size || std::memcmp( p, magic, sizeof( magic ) ) != 0 )
+      {
+         error = path + " is not a balance index";
+         return false;
+      }
+
+      if ( get_u32( p + 8 ) != format_version || get_u32( p + 12 ) != record_size )
+      {
+         error = path + " has an unsupported index version";
+         return false;
+      }
+
+      _header.count          = get_u64( p + 16 );
+      _header.supply         = get_u64( p + 24 );
+      _header.last_height    = get_u64( p + 32 );
+      _header.last_timestamp = get_u64( p + 40 );
+
+      if ( ( _file.size() - header_size ) / record_size < _header.count )
+      {
+         error = path + " is truncated";
+         return false;
+      }
+
+      return true;
+   }
+
+   const header& info() const { return _header; }
+   std::size_t size() const { return std::size_t( _header.count ); }
+
+   entry at( std::size_t i ) const
+   {
+      entry e;
+      read_record( record( i ), e );
+      return e;
+   }
+
+   // Binary search for an address
+   bool find( const address_key& address, entry& e ) const
+   {
+      std::size_t lo = 0, hi = size();
+      while ( lo < hi )
+      {
+         std::size_t mid = lo + ( hi - lo ) / 2;
+         read_record( record( mid ), e );
+         if ( e.address < address )
+            lo = mid + 1;
+         else
+            hi = mid;
+      }
+
+      if ( lo == size() )
+         return false;
+
+      read_record( record( lo ), e );
+      return e.address == address;
+   }
+
+private:
+   const uint8_t* record( std::size_t i ) const { return _file.data() + header_size + i * record_size; }
+
+   mapped_file _file;
+   header      _header;
+};
+
+} // koinos::tools::balance_index
@@ -0,0 +1,265 @@
+#pragma once
+
+#include <koinos/system_contracts/wire.hpp>
+#include <koinos/tools/address.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Exported chain event logs.
+//
+// A log is a sequence of block records. Each record is a varint length
+// followed by a block_events message:
+//
+//    message block_events {
+//       uint64 height = 1;
+//       uint64 timestamp = 2;                       // Block time, ms
+//       repeated koinos.protocol.event_data events = 3;
+//    }
+//
+//    message event_data {                          // koinos/protocol/protocol.proto
+//       uint32 sequence = 1;
+//       bytes source = 2;
+//       string name = 3;
+//       bytes data = 4;
+//       repeated bytes impacted = 5;
+//    }
+//
+// Records are independent, so a log can be split at record boundaries and
+// replayed in parallel.
+namespace koinos::tools::event_log {
+
+namespace wire = koinos::system_contracts::wire;
+
+struct record_span
+{
+   std::size_t offset = 0; // Of the block_events message, after the length
+   std::size_t size   = 0;
+};
+
+struct block_info
+{
+   uint64_t height    = 0;
+   uint64_t timestamp = 0;
+};
+
+struct event
+{
+   uint32_t         sequence = 0;
+   std::string_view source;
+   std::string_view name;
+   const uint8_t*   data      = nullptr;
+   std::size_t      data_size = 0;
+};
+
+// Finds every block record. Only the length prefixes are read.
+inline bool split_records( const uint8_t* data, std::size_t size, std::vector< record_span >& records, std::string& error )
+{
+   wire::reader rdr( data, size );
+   while ( !rdr.eof() )
+   {
+      const uint8_t* body;
+      std::size_t body_size;
+      if ( !rdr.read_bytes( body, body_size ) )
+      {
+         error = "truncated block record at offset " + std::to_string( rdr.position() - data );
+         return false;
+      }
+
+      records.push_back( { std::size_t( body - data ), body_size } );
+   }
+
+   return true;
+}
+
+namespace detail {
+
+inline std::string_view view( const uint8_t* data, std::size_t len )
+{
+   return std::string_view( reinterpret_cast< const char* >( data ), len );
+}
+
+inline bool parse_event( const uint8_t* data, std::size_t len, event& ev )
+{
+   ev = event();
+   wire::reader rdr( data, len );
+   while ( !rdr.eof() )
+   {
+      uint32_t field;
+      wire::wire_type type;
+      if ( !rdr.read_tag( field, type ) )
+         return false;
+
+      const uint8_t* value;
+      std::size_t value_len;
+      uint64_t v;
+
+      if ( field == 1 && type == wire::wire_type::varint )
+      {
+         if ( !rdr.read_varint( v ) )
+            return false;
+         ev.sequence = uint32_t( v );
+      }
+      else if ( field >= 2 && field <= 4 && type == wire::wire_type::length_delimited )
+      {
+         if ( !rdr.read_bytes( value, value_len ) )
+            return false;
+
+         if ( field == 2 )
+            ev.source = view( value, value_len );
+         else if ( field == 3 )
+            ev.name = view( value, value_len );
+         else
+         {
+            ev.data      = value;
+            ev.data_size = value_len;
+         }
+      }
+      else if ( !rdr.skip( type ) )
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+} // detail
+
+// Calls fn( const block_info&, const event& ) for each event of a block
+// record, in log order. Returns false if the record is malformed.
+template< typename Fn >
+bool for_each_event( const uint8_t* data, std::size_t size, Fn&& fn )
+{
+   block_info block;
+   wire::reader rdr( data, size );
+
+   // The block fields may follow the events, so read them first
+   while ( !rdr.eof() )
+   {
+      uint32_t field;
+      wire::wire_type type;
+      if ( !rdr.read_tag( field, type ) )
+         return false;
+
+      if ( ( field == 1 || field == 2 ) && type == wire::wire_type::varint )
+      {
+         if ( !rdr.read_varint( field == 1 ? block.height : block.timestamp ) )
+            return false;
+      }
+      else if ( !rdr.skip( type ) )
+      {
+         return false;
+      }
+   }
+
+   rdr = wire::reader( data, size );
+   while ( !rdr.eof() )
+   {
+      uint32_t field;
+      wire::wire_type type;
+      if ( !rdr.read_tag( field, type ) )
+         return false;
+
+      if ( field == 3 && type == wire::wire_type::length_delimited )
+      {
+         const uint8_t* value;
+         std::size_t value_len;
+         event ev;
+         if ( !rdr.read_bytes( value, value_len ) || !detail::parse_event( value, value_len, ev ) )
+            return false;
+
+         fn( block, ev );
+      }
+      else if ( !rdr.skip( type ) )
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+// Token events, koinos/contracts/token/token.proto
+
+constexpr std::string_view transfer_event_name = "koinos.contracts.token.transfer_event";
+constexpr std::string_view mint_event_name     = "koinos.contracts.token.mint_event";
+constexpr std::string_view burn_event_name     = "koinos.contracts.token.burn_event";
+
+enum class token_event_type : uint8_t
+{
+   none,
+   transfer, // transfer_event { bytes from = 1; bytes to = 2; uint64 value = 3; }
+   mint,     // mint_event { bytes to = 1; uint64 value = 2; }
+   burn      // burn_event { bytes from = 1; uint64 value = 2; }
+};
+
+struct token_event
+{
+   token_event_type type  = token_event_type::none;
+   address_key      from;
+   address_key      to;
+   uint64_t         value = 0;
+};
+
+inline token_event_type classify( std::string_view name )
+{
+   if ( name == transfer_event_name )
+      return token_event_type::transfer;
+   if ( name == mint_event_name )
+      return token_event_type::mint;
+   if ( name == burn_event_name )
+      return token_event_type::burn;
+   return token_event_type::none;
+}
+
+// Decodes a token event. Returns false for other events and malformed ones;
+// te.type tells them apart.
+inline bool decode_token_event( const event& ev, token_event& te )
+{
+   te = token_event();
+   auto type = classify( ev.name );
+   if ( type == token_event_type::none )
+      return false;
+
+   te.type = type;
+
+   uint32_t value_field = type == token_event_type::transfer ? 3 : 2;
+   wire::reader rdr( ev.data, ev.data_size );
+   while ( !rdr.eof() )
+   {
+      uint32_t field;
+      wire::wire_type wt;
+      if ( !rdr.read_tag( field, wt ) )
+         return false;
+
+      if ( field == value_field && wt == wire::wire_type::varint )
+      {
+         if ( !rdr.read_varint( te.value ) )
+            return false;
+      }
+      else if ( field < value_field && wt == wire::wire_type::length_delimited )
+      {
+         const uint8_t* addr;
+         std::size_t addr_len;
+         if ( !rdr.read_bytes( addr, addr_len ) )
+            return false;
+
+         // Field 1 is `from` for transfers and burns and `to` for mints
+         bool is_to = field == 2 || type == token_event_type::mint;
+         if ( !address_key::from( addr, addr_len, is_to ? te.to : te.from ) )
+            return false;
+      }
+      else if ( !rdr.skip( wt ) )
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+} // koinos::tools::event_log
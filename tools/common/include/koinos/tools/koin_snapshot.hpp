@@ -0,0 +1,383 @@
+#pragma once
+
+#include <koinos/system_contracts/fixed_layout.hpp>
+#include <koinos/system_contracts/uint.hpp>
+#include <koinos/tools/address.hpp>
+#include <koinos/tools/mapped_file.hpp>
+#include <koinos/tools/parallel.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Columnar KOIN state snapshot.
+//
+// One row per account of KOIN's balance space, sorted by address, stored as
+// fixed-width columns so a reader maps the file and scans or binary searches
+// a column without decoding anything. All integers are little endian.
+//
+//    header (128 bytes)
+//    0    magic "KOINSNAP"
+//    8    format version
+//    12   flags
+//    16   row count
+//    24   supply, from KOIN's supply space
+//    32   block height
+//    40   block time, ms
+//    48   offset of the address column     count x 26: size, address zero padded to 25
+//    56   offset of the balance column     count x u64
+//    64   offset of the mana column        count x u64
+//    72   offset of the mana update column count x u64, ms
+//    80   file size
+//    88   checksum of bytes [header_size, file size)
+//    96   reserved, zero
+//
+// Columns start on 64 byte boundaries. The checksum is computed over 1 MiB
+// blocks in parallel, see checksum() below.
+namespace koinos::tools::koin_snapshot {
+
+constexpr char magic[8]                = { 'K', 'O', 'I', 'N', 'S', 'N', 'A', 'P' };
+constexpr uint32_t format_version      = 1;
+constexpr std::size_t header_size      = 128;
+constexpr std::size_t address_width    = 1 + max_address_size;
+constexpr std::size_t column_alignment = 64;
+constexpr std::size_t checksum_block   = 1 << 20;
+
+// The mana columns were not known when the snapshot was built, for example
+// when it was built from an event index. They are zero, which regenerates to
+// a full balance.
+constexpr uint32_t flag_mana_unknown = 1 << 0;
+
+struct header
+{
+   uint32_t flags           = 0;
+   uint64_t count           = 0;
+   uint64_t supply          = 0;
+   uint64_t height          = 0;
+   uint64_t timestamp       = 0;
+   uint64_t addresses       = 0;
+   uint64_t balances        = 0;
+   uint64_t mana            = 0;
+   uint64_t mana_updates    = 0;
+   uint64_t file_size       = 0;
+   uint64_t checksum        = 0;
+};
+
+struct row
+{
+   address_key address;
+   uint64_t    balance          = 0;
+   uint64_t    mana             = 0;
+   uint64_t    last_mana_update = 0;
+};
+
+namespace detail {
+
+inline void put_u32( uint8_t* p, uint32_t v )
+{
+   for ( std::size_t i = 0; i < sizeof( uint32_t ); i++ )
+      p[i] = uint8_t( v >> ( 8 * i ) );
+}
+
+inline uint32_t get_u32( const uint8_t* p )
+{
+   uint32_t v = 0;
+   for ( std::size_t i = 0; i < sizeof( uint32_t ); i++ )
+      v |= uint32_t( p[i] ) << ( 8 * i );
+   return v;
+}
+
+constexpr uint64_t align( uint64_t n )
+{
+   return ( n + column_alignment - 1 ) / column_alignment * column_alignment;
+}
+
+constexpr uint64_t fnv_offset = 0xcbf29ce484222325ull;
+constexpr uint64_t fnv_prime  = 0x100000001b3ull;
+
+// FNV-1a over little endian 64-bit words, the tail zero padded
+inline uint64_t hash_block( const uint8_t* data, std::size_t size )
+{
+   uint64_t h = fnv_offset;
+   std::size_t i = 0;
+   for ( ; i + 8 <= size; i += 8 )
+   {
+      h ^= system_contracts::fixed_layout::get_u64( data + i );
+      h *= fnv_prime;
+   }
+
+   if ( i < size )
+   {
+      uint8_t tail[8] = {};
+      std::memcpy( tail, data + i, size - i );
+      h ^= system_contracts::fixed_layout::get_u64( tail );
+      h *= fnv_prime;
+   }
+
+   h ^= size;
+   h *= fnv_prime;
+   return h;
+}
+
+} // detail
+
+// The checksum of a byte range: each 1 MiB block is hashed independently,
+// then the block hashes are hashed in order.
+inline uint64_t checksum( const uint8_t* data, std::size_t size, std::size_t threads )
+{
+   std::size_t blocks = ( size + checksum_block - 1 ) / checksum_block;
+   std::vector< uint64_t > hashes( blocks );
+
+   parallel_for( blocks, threads, [&]( std::size_t b )
+   {
+      std::size_t begin = b * checksum_block;
+      hashes[b] = detail::hash_block( data + begin, std::min( checksum_block, size - begin ) );
+   } );
+
+   uint64_t h = detail::fnv_offset;
+   for ( auto block_hash : hashes )
+   {
+      h ^= block_hash;
+      h *= detail::fnv_prime;
+   }
+   return h;
+}
+
+inline header layout( uint64_t count )
+{
+   header h;
+   h.count        = count;
+   h.addresses    = header_size;
+   h.balances     = detail::align( h.addresses + count * address_width );
+   h.mana         = detail::align( h.balances + count * 8 );
+   h.mana_updates = detail::align( h.mana + count * 8 );
+   h.file_size    = h.mana_updates + count * 8;
+   return h;
+}
+
+inline void write_header( uint8_t* out, const header& h )
+{
+   using system_contracts::fixed_layout::put_u64;
+
+   std::memset( out, 0, header_size );
+   std::memcpy( out, magic, sizeof( magic ) );
+   detail::put_u32( out + 8, format_version );
+   detail::put_u32( out + 12, h.flags );
+   put_u64( out + 16, h.count );
+   put_u64( out + 24, h.supply );
+   put_u64( out + 32, h.height );
+   put_u64( out + 40, h.timestamp );
+   put_u64( out + 48, h.addresses );
+   put_u64( out + 56, h.balances );
+   put_u64( out + 64, h.mana );
+   put_u64( out + 72, h.mana_updates );
+   put_u64( out + 80, h.file_size );
+   put_u64( out + 88, h.checksum );
+}
+
+// Writes a snapshot of a known number of rows. Rows may be set from several
+// threads at once as long as each index is set once.
+class writer
+{
+public:
+   bool create( const std::string& path, uint64_t count, std::string& error )
+   {
+      _path   = path;
+      _header = layout( count );
+      return _file.create( path, std::size_t( _header.file_size ), error );
+   }
+
+   const header& info() const { return _header; }
+
+   void set_row( std::size_t i, const row& r )
+   {
+      using system_contracts::fixed_layout::put_u64;
+
+      uint8_t* p = _file.mutable_data();
+      uint8_t* a = p + _header.addresses + i * address_width;
+      a[0] = r.address.size;
+      std::memcpy( a + 1, r.address.bytes.data(), max_address_size );
+      put_u64( p + _header.balances + i * 8, r.balance );
+      put_u64( p + _header.mana + i * 8, r.mana );
+      put_u64( p + _header.mana_updates + i * 8, r.last_mana_update );
+   }
+
+   // Checksums the columns, writes the header and closes the file
+   bool finish( uint32_t flags, uint64_t supply, uint64_t height, uint64_t timestamp, std::size_t threads, std::string& error )
+   {
+      uint8_t* p = _file.mutable_data();
+
+      _header.flags     = flags;
+      _header.supply    = supply;
+      _header.height    = height;
+      _header.timestamp = timestamp;
+      _header.checksum  = checksum( p + header_size, std::size_t( _header.file_size ) - header_size, threads );
+      write_header( p, _header );
+
+      if ( !_file.close() )
+      {
+         error = "cannot write " + _path;
+         return false;
+      }
+
+      return true;
+   }
+
+private:
+   std::string _path;
+   mapped_file _file;
+   header      _header;
+};
+
+struct verify_report
+{
+   bool        checksum_ok   = false;
+   bool        sorted        = false;
+   std::size_t mana_over     = 0;   // Rows with more mana than balance
+   system_contracts::uint128 total;
+};
+
+// Read-only view of a snapshot
+class reader
+{
+public:
+   bool open( const std::string& path, std::string& error )
+   {
+      using system_contracts::fixed_layout::get_u64;
+
+      if ( !_file.open( path, error ) )
+         return false;
+
+      const uint8_t* p = _file.data();
+      if ( _file.size() < header_size || std::memcmp( p, magic, sizeof( magic ) ) != 0 )
+      {
+         error = path + " is not a KOIN snapshot";
+         return false;
+      }
+
+      if ( detail::get_u32( p + 8 ) != format_version )
+      {
+         error = path + " has an unsupported snapshot version";
+         return false;
+      }
+
+      _header.flags        = detail::get_u32( p + 12 );
+      _header.count        = get_u64( p + 16 );
+      _header.supply       = get_u64( p + 24 );
+      _header.height       = get_u64( p + 32 );
+      _header.timestamp    = get_u64( p + 40 );
+      _header.addresses    = get_u64( p + 48 );
+      _header.balances     = get_u64( p + 56 );
+      _header.mana         = get_u64( p + 64 );
+      _header.mana_updates = get_u64( p + 72 );
+      _header.file_size    = get_u64( p + 80 );
+      _header.checksum     = get_u64( p + 88 );
+
+      auto expected = layout( _header.count );
+      if ( _header.file_size != _file.size() || _header.addresses != expected.addresses || _header.balances != expected.balances
+         || _header.mana != expected.mana || _header.mana_updates != expected.mana_updates || _header.file_size != expected.file_size )
+      {
+         error = path + " has an inconsistent layout or is truncated";
+         return false;
+      }
+
+      return true;
+   }
+
+   const header& info() const { return _header; }
+   std::size_t size() const { return std::size_t( _header.count ); }
+
+   address_key address( std::size_t i ) const
+   {
+      const uint8_t* a = _file.data() + _header.addresses + i * address_width;
+      address_key k;
+      k.size = a[0];
+      std::memcpy( k.bytes.data(), a + 1, max_address_size );
+      return k;
+   }
+
+   uint64_t balance( std::size_t i ) const          { return u64_at( _header.balances, i ); }
+   uint64_t mana( std::size_t i ) const             { return u64_at( _header.mana, i ); }
+   uint64_t last_mana_update( std::size_t i ) const { return u64_at( _header.mana_updates, i ); }
+
+   row at( std::size_t i ) const
+   {
+      return row{ address( i ), balance( i ), mana( i ), last_mana_update( i ) };
+   }
+
+   // Binary search of the address column
+   bool find( const address_key& k, std::size_t& index ) const
+   {
+      std::size_t lo = 0, hi = size();
+      while ( lo < hi )
+      {
+         std::size_t mid = lo + ( hi - lo ) / 2;
+         if ( address( mid ) < k )
+            lo = mid + 1;
+         else
+            hi = mid;
+      }
+
+      index = lo;
+      return lo < size() && address( lo ) == k;
+   }
+
+   // Checks the checksum, that addresses are strictly increasing, and sums
+   // the balances. Rows are checked in parallel chunks.
+   verify_report verify( std::size_t threads ) const
+   {
+      verify_report report;
+      report.checksum_ok = checksum( _file.data() + header_size, _file.size() - header_size, threads ) == _header.checksum;
+
+      constexpr std::size_t chunk_rows = 1 << 16;
+
+      struct partial
+      {
+         bool                      sorted    = true;
+         std::size_t               mana_over = 0;
+         system_contracts::uint128 total;
+      };
+      std::vector< partial > partials( ( size() + chunk_rows - 1 ) / chunk_rows );
+
+      parallel_for_ranges( size(), chunk_rows, threads, [&]( std::size_t begin, std::size_t end )
+      {
+         auto& part = partials[begin / chunk_rows];
+
+         // Each chunk also compares its first row with the previous chunk's last
+         for ( std::size_t i = begin; i < end; i++ )
+         {
+            if ( i && !( address( i - 1 ) < address( i ) ) )
+               part.sorted = false;
+
+            auto bal = balance( i );
+            part.total += bal;
+            if ( mana( i ) > bal )
+               part.mana_over++;
+         }
+      } );
+
+      report.sorted = true;
+      for ( const auto& part : partials )
+      {
+         report.sorted = report.sorted && part.sorted;
+         report.mana_over += part.mana_over;
+         report.total += part.total;
+      }
+
+      return report;
+   }
+
+private:
+   uint64_t u64_at( uint64_t column, std::size_t i ) const
+   {
+      return system_contracts::fixed_layout::get_u64( _file.data() + column + i * 8 );
+   }
+
+   mapped_file _file;
+   header      _header;
+};
+
+} // koinos::tools::koin_snapshot
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+namespace koinos::tools {
+
+// Maps a whole file into memory, either read-only or read-write
+class mapped_file
+{
+public:
+   mapped_file() = default;
+   mapped_file( const mapped_file& ) = delete;
+   mapped_file& operator =( const mapped_file& ) = delete;
+
+   mapped_file( mapped_file&& o ) noexcept { *this = std::move( o ); }
+
+   mapped_file& operator =( mapped_file&& o ) noexcept
+   {
+      if ( this != &o )
+      {
+         close();
+         std::swap( _data, o._data );
+         std::swap( _size, o._size );
+         std::swap( _writable, o._writable );
+      }
+      return *this;
+   }
+
+   ~mapped_file() { close(); }
+
+   // Maps an existing file read-only
+   bool open( const std::string& path, std::string& error )
+   {
+      close();
+
+      int fd = ::open( path.c_str(), O_RDONLY );
+      if ( fd < 0 )
+         return fail( "cannot open " + path, error );
+
+      struct stat st;
+      if ( ::fstat( fd, &st ) != 0 )
+      {
+         ::close( fd );
+         return fail( "cannot stat " + path, error );
+      }
+
+      bool ok = map( fd, std::size_t( st.st_size ), PROT_READ, path, error );
+      ::close( fd );
+      return ok;
+   }
+
+   // Creates or truncates the file to size bytes and maps it read-write
+   bool create( const std::string& path, std::size_t size, std::string& error )
+   {
+      close();
+
+      int fd = ::open( path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+      if ( fd < 0 )
+         return fail( "cannot create " + path, error );
+
+      if ( ::ftruncate( fd, off_t( size ) ) != 0 )
+      {
+         ::close( fd );
+         return fail( "cannot resize " + path, error );
+      }
+
+      bool ok = map( fd, size, PROT_READ | PROT_WRITE, path, error );
+      ::close( fd );
+      _writable = ok;
+      return ok;
+   }
+
+   // Writes back a read-write mapping and unmaps the file
+   bool close()
+   {
+      bool ok = true;
+      if ( _data )
+      {
+         if ( _writable )
+            ok = ::msync( _data, _size, MS_SYNC ) == 0;
+         ::munmap( _data, _size );
+      }
+
+      _data     = nullptr;
+      _size     = 0;
+      _writable = false;
+      return ok;
+   }
+
+   // Hints that the mapping will be read front to back
+   void advise_sequential() const
+   {
+      if ( _data )
+         ::madvise( _data, _size, MADV_SEQUENTIAL );
+   }
+
+   const uint8_t* data() const { return static_cast< const uint8_t* >( _data ); }
+   uint8_t* mutable_data() { return _writable ? static_cast< uint8_t* >( _data ) : nullptr; }
+   std::size_t size() const { return _size; }
+
+private:
+   bool map( int fd, std::size_t size, int prot, const std::string& path, std::string& error )
+   {
+      // mmap rejects empty mappings, an empty file is simply no data
+      if ( size == 0 )
+         return true;
+
+      void* p = ::mmap( nullptr, size, prot, MAP_SHARED, fd, 0 );
+      if ( p == MAP_FAILED )
+         return fail( "cannot map " + path, error );
+
+      _data = p;
+      _size = size;
+      return true;
+   }
+
+   static bool fail( const std::string& what, std::string& error )
+   {
+      error = what + ": " + std::strerror( errno );
+      return false;
+   }
+
+   void*       _data     = nullptr;
+   std::size_t _size     = 0;
+   bool        _writable = false;
+};
+
+} // koinos::tools
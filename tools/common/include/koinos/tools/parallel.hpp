@@ -0,0 +1,60 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace koinos::tools {
+
+inline std::size_t default_thread_count()
+{
+   auto n = std::thread::hardware_concurrency();
+   return n ? n : 1;
+}
+
+// Calls fn( i ) for every i in [0, count) on up to `threads` threads. Workers
+// take the next index as they finish, so uneven work items balance out.
+template< typename Fn >
+void parallel_for( std::size_t count, std::size_t threads, Fn&& fn )
+{
+   threads = std::max< std::size_t >( 1, std::min( threads, count ) );
+   if ( threads == 1 )
+   {
+      for ( std::size_t i = 0; i < count; i++ )
+         fn( i );
+      return;
+   }
+
+   std::atomic< std::size_t > next{ 0 };
+   auto worker = [&]()
+   {
+      for ( auto i = next++; i < count; i = next++ )
+         fn( i );
+   };
+
+   std::vector< std::thread > pool;
+   pool.reserve( threads - 1 );
+   for ( std::size_t t = 1; t < threads; t++ )
+      pool.emplace_back( worker );
+
+   worker();
+
+   for ( auto& t : pool )
+      t.join();
+}
+
+// Calls fn( begin, end ) for consecutive ranges of at most `chunk` indices
+// covering [0, count), for per-item work too small to schedule one by one.
+template< typename Fn >
+void parallel_for_ranges( std::size_t count, std::size_t chunk, std::size_t threads, Fn&& fn )
+{
+   chunk = std::max< std::size_t >( 1, chunk );
+   parallel_for( ( count + chunk - 1 ) / chunk, threads, [&]( std::size_t c )
+   {
+      fn( c * chunk, std::min( count, ( c + 1 ) * chunk ) );
+   } );
+}
+
+} // koinos::tools
@@ -0,0 +1,450 @@
+#include <koinos/system_contracts/uint.hpp>
+#include <koinos/tools/address.hpp>
+#include <koinos/tools/balance_index.hpp>
+#include <koinos/tools/event_log.hpp>
+#include <koinos/tools/mapped_file.hpp>
+#include <koinos/tools/parallel.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Folds KOIN transfer, mint and burn events from an exported event log into
+// a sorted, memory-mapped balance index (see balance_index.hpp).
+//
+// Balances are sums of credits and debits, so the log is replayed out of
+// order: block records are split across threads, each thread accumulates
+// per-account deltas into one map per account shard, and each shard is then
+// merged, sorted and written by its own thread.
+
+using namespace koinos;
+using namespace koinos::tools;
+
+using system_contracts::uint128;
+
+namespace {
+
+using index_clock = std::chrono::steady_clock;
+
+struct account_delta
+{
+   uint128  credit;
+   uint128  debit;
+   uint64_t last_update = 0;
+};
+
+using delta_map = std::unordered_map< address_key, account_delta, address_hash >;
+
+struct worker_state
+{
+   std::vector< delta_map > shards;
+   uint128                  minted;
+   uint128                  burned;
+   uint64_t                 events       = 0;
+   uint64_t                 last_height  = 0;
+   uint64_t                 last_time    = 0;
+   std::size_t              bad_records  = 0;
+   std::size_t              bad_events   = 0;
+};
+
+struct options
+{
+   std::string log_path;
+   std::string index_path;
+   std::string contract;
+   std::size_t threads         = default_thread_count();
+   bool        check_supply    = false;
+   uint64_t    expected_supply = 0;
+};
+
+int usage( const char* argv0 )
+{
+   std::fprintf( stderr,
+      "usage: %s [-j threads] [-c contract] [-s supply] <event_log> <index>\n"
+      "       %s --lookup <index> <address>...\n"
+      "\n"
+      "  -j threads   worker threads (default: hardware concurrency)\n"
+      "  -c contract  only fold events from this contract id (base58 or 0x hex)\n"
+      "  -s supply    also require the indexed supply to equal this value\n",
+      argv0, argv0 );
+   return 1;
+}
+
+std::string to_string( const uint128& v )
+{
+   if ( !v )
+      return "0";
+
+   std::string s;
+   for ( auto x = v; x; x /= 10 )
+      s.push_back( char( '0' + ( x % 10 ).convert_to< uint64_t >() ) );
+   std::reverse( s.begin(), s.end() );
+   return s;
+}
+
+double seconds_since( index_clock::time_point start )
+{
+   return std::chrono::duration< double >( index_clock::now() - start ).count();
+}
+
+void credit( worker_state& w, std::size_t shards, const address_key& to, uint64_t value, uint64_t time )
+{
+   auto& d = w.shards[address_hash()( to ) % shards][to];
+   d.credit += value;
+   d.last_update = std::max( d.last_update, time );
+}
+
+void debit( worker_state& w, std::size_t shards, const address_key& from, uint64_t value, uint64_t time )
+{
+   auto& d = w.shards[address_hash()( from ) % shards][from];
+   d.debit += value;
+   d.last_update = std::max( d.last_update, time );
+}
+
+void replay( const uint8_t* log, const std::vector< event_log::record_span >& records, std::size_t begin, std::size_t end,
+   const std::string& contract, std::size_t shards, worker_state& w )
+{
+   w.shards.resize( shards );
+
+   for ( std::size_t r = begin; r < end; r++ )
+   {
+      bool ok = event_log::for_each_event( log + records[r].offset, records[r].size,
+         [&]( const event_log::block_info& block, const event_log::event& ev )
+         {
+            w.last_height = std::max( w.last_height, block.height );
+            w.last_time   = std::max( w.last_time, block.timestamp );
+
+            if ( !contract.empty() && ev.source != contract )
+               return;
+
+            event_log::token_event te;
+            if ( !event_log::decode_token_event( ev, te ) )
+            {
+               if ( te.type != event_log::token_event_type::none )
+                  w.bad_events++;
+               return;
+            }
+
+            w.events++;
+            switch ( te.type )
+            {
+               case event_log::token_event_type::transfer:
+                  debit( w, shards, te.from, te.value, block.timestamp );
+                  credit( w, shards, te.to, te.value, block.timestamp );
+                  break;
+               case event_log::token_event_type::mint:
+                  credit( w, shards, te.to, te.value, block.timestamp );
+                  w.minted += te.value;
+                  break;
+               case event_log::token_event_type::burn:
+                  debit( w, shards, te.from, te.value, block.timestamp );
+                  w.burned += te.value;
+                  break;
+               default:
+                  break;
+            }
+         } );
+
+      if ( !ok )
+         w.bad_records++;
+   }
+}
+
+struct shard_result
+{
+   std::vector< balance_index::entry > entries;
+   uint128                             total;
+   std::size_t                         negative = 0;
+   std::size_t                         overflow = 0;
+};
+
+void merge_shard( std::vector< worker_state >& workers, std::size_t s, shard_result& out )
+{
+   auto& merged = workers[0].shards[s];
+   for ( std::size_t t = 1; t < workers.size(); t++ )
+   {
+      for ( auto& [ address, d ] : workers[t].shards[s] )
+      {
+         auto& m = merged[address];
+         m.credit += d.credit;
+         m.debit  += d.debit;
+         m.last_update = std::max( m.last_update, d.last_update );
+      }
+      delta_map().swap( workers[t].shards[s] );
+   }
+
+   out.entries.reserve( merged.size() );
+   for ( auto& [ address, d ] : merged )
+   {
+      balance_index::entry e;
+      e.address     = address;
+      e.last_update = d.last_update;
+
+      if ( d.credit < d.debit )
+      {
+         if ( out.negative++ < 5 )
+            std::fprintf( stderr, "negative balance for %s\n", format_address( address ).c_str() );
+      }
+      else
+      {
+         auto balance = d.credit - d.debit;
+         if ( balance > uint128( ~uint64_t( 0 ) ) )
+            out.overflow++;
+         e.balance = balance.convert_to< uint64_t >();
+         out.total += balance;
+      }
+
+      out.entries.push_back( e );
+   }
+   delta_map().swap( merged );
+
+   std::sort( out.entries.begin(), out.entries.end(),
+      []( const auto& a, const auto& b ) { return a.address < b.address; } );
+}
+
+bool write_index( const std::string& path, std::vector< shard_result >& shards, const balance_index::header& h, std::string& error )
+{
+   mapped_file out;
+   if ( !out.create( path, balance_index::header_size + h.count * balance_index::record_size, error ) )
+      return false;
+
+   uint8_t* p = out.mutable_data();
+   balance_index::write_header( p, h );
+   p += balance_index::header_size;
+
+   // k-way merge of the sorted shards
+   using cursor = std::pair< std::size_t, std::size_t >; // shard, position
+   auto greater = [&]( const cursor& a, const cursor& b )
+   {
+      return shards[b.first].entries[b.second].address < shards[a.first].entries[a.second].address;
+   };
+   std::priority_queue< cursor, std::vector< cursor >, decltype( greater ) > heads( greater );
+
+   for ( std::size_t s = 0; s < shards.size(); s++ )
+      if ( !shards[s].entries.empty() )
+         heads.push( { s, 0 } );
+
+   while ( !heads.empty() )
+   {
+      auto [ s, i ] = heads.top();
+      heads.pop();
+
+      balance_index::write_record( p, shards[s].entries[i] );
+      p += balance_index::record_size;
+
+      if ( i + 1 < shards[s].entries.size() )
+         heads.push( { s, i + 1 } );
+   }
+
+   if ( !out.close() )
+   {
+      error = "cannot write " + path;
+      return false;
+   }
+
+   return true;
+}
+
+int build( const options& opts )
+{
+   auto start = index_clock::now();
+   std::string error;
+
+   std::string contract;
+   if ( !opts.contract.empty() && !parse_address( opts.contract, contract ) )
+   {
+      std::fprintf( stderr, "invalid contract id: %s\n", opts.contract.c_str() );
+      return 1;
+   }
+
+   mapped_file log;
+   if ( !log.open( opts.log_path, error ) )
+   {
+      std::fprintf( stderr, "%s\n", error.c_str() );
+      return 1;
+   }
+   log.advise_sequential();
+
+   std::vector< event_log::record_span > records;
+   if ( !event_log::split_records( log.data(), log.size(), records, error ) )
+   {
+      std::fprintf( stderr, "%s: %s\n", opts.log_path.c_str(), error.c_str() );
+      return 1;
+   }
+
+   // Block records are split into more chunks than threads so that blocks
+   // with many events do not leave threads idle
+   std::size_t threads = std::max< std::size_t >( 1, opts.threads );
+   std::size_t shards  = threads;
+   std::size_t chunks  = std::min( records.size(), threads * 8 );
+
+   std::vector< worker_state > workers( std::max< std::size_t >( 1, chunks ) );
+   parallel_for( workers.size(), threads, [&]( std::size_t c )
+   {
+      replay( log.data(), records, c * records.size() / workers.size(), ( c + 1 ) * records.size() / workers.size(),
+         contract, shards, workers[c] );
+   } );
+
+   auto replayed = seconds_since( start );
+
+   balance_index::header h;
+   uint128 minted, burned;
+   uint64_t events = 0;
+   std::size_t bad_records = 0, bad_events = 0;
+   for ( const auto& w : workers )
+   {
+      minted += w.minted;
+      burned += w.burned;
+      events += w.events;
+      bad_records += w.bad_records;
+      bad_events  += w.bad_events;
+      h.last_height    = std::max( h.last_height, w.last_height );
+      h.last_timestamp = std::max( h.last_timestamp, w.last_time );
+   }
+
+   std::vector< shard_result > results( shards );
+   parallel_for( shards, threads, [&]( std::size_t s ) { merge_shard( workers, s, results[s] ); } );
+   workers.clear();
+
+   uint128 total;
+   std::size_t negative = 0, overflow = 0;
+   for ( const auto& r : results )
+   {
+      h.count  += r.entries.size();
+      total    += r.total;
+      negative += r.negative;
+      overflow += r.overflow;
+   }
+
+   uint128 supply = minted >= burned ? minted - burned : uint128( 0 );
+   h.supply = supply.convert_to< uint64_t >();
+
+   if ( !write_index( opts.index_path, results, h, error ) )
+   {
+      std::fprintf( stderr, "%s\n", error.c_str() );
+      return 1;
+   }
+
+   std::printf( "blocks:           %zu\n", records.size() );
+   std::printf( "token events:     %llu\n", (unsigned long long)events );
+   std::printf( "accounts:         %llu\n", (unsigned long long)h.count );
+   std::printf( "last block:       %llu (%llu ms)\n", (unsigned long long)h.last_height, (unsigned long long)h.last_timestamp );
+   std::printf( "supply:           %s (minted %s, burned %s)\n", to_string( supply ).c_str(), to_string( minted ).c_str(), to_string( burned ).c_str() );
+   std::printf( "sum of balances:  %s\n", to_string( total ).c_str() );
+   std::printf( "replay:           %.2f s on %zu threads\n", replayed, threads );
+   std::printf( "total:            %.2f s\n", seconds_since( start ) );
+
+   bool ok = true;
+   if ( bad_records || bad_events )
+   {
+      std::fprintf( stderr, "error: %zu malformed block records, %zu malformed token events\n", bad_records, bad_events );
+      ok = false;
+   }
+   if ( negative || overflow )
+   {
+      std::fprintf( stderr, "error: %zu negative and %zu overflowing balances\n", negative, overflow );
+      ok = false;
+   }
+   if ( burned > minted )
+   {
+      std::fprintf( stderr, "error: burns exceed mints\n" );
+      ok = false;
+   }
+   if ( total != supply )
+   {
+      std::fprintf( stderr, "error: sum of balances does not match supply\n" );
+      ok = false;
+   }
+   if ( opts.check_supply && supply != uint128( opts.expected_supply ) )
+   {
+      std::fprintf( stderr, "error: supply does not match expected %llu\n", (unsigned long long)opts.expected_supply );
+      ok = false;
+   }
+
+   return ok ? 0 : 2;
+}
+
+int lookup( int argc, char** argv )
+{
+   balance_index::reader index;
+   std::string error;
+   if ( !index.open( argv[2], error ) )
+   {
+      std::fprintf( stderr, "%s\n", error.c_str() );
+      return 1;
+   }
+
+   int rc = 0;
+   for ( int i = 3; i < argc; i++ )
+   {
+      std::string raw;
+      address_key key;
+      if ( !parse_address( argv[i], raw ) || !address_key::from( reinterpret_cast< const uint8_t* >( raw.data() ), raw.size(), key ) )
+      {
+         std::fprintf( stderr, "invalid address: %s\n", argv[i] );
+         rc = 1;
+         continue;
+      }
+
+      balance_index::entry e;
+      if ( index.find( key, e ) )
+         std::printf( "%s %llu %llu\n", argv[i], (unsigned long long)e.balance, (unsigned long long)e.last_update );
+      else
+         std::printf( "%s 0 -\n", argv[i] );
+   }
+
+   return rc;
+}
+
+} // anonymous
+
+int main( int argc, char** argv )
+{
+   if ( argc >= 4 && std::strcmp( argv[1], "--lookup" ) == 0 )
+      return lookup( argc, argv );
+
+   options opts;
+   std::vector< std::string > positional;
+   for ( int i = 1; i < argc; i++ )
+   {
+      std::string arg = argv[i];
+      if ( ( arg == "-j" || arg == "-c" || arg == "-s" ) && i + 1 < argc )
+      {
+         std::string value = argv[++i];
+         if ( arg == "-j" )
+            opts.threads = std::strtoull( value.c_str(), nullptr, 10 );
+         else if ( arg == "-c" )
+            opts.contract = value;
+         else
+         {
+            opts.check_supply    = true;
+            opts.expected_supply = std::strtoull( value.c_str(), nullptr, 10 );
+         }
+      }
+      else if ( !arg.empty() && arg[0] == '-' )
+      {
+         return usage( argv[0] );
+      }
+      else
+      {
+         positional.push_back( arg );
+      }
+   }
+
+   if ( positional.size() != 2 || !opts.threads )
+      return usage( argv[0] );
+
+   opts.log_path   = positional[0];
+   opts.index_path = positional[1];
+
+   if ( opts.contract.empty() )
+      std::fprintf( stderr, "warning: no contract id given, folding token events from every contract\n" );
+
+   return build( opts );
+}
@@ -0,0 +1,289 @@
+#include <koinos/system_contracts/checksum.hpp>
+#include <koinos/system_contracts/uint.hpp>
+#include <koinos/tools/address.hpp>
+#include <koinos/tools/balance_index.hpp>
+#include <koinos/tools/koin_snapshot.hpp>
+#include <koinos/tools/parallel.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Builds, verifies and queries columnar KOIN state snapshots (see
+// koin_snapshot.hpp).
+//
+// A snapshot is built here from an event_indexer balance index, which has no
+// mana, or from a native state store with native_host's write_koin_snapshot.
+//
+// seed prints the balance checksum of a snapshot's balances, the arguments
+// of KOIN's seed_balance_checksum for a chain that enables the checksum on
+// existing balances.
+
+using namespace koinos;
+using namespace koinos::tools;
+
+using system_contracts::uint128;
+
+namespace checksum = system_contracts::checksum;
+
+namespace {
+
+using snapshot_clock = std::chrono::steady_clock;
+
+constexpr std::size_t rows_per_chunk = 1 << 14;
+
+// Object space id of balances in system_contracts::token_engine
+constexpr uint32_t balance_id = 1;
+
+int usage( const char* argv0 )
+{
+   std::fprintf( stderr,
+      "usage: %s build [-j threads] <balance_index> <snapshot>\n"
+      "       %s verify [-j threads] <snapshot>\n"
+      "       %s lookup <snapshot> <address>...\n"
+      "       %s seed [-j threads] <snapshot>\n"
+      "\n"
+      "  -j threads   worker threads (default: hardware concurrency)\n",
+      argv0, argv0, argv0, argv0 );
+   return 1;
+}
+
+std::string to_string( const uint128& v )
+{
+   if ( !v )
+      return "0";
+
+   std::string s;
+   for ( auto x = v; x; x /= 10 )
+      s.push_back( char( '0' + ( x % 10 ).convert_to< uint64_t >() ) );
+   std::reverse( s.begin(), s.end() );
+   return s;
+}
+
+double seconds_since( snapshot_clock::time_point start )
+{
+   return std::chrono::duration< double >( snapshot_clock::now() - start ).count();
+}
+
+int build( const std::string& index_path, const std::string& snapshot_path, std::size_t threads )
+{
+   auto start = snapshot_clock::now();
+   std::string error;
+
+   balance_index::reader index;
+   if ( !index.open( index_path, error ) )
+   {
+      std::fprintf( stderr, "%s\n", error.c_str() );
+      return 1;
+   }
+
+   koin_snapshot::writer out;
+   if ( !out.create( snapshot_path, index.size(), error ) )
+   {
+      std::fprintf( stderr, "%s\n", error.c_str() );
+      return 1;
+   }
+
+   // The index is sorted by address already, so rows map one to one
+   parallel_for_ranges( index.size(), rows_per_chunk, threads, [&]( std::size_t begin, std::size_t end )
+   {
+      for ( std::size_t i = begin; i < end; i++ )
+      {
+         auto e = index.at( i );
+         koin_snapshot::row r;
+         r.address = e.address;
+         r.balance = e.balance;
+         out.set_row( i, r );
+      }
+   } );
+
+   const auto& h = index.info();
+   if ( !out.finish( koin_snapshot::flag_mana_unknown, h.supply, h.last_height, h.last_timestamp, threads, error ) )
+   {
+      std::fprintf( stderr, "%s\n", error.c_str() );
+      return 1;
+   }
+
+   std::printf( "accounts:   %llu\n", (unsigned long long)h.count );
+   std::printf( "supply:     %llu\n", (unsigned long long)h.supply );
+   std::printf( "last block: %llu (%llu ms)\n", (unsigned long long)h.last_height, (unsigned long long)h.last_timestamp );
+   std::printf( "checksum:   %016llx\n", (unsigned long long)out.info().checksum );
+   std::printf( "total:      %.2f s on %zu threads\n", seconds_since( start ), threads );
+   return 0;
+}
+
+int verify( const std::string& snapshot_path, std::size_t threads )
+{
+   auto start = snapshot_clock::now();
+   std::string error;
+
+   koin_snapshot::reader snapshot;
+   if ( !snapshot.open( snapshot_path, error ) )
+   {
+      std::fprintf( stderr, "%s\n", error.c_str() );
+      return 1;
+   }
+
+   const auto& h = snapshot.info();
+   auto report = snapshot.verify( threads );
+
+   std::printf( "accounts:         %llu\n", (unsigned long long)h.count );
+   std::printf( "supply:           %llu\n", (unsigned long long)h.supply );
+   std::printf( "sum of balances:  %s\n", to_string( report.total ).c_str() );
+   std::printf( "last block:       %llu (%llu ms)\n", (unsigned long long)h.height, (unsigned long long)h.timestamp );
+   std::printf( "mana:             %s\n", h.flags & koin_snapshot::flag_mana_unknown ? "unknown" : "present" );
+   std::printf( "total:            %.2f s on %zu threads\n", seconds_since( start ), threads );
+
+   bool ok = true;
+   if ( !report.checksum_ok )
+   {
+      std::fprintf( stderr, "error: checksum mismatch\n" );
+      ok = false;
+   }
+   if ( !report.sorted )
+   {
+      std::fprintf( stderr, "error: addresses are not strictly increasing\n" );
+      ok = false;
+   }
+   if ( report.mana_over )
+   {
+      std::fprintf( stderr, "error: %zu accounts have more mana than balance\n", report.mana_over );
+      ok = false;
+   }
+   if ( report.total != uint128( h.supply ) )
+   {
+      std::fprintf( stderr, "error: sum of balances does not match supply\n" );
+      ok = false;
+   }
+
+   return ok ? 0 : 2;
+}
+
+// Every row is taken to be a balance object. A snapshot from a state store
+// has balance shard slots folded into the balances, so it only seeds
+// correctly if no slot existed when it was taken.
+int seed( const std::string& snapshot_path, std::size_t threads )
+{
+   std::string error;
+
+   koin_snapshot::reader snapshot;
+   if ( !snapshot.open( snapshot_path, error ) )
+   {
+      std::fprintf( stderr, "%s\n", error.c_str() );
+      return 1;
+   }
+
+   std::vector< checksum::state > partials( ( snapshot.size() + rows_per_chunk - 1 ) / rows_per_chunk );
+
+   parallel_for_ranges( snapshot.size(), rows_per_chunk, threads, [&]( std::size_t begin, std::size_t end )
+   {
+      auto& part = partials[begin / rows_per_chunk];
+      for ( std::size_t i = begin; i < end; i++ )
+      {
+         auto bal = snapshot.balance( i );
+         if ( !bal )
+            continue;
+
+         checksum::add( part, bal, checksum::weight( checksum::key_hash( balance_id, snapshot.address( i ).str() ) ) );
+      }
+   } );
+
+   checksum::state total;
+   for ( const auto& part : partials )
+      checksum::combine( total, part );
+
+   std::array< uint8_t, system_contracts::uint256::bytes > fingerprint;
+   total.fingerprint.to_big_endian( fingerprint.data() );
+
+   const auto& h = snapshot.info();
+   std::printf( "last block:  %llu (%llu ms)\n", (unsigned long long)h.height, (unsigned long long)h.timestamp );
+   std::printf( "sum:         %llu\n", (unsigned long long)total.sum );
+   std::printf( "fingerprint: 0x" );
+   for ( auto b : fingerprint )
+      std::printf( "%02x", b );
+   std::printf( "\n" );
+
+   if ( total.sum != h.supply )
+   {
+      std::fprintf( stderr, "error: sum of balances does not match supply\n" );
+      return 2;
+   }
+
+   return 0;
+}
+
+int lookup( int argc, char** argv )
+{
+   koin_snapshot::reader snapshot;
+   std::string error;
+   if ( !snapshot.open( argv[2], error ) )
+   {
+      std::fprintf( stderr, "%s\n", error.c_str() );
+      return 1;
+   }
+
+   int rc = 0;
+   for ( int i = 3; i < argc; i++ )
+   {
+      std::string raw;
+      address_key key;
+      if ( !parse_address( argv[i], raw ) || !address_key::from( reinterpret_cast< const uint8_t* >( raw.data() ), raw.size(), key ) )
+      {
+         std::fprintf( stderr, "invalid address: %s\n", argv[i] );
+         rc = 1;
+         continue;
+      }
+
+      std::size_t row;
+      if ( snapshot.find( key, row ) )
+         std::printf( "%s %llu %llu %llu\n", argv[i], (unsigned long long)snapshot.balance( row ),
+            (unsigned long long)snapshot.mana( row ), (unsigned long long)snapshot.last_mana_update( row ) );
+      else
+         std::printf( "%s 0 - -\n", argv[i] );
+   }
+
+   return rc;
+}
+
+} // anonymous
+
+int main( int argc, char** argv )
+{
+   if ( argc < 3 )
+      return usage( argv[0] );
+
+   std::string command = argv[1];
+   if ( command == "lookup" && argc >= 4 )
+      return lookup( argc, argv );
+
+   std::size_t threads = default_thread_count();
+   std::vector< std::string > positional;
+   for ( int i = 2; i < argc; i++ )
+   {
+      std::string arg = argv[i];
+      if ( arg == "-j" && i + 1 < argc )
+         threads = std::strtoull( argv[++i], nullptr, 10 );
+      else if ( !arg.empty() && arg[0] == '-' )
+         return usage( argv[0] );
+      else
+         positional.push_back( arg );
+   }
+
+   if ( !threads )
+      return usage( argv[0] );
+
+   if ( command == "build" && positional.size() == 2 )
+      return build( positional[0], positional[1], threads );
+
+   if ( command == "verify" && positional.size() == 1 )
+      return verify( positional[0], threads );
+
+   if ( command == "seed" && positional.size() == 1 )
+      return seed( positional[0], threads );
+
+   return usage( argv[0] );
+}
@@ -0,0 +1,553 @@
+#include <koinos/system_contracts/mana.hpp>
+#include <koinos/tools/address.hpp>
+#include <koinos/tools/event_log.hpp>
+#include <koinos/tools/mapped_file.hpp>
+#include <koinos/tools/parallel.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Replays KOIN transfers, burns and mints, from an exported event log or a
+// synthetic workload, against mana::regenerate under several regeneration
+// windows at once, and reports how often senders would run out of mana.
+//
+// The replay is open loop: balances follow the trace whether or not a
+// transaction would have been rejected, as if it were retried once enough
+// mana regenerated. An account's mana then depends on its own history only,
+// so accounts are split into one shard per thread and every thread streams
+// the whole trace, simulating just the accounts in its shard.
+
+using namespace koinos;
+using namespace koinos::tools;
+
+namespace mana = koinos::system_contracts::mana;
+
+namespace {
+
+using sim_clock = std::chrono::steady_clock;
+
+constexpr uint64_t ms_per_day = 86'400'000;
+
+enum class op_type : uint8_t
+{
+   transfer,
+   mint,
+   burn
+};
+
+struct options
+{
+   std::string             log_path;
+   std::string             contract;
+   bool                    synthetic    = false;
+   uint64_t                accounts     = 0;
+   uint64_t                transactions = 0;
+   uint64_t                seed         = 1;
+   uint64_t                span         = 30 * ms_per_day;
+   std::vector< uint64_t > windows      = { ms_per_day, 2 * ms_per_day, mana::mana_regen_time_ms, 10 * ms_per_day, 20 * ms_per_day };
+   uint64_t                rc           = 0;
+   std::size_t             threads      = default_thread_count();
+};
+
+int usage( const char* argv0 )
+{
+   std::fprintf( stderr,
+      "usage: %s [-j threads] [-w windows] [-r rc] [-c contract] <event_log>\n"
+      "       %s [-j threads] [-w windows] [-r rc] [-d days] --synthetic <accounts> <transactions> [seed]\n"
+      "\n"
+      "  -j threads   worker threads, one account shard each (default: hardware concurrency)\n"
+      "  -w windows   comma separated regeneration windows, in ms or with a d, h, m or s\n"
+      "               suffix (default: 1d,2d,5d,10d,20d)\n"
+      "  -r rc        mana each transfer and burn also consumes for resources (default: 0)\n"
+      "  -c contract  only replay events from this contract id (base58 or 0x hex)\n"
+      "  -d days      time the synthetic transactions are spread over (default: 30)\n",
+      argv0, argv0 );
+   return 1;
+}
+
+bool parse_duration( const std::string& text, uint64_t& ms )
+{
+   char* end;
+   double value = std::strtod( text.c_str(), &end );
+   std::string suffix( end );
+
+   double scale = 1;
+   if ( suffix == "d" )
+      scale = double( ms_per_day );
+   else if ( suffix == "h" )
+      scale = 3'600'000;
+   else if ( suffix == "m" )
+      scale = 60'000;
+   else if ( suffix == "s" )
+      scale = 1'000;
+   else if ( !suffix.empty() )
+      return false;
+
+   if ( end == text.c_str() || !( value > 0 ) )
+      return false;
+
+   ms = uint64_t( value * scale );
+   return ms > 0;
+}
+
+bool parse_windows( const std::string& text, std::vector< uint64_t >& windows )
+{
+   windows.clear();
+
+   std::size_t pos = 0;
+   while ( pos <= text.size() )
+   {
+      auto comma = std::min( text.find( ',', pos ), text.size() );
+      uint64_t ms;
+      if ( !parse_duration( text.substr( pos, comma - pos ), ms ) )
+         return false;
+
+      windows.push_back( ms );
+      pos = comma + 1;
+   }
+
+   return !windows.empty();
+}
+
+double seconds_since( sim_clock::time_point start )
+{
+   return std::chrono::duration< double >( sim_clock::now() - start ).count();
+}
+
+// Synthetic workload
+
+uint64_t splitmix64( uint64_t& state )
+{
+   uint64_t z = ( state += 0x9e3779b97f4a7c15ull );
+   z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ull;
+   z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebull;
+   return z ^ ( z >> 31 );
+}
+
+double uniform( uint64_t& state )
+{
+   return double( splitmix64( state ) >> 11 ) * ( 1.0 / double( 1ull << 53 ) );
+}
+
+address_key synthetic_address( uint64_t id )
+{
+   std::array< uint8_t, 8 > bytes;
+   for ( std::size_t i = 0; i < bytes.size(); i++ )
+      bytes[i] = uint8_t( id >> ( 8 * i ) );
+
+   address_key key;
+   address_key::from( bytes.data(), bytes.size(), key );
+   return key;
+}
+
+// Mints every account a Pareto distributed balance at time zero, then sends
+// transactions spread evenly over the span. Senders are heavily skewed
+// towards a few active accounts, receivers are uniform and each transfer
+// moves a random, usually small, fraction of the sender's balance. Every
+// thread generates the same sequence from the seed, keeping all balances.
+template< typename Fn >
+void for_each_synthetic( const options& opts, Fn&& fn )
+{
+   uint64_t state = opts.seed;
+   std::vector< uint64_t > balances( opts.accounts );
+
+   for ( uint64_t a = 0; a < opts.accounts; a++ )
+   {
+      balances[a] = uint64_t( 1e8 * std::min( 1e6, std::pow( 1 - uniform( state ), -1 / 1.2 ) ) );
+      fn( op_type::mint, 0, address_key(), synthetic_address( a ), balances[a] );
+   }
+
+   for ( uint64_t t = 0; t < opts.transactions; t++ )
+   {
+      auto time     = opts.span * ( t + 1 ) / opts.transactions;
+      auto from     = std::min( opts.accounts - 1, uint64_t( double( opts.accounts ) * std::pow( uniform( state ), 3 ) ) );
+      auto to       = splitmix64( state ) % opts.accounts;
+      auto fraction = std::pow( uniform( state ), 2 );
+      auto value    = uint64_t( double( balances[from] ) * fraction );
+
+      if ( to == from || !value )
+         continue;
+
+      balances[from] -= value;
+      balances[to]   += value;
+      fn( op_type::transfer, time, synthetic_address( from ), synthetic_address( to ), value );
+   }
+}
+
+template< typename Fn >
+bool for_each_logged( const uint8_t* log, const std::vector< event_log::record_span >& records, const std::string& contract, Fn&& fn )
+{
+   bool ok = true;
+   for ( const auto& r : records )
+   {
+      ok &= event_log::for_each_event( log + r.offset, r.size,
+         [&]( const event_log::block_info& block, const event_log::event& ev )
+         {
+            if ( !contract.empty() && ev.source != contract )
+               return;
+
+            event_log::token_event te;
+            if ( !event_log::decode_token_event( ev, te ) )
+               return;
+
+            switch ( te.type )
+            {
+               case event_log::token_event_type::transfer:
+                  fn( op_type::transfer, block.timestamp, te.from, te.to, te.value );
+                  break;
+               case event_log::token_event_type::mint:
+                  fn( op_type::mint, block.timestamp, address_key(), te.to, te.value );
+                  break;
+               case event_log::token_event_type::burn:
+                  fn( op_type::burn, block.timestamp, te.from, address_key(), te.value );
+                  break;
+               default:
+                  break;
+            }
+         } );
+   }
+   return ok;
+}
+
+// Simulation
+
+constexpr std::size_t utilization_bins = 100;
+
+// What one regeneration window did in one shard
+struct window_stats
+{
+   uint64_t                                    transactions = 0;
+   uint64_t                                    rejected     = 0;
+   uint64_t                                    unpayable    = 0;   // Rejected for costing more than the balance
+   double                                      wait_ms      = 0;   // Until rejected ones could pay
+   uint64_t                                    max_wait_ms  = 0;
+   uint64_t                                    accounts_hit = 0;
+   std::array< uint64_t, utilization_bins >    utilization  = {};  // Accepted, by percent of available mana spent
+
+   void merge( const window_stats& o )
+   {
+      transactions += o.transactions;
+      rejected     += o.rejected;
+      unpayable    += o.unpayable;
+      wait_ms      += o.wait_ms;
+      max_wait_ms   = std::max( max_wait_ms, o.max_wait_ms );
+      accounts_hit += o.accounts_hit;
+      for ( std::size_t i = 0; i < utilization_bins; i++ )
+         utilization[i] += o.utilization[i];
+   }
+};
+
+// Accounts are numbered as the shard first sees them. Mana state is kept per
+// account and window, window minor.
+struct shard_state
+{
+   std::unordered_map< address_key, uint32_t, address_hash > index;
+   std::vector< uint64_t >                                  balance;
+   std::vector< uint8_t >                                   sent;          // Has sent a transaction
+   std::vector< uint64_t >                                  mana;
+   std::vector< uint64_t >                                  last_update;
+   std::vector< uint8_t >                                   hit;           // Has had one rejected
+   std::vector< window_stats >                              stats;
+   uint64_t                                                 senders    = 0;
+   uint64_t                                                 first_time = ~uint64_t( 0 );
+   uint64_t                                                 last_time  = 0;
+};
+
+uint32_t account( shard_state& s, const address_key& key, std::size_t windows )
+{
+   auto [ it, inserted ] = s.index.emplace( key, uint32_t( s.balance.size() ) );
+   if ( inserted )
+   {
+      s.balance.push_back( 0 );
+      s.sent.push_back( 0 );
+      s.mana.resize( s.mana.size() + windows, 0 );
+      s.last_update.resize( s.last_update.size() + windows, 0 );
+      s.hit.resize( s.hit.size() + windows, 0 );
+   }
+   return it->second;
+}
+
+// A credit adds its value to mana as well, as token_engine::credit does
+void credit( shard_state& s, const options& opts, uint32_t a, uint64_t value, uint64_t time )
+{
+   for ( std::size_t w = 0; w < opts.windows.size(); w++ )
+   {
+      auto i = a * opts.windows.size() + w;
+      auto state = mana::regenerate( { s.balance[a], s.mana[i], s.last_update[i] }, time, opts.windows[w] );
+      s.mana[i]        = state.mana + value;
+      s.last_update[i] = state.last_mana_update;
+   }
+
+   s.balance[a] += value;
+}
+
+// A transaction from the account needs mana for its value and its
+// resources. A rejected one still debits the balance.
+void debit( shard_state& s, const options& opts, uint32_t a, uint64_t value, uint64_t time )
+{
+   if ( !s.sent[a] )
+   {
+      s.sent[a] = 1;
+      s.senders++;
+   }
+
+   auto balance = s.balance[a];
+   auto cost    = value + opts.rc;
+   s.balance[a] = balance >= value ? balance - value : 0;
+
+   for ( std::size_t w = 0; w < opts.windows.size(); w++ )
+   {
+      auto i = a * opts.windows.size() + w;
+      auto& st = s.stats[w];
+      auto state = mana::regenerate( { balance, s.mana[i], s.last_update[i] }, time, opts.windows[w] );
+      s.last_update[i] = state.last_mana_update;
+      st.transactions++;
+
+      if ( state.mana >= cost )
+      {
+         auto bin = std::min< std::size_t >( utilization_bins - 1, state.mana ? std::size_t( double( cost ) * 100 / double( state.mana ) ) : 0 );
+         st.utilization[bin]++;
+         state.mana -= cost;
+      }
+      else
+      {
+         st.rejected++;
+         if ( !s.hit[i] )
+         {
+            s.hit[i] = 1;
+            st.accounts_hit++;
+         }
+
+         if ( cost > balance )
+         {
+            st.unpayable++;
+         }
+         else
+         {
+            auto wait = uint64_t( std::ceil( double( cost - state.mana ) * double( opts.windows[w] ) / double( balance ) ) );
+            st.wait_ms    += double( wait );
+            st.max_wait_ms = std::max( st.max_wait_ms, wait );
+         }
+      }
+
+      s.mana[i] = std::min( state.mana, s.balance[a] );
+   }
+}
+
+template< typename Source >
+void simulate( const options& opts, std::size_t shard, std::size_t shards, shard_state& s, Source&& for_each_op )
+{
+   s.stats.resize( opts.windows.size() );
+
+   for_each_op( [&]( op_type type, uint64_t time, const address_key& from, const address_key& to, uint64_t value )
+   {
+      s.first_time = std::min( s.first_time, time );
+      s.last_time  = std::max( s.last_time, time );
+
+      if ( type != op_type::mint && address_hash()( from ) % shards == shard )
+         debit( s, opts, account( s, from, opts.windows.size() ), value, time );
+
+      if ( type != op_type::burn && address_hash()( to ) % shards == shard )
+         credit( s, opts, account( s, to, opts.windows.size() ), value, time );
+   } );
+}
+
+// The smallest percent of available mana spent that at least q of the
+// accepted transactions stay under
+std::size_t percentile( const window_stats& st, double q )
+{
+   uint64_t accepted = st.transactions - st.rejected;
+   uint64_t seen = 0;
+   for ( std::size_t i = 0; i < utilization_bins; i++ )
+   {
+      seen += st.utilization[i];
+      if ( double( seen ) >= q * double( accepted ) )
+         return i + 1;
+   }
+   return utilization_bins;
+}
+
+void report( const options& opts, const std::vector< shard_state >& shards, double replay_seconds )
+{
+   std::vector< window_stats > stats( opts.windows.size() );
+   uint64_t accounts = 0, senders = 0, first_time = ~uint64_t( 0 ), last_time = 0;
+   for ( const auto& s : shards )
+   {
+      accounts  += s.balance.size();
+      senders   += s.senders;
+      first_time = std::min( first_time, s.first_time );
+      last_time  = std::max( last_time, s.last_time );
+      for ( std::size_t w = 0; w < stats.size(); w++ )
+         stats[w].merge( s.stats[w] );
+   }
+
+   double span_seconds = last_time > first_time ? double( last_time - first_time ) / 1000 : 0;
+
+   if ( opts.synthetic )
+      std::printf( "trace:         synthetic, %llu accounts, %llu transactions, seed %llu\n",
+         (unsigned long long)opts.accounts, (unsigned long long)opts.transactions, (unsigned long long)opts.seed );
+   else
+      std::printf( "trace:         %s\n", opts.log_path.c_str() );
+   std::printf( "accounts:      %llu (%llu sent)\n", (unsigned long long)accounts, (unsigned long long)senders );
+   std::printf( "transactions:  %llu over %.2f days\n", (unsigned long long)stats[0].transactions, span_seconds / 86400 );
+   std::printf( "rc per tx:     %llu\n", (unsigned long long)opts.rc );
+   std::printf( "replay:        %.2f s on %zu threads\n", replay_seconds, shards.size() );
+   std::printf( "\n" );
+   std::printf( "  window   rejected    rate  senders hit  unpayable  mean wait  max wait   util p50  p90  p99  accepted tx/s\n" );
+
+   for ( std::size_t w = 0; w < stats.size(); w++ )
+   {
+      const auto& st = stats[w];
+      auto waited    = st.rejected - st.unpayable;
+      auto accepted  = st.transactions - st.rejected;
+
+      std::printf( "%7.2fd %10llu %6.2f%% %11.2f%% %10llu %9.2fh %8.2fh %9zu%% %3zu%% %3zu%% %14.3f\n",
+         double( opts.windows[w] ) / double( ms_per_day ),
+         (unsigned long long)st.rejected,
+         st.transactions ? 100.0 * double( st.rejected ) / double( st.transactions ) : 0.0,
+         senders ? 100.0 * double( st.accounts_hit ) / double( senders ) : 0.0,
+         (unsigned long long)st.unpayable,
+         waited ? st.wait_ms / double( waited ) / 3'600'000 : 0.0,
+         double( st.max_wait_ms ) / 3'600'000,
+         percentile( st, 0.5 ), percentile( st, 0.9 ), percentile( st, 0.99 ),
+         span_seconds > 0 ? double( accepted ) / span_seconds : 0.0 );
+   }
+}
+
+int run( const options& opts )
+{
+   auto start = sim_clock::now();
+   std::string error;
+
+   std::string contract;
+   if ( !opts.contract.empty() && !parse_address( opts.contract, contract ) )
+   {
+      std::fprintf( stderr, "invalid contract id: %s\n", opts.contract.c_str() );
+      return 1;
+   }
+
+   mapped_file log;
+   std::vector< event_log::record_span > records;
+   if ( !opts.synthetic )
+   {
+      if ( !log.open( opts.log_path, error ) )
+      {
+         std::fprintf( stderr, "%s\n", error.c_str() );
+         return 1;
+      }
+
+      if ( !event_log::split_records( log.data(), log.size(), records, error ) )
+      {
+         std::fprintf( stderr, "%s: %s\n", opts.log_path.c_str(), error.c_str() );
+         return 1;
+      }
+   }
+
+   std::size_t shards = std::max< std::size_t >( 1, opts.threads );
+   std::vector< shard_state > states( shards );
+   std::vector< uint8_t > malformed( shards, 0 );
+
+   parallel_for( shards, shards, [&]( std::size_t s )
+   {
+      if ( opts.synthetic )
+      {
+         simulate( opts, s, shards, states[s], [&]( auto&& fn ) { for_each_synthetic( opts, fn ); } );
+      }
+      else
+      {
+         simulate( opts, s, shards, states[s], [&]( auto&& fn )
+         {
+            malformed[s] = !for_each_logged( log.data(), records, contract, fn );
+         } );
+      }
+   } );
+
+   if ( malformed[0] )
+   {
+      std::fprintf( stderr, "error: %s has malformed block records\n", opts.log_path.c_str() );
+      return 2;
+   }
+
+   report( opts, states, seconds_since( start ) );
+   return 0;
+}
+
+} // anonymous
+
+int main( int argc, char** argv )
+{
+   options opts;
+   std::vector< std::string > positional;
+   for ( int i = 1; i < argc; i++ )
+   {
+      std::string arg = argv[i];
+      if ( ( arg == "-j" || arg == "-w" || arg == "-r" || arg == "-c" || arg == "-d" ) && i + 1 < argc )
+      {
+         std::string value = argv[++i];
+         if ( arg == "-j" )
+            opts.threads = std::strtoull( value.c_str(), nullptr, 10 );
+         else if ( arg == "-w" )
+         {
+            if ( !parse_windows( value, opts.windows ) )
+               return usage( argv[0] );
+         }
+         else if ( arg == "-r" )
+            opts.rc = std::strtoull( value.c_str(), nullptr, 10 );
+         else if ( arg == "-c" )
+            opts.contract = value;
+         else
+         {
+            uint64_t days = std::strtoull( value.c_str(), nullptr, 10 );
+            opts.span = days * ms_per_day;
+         }
+      }
+      else if ( arg == "--synthetic" )
+      {
+         opts.synthetic = true;
+      }
+      else if ( !arg.empty() && arg[0] == '-' )
+      {
+         return usage( argv[0] );
+      }
+      else
+      {
+         positional.push_back( arg );
+      }
+   }
+
+   if ( !opts.threads || !opts.span )
+      return usage( argv[0] );
+
+   if ( opts.synthetic )
+   {
+      if ( positional.size() < 2 || positional.size() > 3 )
+         return usage( argv[0] );
+
+      opts.accounts     = std::strtoull( positional[0].c_str(), nullptr, 10 );
+      opts.transactions = std::strtoull( positional[1].c_str(), nullptr, 10 );
+      if ( positional.size() == 3 )
+         opts.seed = std::strtoull( positional[2].c_str(), nullptr, 10 );
+
+      if ( opts.accounts < 2 || !opts.transactions )
+         return usage( argv[0] );
+   }
+   else
+   {
+      if ( positional.size() != 1 )
+         return usage( argv[0] );
+
+      opts.log_path = positional[0];
+      if ( opts.contract.empty() )
+         std::fprintf( stderr, "warning: no contract id given, replaying token events from every contract\n" );
+   }
+
+   return run( opts );
+}
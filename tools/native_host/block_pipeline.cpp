@@ -0,0 +1,181 @@
+#include <koinos/native_host/block_pipeline.hpp>
+
+#include <koinos/system_contracts/wire.hpp>
+
+#include <chrono>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <utility>
+
+using namespace koinos::system_contracts;
+
+namespace koinos::native_host {
+
+namespace {
+
+using host_clock = std::chrono::steady_clock;
+
+// A transaction in the pipeline. The coroutine runs as soon as it is
+// created, up to its first suspension, and run() resumes it from there.
+class pipelined_transaction
+{
+public:
+   struct promise_type
+   {
+      std::exception_ptr error;
+
+      pipelined_transaction get_return_object() { return pipelined_transaction( handle::from_promise( *this ) ); }
+      std::suspend_never initial_suspend() noexcept { return {}; }
+      std::suspend_always final_suspend() noexcept { return {}; }
+      void return_void() {}
+      void unhandled_exception() { error = std::current_exception(); }
+   };
+
+   using handle = std::coroutine_handle< promise_type >;
+
+   pipelined_transaction( pipelined_transaction&& other ) noexcept : _h( std::exchange( other._h, {} ) ) {}
+   pipelined_transaction& operator =( pipelined_transaction&& ) = delete;
+
+   ~pipelined_transaction()
+   {
+      if ( _h )
+         _h.destroy();
+   }
+
+   // Runs the transaction to completion, rethrowing what either stage threw
+   void run()
+   {
+      if ( !_h.done() )
+         _h.resume();
+
+      if ( _h.promise().error )
+         std::rethrow_exception( _h.promise().error );
+   }
+
+private:
+   explicit pipelined_transaction( handle h ) : _h( h ) {}
+
+   handle _h;
+};
+
+pipelined_transaction pipeline( latency_store& store, const transaction& tx, const key_source& keys, const transaction_runner& run, bool prefetch )
+{
+   if ( prefetch )
+   {
+      std::vector< object_key > upcoming;
+      keys( tx, upcoming );
+      for ( const auto& k : upcoming )
+         store.prefetch( k );
+   }
+
+   co_await std::suspend_always();
+
+   run( tx );
+}
+
+// Advances the store's clock by the time f computes for. Stalls inside f are
+// modeled and already on the clock.
+template< typename F >
+uint64_t timed( latency_store& store, F&& f )
+{
+   auto start = host_clock::now();
+   f();
+   auto ns = uint64_t( std::chrono::duration_cast< std::chrono::nanoseconds >( host_clock::now() - start ).count() );
+   store.advance( ns );
+   return ns;
+}
+
+} // anonymous
+
+std::string encode_transfer( const std::string& from, const std::string& to, uint64_t value )
+{
+   std::string args;
+   wire::append_bytes( args, 1, from );
+   wire::append_bytes( args, 2, to );
+   wire::append_uint64( args, 3, value );
+   return args;
+}
+
+bool decode_transfer( const std::string& arguments, std::string& from, std::string& to, uint64_t& value )
+{
+   from.clear();
+   to.clear();
+   value = 0;
+
+   wire::reader rdr( reinterpret_cast< const uint8_t* >( arguments.data() ), arguments.size() );
+   while ( !rdr.eof() )
+   {
+      uint32_t field;
+      wire::wire_type type;
+
+      if ( !rdr.read_tag( field, type ) )
+         return false;
+
+      if ( field == 1 && type == wire::wire_type::length_delimited )
+      {
+         if ( !rdr.read_bytes( from ) )
+            return false;
+      }
+      else if ( field == 2 && type == wire::wire_type::length_delimited )
+      {
+         if ( !rdr.read_bytes( to ) )
+            return false;
+      }
+      else if ( field == 3 && type == wire::wire_type::varint )
+      {
+         if ( !rdr.read_varint( value ) )
+            return false;
+      }
+      else if ( !rdr.skip( type ) )
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+void transfer_balance_keys( const transaction& tx, std::vector< object_key >& keys )
+{
+   std::string from, to;
+   uint64_t value;
+   if ( tx.entry_point != transfer_entry || !decode_transfer( tx.arguments, from, to, value ) )
+      return;
+
+   keys.push_back( object_key{ tx.contract, balance_space_id, true, std::move( from ) } );
+   keys.push_back( object_key{ tx.contract, balance_space_id, true, std::move( to ) } );
+}
+
+block_timing execute_block( latency_store& store, const std::vector< transaction >& block, const key_source& keys,
+   const transaction_runner& run, std::size_t depth )
+{
+   block_timing timing;
+   timing.transactions = block.size();
+   store.reset_stats();
+   auto start = store.now();
+
+   std::deque< pipelined_transaction > in_flight;
+   std::size_t entered = 0;
+
+   for ( std::size_t i = 0; i < block.size(); i++ )
+   {
+      while ( entered < block.size() && entered <= i + depth )
+      {
+         timing.prefetch_ns += timed( store, [&]
+         {
+            in_flight.push_back( pipeline( store, block[entered], keys, run, depth > 0 ) );
+         } );
+         entered++;
+      }
+
+      timed( store, [&] { in_flight.front().run(); } );
+      in_flight.pop_front();
+   }
+
+   timing.elapsed_ns = store.now() - start;
+   timing.reads      = store.stats();
+   return timing;
+}
+
+} // koinos::native_host
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <koinos/native_host/latency_store.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace koinos::native_host {
+
+// The token engine's transfer entry point and balance space, as in token.hpp
+constexpr uint32_t transfer_entry   = 0x27f576ca;
+constexpr uint32_t balance_space_id = 1;
+
+struct transaction
+{
+   std::string contract;
+   uint32_t    entry_point = 0;
+   std::string arguments;
+};
+
+// Appends the keys a transaction will read that can be told from its
+// arguments alone
+using key_source = std::function< void( const transaction& tx, std::vector< object_key >& keys ) >;
+
+// Executes a transaction against the store
+using transaction_runner = std::function< void( const transaction& tx ) >;
+
+std::string encode_transfer( const std::string& from, const std::string& to, uint64_t value );
+bool decode_transfer( const std::string& arguments, std::string& from, std::string& to, uint64_t& value );
+
+// The balance_space() keys of a token transfer's sender and recipient. Other
+// entry points and malformed arguments have none.
+void transfer_balance_keys( const transaction& tx, std::vector< object_key >& keys );
+
+// Modeled time a block took on a latency_store
+struct block_timing
+{
+   uint64_t   transactions = 0;
+   uint64_t   elapsed_ns   = 0;   // Computing and stalled
+   uint64_t   prefetch_ns  = 0;   // Computing keys and starting fetches
+   read_stats reads;
+};
+
+// Runs a block's transactions in order. While one runs, the keys of the
+// next `depth` transactions are already being fetched: each transaction is
+// a coroutine that starts fetching its keys when it enters the pipeline and
+// suspends until its turn to run. A depth of 0 prefetches nothing.
+//
+// Prefetching only warms the store, every read still sees the writes of the
+// transactions before it.
+//
+// Time spent in the key source and the runner is measured and advances the
+// store's clock, so a runner that models its compute instead can advance the
+// clock itself.
+block_timing execute_block( latency_store& store, const std::vector< transaction >& block, const key_source& keys,
+   const transaction_runner& run, std::size_t depth );
+
+} // koinos::native_host
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <koinos/native_host/state_store.hpp>
+
+#include <cstdint>
+
+namespace koinos::native_host {
+
+constexpr int32_t success             = 0;
+constexpr int32_t unknown_system_call = -1;
+constexpr int32_t malformed_arguments = -2;
+constexpr int32_t buffer_too_small    = -3;
+
+// Counts crossings of the contract/host boundary
+struct host_stats
+{
+   uint64_t system_calls    = 0;
+   uint64_t objects_read    = 0;
+   uint64_t objects_written = 0;
+};
+
+// Native stand-in for the koinos host. Contracts compiled natively link
+// against invoke_system_call from this library instead of the wasm import.
+struct host
+{
+   state_store* store       = nullptr;
+   bool         batch_calls = true;    // Serve get_objects/put_objects
+   host_stats   stats;
+};
+
+// The host serving system calls on the calling thread
+host& current_host();
+void set_current_host( host* h );
+
+} // koinos::native_host
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <koinos/native_host/state_store.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace koinos::native_host {
+
+struct snapshot_source
+{
+   std::string contract_id;        // Raw KOIN contract id, the zone of its object spaces
+   uint64_t    height    = 0;
+   uint64_t    timestamp = 0;      // Block time, ms
+};
+
+// Writes KOIN's balance and supply spaces from a store as a columnar
+// snapshot (see koinos/tools/koin_snapshot.hpp). Returns false and sets
+// error if an object does not decode or the file cannot be written.
+bool write_koin_snapshot( const state_store& store, const snapshot_source& source, const std::string& path,
+   std::size_t threads, std::string& error );
+
+} // koinos::native_host
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <koinos/native_host/state_store.hpp>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace koinos::native_host {
+
+// Reads served by a latency_store since its stats were last reset
+struct read_stats
+{
+   uint64_t reads      = 0;
+   uint64_t misses     = 0;   // Waited the full read latency
+   uint64_t late       = 0;   // Prefetched, but waited for the rest of the fetch
+   uint64_t prefetched = 0;   // Prefetched in time
+   uint64_t prefetches = 0;   // Fetches started by prefetch()
+   uint64_t stall_ns   = 0;   // Time spent waiting on reads
+};
+
+// A state_store in front of another that models how long production state
+// reads take. It keeps a modeled clock instead of sleeping: a read of an
+// object that is not resident stalls the clock for the read latency, and the
+// object stays resident until evict(). prefetch() starts a fetch without
+// waiting, so a later read only waits for what is left of it.
+//
+// Whoever drives the store advances the clock by the time spent computing
+// between reads. Writes make an object resident without a wait, as a node
+// writes back to its cache.
+class latency_store : public state_store
+{
+public:
+   latency_store( state_store& backing, uint64_t read_latency_ns );
+
+   bool get( const object_key& k, std::string& value ) const override;
+   void put( const object_key& k, const std::string& value ) override;
+   void remove( const object_key& k ) override;
+
+   // A scan stalls for one read latency, whatever its length
+   void for_each( const object_key& space, const object_visitor& fn ) const override;
+
+   std::size_t size() const override { return _backing.size(); }
+
+   // Starts fetching an object that is neither resident nor being fetched
+   void prefetch( const object_key& k );
+
+   // Forgets every resident object and fetch in flight, e.g. between blocks
+   void evict();
+
+   void     advance( uint64_t ns ) { _now += ns; }
+   uint64_t now() const { return _now; }
+   uint64_t read_latency() const { return _latency; }
+
+   const read_stats& stats() const { return _stats; }
+   void reset_stats() { _stats = read_stats(); }
+
+private:
+   struct fetch
+   {
+      uint64_t ready_at   = 0;
+      bool     prefetched = false;   // Started by prefetch() and not read yet
+   };
+
+   void wait_for( const std::string& encoded ) const;
+
+   state_store&                                     _backing;
+   uint64_t                                         _latency;
+   mutable uint64_t                                 _now = 0;
+   mutable std::unordered_map< std::string, fetch > _fetches;
+   mutable read_stats                               _stats;
+};
+
+} // koinos::native_host
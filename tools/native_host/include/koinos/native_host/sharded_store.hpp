@@ -0,0 +1,96 @@
+#pragma once
+
+#include <koinos/native_host/state_store.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace koinos::native_host {
+
+// A state_store that many threads can share, for running invocations
+// concurrently. Keys are hashed to shards, each a fixed array of buckets of
+// objects. Writers to a shard take its lock. Readers take no lock and write
+// nothing shared: an object's value is an immutable string that a write
+// replaces with an atomic pointer swap, and the old string is only freed once
+// no read that could still hold it is in progress (epoch based reclamation).
+//
+// Reads and writes are atomic per object. A transaction's writes are
+// buffered by a store_transaction and land together on commit(), but a read
+// of several objects may see some of another transaction's writes and not
+// others.
+//
+// Buckets do not grow, so size the store for the objects it will hold. At
+// most max_threads threads can read at once.
+class sharded_store : public state_store
+{
+public:
+   static constexpr std::size_t max_threads = 256;
+
+   explicit sharded_store( std::size_t shards = 64, std::size_t buckets_per_shard = 4096 );
+   ~sharded_store() override;
+
+   sharded_store( const sharded_store& ) = delete;
+   sharded_store& operator =( const sharded_store& ) = delete;
+
+   bool get( const object_key& k, std::string& value ) const override;
+   void put( const object_key& k, const std::string& value ) override;
+   void remove( const object_key& k ) override;
+
+   // Gathers and sorts the space's objects, so it is not meant for hot paths
+   void for_each( const object_key& space, const object_visitor& fn ) const override;
+
+   std::size_t size() const override { return _size.load( std::memory_order_relaxed ); }
+
+   // Applies writes keyed by object_key::encode(), no value meaning a
+   // removal. The shards written are locked in order for the whole batch, so
+   // concurrent batches land one after the other on the objects they share.
+   void apply( const std::map< std::string, std::optional< std::string > >& writes );
+
+private:
+   struct node;
+   struct shard;
+
+   shard& shard_of( const std::string& encoded, std::size_t& bucket ) const;
+   void   write( shard& s, std::size_t bucket, const std::string& encoded, const std::string* value );
+
+   std::size_t                 _shard_mask;
+   std::size_t                 _bucket_mask;
+   std::unique_ptr< shard[] >  _shards;
+   std::atomic< std::size_t >  _size{ 0 };
+};
+
+// One transaction's view of a sharded_store. Reads see the transaction's own
+// writes, which are buffered until commit(). It is a state_store itself, so
+// a native host can serve an invocation's object calls from it.
+class store_transaction : public state_store
+{
+public:
+   explicit store_transaction( sharded_store& base ) : _base( base ) {}
+
+   bool get( const object_key& k, std::string& value ) const override;
+   void put( const object_key& k, const std::string& value ) override;
+   void remove( const object_key& k ) override;
+   void for_each( const object_key& space, const object_visitor& fn ) const override;
+
+   // The base store's count, not counting buffered writes
+   std::size_t size() const override { return _base.size(); }
+
+   std::size_t pending() const { return _writes.size(); }
+
+   void commit();
+   void discard() { _writes.clear(); }
+
+private:
+   sharded_store&                                        _base;
+   std::map< std::string, std::optional< std::string > > _writes;
+};
+
+} // koinos::native_host
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+
+namespace koinos::native_host {
+
+// Identifies an object by its object space and key
+struct object_key
+{
+   std::string zone;
+   uint32_t    id     = 0;
+   bool        system = false;
+   std::string key;
+
+   // Unique, ordered encoding used as the store's map key
+   std::string encode() const;
+};
+
+// Called with an object's key within its space and its value
+using object_visitor = std::function< void( const std::string& key, const std::string& value ) >;
+
+// In-memory object store backing the native system call stand-in
+class state_store
+{
+public:
+   virtual ~state_store() = default;
+
+   virtual bool get( const object_key& k, std::string& value ) const;
+   virtual void put( const object_key& k, const std::string& value );
+   virtual void remove( const object_key& k );
+
+   // Visits every object in the space of `space` (its key is ignored) in key order
+   virtual void for_each( const object_key& space, const object_visitor& fn ) const;
+
+   virtual std::size_t size() const { return _objects.size(); }
+
+private:
+   std::map< std::string, std::string > _objects;
+};
+
+} // koinos::native_host
@@ -0,0 +1,174 @@
+#include <koinos/native_host/koin_snapshot.hpp>
+
+#include <koinos/system_contracts/fixed_layout.hpp>
+#include <koinos/system_contracts/mana.hpp>
+#include <koinos/system_contracts/schema.hpp>
+#include <koinos/system_contracts/wire.hpp>
+#include <koinos/tools/koin_snapshot.hpp>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+namespace koinos::native_host {
+
+namespace {
+
+namespace wire = system_contracts::wire;
+
+// Object space ids of system_contracts::token_engine
+constexpr uint32_t supply_id  = 0;
+constexpr uint32_t balance_id = 1;
+constexpr uint32_t slot_id    = 3;
+
+constexpr std::size_t rows_per_chunk = 1 << 14;
+
+// token::balance_object { uint64 value = 1; }, bare protobuf or the version 1
+// fixed layout. The supply and balance shard slots are stored this way.
+bool decode_value( const std::string& value, uint64_t& supply )
+{
+   auto data = reinterpret_cast< const uint8_t* >( value.data() );
+   supply = 0;
+
+   if ( value.size() >= 2 && data[0] == system_contracts::envelope_tag )
+   {
+      if ( data[1] != system_contracts::fixed_layout_version || value.size() != 2 + 8 )
+         return false;
+
+      supply = system_contracts::fixed_layout::get_u64( data + 2 );
+      return true;
+   }
+
+   wire::reader rdr( data, value.size() );
+   while ( !rdr.eof() )
+   {
+      uint32_t field;
+      wire::wire_type type;
+      if ( !rdr.read_tag( field, type ) )
+         return false;
+
+      if ( field == 1 && type == wire::wire_type::varint )
+      {
+         if ( !rdr.read_varint( supply ) )
+            return false;
+      }
+      else if ( !rdr.skip( type ) )
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+} // anonymous
+
+bool write_koin_snapshot( const state_store& store, const snapshot_source& source, const std::string& path,
+   std::size_t threads, std::string& error )
+{
+   namespace snapshot = tools::koin_snapshot;
+
+   object_key space;
+   space.zone   = source.contract_id;
+   space.system = true;
+
+   uint64_t supply = 0;
+   space.id = supply_id;
+   std::string supply_value;
+   if ( store.get( space, supply_value ) && !decode_value( supply_value, supply ) )
+   {
+      error = "malformed supply object";
+      return false;
+   }
+
+   // The store visits keys in order, which for equal-length addresses is
+   // the snapshot's address order. Sort anyway so mixed lengths are right.
+   std::vector< std::pair< std::string, std::string > > objects;
+   space.id = balance_id;
+   store.for_each( space, [&]( const std::string& key, const std::string& value )
+   {
+      objects.emplace_back( key, value );
+   } );
+
+   std::vector< snapshot::row > rows( objects.size() );
+   std::vector< uint8_t > bad( objects.size() );
+   tools::parallel_for_ranges( objects.size(), rows_per_chunk, threads, [&]( std::size_t begin, std::size_t end )
+   {
+      for ( std::size_t i = begin; i < end; i++ )
+      {
+         const auto& [ key, value ] = objects[i];
+         system_contracts::mana::balance_state bal;
+
+         auto& r = rows[i];
+         bad[i] = !tools::address_key::from( reinterpret_cast< const uint8_t* >( key.data() ), key.size(), r.address )
+            || !system_contracts::mana::decode( reinterpret_cast< const uint8_t* >( value.data() ), value.size(), bal );
+
+         r.balance          = bal.balance;
+         r.mana             = bal.mana;
+         r.last_mana_update = bal.last_mana_update;
+      }
+   } );
+   objects.clear();
+
+   for ( std::size_t i = 0; i < bad.size(); i++ )
+   {
+      if ( bad[i] )
+      {
+         error = "malformed balance object for " + tools::format_address( rows[i].address );
+         return false;
+      }
+   }
+
+   // Credits waiting in balance shard slots are added to the balance and
+   // mana, as the contract does when it folds them
+   std::map< std::string, uint64_t > credits;
+   space.id = slot_id;
+   bool bad_slot = false;
+   store.for_each( space, [&]( const std::string& key, const std::string& value )
+   {
+      uint64_t credit;
+      if ( key.empty() || !decode_value( value, credit ) )
+         bad_slot = true;
+      else if ( credit )
+         credits[ key.substr( 0, key.size() - 1 ) ] += credit;
+   } );
+
+   if ( bad_slot )
+   {
+      error = "malformed balance shard slot";
+      return false;
+   }
+
+   std::sort( rows.begin(), rows.end(), []( const auto& a, const auto& b ) { return a.address < b.address; } );
+
+   for ( const auto& [ owner, credit ] : credits )
+   {
+      snapshot::row r;
+      if ( !tools::address_key::from( reinterpret_cast< const uint8_t* >( owner.data() ), owner.size(), r.address ) )
+      {
+         error = "malformed balance shard slot";
+         return false;
+      }
+
+      auto it = std::lower_bound( rows.begin(), rows.end(), r, []( const auto& a, const auto& b ) { return a.address < b.address; } );
+      if ( it == rows.end() || !( it->address == r.address ) )
+         it = rows.insert( it, r );
+
+      it->balance += credit;
+      it->mana    += credit;
+   }
+
+   snapshot::writer out;
+   if ( !out.create( path, rows.size(), error ) )
+      return false;
+
+   tools::parallel_for_ranges( rows.size(), rows_per_chunk, threads, [&]( std::size_t begin, std::size_t end )
+   {
+      for ( std::size_t i = begin; i < end; i++ )
+         out.set_row( i, rows[i] );
+   } );
+
+   return out.finish( 0, supply, source.height, source.timestamp, threads, error );
+}
+
+} // koinos::native_host
@@ -0,0 +1,81 @@
+#include <koinos/native_host/latency_store.hpp>
+
+namespace koinos::native_host {
+
+latency_store::latency_store( state_store& backing, uint64_t read_latency_ns ) :
+   _backing( backing ),
+   _latency( read_latency_ns )
+{}
+
+void latency_store::wait_for( const std::string& encoded ) const
+{
+   _stats.reads++;
+
+   auto [ it, started ] = _fetches.try_emplace( encoded );
+   auto& f = it->second;
+
+   if ( started )
+   {
+      f.ready_at = _now + _latency;
+      _stats.misses++;
+   }
+   else if ( f.prefetched )
+   {
+      if ( f.ready_at > _now )
+         _stats.late++;
+      else
+         _stats.prefetched++;
+   }
+   f.prefetched = false;
+
+   if ( f.ready_at > _now )
+   {
+      _stats.stall_ns += f.ready_at - _now;
+      _now = f.ready_at;
+   }
+}
+
+bool latency_store::get( const object_key& k, std::string& value ) const
+{
+   wait_for( k.encode() );
+   return _backing.get( k, value );
+}
+
+void latency_store::put( const object_key& k, const std::string& value )
+{
+   // A write does not wait for a fetch in flight, the value replaces it
+   _fetches[ k.encode() ] = fetch{ _now, false };
+   _backing.put( k, value );
+}
+
+void latency_store::remove( const object_key& k )
+{
+   _fetches[ k.encode() ] = fetch{ _now, false };
+   _backing.remove( k );
+}
+
+void latency_store::for_each( const object_key& space, const object_visitor& fn ) const
+{
+   _stats.reads++;
+   _stats.misses++;
+   _stats.stall_ns += _latency;
+   _now += _latency;
+   _backing.for_each( space, fn );
+}
+
+void latency_store::prefetch( const object_key& k )
+{
+   auto [ it, started ] = _fetches.try_emplace( k.encode() );
+   if ( !started )
+      return;
+
+   it->second = fetch{ _now + _latency, true };
+   _stats.prefetches++;
+}
+
+void latency_store::evict()
+{
+   _fetches.clear();
+}
+
+} // koinos::native_host
@@ -0,0 +1,272 @@
+#include <koinos/native_host/host.hpp>
+
+#include <koinos/system/system_calls.hpp>
+#include <koinos/system_contracts/object_batch.hpp>
+#include <koinos/system_contracts/wire.hpp>
+
+#include <cstring>
+#include <vector>
+#include <stdexcept>
+#include <string>
+
+using namespace koinos;
+using namespace koinos::system_contracts;
+
+namespace koinos::native_host {
+
+namespace {
+
+thread_local host* active_host = nullptr;
+
+bool decode_object_space( const uint8_t* data, std::size_t len, object_key& k )
+{
+   wire::reader rdr( data, len );
+   while ( !rdr.eof() )
+   {
+      uint32_t field;
+      wire::wire_type type;
+      uint64_t v;
+
+      if ( !rdr.read_tag( field, type ) )
+         return false;
+
+      if ( field == 1 && type == wire::wire_type::varint )
+      {
+         if ( !rdr.read_varint( v ) )
+            return false;
+         k.system = v != 0;
+      }
+      else if ( field == 2 && type == wire::wire_type::length_delimited )
+      {
+         if ( !rdr.read_bytes( k.zone ) )
+            return false;
+      }
+      else if ( field == 3 && type == wire::wire_type::varint )
+      {
+         if ( !rdr.read_varint( v ) )
+            return false;
+         k.id = uint32_t( v );
+      }
+      else if ( !rdr.skip( type ) )
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+// Decodes get_object_arguments, put_object_arguments and remove_object_arguments,
+// which share their first two fields.
+bool decode_object_request( const uint8_t* data, std::size_t len, object_key& k, std::string* value )
+{
+   wire::reader rdr( data, len );
+   while ( !rdr.eof() )
+   {
+      uint32_t field;
+      wire::wire_type type;
+      const uint8_t* bytes;
+      std::size_t bytes_len;
+
+      if ( !rdr.read_tag( field, type ) )
+         return false;
+
+      if ( field == 1 && type == wire::wire_type::length_delimited )
+      {
+         if ( !rdr.read_bytes( bytes, bytes_len ) || !decode_object_space( bytes, bytes_len, k ) )
+            return false;
+      }
+      else if ( field == 2 && type == wire::wire_type::length_delimited )
+      {
+         if ( !rdr.read_bytes( k.key ) )
+            return false;
+      }
+      else if ( field == 3 && type == wire::wire_type::length_delimited && value )
+      {
+         if ( !rdr.read_bytes( *value ) )
+            return false;
+      }
+      else if ( !rdr.skip( type ) )
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+std::string encode_database_object( bool exists, const std::string& value )
+{
+   std::string obj;
+   if ( exists )
+   {
+      wire::append_bool( obj, 1, true );
+      wire::append_bytes( obj, 2, value );
+   }
+   return obj;
+}
+
+int32_t write_result( const std::string& result, char* ret_ptr, uint32_t ret_len, uint32_t* bytes_written )
+{
+   if ( result.size() > ret_len )
+      return buffer_too_small;
+
+   std::memcpy( ret_ptr, result.data(), result.size() );
+   *bytes_written = uint32_t( result.size() );
+   return success;
+}
+
+// Calls a function for each repeated message in field 1 of a batch request
+template< typename F >
+bool for_each_request( const uint8_t* data, std::size_t len, F&& f )
+{
+   wire::reader rdr( data, len );
+   while ( !rdr.eof() )
+   {
+      uint32_t field;
+      wire::wire_type type;
+      const uint8_t* request;
+      std::size_t request_len;
+
+      if ( !rdr.read_tag( field, type ) || field != 1 || type != wire::wire_type::length_delimited
+         || !rdr.read_bytes( request, request_len ) || !f( request, request_len ) )
+         return false;
+   }
+
+   return true;
+}
+
+int32_t get_object( host& h, const uint8_t* args, std::size_t args_len, char* ret_ptr, uint32_t ret_len, uint32_t* bytes_written )
+{
+   object_key k;
+   if ( !decode_object_request( args, args_len, k, nullptr ) )
+      return malformed_arguments;
+
+   std::string value;
+   bool exists = h.store->get( k, value );
+   h.stats.objects_read++;
+
+   std::string result;
+   wire::append_bytes( result, 1, encode_database_object( exists, value ) );
+   return write_result( result, ret_ptr, ret_len, bytes_written );
+}
+
+int32_t put_object( host& h, const uint8_t* args, std::size_t args_len, uint32_t* bytes_written )
+{
+   object_key k;
+   std::string value;
+   if ( !decode_object_request( args, args_len, k, &value ) )
+      return malformed_arguments;
+
+   h.store->put( k, value );
+   h.stats.objects_written++;
+   *bytes_written = 0;
+   return success;
+}
+
+int32_t remove_object( host& h, const uint8_t* args, std::size_t args_len, uint32_t* bytes_written )
+{
+   object_key k;
+   if ( !decode_object_request( args, args_len, k, nullptr ) )
+      return malformed_arguments;
+
+   h.store->remove( k );
+   h.stats.objects_written++;
+   *bytes_written = 0;
+   return success;
+}
+
+int32_t get_objects( host& h, const uint8_t* args, std::size_t args_len, char* ret_ptr, uint32_t ret_len, uint32_t* bytes_written )
+{
+   std::string result;
+   bool ok = for_each_request( args, args_len, [&]( const uint8_t* request, std::size_t request_len )
+   {
+      object_key k;
+      if ( !decode_object_request( request, request_len, k, nullptr ) )
+         return false;
+
+      std::string value;
+      bool exists = h.store->get( k, value );
+      h.stats.objects_read++;
+      wire::append_bytes( result, 1, encode_database_object( exists, value ) );
+      return true;
+   } );
+
+   if ( !ok )
+      return malformed_arguments;
+
+   return write_result( result, ret_ptr, ret_len, bytes_written );
+}
+
+int32_t put_objects( host& h, const uint8_t* args, std::size_t args_len, uint32_t* bytes_written )
+{
+   // Validate the whole batch before writing so that a malformed request
+   // leaves the store untouched, as a single failed system call would.
+   std::vector< std::pair< object_key, std::string > > writes;
+   bool ok = for_each_request( args, args_len, [&]( const uint8_t* request, std::size_t request_len )
+   {
+      object_key k;
+      std::string value;
+      if ( !decode_object_request( request, request_len, k, &value ) )
+         return false;
+
+      writes.emplace_back( std::move( k ), std::move( value ) );
+      return true;
+   } );
+
+   if ( !ok )
+      return malformed_arguments;
+
+   for ( const auto& [ k, value ] : writes )
+   {
+      h.store->put( k, value );
+      h.stats.objects_written++;
+   }
+
+   *bytes_written = 0;
+   return success;
+}
+
+} // anonymous
+
+host& current_host()
+{
+   if ( !active_host )
+      throw std::logic_error( "no native host is active on this thread" );
+
+   return *active_host;
+}
+
+void set_current_host( host* h )
+{
+   active_host = h;
+}
+
+} // koinos::native_host
+
+extern "C" int32_t invoke_system_call( uint32_t sid, char* ret_ptr, uint32_t ret_len, char* arg_ptr, uint32_t arg_len, uint32_t* bytes_written )
+{
+   using namespace koinos::native_host;
+
+   auto& h = current_host();
+   h.stats.system_calls++;
+   *bytes_written = 0;
+
+   auto args = reinterpret_cast< const uint8_t* >( arg_ptr );
+
+   switch ( sid )
+   {
+      case std::underlying_type_t< chain::system_call_id >( chain::system_call_id::get_object ):
+         return get_object( h, args, arg_len, ret_ptr, ret_len, bytes_written );
+      case std::underlying_type_t< chain::system_call_id >( chain::system_call_id::put_object ):
+         return put_object( h, args, arg_len, bytes_written );
+      case std::underlying_type_t< chain::system_call_id >( chain::system_call_id::remove_object ):
+         return remove_object( h, args, arg_len, bytes_written );
+      case get_objects_call_id:
+         return h.batch_calls ? get_objects( h, args, arg_len, ret_ptr, ret_len, bytes_written ) : unknown_system_call;
+      case put_objects_call_id:
+         return h.batch_calls ? put_objects( h, args, arg_len, bytes_written ) : unknown_system_call;
+      default:
+         return unknown_system_call;
+   }
+}
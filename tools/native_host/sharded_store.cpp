@@ -0,0 +1,371 @@
+#include <koinos/native_host/sharded_store.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace koinos::native_host {
+
+namespace {
+
+// Epoch based reclamation. A reader announces the global epoch in its slot
+// for the length of a read. A replaced value is retired with the epoch the
+// writer moves past, and can be freed once every announced epoch is newer:
+// a read that started later already sees the new value.
+
+std::atomic< uint64_t > global_epoch{ 1 };
+
+struct alignas( 64 ) reader_slot
+{
+   std::atomic< uint64_t > active{ 0 };   // Epoch of the read in progress, 0 when none
+   std::atomic< bool >     claimed{ false };
+};
+
+reader_slot reader_slots[ sharded_store::max_threads ];
+
+// A thread claims a slot on its first read and frees it when it exits
+struct slot_claim
+{
+   reader_slot* slot = nullptr;
+
+   slot_claim()
+   {
+      for ( auto& s : reader_slots )
+      {
+         bool expected = false;
+         if ( s.claimed.compare_exchange_strong( expected, true ) )
+         {
+            slot = &s;
+            return;
+         }
+      }
+
+      throw std::runtime_error( "too many threads reading a sharded_store" );
+   }
+
+   ~slot_claim()
+   {
+      slot->claimed.store( false, std::memory_order_release );
+   }
+};
+
+reader_slot& this_thread_slot()
+{
+   thread_local slot_claim claim;
+   return *claim.slot;
+}
+
+// Marks a read in progress on this thread. Reads do not nest.
+class read_guard
+{
+public:
+   read_guard() : _slot( this_thread_slot() )
+   {
+      _slot.active.store( global_epoch.load() );
+   }
+
+   ~read_guard()
+   {
+      _slot.active.store( 0, std::memory_order_release );
+   }
+
+private:
+   reader_slot& _slot;
+};
+
+uint64_t oldest_active_epoch()
+{
+   uint64_t oldest = std::numeric_limits< uint64_t >::max();
+   for ( const auto& s : reader_slots )
+   {
+      auto e = s.active.load();
+      if ( e && e < oldest )
+         oldest = e;
+   }
+   return oldest;
+}
+
+constexpr std::size_t reclaim_batch = 64;
+
+// FNV-1a. The low bits pick the shard and the high bits the bucket.
+uint64_t key_hash( const std::string& encoded )
+{
+   uint64_t h = 0xcbf29ce484222325ull;
+   for ( auto c : encoded )
+   {
+      h ^= uint8_t( c );
+      h *= 0x100000001b3ull;
+   }
+   return h;
+}
+
+std::size_t power_of_two( std::size_t n )
+{
+   std::size_t p = 1;
+   while ( p < n )
+      p <<= 1;
+   return p;
+}
+
+} // anonymous
+
+// The key and the next pointer never change once the node is in a bucket.
+// The value is null while the object is removed.
+struct sharded_store::node
+{
+   std::string                       key;
+   std::atomic< const std::string* > value;
+   node*                             next;
+
+   node( const std::string& k, const std::string* v, node* n ) : key( k ), value( v ), next( n ) {}
+};
+
+struct alignas( 64 ) sharded_store::shard
+{
+   std::mutex                                               lock;      // Held by writers
+   std::unique_ptr< std::atomic< node* >[] >                buckets;
+   std::vector< std::pair< const std::string*, uint64_t > > retired;   // Replaced values and their epochs
+};
+
+sharded_store::sharded_store( std::size_t shards, std::size_t buckets_per_shard ) :
+   _shard_mask( power_of_two( std::max< std::size_t >( 1, shards ) ) - 1 ),
+   _bucket_mask( power_of_two( std::max< std::size_t >( 1, buckets_per_shard ) ) - 1 ),
+   _shards( new shard[ _shard_mask + 1 ] )
+{
+   for ( std::size_t i = 0; i <= _shard_mask; i++ )
+   {
+      _shards[i].buckets.reset( new std::atomic< node* >[ _bucket_mask + 1 ] );
+      for ( std::size_t b = 0; b <= _bucket_mask; b++ )
+         _shards[i].buckets[b].store( nullptr, std::memory_order_relaxed );
+   }
+}
+
+sharded_store::~sharded_store()
+{
+   for ( std::size_t i = 0; i <= _shard_mask; i++ )
+   {
+      auto& s = _shards[i];
+      for ( std::size_t b = 0; b <= _bucket_mask; b++ )
+      {
+         for ( auto* n = s.buckets[b].load( std::memory_order_relaxed ); n; )
+         {
+            auto* next = n->next;
+            delete n->value.load( std::memory_order_relaxed );
+            delete n;
+            n = next;
+         }
+      }
+
+      for ( const auto& [ value, epoch ] : s.retired )
+         delete value;
+   }
+}
+
+sharded_store::shard& sharded_store::shard_of( const std::string& encoded, std::size_t& bucket ) const
+{
+   auto h = key_hash( encoded );
+   bucket = std::size_t( h >> 32 ) & _bucket_mask;
+   return _shards[ std::size_t( h ) & _shard_mask ];
+}
+
+bool sharded_store::get( const object_key& k, std::string& value ) const
+{
+   auto encoded = k.encode();
+   std::size_t bucket;
+   auto& s = shard_of( encoded, bucket );
+
+   read_guard guard;
+   for ( auto* n = s.buckets[ bucket ].load( std::memory_order_acquire ); n; n = n->next )
+   {
+      if ( n->key != encoded )
+         continue;
+
+      auto* v = n->value.load();
+      if ( !v )
+         return false;
+
+      value = *v;
+      return true;
+   }
+
+   return false;
+}
+
+// Called with the shard locked. A null value removes the object.
+void sharded_store::write( shard& s, std::size_t bucket, const std::string& encoded, const std::string* value )
+{
+   auto* head = s.buckets[ bucket ].load( std::memory_order_relaxed );
+   for ( auto* n = head; n; n = n->next )
+   {
+      if ( n->key != encoded )
+         continue;
+
+      auto* old = n->value.exchange( value );
+      if ( !old && value )
+         _size.fetch_add( 1, std::memory_order_relaxed );
+      else if ( old && !value )
+         _size.fetch_sub( 1, std::memory_order_relaxed );
+
+      if ( old )
+      {
+         s.retired.emplace_back( old, global_epoch.fetch_add( 1 ) );
+         if ( s.retired.size() >= reclaim_batch )
+         {
+            auto oldest = oldest_active_epoch();
+            auto end = std::remove_if( s.retired.begin(), s.retired.end(), [&]( const auto& r )
+            {
+               if ( r.second >= oldest )
+                  return false;
+
+               delete r.first;
+               return true;
+            } );
+            s.retired.erase( end, s.retired.end() );
+         }
+      }
+      return;
+   }
+
+   if ( !value )
+      return;
+
+   s.buckets[ bucket ].store( new node( encoded, value, head ), std::memory_order_release );
+   _size.fetch_add( 1, std::memory_order_relaxed );
+}
+
+void sharded_store::put( const object_key& k, const std::string& value )
+{
+   auto encoded = k.encode();
+   std::size_t bucket;
+   auto& s = shard_of( encoded, bucket );
+
+   std::lock_guard< std::mutex > lock( s.lock );
+   write( s, bucket, encoded, new std::string( value ) );
+}
+
+void sharded_store::remove( const object_key& k )
+{
+   auto encoded = k.encode();
+   std::size_t bucket;
+   auto& s = shard_of( encoded, bucket );
+
+   std::lock_guard< std::mutex > lock( s.lock );
+   write( s, bucket, encoded, nullptr );
+}
+
+void sharded_store::apply( const std::map< std::string, std::optional< std::string > >& writes )
+{
+   struct located
+   {
+      std::size_t                                                        shard;
+      std::size_t                                                        bucket;
+      const std::pair< const std::string, std::optional< std::string > >* write;
+   };
+
+   std::vector< located > order;
+   order.reserve( writes.size() );
+   for ( const auto& w : writes )
+   {
+      std::size_t bucket;
+      auto& s = shard_of( w.first, bucket );
+      order.push_back( located{ std::size_t( &s - _shards.get() ), bucket, &w } );
+   }
+
+   std::stable_sort( order.begin(), order.end(), []( const located& a, const located& b ) { return a.shard < b.shard; } );
+
+   std::vector< std::unique_lock< std::mutex > > locks;
+   for ( std::size_t i = 0; i < order.size(); i++ )
+      if ( !i || order[i].shard != order[i - 1].shard )
+         locks.emplace_back( _shards[ order[i].shard ].lock );
+
+   for ( const auto& w : order )
+   {
+      const auto& value = w.write->second;
+      write( _shards[ w.shard ], w.bucket, w.write->first, value ? new std::string( *value ) : nullptr );
+   }
+}
+
+void sharded_store::for_each( const object_key& space, const object_visitor& fn ) const
+{
+   object_key prefix = space;
+   prefix.key.clear();
+   auto bytes = prefix.encode();
+
+   std::map< std::string, std::string > objects;
+   {
+      read_guard guard;
+      for ( std::size_t i = 0; i <= _shard_mask; i++ )
+      {
+         for ( std::size_t b = 0; b <= _bucket_mask; b++ )
+         {
+            for ( auto* n = _shards[i].buckets[b].load( std::memory_order_acquire ); n; n = n->next )
+            {
+               if ( n->key.compare( 0, bytes.size(), bytes ) != 0 )
+                  continue;
+
+               if ( auto* v = n->value.load() )
+                  objects.emplace( n->key.substr( bytes.size() ), *v );
+            }
+         }
+      }
+   }
+
+   for ( const auto& [ key, value ] : objects )
+      fn( key, value );
+}
+
+bool store_transaction::get( const object_key& k, std::string& value ) const
+{
+   auto it = _writes.find( k.encode() );
+   if ( it == _writes.end() )
+      return _base.get( k, value );
+
+   if ( !it->second )
+      return false;
+
+   value = *it->second;
+   return true;
+}
+
+void store_transaction::put( const object_key& k, const std::string& value )
+{
+   _writes[ k.encode() ] = value;
+}
+
+void store_transaction::remove( const object_key& k )
+{
+   _writes[ k.encode() ] = std::nullopt;
+}
+
+void store_transaction::for_each( const object_key& space, const object_visitor& fn ) const
+{
+   object_key prefix = space;
+   prefix.key.clear();
+   auto bytes = prefix.encode();
+
+   std::map< std::string, std::string > objects;
+   _base.for_each( space, [&]( const std::string& key, const std::string& value )
+   {
+      objects.emplace( key, value );
+   } );
+
+   for ( auto it = _writes.lower_bound( bytes ); it != _writes.end() && it->first.compare( 0, bytes.size(), bytes ) == 0; ++it )
+   {
+      auto key = it->first.substr( bytes.size() );
+      if ( it->second )
+         objects[ key ] = *it->second;
+      else
+         objects.erase( key );
+   }
+
+   for ( const auto& [ key, value ] : objects )
+      fn( key, value );
+}
+
+void store_transaction::commit()
+{
+   _base.apply( _writes );
+   _writes.clear();
+}
+
+} // koinos::native_host
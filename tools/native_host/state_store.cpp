@@ -0,0 +1,49 @@
+#include <koinos/native_host/state_store.hpp>
+
+namespace koinos::native_host {
+
+std::string object_key::encode() const
+{
+   std::string bytes;
+   bytes.reserve( 1 + zone.size() + 5 + key.size() );
+   bytes.push_back( char( zone.size() ) );
+   bytes.append( zone );
+   for ( int shift = 24; shift >= 0; shift -= 8 )
+      bytes.push_back( char( id >> shift ) );
+   bytes.push_back( system ? 1 : 0 );
+   bytes.append( key );
+   return bytes;
+}
+
+bool state_store::get( const object_key& k, std::string& value ) const
+{
+   auto it = _objects.find( k.encode() );
+   if ( it == _objects.end() )
+      return false;
+
+   value = it->second;
+   return true;
+}
+
+void state_store::put( const object_key& k, const std::string& value )
+{
+   _objects[ k.encode() ] = value;
+}
+
+void state_store::remove( const object_key& k )
+{
+   _objects.erase( k.encode() );
+}
+
+void state_store::for_each( const object_key& space, const object_visitor& fn ) const
+{
+   // Encoded keys sort by space first, so a space is one contiguous range
+   object_key prefix = space;
+   prefix.key.clear();
+   auto bytes = prefix.encode();
+
+   for ( auto it = _objects.lower_bound( bytes ); it != _objects.end() && it->first.compare( 0, bytes.size(), bytes ) == 0; ++it )
+      fn( it->first.substr( bytes.size() ), it->second );
+}
+
+} // koinos::native_host
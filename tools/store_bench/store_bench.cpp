@@ -0,0 +1,308 @@
+#include <koinos/native_host/block_pipeline.hpp>
+#include <koinos/native_host/sharded_store.hpp>
+#include <koinos/system_contracts/fixed_layout.hpp>
+#include <koinos/tools/address.hpp>
+#include <koinos/tools/parallel.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Measures how object reads and writes scale with threads on a state store
+// shared by concurrent invocations. Each thread runs a read-heavy KOIN
+// workload against a population of balance objects: mostly balance_of reads,
+// and transfers that read both balances through a store_transaction and
+// commit both writes.
+//
+// The sharded_store is compared with the plain state_store behind a
+// reader-writer lock.
+
+using namespace koinos;
+using namespace koinos::native_host;
+using namespace koinos::tools;
+
+namespace fixed_layout = koinos::system_contracts::fixed_layout;
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+struct options
+{
+   std::vector< uint64_t > threads       = { 1, 2, 4, 8, 16, 32, 64 };
+   uint64_t                accounts      = 1'000'000;
+   uint64_t                operations    = 1'000'000;   // Per thread
+   uint64_t                write_percent = 1;
+   uint64_t                shards        = 64;
+};
+
+int usage( const char* argv0 )
+{
+   std::fprintf( stderr,
+      "usage: %s [-j threads] [-n accounts] [-o operations] [-w percent] [-s shards]\n"
+      "\n"
+      "  -j threads     comma separated thread counts (default: 1,2,4,8,16,32,64)\n"
+      "  -n accounts    balance objects in the store (default: 1000000)\n"
+      "  -o operations  operations per thread (default: 1000000)\n"
+      "  -w percent     share of operations that are transfers (default: 1)\n"
+      "  -s shards      sharded_store shards (default: 64)\n",
+      argv0 );
+   return 1;
+}
+
+bool parse_count( const std::string& text, uint64_t& v )
+{
+   char* end;
+   v = std::strtoull( text.c_str(), &end, 10 );
+   return !text.empty() && *end == '\0';
+}
+
+bool parse_counts( const std::string& text, std::vector< uint64_t >& values )
+{
+   values.clear();
+
+   std::size_t pos = 0;
+   while ( pos <= text.size() )
+   {
+      auto comma = std::min( text.find( ',', pos ), text.size() );
+      uint64_t v;
+      if ( !parse_count( text.substr( pos, comma - pos ), v ) || !v )
+         return false;
+
+      values.push_back( v );
+      pos = comma + 1;
+   }
+
+   return !values.empty();
+}
+
+uint64_t splitmix64( uint64_t& state )
+{
+   uint64_t z = ( state += 0x9e3779b97f4a7c15ull );
+   z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ull;
+   z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebull;
+   return z ^ ( z >> 31 );
+}
+
+// The plain store, safe to share
+class locked_store : public state_store
+{
+public:
+   bool get( const object_key& k, std::string& value ) const override
+   {
+      std::shared_lock< std::shared_mutex > lock( _lock );
+      return state_store::get( k, value );
+   }
+
+   void put( const object_key& k, const std::string& value ) override
+   {
+      std::unique_lock< std::shared_mutex > lock( _lock );
+      state_store::put( k, value );
+   }
+
+   void remove( const object_key& k ) override
+   {
+      std::unique_lock< std::shared_mutex > lock( _lock );
+      state_store::remove( k );
+   }
+
+   // A transfer's two writes under one lock
+   void put_pair( const object_key& a, const std::string& a_value, const object_key& b, const std::string& b_value )
+   {
+      std::unique_lock< std::shared_mutex > lock( _lock );
+      state_store::put( a, a_value );
+      state_store::put( b, b_value );
+   }
+
+private:
+   mutable std::shared_mutex _lock;
+};
+
+struct workload
+{
+   std::string               contract;
+   std::vector< object_key > balances;
+};
+
+std::string encode_balance( uint64_t balance )
+{
+   std::string value( 8, '\0' );
+   fixed_layout::put_u64( reinterpret_cast< uint8_t* >( value.data() ), balance );
+   return value;
+}
+
+uint64_t decode_balance( const std::string& value )
+{
+   return value.size() == 8 ? fixed_layout::get_u64( reinterpret_cast< const uint8_t* >( value.data() ) ) : 0;
+}
+
+void populate( const options& opts, workload& w, state_store& store )
+{
+   for ( uint64_t a = 0; a < opts.accounts; a++ )
+      store.put( w.balances[a], encode_balance( 1'000'000 ) );
+}
+
+// Moves one unit between two random accounts
+void transfer( sharded_store& store, const workload& w, uint64_t& rng )
+{
+   const auto& from = w.balances[ splitmix64( rng ) % w.balances.size() ];
+   const auto& to   = w.balances[ splitmix64( rng ) % w.balances.size() ];
+
+   store_transaction tx( store );
+   std::string from_value, to_value;
+   tx.get( from, from_value );
+   tx.get( to, to_value );
+   auto from_balance = decode_balance( from_value );
+   if ( !from_balance )
+      return;
+
+   tx.put( from, encode_balance( from_balance - 1 ) );
+   tx.put( to, encode_balance( decode_balance( to_value ) + 1 ) );
+   tx.commit();
+}
+
+void transfer( locked_store& store, const workload& w, uint64_t& rng )
+{
+   const auto& from = w.balances[ splitmix64( rng ) % w.balances.size() ];
+   const auto& to   = w.balances[ splitmix64( rng ) % w.balances.size() ];
+
+   std::string from_value, to_value;
+   store.get( from, from_value );
+   store.get( to, to_value );
+   auto from_balance = decode_balance( from_value );
+   if ( !from_balance )
+      return;
+
+   store.put_pair( from, encode_balance( from_balance - 1 ), to, encode_balance( decode_balance( to_value ) + 1 ) );
+}
+
+// Operations per second over all threads
+template< typename Store >
+double run( const options& opts, const workload& w, Store& store, std::size_t threads )
+{
+   std::vector< uint64_t > checks( threads, 0 );
+   auto start = bench_clock::now();
+
+   parallel_for( threads, threads, [&]( std::size_t t )
+   {
+      uint64_t rng = 0x5eed + t;
+      uint64_t check = 0;
+      std::string value;
+
+      for ( uint64_t i = 0; i < opts.operations; i++ )
+      {
+         if ( splitmix64( rng ) % 100 < opts.write_percent )
+         {
+            transfer( store, w, rng );
+         }
+         else if ( store.get( w.balances[ splitmix64( rng ) % w.balances.size() ], value ) )
+         {
+            check += decode_balance( value );
+         }
+      }
+
+      checks[t] = check;
+   } );
+
+   auto seconds = std::chrono::duration< double >( bench_clock::now() - start ).count();
+
+   // Keeps the reads from being optimized away
+   uint64_t check = 0;
+   for ( auto c : checks )
+      check += c;
+   if ( check == 1 )
+      std::fprintf( stderr, "\n" );
+
+   return seconds > 0 ? double( opts.operations * threads ) / seconds : 0.0;
+}
+
+int bench( const options& opts )
+{
+   workload w;
+   parse_address( "15DJN4a8SgrbGhhGksSBASiSYjGnMU8dGL", w.contract );
+   w.balances.reserve( opts.accounts );
+   for ( uint64_t a = 0; a < opts.accounts; a++ )
+   {
+      std::string address( 8, '\0' );
+      for ( std::size_t i = 0; i < address.size(); i++ )
+         address[i] = char( a >> ( 8 * i ) );
+      w.balances.push_back( object_key{ w.contract, balance_space_id, true, std::move( address ) } );
+   }
+
+   sharded_store sharded( opts.shards, std::max< uint64_t >( 1, opts.accounts / opts.shards ) );
+   locked_store locked;
+   populate( opts, w, sharded );
+   populate( opts, w, locked );
+
+   std::printf( "accounts:      %llu\n", (unsigned long long)opts.accounts );
+   std::printf( "operations:    %llu per thread, %llu%% transfers\n", (unsigned long long)opts.operations, (unsigned long long)opts.write_percent );
+   std::printf( "shards:        %llu\n", (unsigned long long)opts.shards );
+   std::printf( "cores:         %zu\n", default_thread_count() );
+   std::printf( "\n" );
+   std::printf( " threads   sharded Mops/s  speedup   locked Mops/s  speedup\n" );
+
+   double sharded_base = 0, locked_base = 0;
+   for ( auto threads : opts.threads )
+   {
+      auto s = run( opts, w, sharded, std::size_t( threads ) );
+      auto l = run( opts, w, locked, std::size_t( threads ) );
+      if ( threads == opts.threads.front() )
+      {
+         sharded_base = s;
+         locked_base  = l;
+      }
+
+      std::printf( "%8llu %16.2f %7.2fx %15.2f %7.2fx\n", (unsigned long long)threads,
+         s / 1e6, sharded_base > 0 ? s / sharded_base : 0.0,
+         l / 1e6, locked_base > 0 ? l / locked_base : 0.0 );
+   }
+
+   return 0;
+}
+
+} // anonymous
+
+int main( int argc, char** argv )
+{
+   options opts;
+   for ( int i = 1; i < argc; i++ )
+   {
+      std::string arg = argv[i];
+      if ( i + 1 >= argc )
+         return usage( argv[0] );
+
+      std::string value = argv[++i];
+      bool ok = true;
+      if ( arg == "-j" )
+         ok = parse_counts( value, opts.threads );
+      else if ( arg == "-n" )
+         ok = parse_count( value, opts.accounts ) && opts.accounts >= 2;
+      else if ( arg == "-o" )
+         ok = parse_count( value, opts.operations );
+      else if ( arg == "-w" )
+         ok = parse_count( value, opts.write_percent ) && opts.write_percent <= 100;
+      else if ( arg == "-s" )
+         ok = parse_count( value, opts.shards ) && opts.shards;
+      else
+         ok = false;
+
+      if ( !ok )
+         return usage( argv[0] );
+   }
+
+   for ( auto threads : opts.threads )
+   {
+      if ( threads > sharded_store::max_threads )
+      {
+         std::fprintf( stderr, "at most %zu threads\n", sharded_store::max_threads );
+         return 1;
+      }
+   }
+
+   return bench( opts );
+}
@@ -0,0 +1,72 @@
+#include <koinos/system_contracts/arguments.hpp>
+#include <koinos/wasm_meter/host_results.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Decodes the results wasm_meter's koinos host stub serves with the parsers
+// the contracts use on the same system calls, so that an instruction count
+// is never measured on a path the chain would not take because the stub and
+// the contracts disagree on a layout.
+
+using namespace koinos;
+
+namespace results = koinos::wasm_meter::results;
+
+namespace {
+
+uint64_t failures = 0;
+uint64_t checks   = 0;
+
+void check( bool ok, const char* what )
+{
+   checks++;
+   if ( ok )
+      return;
+
+   failures++;
+   std::fprintf( stderr, "FAIL %s\n", what );
+}
+
+const uint8_t* bytes_of( const std::string& s )
+{
+   return reinterpret_cast< const uint8_t* >( s.data() );
+}
+
+void check_arguments( uint32_t entry_point, const std::string& args )
+{
+   auto encoded = results::arguments( entry_point, args );
+
+   system_contracts::argument_view view;
+   check( system_contracts::detail::parse_arguments( bytes_of( encoded ), encoded.size(), view ), "get_arguments parses" );
+   check( view.entry_point == entry_point, "get_arguments entry point" );
+   check( view.size == args.size() && ( args.empty() || !std::memcmp( view.data, args.data(), args.size() ) ), "get_arguments arguments" );
+}
+
+void check_transaction_id( const std::string& id )
+{
+   auto encoded = results::transaction_id( id );
+
+   std::string parsed = "stale";
+   check( system_contracts::detail::parse_transaction_id( bytes_of( encoded ), encoded.size(), parsed ), "get_transaction_field parses" );
+   check( parsed == id, "get_transaction_field id" );
+}
+
+} // anonymous
+
+int main()
+{
+   check_arguments( 0, "" );
+   check_arguments( 0x27f576ca, "" );
+   check_arguments( 0, std::string( "\x0a\x00", 2 ) );
+   check_arguments( 0xffffffff, std::string( 300, '\x7f' ) );
+
+   check_transaction_id( "" );
+   check_transaction_id( std::string( "\x12\x20", 2 ) + std::string( 32, '\xab' ) );
+
+   std::printf( "%llu checks, %llu failures\n", (unsigned long long)checks, (unsigned long long)failures );
+   return failures ? 1 : 0;
+}
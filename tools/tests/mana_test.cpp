@@ -0,0 +1,121 @@
+#include <koinos/system_contracts/mana.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Checks mana::regenerate, which the koin contract and node code share,
+// against the formula the contract computed inline before it was moved
+// into mana.hpp, transcribed here with native unsigned __int128.
+//
+// Every combination of boundary balances, mana, last update times, elapsed
+// times and regeneration windows is checked, followed by pseudo-random
+// states.
+
+namespace mana = koinos::system_contracts::mana;
+
+using u128 = unsigned __int128;
+
+namespace {
+
+uint64_t failures = 0;
+uint64_t checks   = 0;
+
+// The contract's regenerating_mana::regenerate as of the move to mana.hpp
+mana::balance_state contract_regenerate( mana::balance_state bal, uint64_t head_block_time, uint64_t regen_time_ms )
+{
+   auto delta = std::min( head_block_time - bal.last_mana_update, regen_time_ms );
+   if ( delta )
+   {
+      auto new_mana = bal.mana + uint64_t( ( u128( delta ) * bal.balance ) / regen_time_ms );
+      bal.mana = std::min( new_mana, bal.balance );
+      bal.last_mana_update = head_block_time;
+   }
+
+   return bal;
+}
+
+void check( const mana::balance_state& bal, uint64_t head_block_time, uint64_t regen_time_ms )
+{
+   checks++;
+
+   auto expected = contract_regenerate( bal, head_block_time, regen_time_ms );
+   auto actual   = mana::regenerate( bal, head_block_time, regen_time_ms );
+
+   if ( actual.balance == expected.balance
+     && actual.mana == expected.mana
+     && actual.last_mana_update == expected.last_mana_update
+     && mana::available_mana( bal, head_block_time, regen_time_ms ) == expected.mana )
+      return;
+
+   if ( failures++ < 20 )
+      std::fprintf( stderr, "FAIL balance %llu mana %llu last %llu now %llu window %llu: got %llu, expected %llu\n",
+         (unsigned long long)bal.balance, (unsigned long long)bal.mana, (unsigned long long)bal.last_mana_update,
+         (unsigned long long)head_block_time, (unsigned long long)regen_time_ms,
+         (unsigned long long)actual.mana, (unsigned long long)expected.mana );
+}
+
+struct xorshift
+{
+   uint64_t state;
+
+   uint64_t next()
+   {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      return state;
+   }
+};
+
+} // anonymous
+
+int main()
+{
+   constexpr uint64_t max = ~uint64_t( 0 );
+   constexpr uint64_t regen = mana::mana_regen_time_ms;
+
+   // KOIN's supply is below 2^63 satoshi, the rest probe overflow
+   std::vector< uint64_t > balances = {
+      0, 1, 2, 3, regen - 1, regen, regen + 1, 100'000'000, 1ull << 32,
+      10'000'000'000'000'000ull, 1ull << 63, max - 1, max
+   };
+
+   std::vector< uint64_t > windows = { 1, 2, 1'000, 86'400'000, regen, 1ull << 40, max };
+
+   std::vector< uint64_t > times = { 0, 1, 1'600'000'000'000, 1ull << 62, max - regen, max - 1, max };
+
+   for ( auto window : windows )
+   {
+      std::vector< uint64_t > elapsed = { 0, 1, 2, window / 2, window - 1, window, window + 1, 2 * window, max };
+
+      for ( auto balance : balances )
+      {
+         std::vector< uint64_t > manas = { 0, 1, balance / 3, balance / 2, balance - 1, balance, balance + 1, max };
+
+         for ( auto mana_value : manas )
+            for ( auto last : times )
+               for ( auto dt : elapsed )
+                  check( { balance, mana_value, last }, last + dt, window );
+      }
+   }
+
+   xorshift rng{ 0x2545'F491'4F6C'DD1Dull };
+
+   for ( int i = 0; i < 2'000'000; i++ )
+   {
+      mana::balance_state bal;
+      bal.balance          = rng.next() >> ( rng.next() % 64 );
+      bal.mana             = bal.balance ? rng.next() % ( bal.balance + 1 ) : 0;
+      bal.last_mana_update = rng.next() >> 2;
+
+      auto now    = bal.last_mana_update + ( rng.next() >> ( 16 + rng.next() % 48 ) );
+      auto window = i % 2 ? regen : ( rng.next() >> ( rng.next() % 64 ) ) | 1;
+
+      check( bal, now, window );
+   }
+
+   std::printf( "%llu checks, %llu failures\n", (unsigned long long)checks, (unsigned long long)failures );
+   return failures ? 1 : 0;
+}
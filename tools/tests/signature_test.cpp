@@ -0,0 +1,264 @@
+#include <koinos/crypto.hpp>
+#include <koinos/system/system_calls.hpp>
+#include <koinos/system_contracts/arguments.hpp>
+#include <koinos/system_contracts/wire.hpp>
+
+#include <openssl/bn.h>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/obj_mac.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Recovers a real secp256k1 signature with the SDK's recover_public_key and
+// derives the signer's address with its address_from_public_key, as the
+// multisig check and transfer_with_permit do. The test serves hash and
+// recover_public_key itself, with OpenSSL, the way the chain serves them:
+// digests are multihashes, and a signature is 65 bytes, 31 plus the recovery
+// id, then r and s, with s in the lower half of the group order.
+//
+// The vector signs sha256( "koinos transfer_with_permit" ) with private key
+// 1. Its address is the well-known 1BgGZ9tcN4rm9KBzDn7KprQz87SZ26SAMH, and
+// `openssl pkeyutl -verify` accepts the signature for its public key.
+
+using namespace koinos;
+
+namespace wire = koinos::system_contracts::wire;
+
+namespace {
+
+constexpr int32_t success             = 0;
+constexpr int32_t unknown_system_call = -1;
+constexpr int32_t malformed_arguments = -2;
+constexpr int32_t buffer_too_small    = -3;
+
+constexpr uint64_t sha256_id    = 0x12;
+constexpr uint64_t ripemd160_id = 0x1053;
+
+uint64_t failures = 0;
+uint64_t checks   = 0;
+
+void check( bool ok, const char* what )
+{
+   checks++;
+   if ( ok )
+      return;
+
+   failures++;
+   std::fprintf( stderr, "FAIL %s\n", what );
+}
+
+std::string from_hex( const char* hex )
+{
+   std::string out;
+   for ( ; hex[0] && hex[1]; hex += 2 )
+   {
+      auto nibble = []( char c ) { return c <= '9' ? c - '0' : c - 'a' + 10; };
+      out.push_back( char( nibble( hex[0] ) << 4 | nibble( hex[1] ) ) );
+   }
+   return out;
+}
+
+std::string multihash( uint64_t code, const std::string& digest )
+{
+   std::string out;
+   wire::append_varint( out, code );
+   wire::append_varint( out, digest.size() );
+   return out + digest;
+}
+
+// The 32-byte digest of a multihash
+bool multihash_digest( const std::string& value, std::string& digest )
+{
+   wire::reader rdr( value );
+   uint64_t code;
+   return rdr.read_varint( code ) && rdr.read_bytes( digest ) && rdr.eof() && digest.size() == 32;
+}
+
+bool hash( uint64_t code, const std::string& data, std::string& digest )
+{
+   auto md = code == sha256_id ? EVP_sha256() : code == ripemd160_id ? EVP_ripemd160() : nullptr;
+   unsigned char buf[EVP_MAX_MD_SIZE];
+   unsigned int len = 0;
+   if ( !md || !EVP_Digest( data.data(), data.size(), buf, &len, md, nullptr ) )
+      return false;
+
+   digest.assign( reinterpret_cast< const char* >( buf ), len );
+   return true;
+}
+
+using bignum = std::unique_ptr< BIGNUM, decltype( &BN_free ) >;
+using point  = std::unique_ptr< EC_POINT, decltype( &EC_POINT_free ) >;
+
+bignum to_bignum( const std::string& bytes )
+{
+   return bignum( BN_bin2bn( reinterpret_cast< const unsigned char* >( bytes.data() ), int( bytes.size() ), nullptr ), &BN_free );
+}
+
+// The compressed public key that signed digest, Q = r^-1 ( s R - e G )
+bool recover( const std::string& signature, const std::string& digest, std::string& key )
+{
+   if ( signature.size() != 65 || uint8_t( signature[0] ) < 27 || uint8_t( signature[0] ) > 34 )
+      return false;
+
+   int recovery_id = ( uint8_t( signature[0] ) - 27 ) & 3;
+
+   std::unique_ptr< EC_GROUP, decltype( &EC_GROUP_free ) > group( EC_GROUP_new_by_curve_name( NID_secp256k1 ), &EC_GROUP_free );
+   std::unique_ptr< BN_CTX, decltype( &BN_CTX_free ) > ctx( BN_CTX_new(), &BN_CTX_free );
+
+   auto r = to_bignum( signature.substr( 1, 32 ) );
+   auto s = to_bignum( signature.substr( 33, 32 ) );
+   auto e = to_bignum( digest );
+   const BIGNUM* n = EC_GROUP_get0_order( group.get() );
+
+   bignum half( BN_dup( n ), &BN_free );
+   BN_rshift1( half.get(), half.get() );
+   if ( BN_is_zero( r.get() ) || BN_is_zero( s.get() ) || BN_cmp( r.get(), n ) >= 0 || BN_cmp( s.get(), half.get() ) > 0 )
+      return false;
+
+   // R from its x coordinate, r plus n for recovery ids 2 and 3, and the
+   // parity of its y coordinate
+   bignum x( BN_dup( r.get() ), &BN_free );
+   if ( recovery_id & 2 )
+      BN_add( x.get(), x.get(), n );
+
+   point R( EC_POINT_new( group.get() ), &EC_POINT_free );
+   if ( !EC_POINT_set_compressed_coordinates( group.get(), R.get(), x.get(), recovery_id & 1, ctx.get() ) )
+      return false;
+
+   bignum r_inverse( BN_mod_inverse( nullptr, r.get(), n, ctx.get() ), &BN_free );
+   bignum u1( BN_new(), &BN_free ), u2( BN_new(), &BN_free );
+   BN_mod_mul( u1.get(), e.get(), r_inverse.get(), n, ctx.get() );
+   BN_sub( u1.get(), n, u1.get() );
+   BN_mod_mul( u2.get(), s.get(), r_inverse.get(), n, ctx.get() );
+
+   point Q( EC_POINT_new( group.get() ), &EC_POINT_free );
+   if ( !EC_POINT_mul( group.get(), Q.get(), u1.get(), R.get(), u2.get(), ctx.get() ) || EC_POINT_is_at_infinity( group.get(), Q.get() ) )
+      return false;
+
+   unsigned char buf[33];
+   if ( EC_POINT_point2oct( group.get(), Q.get(), POINT_CONVERSION_COMPRESSED, buf, sizeof( buf ), ctx.get() ) != sizeof( buf ) )
+      return false;
+
+   key.assign( reinterpret_cast< const char* >( buf ), sizeof( buf ) );
+   return true;
+}
+
+// The varint and bytes fields of a system call's arguments
+bool read_fields( const std::string& message, std::map< uint32_t, uint64_t >& varints, std::map< uint32_t, std::string >& bytes )
+{
+   wire::reader rdr( message );
+   while ( !rdr.eof() )
+   {
+      uint32_t field;
+      wire::wire_type type;
+      if ( !rdr.read_tag( field, type ) )
+         return false;
+
+      if ( type == wire::wire_type::varint )
+      {
+         if ( !rdr.read_varint( varints[ field ] ) )
+            return false;
+      }
+      else if ( type == wire::wire_type::length_delimited )
+      {
+         if ( !rdr.read_bytes( bytes[ field ] ) )
+            return false;
+      }
+      else if ( !rdr.skip( type ) )
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+constexpr uint32_t id( chain::system_call_id sid )
+{
+   return std::underlying_type_t< chain::system_call_id >( sid );
+}
+
+} // anonymous
+
+extern "C" int32_t invoke_system_call( uint32_t sid, char* ret_ptr, uint32_t ret_len, char* arg_ptr, uint32_t arg_len, uint32_t* bytes_written )
+{
+   *bytes_written = 0;
+
+   std::map< uint32_t, uint64_t > varints;
+   std::map< uint32_t, std::string > bytes;
+   if ( !read_fields( std::string( arg_ptr, arg_len ), varints, bytes ) )
+      return malformed_arguments;
+
+   std::string value;
+   if ( sid == id( chain::system_call_id::hash ) )
+   {
+      // hash_arguments { uint64 code = 1; bytes obj = 2; uint64 size = 3; }
+      std::string digest;
+      if ( !hash( varints[1], bytes[2], digest ) || ( varints[3] && varints[3] != digest.size() ) )
+         return unknown_system_call;
+
+      value = multihash( varints[1], digest );
+   }
+   else if ( sid == id( chain::system_call_id::recover_public_key ) )
+   {
+      // recover_public_key_arguments { dsa type = 1; bytes signature = 2; bytes digest = 3; bool compressed = 4; }
+      std::string digest;
+      if ( varints[1] != 0 || !varints[4] || !multihash_digest( bytes[3], digest ) )
+         return malformed_arguments;
+      if ( !recover( bytes[2], digest, value ) )
+         return unknown_system_call;
+   }
+   else
+   {
+      return unknown_system_call;
+   }
+
+   // Either result { bytes value = 1; }
+   std::string out;
+   wire::append_bytes( out, 1, value );
+   if ( out.size() > ret_len )
+      return buffer_too_small;
+
+   std::memcpy( ret_ptr, out.data(), out.size() );
+   *bytes_written = uint32_t( out.size() );
+   return success;
+}
+
+int main()
+{
+   const auto digest     = from_hex( "dadb059636f23b171427d1ea6b06af38e5cdd180f9cc9afb2f765b63b3738a41" );
+   const auto signature  = from_hex( "1fb8434877776bc2c80e11b0be07d8beea6fe5d287c1002921727d3cc23aae425b"
+                                     "4d1b9a29de542c9561633fbc9017f73bbcbcfc0d172f24f5a10beec77de30385" );
+   const auto public_key = from_hex( "0279be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798" );
+   const auto address    = from_hex( "00751e76e8199196d454941c45d1b3a323f1433bd6510d1634" );
+
+   // The signature as the multisig check reads it, from get_transaction
+   std::string transaction, result;
+   wire::append_bytes( transaction, 1, multihash( sha256_id, digest ) );
+   wire::append_bytes( transaction, 4, signature );
+   wire::append_bytes( result, 1, transaction );
+
+   std::string id;
+   std::vector< std::string > signatures;
+   check( system_contracts::detail::parse_transaction_signatures( reinterpret_cast< const uint8_t* >( result.data() ), result.size(), id, signatures ), "get_transaction parses" );
+   check( signatures.size() == 1 && signatures[0] == signature, "get_transaction signature" );
+
+   auto key = system::recover_public_key( signature, id );
+   check( key == public_key, "recover_public_key recovers the signer's key" );
+   check( koinos::address_from_public_key( key ) == address, "address_from_public_key derives the signer's address" );
+
+   // The same signature over any other digest recovers some other signer
+   auto other = id;
+   other.back() ^= 1;
+   check( koinos::address_from_public_key( system::recover_public_key( signature, other ) ) != address, "another digest recovers another signer" );
+
+   std::printf( "%llu checks, %llu failures\n", (unsigned long long)checks, (unsigned long long)failures );
+   return failures ? 1 : 0;
+}
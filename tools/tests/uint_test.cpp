@@ -0,0 +1,241 @@
+#include <koinos/system_contracts/uint.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Differential test of uint.hpp against the compiler's unsigned __int128.
+//
+// Built twice: uint_test uses uint.hpp's __int128 primitives, and
+// uint_test_portable is compiled with __SIZEOF_INT128__ undefined so it
+// takes the 32-bit split path that wasm32 contracts use. The test itself
+// still computes its expected values with native unsigned __int128.
+//
+// Every pair from a set of boundary values is checked exhaustively,
+// followed by pseudo-random operands. uint256 has no native reference, so
+// its divmod is checked for q * v + r == u and r < v, and against a
+// shift-subtract long division.
+
+using namespace koinos::system_contracts;
+
+using u128 = unsigned __int128;
+
+#ifdef UINT_TEST_PORTABLE
+#ifdef KOINOS_UINT_HAS_INT128
+#error "uint_test_portable must build uint.hpp without __int128"
+#endif
+#else
+#ifndef KOINOS_UINT_HAS_INT128
+#error "uint_test must build uint.hpp with __int128"
+#endif
+#endif
+
+namespace {
+
+uint64_t failures = 0;
+uint64_t checks   = 0;
+
+void check( bool ok, const char* what, uint64_t a, uint64_t b )
+{
+   checks++;
+   if ( ok )
+      return;
+
+   if ( failures++ < 20 )
+      std::fprintf( stderr, "FAIL %s: 0x%016llx 0x%016llx\n", what, (unsigned long long)a, (unsigned long long)b );
+}
+
+struct xorshift
+{
+   uint64_t state;
+
+   uint64_t next()
+   {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      return state;
+   }
+
+   // Biased towards small values, long runs of ones and single bits, where
+   // carries, borrows and quotient estimates go wrong
+   uint64_t word()
+   {
+      auto v = next();
+      switch ( next() % 6 )
+      {
+         case 0:  return v >> ( next() % 64 );
+         case 1:  return ~uint64_t( 0 ) >> ( next() % 64 );
+         case 2:  return uint64_t( 1 ) << ( next() % 64 );
+         case 3:  return ~( uint64_t( 1 ) << ( next() % 64 ) );
+         default: return v;
+      }
+   }
+};
+
+std::vector< uint64_t > boundary_words()
+{
+   std::vector< uint64_t > words = {
+      0, 1, 2, 3, 7,
+      0x7FFF'FFFFull, 0x8000'0000ull, 0xFFFF'FFFEull, 0xFFFF'FFFFull,
+      0x1'0000'0000ull, 0x1'0000'0001ull, 0x1'FFFF'FFFFull,
+      0x5555'5555'5555'5555ull, 0xAAAA'AAAA'AAAA'AAAAull,
+      0x7FFF'FFFF'FFFF'FFFFull, 0x8000'0000'0000'0000ull, 0x8000'0000'0000'0001ull,
+      0xFFFF'FFFF'0000'0000ull, 0xFFFF'FFFF'FFFF'FFFEull, 0xFFFF'FFFF'FFFF'FFFFull
+   };
+   return words;
+}
+
+u128 to_native( const uint128& v )
+{
+   return ( u128( v.limb( 1 ) ) << 64 ) | v.limb( 0 );
+}
+
+uint128 from_native( u128 v )
+{
+   return ( uint128( uint64_t( v >> 64 ) ) << 64 ) | uint128( uint64_t( v ) );
+}
+
+void check_primitives( uint64_t a, uint64_t b )
+{
+   u128 p = u128( a ) * b;
+   uint64_t hi = 0;
+   uint64_t lo = detail::mul_wide( a, b, hi );
+   check( lo == uint64_t( p ) && hi == uint64_t( p >> 64 ), "mul_wide", a, b );
+
+   if ( b == 0 )
+      return;
+
+   // div_wide requires hi < d
+   uint64_t n_hi = a % b;
+   u128 n = ( u128( n_hi ) << 64 ) | ( a ^ b );
+   uint64_t rem = 0;
+   uint64_t q = detail::div_wide( n_hi, a ^ b, b, rem );
+   check( q == uint64_t( n / b ) && rem == uint64_t( n % b ), "div_wide", a, b );
+
+   if ( b > 1 )
+   {
+      q = detail::div_wide( b - 1, ~a, b, rem );
+      n = ( u128( b - 1 ) << 64 ) | ~a;
+      check( q == uint64_t( n / b ) && rem == uint64_t( n % b ), "div_wide max", a, b );
+   }
+}
+
+void check_uint128( u128 x, u128 y )
+{
+   auto a = from_native( x );
+   auto b = from_native( y );
+   auto lo = uint64_t( x ), lo_y = uint64_t( y );
+
+   check( to_native( a + b ) == x + y, "uint128 +", lo, lo_y );
+   check( to_native( a - b ) == x - y, "uint128 -", lo, lo_y );
+   check( to_native( a * b ) == x * y, "uint128 *", lo, lo_y );
+   check( ( a < b ) == ( x < y ) && ( a == b ) == ( x == y ), "uint128 compare", lo, lo_y );
+
+   if ( y )
+   {
+      check( to_native( a / b ) == x / y, "uint128 /", lo, lo_y );
+      check( to_native( a % b ) == x % y, "uint128 %", lo, lo_y );
+   }
+
+   auto shift = std::size_t( lo_y % 130 );
+   check( to_native( a << shift ) == ( shift < 128 ? x << shift : 0 ), "uint128 <<", lo, shift );
+   check( to_native( a >> shift ) == ( shift < 128 ? x >> shift : 0 ), "uint128 >>", lo, shift );
+
+   uint8_t bytes[uint128::bytes];
+   a.to_big_endian( bytes );
+   check( uint128::from_big_endian( bytes ) == a, "uint128 big endian", lo, lo_y );
+}
+
+uint256 make_uint256( uint64_t l0, uint64_t l1, uint64_t l2, uint64_t l3 )
+{
+   return ( uint256( l3 ) << 192 ) | ( uint256( l2 ) << 128 ) | ( uint256( l1 ) << 64 ) | uint256( l0 );
+}
+
+// Restoring binary long division, one quotient bit at a time
+void long_divide( const uint256& u, const uint256& v, uint256& q, uint256& r )
+{
+   q = uint256();
+   r = uint256();
+   for ( std::size_t i = uint256::bits; i-- > 0; )
+   {
+      r = ( r << 1 ) | ( ( u >> i ) & uint256( 1 ) );
+      if ( r >= v )
+      {
+         r -= v;
+         q |= uint256( 1 ) << i;
+      }
+   }
+}
+
+void check_uint256( const uint256& u, const uint256& v, bool reference )
+{
+   if ( !v )
+      return;
+
+   uint256 q, r;
+   uint256::divmod( u, v, q, r );
+   check( r < v, "uint256 remainder < divisor", u.limb( 0 ), v.limb( 0 ) );
+   check( q * v + r == u, "uint256 q * v + r == u", u.limb( 0 ), v.limb( 0 ) );
+   check( u / v == q && u % v == r, "uint256 operators match divmod", u.limb( 0 ), v.limb( 0 ) );
+
+   if ( reference )
+   {
+      uint256 lq, lr;
+      long_divide( u, v, lq, lr );
+      check( q == lq && r == lr, "uint256 long division", u.limb( 0 ), v.limb( 0 ) );
+   }
+}
+
+} // anonymous
+
+int main()
+{
+   auto words = boundary_words();
+
+   for ( auto a : words )
+      for ( auto b : words )
+         check_primitives( a, b );
+
+   for ( auto a_hi : words )
+      for ( auto a_lo : words )
+         for ( auto b_hi : words )
+            for ( auto b_lo : words )
+               check_uint128( ( u128( a_hi ) << 64 ) | a_lo, ( u128( b_hi ) << 64 ) | b_lo );
+
+   // Every limb of the dividend and the top two limbs of the divisor from
+   // the boundary set, which is where Knuth D's quotient estimate and
+   // add back steps are exercised
+   std::vector< uint64_t > limbs = { 0, 1, 0x8000'0000'0000'0000ull, 0xFFFF'FFFF'FFFF'FFFEull, 0xFFFF'FFFF'FFFF'FFFFull };
+   for ( auto u3 : limbs )
+      for ( auto u2 : limbs )
+         for ( auto u1 : limbs )
+            for ( auto u0 : limbs )
+               for ( auto v1 : words )
+                  for ( auto v0 : limbs )
+                  {
+                     auto u = make_uint256( u0, u1, u2, u3 );
+                     check_uint256( u, make_uint256( v0, v1, 0, 0 ), false );
+                     check_uint256( u, make_uint256( 0, v0, v1, 0 ), false );
+                     check_uint256( u, make_uint256( v0, 0, 0, v1 ), false );
+                  }
+
+   xorshift rng{ 0x9E37'79B9'7F4A'7C15ull };
+
+   for ( int i = 0; i < 1'000'000; i++ )
+   {
+      auto a = rng.word(), b = rng.word();
+      check_primitives( a, b );
+      check_uint128( ( u128( rng.word() ) << 64 ) | a, ( u128( rng.word() ) << 64 ) | b );
+   }
+
+   for ( int i = 0; i < 200'000; i++ )
+   {
+      auto u = make_uint256( rng.word(), rng.word(), rng.word(), rng.word() );
+      auto v = make_uint256( rng.word(), rng.word(), rng.word(), rng.word() ) >> ( rng.next() % 256 );
+      check_uint256( u, v, i < 20'000 );
+   }
+
+   std::printf( "%llu checks, %llu failures\n", (unsigned long long)checks, (unsigned long long)failures );
+   return failures ? 1 : 0;
+}
@@ -0,0 +1,404 @@
+#include <koinos/wasm_meter/instance.hpp>
+#include <koinos/wasm_meter/module.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Runs wasm_meter's interpreter over a module assembled here, one exported
+// function per feature: recursion, loops, br_table, memory and bulk memory,
+// tables and call_indirect, floats and saturating conversions, traps, host
+// imports, passive data and the instruction limit. Each result is compared
+// with what the wasm specification requires, and the instruction counts are
+// checked to follow the one-per-executed-instruction rule the contract
+// budgets rely on, exactly for each construct where metering interpreters
+// can differ.
+
+using namespace koinos::wasm_meter;
+
+namespace {
+
+uint64_t failures = 0;
+uint64_t checks   = 0;
+
+void check( bool ok, const char* what )
+{
+   checks++;
+   if ( ok )
+      return;
+
+   failures++;
+   std::fprintf( stderr, "FAIL %s\n", what );
+}
+
+template< typename F >
+void check_trap( F&& f, const char* what )
+{
+   checks++;
+   try
+   {
+      f();
+   }
+   catch ( const trap& )
+   {
+      return;
+   }
+
+   failures++;
+   std::fprintf( stderr, "FAIL %s did not trap\n", what );
+}
+
+// A minimal assembler for the binary format
+
+using bytes = std::vector< uint8_t >;
+
+constexpr uint8_t i32 = 0x7f, i64 = 0x7e, f32 = 0x7d, f64 = 0x7c, empty = 0x40;
+
+bytes operator +( bytes a, const bytes& b )
+{
+   a.insert( a.end(), b.begin(), b.end() );
+   return a;
+}
+
+bytes uleb( uint64_t v )
+{
+   bytes out;
+   do
+   {
+      uint8_t b = v & 0x7f;
+      v >>= 7;
+      out.push_back( v ? b | 0x80 : b );
+   } while ( v );
+   return out;
+}
+
+bytes sleb( int64_t v )
+{
+   bytes out;
+   for ( ;; )
+   {
+      uint8_t b = v & 0x7f;
+      v >>= 7;
+      if ( ( v == 0 && !( b & 0x40 ) ) || ( v == -1 && ( b & 0x40 ) ) )
+      {
+         out.push_back( b );
+         return out;
+      }
+      out.push_back( b | 0x80 );
+   }
+}
+
+bytes vec( const std::vector< bytes >& items )
+{
+   bytes out = uleb( items.size() );
+   for ( const auto& item : items )
+      out = out + item;
+   return out;
+}
+
+bytes name( const std::string& s )
+{
+   return uleb( s.size() ) + bytes( s.begin(), s.end() );
+}
+
+bytes section( uint8_t id, const bytes& body )
+{
+   return bytes{ id } + uleb( body.size() ) + body;
+}
+
+bytes functype( const bytes& params, const bytes& results )
+{
+   return bytes{ 0x60 } + uleb( params.size() ) + params + uleb( results.size() ) + results;
+}
+
+// A function body without locals, or with count locals of one type
+bytes body( const bytes& code, uint32_t locals = 0, uint8_t local_type = i32 )
+{
+   bytes b = locals ? uleb( 1 ) + uleb( locals ) + bytes{ local_type } : uleb( 0 );
+   b = b + code + bytes{ 0x0b };
+   return uleb( b.size() ) + b;
+}
+
+bytes i32c( int32_t v ) { return bytes{ 0x41 } + sleb( v ); }
+bytes i64c( int64_t v ) { return bytes{ 0x42 } + sleb( v ); }
+
+bytes f32c( float v )
+{
+   bytes out{ 0x43, 0, 0, 0, 0 };
+   std::memcpy( out.data() + 1, &v, 4 );
+   return out;
+}
+
+bytes local_get( uint32_t i ) { return bytes{ 0x20 } + uleb( i ); }
+bytes local_set( uint32_t i ) { return bytes{ 0x21 } + uleb( i ); }
+bytes call( uint32_t i )      { return bytes{ 0x10 } + uleb( i ); }
+
+bytes memory_op( uint8_t op, uint32_t align = 0, uint32_t offset = 0 )
+{
+   return bytes{ op } + uleb( align ) + uleb( offset );
+}
+
+struct function
+{
+   uint32_t    type;
+   bytes       code;
+   std::string export_name;
+};
+
+// Function 0 is the imported env.add( i32, i32 ) -> i32, so function i of
+// this list has index i + 1
+std::vector< function > functions()
+{
+   return {
+      // 1: recursive factorial, i64 -> i64
+      { 0, body( local_get( 0 ) + bytes{ 0x50, 0x04, i64 } + i64c( 1 ) + bytes{ 0x05 }
+         + local_get( 0 ) + local_get( 0 ) + i64c( 1 ) + bytes{ 0x7d } + call( 1 ) + bytes{ 0x7e, 0x0b } ), "fac" },
+
+      // 2: 1 + ... + n in a loop
+      { 1, body( bytes{ 0x02, empty, 0x03, empty } + local_get( 0 ) + bytes{ 0x45, 0x0d, 1 }
+         + local_get( 1 ) + local_get( 0 ) + bytes{ 0x6a } + local_set( 1 )
+         + local_get( 0 ) + i32c( 1 ) + bytes{ 0x6b } + local_set( 0 )
+         + bytes{ 0x0c, 0, 0x0b, 0x0b } + local_get( 1 ), 1 ), "sum" },
+
+      // 3: br_table to 10, 20, 30, default 99
+      { 1, body( bytes{ 0x02, empty, 0x02, empty, 0x02, empty, 0x02, empty } + local_get( 0 )
+         + bytes{ 0x0e, 3, 0, 1, 2, 3, 0x0b } + i32c( 10 ) + bytes{ 0x0f, 0x0b } + i32c( 20 ) + bytes{ 0x0f, 0x0b }
+         + i32c( 30 ) + bytes{ 0x0f, 0x0b } + i32c( 99 ) ), "switch" },
+
+      // 4: i64.store, i32.load8_s, memory.fill, memory.copy, i32.load
+      { 2, body( i32c( 8 ) + i64c( -2 ) + memory_op( 0x37, 3 )
+         + i32c( 8 ) + memory_op( 0x2c )
+         + i32c( 100 ) + i32c( 7 ) + i32c( 4 ) + bytes{ 0xfc, 11, 0 }
+         + i32c( 200 ) + i32c( 100 ) + i32c( 4 ) + bytes{ 0xfc, 10, 0, 0 }
+         + i32c( 200 ) + memory_op( 0x28, 2 ) + bytes{ 0x6a } ), "memtest" },
+
+      // 5: memory.grow by 2 from 1 page, times memory.size
+      { 2, body( i32c( 2 ) + bytes{ 0x40, 0, 0x3f, 0, 0x6c } ), "grow" },
+
+      // 6: call_indirect table[n]( 5 )
+      { 1, body( i32c( 5 ) + local_get( 0 ) + bytes{ 0x11, 1, 0 } ), "indirect" },
+
+      // 7: f64.nearest( f64.sqrt( x ) )
+      { 4, body( local_get( 0 ) + bytes{ 0x9f, 0x9e } ), "sqrtn" },
+
+      // 8: i32.trunc_sat_f64_s
+      { 7, body( local_get( 0 ) + bytes{ 0xfc, 2 } ), "tsat" },
+
+      // 9: 1 / n, signed
+      { 1, body( i32c( 1 ) + local_get( 0 ) + bytes{ 0x6d } ), "divs" },
+
+      // 10: env.add( n, 40 )
+      { 1, body( local_get( 0 ) + i32c( 40 ) + call( 0 ) ), "hostadd" },
+
+      // 11: a block taking its i32 parameter from the stack
+      { 1, body( local_get( 0 ) + bytes{ 0x02, 1 } + i32c( 3 ) + bytes{ 0x6c, 0x0b } ), "blockparam" },
+
+      // 12, 13: table targets
+      { 1, body( local_get( 0 ) + local_get( 0 ) + bytes{ 0x6a } ), "dbl" },
+      { 1, body( i32c( 0 ) + local_get( 0 ) + bytes{ 0x6b } ), "neg" },
+
+      // 14: memory.init from passive segment 1, data.drop, then load
+      { 2, body( i32c( 300 ) + i32c( 1 ) + i32c( 4 ) + bytes{ 0xfc, 8, 1, 0, 0xfc, 9, 1 } + i32c( 300 ) + memory_op( 0x28, 2 ) ), "init" },
+
+      // 15: out of bounds load
+      { 2, body( i32c( -4 ) + memory_op( 0x28, 2 ) ), "oob" },
+
+      // 16: select( 1000, 0, i64.popcnt( 0xff ) + i64.clz( i64.rotl( 1, 63 ) ) )
+      { 5, body( i64c( 1 ) + i64c( 63 ) + bytes{ 0x89, 0x79 } + i64c( 0xff ) + bytes{ 0x7b, 0x7c } + i64c( 1000 ) + i32c( 0 ) + bytes{ 0x1b } ), "bits" },
+
+      // 17: f32( 3 ) / 2 == 1.5
+      { 2, body( i32c( 3 ) + bytes{ 0xb2 } + f32c( 2.0f ) + bytes{ 0x95 } + f32c( 1.5f ) + bytes{ 0x5b } ), "f32" },
+
+      // 18: br_if out of a block with a value
+      { 1, body( bytes{ 0x02, i32 } + i32c( 7 ) + local_get( 0 ) + bytes{ 0x0d, 0, 0x1a } + i32c( 8 ) + bytes{ 0x0b } ), "brval" },
+
+      // 19: loops forever
+      { 2, body( bytes{ 0x03, empty, 0x0c, 0, 0x0b } + i32c( 0 ) ), "spin" },
+
+      // 20 to 31 each exercise one construct whose cost the metering rule
+      // decides, checked below against exact counts
+
+      // 20: 1 + 2
+      { 2, body( i32c( 1 ) + i32c( 2 ) + bytes{ 0x6a } ), "m_straight" },
+
+      // 21: br out of a block
+      { 2, body( bytes{ 0x02, empty, 0x0c, 0, 0x0b } + i32c( 1 ) ), "m_block_br" },
+
+      // 22: loop counting n down to zero
+      { 1, body( bytes{ 0x03, empty } + local_get( 0 ) + i32c( 1 ) + bytes{ 0x6b, 0x22, 0, 0x0d, 0, 0x0b } + local_get( 0 ) ), "m_loop" },
+
+      // 23: n ? 10 : 20 with if and else
+      { 1, body( local_get( 0 ) + bytes{ 0x04, i32 } + i32c( 10 ) + bytes{ 0x05 } + i32c( 20 ) + bytes{ 0x0b } ), "m_if_else" },
+
+      // 24: if without else
+      { 1, body( local_get( 0 ) + bytes{ 0x04, empty, 0x01, 0x0b } + i32c( 5 ) ), "m_if" },
+
+      // 25: return before the function's end
+      { 2, body( i32c( 7 ) + bytes{ 0x0f } ), "m_return" },
+
+      // 26: a call to m_straight
+      { 2, body( call( 20 ) ), "m_call" },
+
+      // 27: a call to the host
+      { 2, body( i32c( 1 ) + i32c( 2 ) + call( 0 ) ), "m_host" },
+
+      // 28: br_table to the inner block for 0, else to the outer one
+      { 1, body( bytes{ 0x02, empty, 0x02, empty } + local_get( 0 ) + bytes{ 0x0e, 1, 0, 1, 0x0b } + i32c( 1 ) + bytes{ 0x0f, 0x0b } + i32c( 2 ) ), "m_br_table" },
+
+      // 29: br to the function's own label
+      { 2, body( i32c( 9 ) + bytes{ 0x0c, 0 } ), "m_br_function" },
+
+      // 30: unreachable
+      { 2, body( i32c( 1 ) + bytes{ 0x00 } ), "m_trap" },
+
+      // 31: memory.fill of 1000 bytes
+      { 2, body( i32c( 0 ) + i32c( 0 ) + i32c( 1000 ) + bytes{ 0xfc, 11, 0 } + i32c( 0 ) ), "m_fill" },
+   };
+}
+
+bytes assemble()
+{
+   std::vector< bytes > types = {
+      functype( { i64 }, { i64 } ),        // 0
+      functype( { i32 }, { i32 } ),        // 1
+      functype( {}, { i32 } ),             // 2
+      functype( { i32, i32 }, { i32 } ),   // 3
+      functype( { f64 }, { f64 } ),        // 4
+      functype( {}, { i64 } ),             // 5
+      functype( { i32 }, { i32, i32 } ),   // 6
+      functype( { f64 }, { i32 } ),        // 7
+   };
+
+   auto funcs = functions();
+   std::vector< bytes > func_types, exports, code;
+   for ( std::size_t i = 0; i < funcs.size(); i++ )
+   {
+      func_types.push_back( uleb( funcs[i].type ) );
+      exports.push_back( name( funcs[i].export_name ) + bytes{ 0x00 } + uleb( i + 1 ) );
+      code.push_back( funcs[i].code );
+   }
+
+   return bytes{ 0x00, 'a', 's', 'm', 0x01, 0x00, 0x00, 0x00 }
+      + section( 1, vec( types ) )
+      + section( 2, vec( { name( "env" ) + name( "add" ) + bytes{ 0x00 } + uleb( 3 ) } ) )
+      + section( 3, vec( func_types ) )
+      + section( 4, vec( { bytes{ 0x70, 0 } + uleb( 4 ) } ) )
+      + section( 5, vec( { bytes{ 1 } + uleb( 1 ) + uleb( 4 ) } ) )
+      + section( 6, vec( { bytes{ i32, 1 } + i32c( 5 ) + bytes{ 0x0b } } ) )
+      + section( 7, vec( exports ) )
+      // table[1] = dbl, table[2] = neg, table[3] = fac, whose type does not match
+      + section( 9, vec( { bytes{ 0x00 } + i32c( 1 ) + bytes{ 0x0b } + vec( { uleb( 12 ), uleb( 13 ), uleb( 1 ) } ) } ) )
+      + section( 12, uleb( 2 ) )
+      + section( 10, vec( code ) )
+      // "AB" at 16, and passive bytes 0 to 5
+      + section( 11, vec( {
+         bytes{ 0x00 } + i32c( 16 ) + bytes{ 0x0b } + vec( { bytes{ 'A' }, bytes{ 'B' } } ),
+         bytes{ 0x01 } + vec( { bytes{ 0 }, bytes{ 1 }, bytes{ 2 }, bytes{ 3 }, bytes{ 4 }, bytes{ 5 } } ) } ) );
+}
+
+uint64_t bits( double d )
+{
+   uint64_t b;
+   std::memcpy( &b, &d, sizeof( b ) );
+   return b;
+}
+
+double real( uint64_t b )
+{
+   double d;
+   std::memcpy( &d, &b, sizeof( d ) );
+   return d;
+}
+
+} // anonymous
+
+int main()
+{
+   auto code = assemble();
+   auto m = decode_module( code.data(), code.size() );
+
+   auto resolve = []( const import& imp, const func_type& type ) -> host_function
+   {
+      if ( imp.name == "add" && type.params.size() == 2 )
+         return []( instance&, const uint64_t* a, uint64_t* r ) { r[0] = uint32_t( a[0] + a[1] ); };
+      return {};
+   };
+
+   instance in( m, resolve );
+
+   check( in.call( "fac", { 20 } )[0] == 2432902008176640000ull, "fac" );
+   check( in.call( "sum", { 100 } )[0] == 5050, "sum" );
+   check( in.call( "switch", { 0 } )[0] == 10 && in.call( "switch", { 2 } )[0] == 30 && in.call( "switch", { 7 } )[0] == 99, "br_table" );
+   check( in.call( "memtest" )[0] == uint32_t( 0x07070707 - 2 ), "memory" );
+   check( in.call( "grow" )[0] == 3, "memory.grow" );
+   check( in.call( "indirect", { 1 } )[0] == 10 && in.call( "indirect", { 2 } )[0] == uint32_t( -5 ), "call_indirect" );
+   check_trap( [&] { in.call( "indirect", { 3 } ); }, "call_indirect type mismatch" );
+   check_trap( [&] { in.call( "indirect", { 0 } ); }, "call_indirect null entry" );
+   check( real( in.call( "sqrtn", { bits( 10.0 ) } )[0] ) == 3.0, "f64.sqrt, f64.nearest" );
+   check( in.call( "tsat", { bits( 1e20 ) } )[0] == 0x7fffffff && in.call( "tsat", { bits( -3.7 ) } )[0] == uint32_t( -3 ), "trunc_sat" );
+   check_trap( [&] { in.call( "divs", { 0 } ); }, "division by zero" );
+   check( in.call( "hostadd", { 2 } )[0] == 42, "host import" );
+   check( in.call( "blockparam", { 5 } )[0] == 15, "block parameter" );
+   check( in.call( "init" )[0] == 0x04030201, "memory.init" );
+   check_trap( [&] { in.call( "init" ); }, "memory.init after data.drop" );
+   check_trap( [&] { in.call( "oob" ); }, "out of bounds load" );
+   check( in.call( "bits" )[0] == 1000, "i64 bit ops, select" );
+   check( in.call( "f32" )[0] == 1, "f32" );
+   check( in.call( "brval", { 1 } )[0] == 7 && in.call( "brval", { 0 } )[0] == 8, "br_if with a value" );
+   check( *in.memory( 16, 2 ) == 'A', "active data" );
+
+   // Each loop iteration of sum executes 12 instructions, and the count is
+   // the same in a fresh instance
+   auto count = [&]( instance& i, uint64_t n )
+   {
+      auto before = i.instructions();
+      i.call( "sum", { n } );
+      return i.instructions() - before;
+   };
+   auto c10 = count( in, 10 );
+   check( count( in, 11 ) - c10 == 12 && count( in, 20 ) - c10 == 120, "instructions per iteration" );
+
+   instance fresh( m, resolve );
+   check( count( fresh, 10 ) == c10, "instruction count is deterministic" );
+
+   // Exact counts for the constructs where interpreters can disagree. Every
+   // instruction fetched costs one, the trapping one and block, loop, if,
+   // else and end included. A branch resumes after the end of a block, which
+   // is not counted, or after the loop instruction of a loop, which is not
+   // counted again. A false if without else runs its end; one with else
+   // skips the else. return and a branch to the function's label skip its
+   // end. Host functions cost nothing beyond their call instruction, and
+   // bulk memory instructions cost one whatever their length.
+   auto cost = [&]( const char* function, std::vector< uint64_t > args = {} )
+   {
+      auto before = in.instructions();
+      try
+      {
+         in.call( function, args );
+      }
+      catch ( const trap& )
+      {
+      }
+      return in.instructions() - before;
+   };
+   check( cost( "m_straight" ) == 4, "cost of straight-line code" );
+   check( cost( "m_block_br" ) == 4, "cost of br out of a block" );
+   check( cost( "m_loop", { 3 } ) == 19, "cost of a loop" );
+   check( cost( "m_if_else", { 1 } ) == 6 && cost( "m_if_else", { 0 } ) == 5, "cost of if and else" );
+   check( cost( "m_if", { 1 } ) == 6 && cost( "m_if", { 0 } ) == 5, "cost of if without else" );
+   check( cost( "m_return" ) == 2, "cost of return" );
+   check( cost( "m_call" ) == 6, "cost of a call" );
+   check( cost( "m_host" ) == 4, "cost of a host call" );
+   check( cost( "m_br_table", { 0 } ) == 6 && cost( "m_br_table", { 5 } ) == 6, "cost of br_table" );
+   check( cost( "m_br_function" ) == 2, "cost of br to the function label" );
+   check( cost( "m_trap" ) == 2, "cost of a trap" );
+   check( cost( "m_fill" ) == 6, "cost of memory.fill" );
+
+   in.set_instruction_limit( in.instructions() + 1000 );
+   check_trap( [&] { in.call( "spin" ); }, "instruction limit" );
+
+   std::printf( "%llu checks, %llu failures\n", (unsigned long long)checks, (unsigned long long)failures );
+   return failures ? 1 : 0;
+}
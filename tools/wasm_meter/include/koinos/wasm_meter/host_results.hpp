@@ -0,0 +1,83 @@
+#pragma once
+
+#include <koinos/system_contracts/wire.hpp>
+
+#include <cstdint>
+#include <string>
+
+// The system call results the koinos host stub serves, encoded by hand from
+// the chain protobuf definitions. They are kept apart from the stub so that
+// the host_results test can decode them with the contracts' own parsers.
+
+namespace koinos::wasm_meter::results {
+
+namespace wire = koinos::system_contracts::wire;
+
+// get_arguments_result { argument_data value = 1; }
+// argument_data { uint32 entry_point = 1; bytes arguments = 2; }
+inline std::string arguments( uint32_t entry_point, const std::string& args )
+{
+   std::string data, out;
+   if ( entry_point )
+      wire::append_uint64( data, 1, entry_point );
+   if ( !args.empty() )
+      wire::append_bytes( data, 2, args );
+   wire::append_bytes( out, 1, data );
+   return out;
+}
+
+// get_caller_result { caller_data value = 1; }
+// caller_data { bytes caller = 1; privilege caller_privilege = 2; }
+inline std::string caller( const std::string& address, uint64_t privilege )
+{
+   std::string data, out;
+   if ( !address.empty() )
+      wire::append_bytes( data, 1, address );
+   if ( privilege )
+      wire::append_uint64( data, 2, privilege );
+   wire::append_bytes( out, 1, data );
+   return out;
+}
+
+// get_head_info_result { head_info value = 1; }
+// head_info { block_topology head_topology = 1; uint64 head_block_time = 2; uint64 last_irreversible_block = 3; }
+// block_topology { bytes id = 1; uint64 height = 2; bytes previous = 3; }
+inline std::string head_info( uint64_t height, uint64_t head_block_time )
+{
+   std::string topology, info, out;
+   wire::append_uint64( topology, 2, height );
+   wire::append_bytes( info, 1, topology );
+   wire::append_uint64( info, 2, head_block_time );
+   wire::append_bytes( out, 1, info );
+   return out;
+}
+
+// get_transaction_field_result { value_type value = 1; }, the id as
+// value_type.bytes_value = 14
+inline std::string transaction_id( const std::string& id )
+{
+   std::string value, out;
+   wire::append_bytes( value, 14, id );
+   wire::append_bytes( out, 1, value );
+   return out;
+}
+
+// check_authority_result { bool value = 1; }
+inline std::string authority( bool authorized )
+{
+   std::string out;
+   if ( authorized )
+      wire::append_bool( out, 1, true );
+   return out;
+}
+
+// Any result { bytes value = 1; }: get_contract_id, get_chain_id, call, and
+// hash with a multihash
+inline std::string bytes( const std::string& value )
+{
+   std::string out;
+   wire::append_bytes( out, 1, value );
+   return out;
+}
+
+} // koinos::wasm_meter::results
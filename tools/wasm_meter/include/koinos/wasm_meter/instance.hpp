@@ -0,0 +1,97 @@
+#pragma once
+
+#include <koinos/wasm_meter/module.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace koinos::wasm_meter {
+
+// Execution stopped by the module: unreachable, an out of bounds access, a
+// failed conversion, or the instruction limit
+struct trap : std::runtime_error
+{
+   using std::runtime_error::runtime_error;
+};
+
+class instance;
+
+// A host function gets its arguments and writes its results as raw value
+// bits: i32 zero extended, floats as their bit patterns. It may throw to
+// stop execution, and the exception propagates out of instance::call().
+using host_function = std::function< void( instance&, const uint64_t* args, uint64_t* results ) >;
+
+// Supplies the host function for an import, or throws if there is none
+using import_resolver = std::function< host_function( const import&, const func_type& ) >;
+
+// An instance of a decoded module that counts the instructions it executes.
+// Every executed instruction costs one, structured control instructions
+// (block, loop, else, end) included, so the count is a pure function of the
+// module and its inputs. A branch resumes after a block's end or after a
+// loop's loop instruction, neither counted. Bulk memory instructions cost
+// one whatever their length, and time spent in host functions is not
+// counted.
+//
+// The module must outlive the instance.
+class instance
+{
+public:
+   static constexpr uint32_t page_size      = 65536;
+   static constexpr uint32_t max_call_depth = 8192;
+
+   instance( const module& m, const import_resolver& resolve );
+
+   // Runs the module's start function, if it has one
+   void start();
+
+   // Calls an exported function
+   std::vector< uint64_t > call( const std::string& name, const std::vector< uint64_t >& args = {} );
+
+   // Instructions executed so far, over all calls
+   uint64_t instructions() const { return _instructions; }
+
+   // Traps once more than limit instructions have executed
+   void set_instruction_limit( uint64_t limit ) { _limit = limit; }
+
+   // Linear memory, bounds checked, for host functions. Traps when the range
+   // is out of bounds.
+   uint8_t* memory( uint32_t address, uint32_t size );
+
+   std::size_t memory_size() const { return _memory.size(); }
+
+private:
+   void     run( uint32_t index );
+   void     call_host( uint32_t index );
+
+   uint64_t pop()
+   {
+      auto v = _stack.back();
+      _stack.pop_back();
+      return v;
+   }
+
+   void push( uint64_t v ) { _stack.push_back( v ); }
+
+   template< typename T, typename F > void unary( F f );
+   template< typename T, typename F > void binary( F f );
+   template< typename T > T    load( uint32_t offset );
+   template< typename T > void store( uint32_t offset );
+
+   const module&                          _module;
+   std::vector< host_function >           _imports;
+   std::vector< uint8_t >                 _memory;
+   uint32_t                               _max_pages    = 0;
+   std::vector< uint64_t >                _globals;
+   std::vector< std::vector< uint64_t > > _tables;
+   std::vector< bool >                    _dropped;        // Data segments memory.init can no longer use
+   std::vector< uint64_t >                _stack;
+   uint64_t                               _instructions = 0;
+   uint64_t                               _limit        = std::numeric_limits< uint64_t >::max();
+};
+
+} // koinos::wasm_meter
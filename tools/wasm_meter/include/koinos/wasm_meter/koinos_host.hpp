@@ -0,0 +1,55 @@
+#pragma once
+
+#include <koinos/native_host/sharded_store.hpp>
+#include <koinos/wasm_meter/module.hpp>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace koinos::wasm_meter {
+
+// What the chain shows a contract during an invocation
+struct chain_state
+{
+   std::string                       contract_id;
+   std::string                       caller;
+   bool                              kernel_mode     = false;
+   bool                              authorized      = true;    // The answer to check_authority
+   uint64_t                          head_block_time = 0;
+   uint64_t                          head_height     = 1;
+   std::string                       chain_id;
+   std::string                       transaction_id;
+   std::map< uint32_t, std::string > call_results;              // Results of calls to other contracts, by entry point
+   bool                              batch_calls     = false;   // Serve get_objects/put_objects, which the chain does not
+};
+
+struct invocation_result
+{
+   int32_t                    code         = 0;       // Exit code
+   bool                       trapped      = false;
+   std::string                output;                 // Result object, or the error message
+   uint64_t                   instructions = 0;
+   uint64_t                   system_calls = 0;
+   uint64_t                   events       = 0;
+   std::vector< std::string > logs;
+
+   bool ok() const { return !trapped && code == 0; }
+};
+
+// Runs one invocation of a contract module: a fresh instance whose _start
+// export is called with the entry point and arguments, as the chain runs a
+// contract call. System calls are served from chain and from the store,
+// through the native host. Object writes land in the store only if the
+// invocation succeeds.
+//
+// Served: get_arguments, get_contract_id, get_caller, get_head_info,
+// get_chain_id, get_transaction_field ("id" only), check_authority, hash
+// (sha256 only), call (canned results), event, log, exit and the object
+// calls. Anything else, signature recovery included, returns an error to the
+// contract. WASI imports get minimal stubs.
+invocation_result invoke( const module& m, const chain_state& chain, native_host::sharded_store& store,
+   uint32_t entry_point, const std::string& arguments, uint64_t instruction_limit );
+
+} // koinos::wasm_meter
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace koinos::wasm_meter {
+
+// A malformed module, or one using a feature the interpreter lacks
+struct module_error : std::runtime_error
+{
+   using std::runtime_error::runtime_error;
+};
+
+enum class value_type : uint8_t
+{
+   i32       = 0x7f,
+   i64       = 0x7e,
+   f32       = 0x7d,
+   f64       = 0x7c,
+   funcref   = 0x70,
+   externref = 0x6f
+};
+
+struct func_type
+{
+   std::vector< value_type > params;
+   std::vector< value_type > results;
+
+   friend bool operator ==( const func_type& a, const func_type& b )
+   {
+      return a.params == b.params && a.results == b.results;
+   }
+};
+
+// Opcodes as they are encoded. Ops behind the 0xfc prefix are 0xfc00 plus
+// their index.
+enum op : uint16_t
+{
+   unreachable = 0x00, nop = 0x01, block = 0x02, loop = 0x03, if_ = 0x04, else_ = 0x05, end = 0x0b,
+   br = 0x0c, br_if = 0x0d, br_table = 0x0e, return_ = 0x0f, call = 0x10, call_indirect = 0x11,
+
+   drop = 0x1a, select = 0x1b, select_t = 0x1c,
+
+   local_get = 0x20, local_set = 0x21, local_tee = 0x22, global_get = 0x23, global_set = 0x24,
+
+   i32_load = 0x28, i64_load = 0x29, f32_load = 0x2a, f64_load = 0x2b,
+   i32_load8_s = 0x2c, i32_load8_u = 0x2d, i32_load16_s = 0x2e, i32_load16_u = 0x2f,
+   i64_load8_s = 0x30, i64_load8_u = 0x31, i64_load16_s = 0x32, i64_load16_u = 0x33, i64_load32_s = 0x34, i64_load32_u = 0x35,
+   i32_store = 0x36, i64_store = 0x37, f32_store = 0x38, f64_store = 0x39,
+   i32_store8 = 0x3a, i32_store16 = 0x3b, i64_store8 = 0x3c, i64_store16 = 0x3d, i64_store32 = 0x3e,
+   memory_size = 0x3f, memory_grow = 0x40,
+
+   i32_const = 0x41, i64_const = 0x42, f32_const = 0x43, f64_const = 0x44,
+
+   i32_eqz = 0x45, i32_eq = 0x46, i32_ne = 0x47, i32_lt_s = 0x48, i32_lt_u = 0x49, i32_gt_s = 0x4a, i32_gt_u = 0x4b,
+   i32_le_s = 0x4c, i32_le_u = 0x4d, i32_ge_s = 0x4e, i32_ge_u = 0x4f,
+   i64_eqz = 0x50, i64_eq = 0x51, i64_ne = 0x52, i64_lt_s = 0x53, i64_lt_u = 0x54, i64_gt_s = 0x55, i64_gt_u = 0x56,
+   i64_le_s = 0x57, i64_le_u = 0x58, i64_ge_s = 0x59, i64_ge_u = 0x5a,
+   f32_eq = 0x5b, f32_ne = 0x5c, f32_lt = 0x5d, f32_gt = 0x5e, f32_le = 0x5f, f32_ge = 0x60,
+   f64_eq = 0x61, f64_ne = 0x62, f64_lt = 0x63, f64_gt = 0x64, f64_le = 0x65, f64_ge = 0x66,
+
+   i32_clz = 0x67, i32_ctz = 0x68, i32_popcnt = 0x69, i32_add = 0x6a, i32_sub = 0x6b, i32_mul = 0x6c,
+   i32_div_s = 0x6d, i32_div_u = 0x6e, i32_rem_s = 0x6f, i32_rem_u = 0x70, i32_and = 0x71, i32_or = 0x72, i32_xor = 0x73,
+   i32_shl = 0x74, i32_shr_s = 0x75, i32_shr_u = 0x76, i32_rotl = 0x77, i32_rotr = 0x78,
+   i64_clz = 0x79, i64_ctz = 0x7a, i64_popcnt = 0x7b, i64_add = 0x7c, i64_sub = 0x7d, i64_mul = 0x7e,
+   i64_div_s = 0x7f, i64_div_u = 0x80, i64_rem_s = 0x81, i64_rem_u = 0x82, i64_and = 0x83, i64_or = 0x84, i64_xor = 0x85,
+   i64_shl = 0x86, i64_shr_s = 0x87, i64_shr_u = 0x88, i64_rotl = 0x89, i64_rotr = 0x8a,
+
+   f32_abs = 0x8b, f32_neg = 0x8c, f32_ceil = 0x8d, f32_floor = 0x8e, f32_trunc = 0x8f, f32_nearest = 0x90, f32_sqrt = 0x91,
+   f32_add = 0x92, f32_sub = 0x93, f32_mul = 0x94, f32_div = 0x95, f32_min = 0x96, f32_max = 0x97, f32_copysign = 0x98,
+   f64_abs = 0x99, f64_neg = 0x9a, f64_ceil = 0x9b, f64_floor = 0x9c, f64_trunc = 0x9d, f64_nearest = 0x9e, f64_sqrt = 0x9f,
+   f64_add = 0xa0, f64_sub = 0xa1, f64_mul = 0xa2, f64_div = 0xa3, f64_min = 0xa4, f64_max = 0xa5, f64_copysign = 0xa6,
+
+   i32_wrap_i64 = 0xa7, i32_trunc_f32_s = 0xa8, i32_trunc_f32_u = 0xa9, i32_trunc_f64_s = 0xaa, i32_trunc_f64_u = 0xab,
+   i64_extend_i32_s = 0xac, i64_extend_i32_u = 0xad,
+   i64_trunc_f32_s = 0xae, i64_trunc_f32_u = 0xaf, i64_trunc_f64_s = 0xb0, i64_trunc_f64_u = 0xb1,
+   f32_convert_i32_s = 0xb2, f32_convert_i32_u = 0xb3, f32_convert_i64_s = 0xb4, f32_convert_i64_u = 0xb5, f32_demote_f64 = 0xb6,
+   f64_convert_i32_s = 0xb7, f64_convert_i32_u = 0xb8, f64_convert_i64_s = 0xb9, f64_convert_i64_u = 0xba, f64_promote_f32 = 0xbb,
+   i32_reinterpret_f32 = 0xbc, i64_reinterpret_f64 = 0xbd, f32_reinterpret_i32 = 0xbe, f64_reinterpret_i64 = 0xbf,
+
+   i32_extend8_s = 0xc0, i32_extend16_s = 0xc1, i64_extend8_s = 0xc2, i64_extend16_s = 0xc3, i64_extend32_s = 0xc4,
+
+   ref_null = 0xd0, ref_is_null = 0xd1, ref_func = 0xd2,
+
+   i32_trunc_sat_f32_s = 0xfc00, i32_trunc_sat_f32_u = 0xfc01, i32_trunc_sat_f64_s = 0xfc02, i32_trunc_sat_f64_u = 0xfc03,
+   i64_trunc_sat_f32_s = 0xfc04, i64_trunc_sat_f32_u = 0xfc05, i64_trunc_sat_f64_s = 0xfc06, i64_trunc_sat_f64_u = 0xfc07,
+   memory_init = 0xfc08, data_drop = 0xfc09, memory_copy = 0xfc0a, memory_fill = 0xfc0b
+};
+
+// An instruction with its immediates decoded. Branch targets are resolved
+// to instruction indices at load time:
+//
+//    block, if   a = index of the matching end, b = params, c = results
+//    loop        b = params, c = results
+//    if          c also holds the index of the matching else above bit 32
+//    else        a = index of the matching end
+//    br, br_if   a = label depth
+//    br_table    a = first depth in the function's table pool, b = depths
+//                before the default
+//    call        a = function index
+//    call_indirect  a = type index, b = table index
+//    locals, globals, ref.func, memory.init, data.drop   a = index
+//    loads, stores   a = offset
+//    consts      c = the value's bits
+struct instruction
+{
+   uint16_t op = nop;
+   uint32_t a  = 0;
+   uint32_t b  = 0;
+   uint64_t c  = 0;
+};
+
+struct function
+{
+   uint32_t                   type   = 0;
+   uint32_t                   locals = 0;   // Declared locals, not counting params
+   std::vector< instruction > code;         // Ends with the body's end
+   std::vector< uint32_t >    br_tables;
+};
+
+// Only functions can be imported
+struct import
+{
+   std::string module;
+   std::string name;
+   uint32_t    type = 0;
+};
+
+enum class external_kind : uint8_t
+{
+   function = 0,
+   table    = 1,
+   memory   = 2,
+   global   = 3
+};
+
+struct export_entry
+{
+   std::string   name;
+   external_kind kind  = external_kind::function;
+   uint32_t      index = 0;
+};
+
+struct limits
+{
+   uint32_t                  min = 0;
+   std::optional< uint32_t > max;
+};
+
+struct global
+{
+   value_type type       = value_type::i32;
+   bool       is_mutable = false;
+   uint64_t   init       = 0;
+};
+
+// Active segments are copied in at instantiation. Passive segments are
+// kept for memory.init.
+struct data_segment
+{
+   bool                   active = true;
+   uint32_t               offset = 0;
+   std::vector< uint8_t > bytes;
+};
+
+struct element_segment
+{
+   bool                    active = true;
+   uint32_t                table  = 0;
+   uint32_t                offset = 0;
+   std::vector< uint64_t > refs;   // Function indices, null_ref for null
+};
+
+constexpr uint64_t null_ref = ~uint64_t( 0 );
+
+struct module
+{
+   std::vector< func_type >       types;
+   std::vector< import >          imports;
+   std::vector< function >        functions;   // Defined functions, indexed after the imports
+   std::vector< limits >          tables;
+   std::optional< limits >        memory;
+   std::vector< global >          globals;
+   std::vector< export_entry >    exports;
+   std::optional< uint32_t >      start;
+   std::vector< element_segment > elements;
+   std::vector< data_segment >    data;
+
+   std::size_t function_count() const { return imports.size() + functions.size(); }
+
+   const func_type& function_type( uint32_t index ) const;
+   const export_entry* find_export( const std::string& name, external_kind kind ) const;
+};
+
+// Decodes a binary module. Instructions are checked for the immediates and
+// indices they use, but the module is not type checked: it is expected to
+// come from a compiler.
+module decode_module( const uint8_t* data, std::size_t size );
+
+} // koinos::wasm_meter
@@ -0,0 +1,770 @@
+#include <koinos/wasm_meter/instance.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+namespace koinos::wasm_meter {
+
+namespace {
+
+// Values live on the stack as 64 bits: i32 zero extended, floats as their
+// bit patterns
+
+template< typename T >
+T as( uint64_t v )
+{
+   if constexpr ( std::is_same_v< T, float > )
+   {
+      auto b = uint32_t( v );
+      float f;
+      std::memcpy( &f, &b, sizeof( f ) );
+      return f;
+   }
+   else if constexpr ( std::is_same_v< T, double > )
+   {
+      double d;
+      std::memcpy( &d, &v, sizeof( d ) );
+      return d;
+   }
+   else
+   {
+      return T( v );
+   }
+}
+
+inline uint64_t bits( bool v )     { return v ? 1 : 0; }
+inline uint64_t bits( uint32_t v ) { return v; }
+inline uint64_t bits( int32_t v )  { return uint32_t( v ); }
+inline uint64_t bits( uint64_t v ) { return v; }
+inline uint64_t bits( int64_t v )  { return uint64_t( v ); }
+
+inline uint64_t bits( float v )
+{
+   uint32_t b;
+   std::memcpy( &b, &v, sizeof( b ) );
+   return b;
+}
+
+inline uint64_t bits( double v )
+{
+   uint64_t b;
+   std::memcpy( &b, &v, sizeof( b ) );
+   return b;
+}
+
+template< typename F >
+F wasm_min( F a, F b )
+{
+   if ( std::isnan( a ) || std::isnan( b ) )
+      return std::numeric_limits< F >::quiet_NaN();
+   if ( a == b )
+      return std::signbit( a ) ? a : b;
+   return a < b ? a : b;
+}
+
+template< typename F >
+F wasm_max( F a, F b )
+{
+   if ( std::isnan( a ) || std::isnan( b ) )
+      return std::numeric_limits< F >::quiet_NaN();
+   if ( a == b )
+      return std::signbit( a ) ? b : a;
+   return a > b ? a : b;
+}
+
+// Whether a truncated float is in range of the integer type
+template< typename I, typename F >
+bool fits( F t )
+{
+   const F upper = std::ldexp( F( 1 ), std::numeric_limits< I >::digits );
+   if constexpr ( std::is_signed_v< I > )
+      return t >= -upper && t < upper;
+   else
+      return t > F( -1 ) && t < upper;
+}
+
+template< typename I, typename F >
+I trunc_checked( F x )
+{
+   if ( std::isnan( x ) )
+      throw trap( "invalid conversion to integer" );
+
+   auto t = std::trunc( x );
+   if ( !fits< I >( t ) )
+      throw trap( "integer overflow" );
+   return I( t );
+}
+
+template< typename I, typename F >
+I trunc_saturated( F x )
+{
+   if ( std::isnan( x ) )
+      return 0;
+
+   auto t = std::trunc( x );
+   if ( fits< I >( t ) )
+      return I( t );
+   return t < 0 ? std::numeric_limits< I >::min() : std::numeric_limits< I >::max();
+}
+
+template< typename S >
+S div_s( S x, S y )
+{
+   if ( y == 0 )
+      throw trap( "integer divide by zero" );
+   if ( x == std::numeric_limits< S >::min() && y == -1 )
+      throw trap( "integer overflow" );
+   return S( x / y );
+}
+
+template< typename S >
+S rem_s( S x, S y )
+{
+   if ( y == 0 )
+      throw trap( "integer divide by zero" );
+   if ( y == -1 )
+      return 0;
+   return S( x % y );
+}
+
+template< typename U >
+U div_u( U x, U y )
+{
+   if ( y == 0 )
+      throw trap( "integer divide by zero" );
+   return x / y;
+}
+
+template< typename U >
+U rem_u( U x, U y )
+{
+   if ( y == 0 )
+      throw trap( "integer divide by zero" );
+   return x % y;
+}
+
+template< typename U >
+U rotl( U x, U y )
+{
+   constexpr U width = sizeof( U ) * 8;
+   y &= width - 1;
+   return y ? U( ( x << y ) | ( x >> ( width - y ) ) ) : x;
+}
+
+template< typename U >
+U rotr( U x, U y )
+{
+   constexpr U width = sizeof( U ) * 8;
+   y &= width - 1;
+   return y ? U( ( x >> y ) | ( x << ( width - y ) ) ) : x;
+}
+
+struct label
+{
+   uint32_t    pc;      // Where a branch to the label continues
+   std::size_t height;  // Stack height below the block's params
+   uint32_t    arity;   // Values a branch carries: results, or params for a loop
+   bool        loop;
+};
+
+// A suspended caller
+struct frame
+{
+   const function* fn;
+   uint32_t        pc;
+   std::size_t     locals;
+   std::size_t     labels;
+};
+
+} // anonymous
+
+instance::instance( const module& m, const import_resolver& resolve ) : _module( m )
+{
+   for ( const auto& imp : m.imports )
+   {
+      auto fn = resolve( imp, m.types[ imp.type ] );
+      if ( !fn )
+         throw module_error( "unresolved import " + imp.module + "." + imp.name );
+      _imports.push_back( std::move( fn ) );
+   }
+
+   if ( m.memory )
+   {
+      _memory.assign( std::size_t( m.memory->min ) * page_size, 0 );
+      _max_pages = m.memory->max ? *m.memory->max : page_size;
+   }
+
+   for ( const auto& g : m.globals )
+      _globals.push_back( g.init );
+
+   for ( const auto& t : m.tables )
+      _tables.emplace_back( t.min, null_ref );
+
+   for ( const auto& e : m.elements )
+   {
+      if ( !e.active )
+         continue;
+
+      auto& table = _tables[ e.table ];
+      if ( uint64_t( e.offset ) + e.refs.size() > table.size() )
+         throw trap( "element segment does not fit its table" );
+      std::copy( e.refs.begin(), e.refs.end(), table.begin() + e.offset );
+   }
+
+   for ( const auto& d : m.data )
+   {
+      _dropped.push_back( d.active );
+      if ( !d.active )
+         continue;
+
+      if ( uint64_t( d.offset ) + d.bytes.size() > _memory.size() )
+         throw trap( "data segment does not fit in memory" );
+      std::copy( d.bytes.begin(), d.bytes.end(), _memory.begin() + d.offset );
+   }
+}
+
+void instance::start()
+{
+   if ( _module.start )
+   {
+      _stack.clear();
+      run( *_module.start );
+   }
+}
+
+std::vector< uint64_t > instance::call( const std::string& name, const std::vector< uint64_t >& args )
+{
+   auto e = _module.find_export( name, external_kind::function );
+   if ( !e )
+      throw module_error( "no exported function " + name );
+
+   const auto& type = _module.function_type( e->index );
+   if ( args.size() != type.params.size() )
+      throw module_error( "wrong number of arguments to " + name );
+
+   _stack.assign( args.begin(), args.end() );
+   run( e->index );
+   return std::vector< uint64_t >( _stack.end() - type.results.size(), _stack.end() );
+}
+
+uint8_t* instance::memory( uint32_t address, uint32_t size )
+{
+   if ( uint64_t( address ) + size > _memory.size() )
+      throw trap( "out of bounds memory access" );
+   return _memory.data() + address;
+}
+
+void instance::call_host( uint32_t index )
+{
+   const auto& type = _module.function_type( index );
+   std::vector< uint64_t > args( _stack.end() - type.params.size(), _stack.end() );
+   std::vector< uint64_t > results( type.results.size() );
+   _stack.resize( _stack.size() - args.size() );
+
+   _imports[ index ]( *this, args.data(), results.data() );
+   _stack.insert( _stack.end(), results.begin(), results.end() );
+}
+
+template< typename T, typename F >
+void instance::unary( F f )
+{
+   _stack.back() = bits( f( as< T >( _stack.back() ) ) );
+}
+
+template< typename T, typename F >
+void instance::binary( F f )
+{
+   auto y = as< T >( pop() );
+   _stack.back() = bits( f( as< T >( _stack.back() ), y ) );
+}
+
+template< typename T >
+T instance::load( uint32_t offset )
+{
+   auto address = uint64_t( uint32_t( _stack.back() ) ) + offset;
+   if ( address + sizeof( T ) > _memory.size() )
+      throw trap( "out of bounds memory access" );
+
+   T v;
+   std::memcpy( &v, _memory.data() + address, sizeof( T ) );
+   return v;
+}
+
+template< typename T >
+void instance::store( uint32_t offset )
+{
+   auto v = T( pop() );
+   auto address = uint64_t( uint32_t( pop() ) ) + offset;
+   if ( address + sizeof( T ) > _memory.size() )
+      throw trap( "out of bounds memory access" );
+
+   std::memcpy( _memory.data() + address, &v, sizeof( T ) );
+}
+
+void instance::run( uint32_t index )
+{
+   if ( index < _imports.size() )
+   {
+      call_host( index );
+      return;
+   }
+
+   std::vector< frame > frames;
+   std::vector< label > labels;
+
+   const function*    fn;
+   const instruction* code;
+   uint32_t           pc;
+   std::size_t        locals;
+   std::size_t        label_base = 0;
+
+   auto enter = [&]( uint32_t callee )
+   {
+      fn     = &_module.functions[ callee - _imports.size() ];
+      locals = _stack.size() - _module.types[ fn->type ].params.size();
+      _stack.resize( _stack.size() + fn->locals, 0 );
+      code   = fn->code.data();
+      pc     = 0;
+   };
+
+   // Returns true when the outermost function returns
+   auto leave = [&]()
+   {
+      auto arity = _module.types[ fn->type ].results.size();
+      std::copy( _stack.end() - arity, _stack.end(), _stack.begin() + locals );
+      _stack.resize( locals + arity );
+      labels.resize( label_base );
+
+      if ( frames.empty() )
+         return true;
+
+      const auto& f = frames.back();
+      fn         = f.fn;
+      code       = fn->code.data();
+      pc         = f.pc;
+      locals     = f.locals;
+      label_base = f.labels;
+      frames.pop_back();
+      return false;
+   };
+
+   auto branch = [&]( std::size_t depth )
+   {
+      if ( depth == labels.size() - label_base )
+         return leave();
+
+      auto target = labels.size() - 1 - depth;
+      const auto l = labels[ target ];
+      std::copy( _stack.end() - l.arity, _stack.end(), _stack.begin() + l.height );
+      _stack.resize( l.height + l.arity );
+      labels.resize( l.loop ? target + 1 : target );
+      pc = l.pc;
+      return false;
+   };
+
+   auto invoke = [&]( uint32_t callee )
+   {
+      if ( callee < _imports.size() )
+      {
+         call_host( callee );
+         return;
+      }
+
+      if ( frames.size() >= max_call_depth )
+         throw trap( "call stack exhausted" );
+
+      frames.push_back( frame{ fn, pc, locals, label_base } );
+      label_base = labels.size();
+      enter( callee );
+   };
+
+   enter( index );
+
+   for ( ;; )
+   {
+      const auto& in = code[ pc++ ];
+      if ( ++_instructions > _limit )
+         throw trap( "instruction limit exceeded" );
+
+      switch ( in.op )
+      {
+         case unreachable:
+            throw trap( "unreachable executed" );
+
+         case nop:
+            break;
+
+         case block:
+            labels.push_back( label{ in.a + 1, _stack.size() - in.b, uint32_t( in.c ), false } );
+            break;
+
+         case loop:
+            labels.push_back( label{ pc, _stack.size() - in.b, in.b, true } );
+            break;
+
+         case if_:
+         {
+            auto condition = uint32_t( pop() );
+            labels.push_back( label{ in.a + 1, _stack.size() - in.b, uint32_t( in.c ), false } );
+            if ( !condition )
+            {
+               auto else_index = uint32_t( in.c >> 32 );
+               pc = else_index ? else_index + 1 : in.a;
+            }
+            break;
+         }
+
+         case else_:
+            // The then branch is done, continue at the end
+            pc = in.a;
+            break;
+
+         case end:
+            if ( pc == fn->code.size() )
+            {
+               if ( leave() )
+                  return;
+            }
+            else
+            {
+               labels.pop_back();
+            }
+            break;
+
+         case br:
+            if ( branch( in.a ) )
+               return;
+            break;
+
+         case br_if:
+            if ( uint32_t( pop() ) && branch( in.a ) )
+               return;
+            break;
+
+         case br_table:
+         {
+            auto i = uint32_t( pop() );
+            if ( branch( fn->br_tables[ in.a + std::min( i, in.b ) ] ) )
+               return;
+            break;
+         }
+
+         case return_:
+            if ( leave() )
+               return;
+            break;
+
+         case op::call:
+            invoke( in.a );
+            break;
+
+         case call_indirect:
+         {
+            auto i = uint32_t( pop() );
+            const auto& table = _tables[ in.b ];
+            if ( i >= table.size() )
+               throw trap( "undefined table element" );
+            if ( table[ i ] == null_ref )
+               throw trap( "uninitialized table element" );
+            if ( !( _module.function_type( uint32_t( table[ i ] ) ) == _module.types[ in.a ] ) )
+               throw trap( "indirect call type mismatch" );
+            invoke( uint32_t( table[ i ] ) );
+            break;
+         }
+
+         case drop:
+            _stack.pop_back();
+            break;
+
+         case select:
+         {
+            auto condition = uint32_t( pop() );
+            auto b = pop();
+            if ( !condition )
+               _stack.back() = b;
+            break;
+         }
+
+         case local_get:
+            push( _stack[ locals + in.a ] );
+            break;
+
+         case local_set:
+            _stack[ locals + in.a ] = pop();
+            break;
+
+         case local_tee:
+            _stack[ locals + in.a ] = _stack.back();
+            break;
+
+         case global_get:
+            push( _globals[ in.a ] );
+            break;
+
+         case global_set:
+            _globals[ in.a ] = pop();
+            break;
+
+         case i32_load:     _stack.back() = bits( load< uint32_t >( in.a ) ); break;
+         case i64_load:     _stack.back() = bits( load< uint64_t >( in.a ) ); break;
+         case f32_load:     _stack.back() = bits( load< uint32_t >( in.a ) ); break;
+         case f64_load:     _stack.back() = bits( load< uint64_t >( in.a ) ); break;
+         case i32_load8_s:  _stack.back() = bits( int32_t( load< int8_t >( in.a ) ) ); break;
+         case i32_load8_u:  _stack.back() = bits( uint32_t( load< uint8_t >( in.a ) ) ); break;
+         case i32_load16_s: _stack.back() = bits( int32_t( load< int16_t >( in.a ) ) ); break;
+         case i32_load16_u: _stack.back() = bits( uint32_t( load< uint16_t >( in.a ) ) ); break;
+         case i64_load8_s:  _stack.back() = bits( int64_t( load< int8_t >( in.a ) ) ); break;
+         case i64_load8_u:  _stack.back() = bits( uint64_t( load< uint8_t >( in.a ) ) ); break;
+         case i64_load16_s: _stack.back() = bits( int64_t( load< int16_t >( in.a ) ) ); break;
+         case i64_load16_u: _stack.back() = bits( uint64_t( load< uint16_t >( in.a ) ) ); break;
+         case i64_load32_s: _stack.back() = bits( int64_t( load< int32_t >( in.a ) ) ); break;
+         case i64_load32_u: _stack.back() = bits( uint64_t( load< uint32_t >( in.a ) ) ); break;
+
+         case i32_store:    store< uint32_t >( in.a ); break;
+         case i64_store:    store< uint64_t >( in.a ); break;
+         case f32_store:    store< uint32_t >( in.a ); break;
+         case f64_store:    store< uint64_t >( in.a ); break;
+         case i32_store8:   store< uint8_t >( in.a ); break;
+         case i32_store16:  store< uint16_t >( in.a ); break;
+         case i64_store8:   store< uint8_t >( in.a ); break;
+         case i64_store16:  store< uint16_t >( in.a ); break;
+         case i64_store32:  store< uint32_t >( in.a ); break;
+
+         case op::memory_size:
+            push( uint32_t( _memory.size() / page_size ) );
+            break;
+
+         case memory_grow:
+         {
+            auto delta = uint64_t( uint32_t( _stack.back() ) );
+            auto pages = uint64_t( _memory.size() / page_size );
+            if ( pages + delta > _max_pages )
+            {
+               _stack.back() = bits( int32_t( -1 ) );
+            }
+            else
+            {
+               _memory.resize( std::size_t( pages + delta ) * page_size, 0 );
+               _stack.back() = pages;
+            }
+            break;
+         }
+
+         case i32_const:
+         case i64_const:
+         case f32_const:
+         case f64_const:
+            push( in.c );
+            break;
+
+         case i32_eqz:  unary< uint32_t >( []( uint32_t x ) { return x == 0; } ); break;
+         case i32_eq:   binary< uint32_t >( []( uint32_t x, uint32_t y ) { return x == y; } ); break;
+         case i32_ne:   binary< uint32_t >( []( uint32_t x, uint32_t y ) { return x != y; } ); break;
+         case i32_lt_s: binary< int32_t >( []( int32_t x, int32_t y ) { return x < y; } ); break;
+         case i32_lt_u: binary< uint32_t >( []( uint32_t x, uint32_t y ) { return x < y; } ); break;
+         case i32_gt_s: binary< int32_t >( []( int32_t x, int32_t y ) { return x > y; } ); break;
+         case i32_gt_u: binary< uint32_t >( []( uint32_t x, uint32_t y ) { return x > y; } ); break;
+         case i32_le_s: binary< int32_t >( []( int32_t x, int32_t y ) { return x <= y; } ); break;
+         case i32_le_u: binary< uint32_t >( []( uint32_t x, uint32_t y ) { return x <= y; } ); break;
+         case i32_ge_s: binary< int32_t >( []( int32_t x, int32_t y ) { return x >= y; } ); break;
+         case i32_ge_u: binary< uint32_t >( []( uint32_t x, uint32_t y ) { return x >= y; } ); break;
+
+         case i64_eqz:  unary< uint64_t >( []( uint64_t x ) { return x == 0; } ); break;
+         case i64_eq:   binary< uint64_t >( []( uint64_t x, uint64_t y ) { return x == y; } ); break;
+         case i64_ne:   binary< uint64_t >( []( uint64_t x, uint64_t y ) { return x != y; } ); break;
+         case i64_lt_s: binary< int64_t >( []( int64_t x, int64_t y ) { return x < y; } ); break;
+         case i64_lt_u: binary< uint64_t >( []( uint64_t x, uint64_t y ) { return x < y; } ); break;
+         case i64_gt_s: binary< int64_t >( []( int64_t x, int64_t y ) { return x > y; } ); break;
+         case i64_gt_u: binary< uint64_t >( []( uint64_t x, uint64_t y ) { return x > y; } ); break;
+         case i64_le_s: binary< int64_t >( []( int64_t x, int64_t y ) { return x <= y; } ); break;
+         case i64_le_u: binary< uint64_t >( []( uint64_t x, uint64_t y ) { return x <= y; } ); break;
+         case i64_ge_s: binary< int64_t >( []( int64_t x, int64_t y ) { return x >= y; } ); break;
+         case i64_ge_u: binary< uint64_t >( []( uint64_t x, uint64_t y ) { return x >= y; } ); break;
+
+         case f32_eq: binary< float >( []( float x, float y ) { return x == y; } ); break;
+         case f32_ne: binary< float >( []( float x, float y ) { return x != y; } ); break;
+         case f32_lt: binary< float >( []( float x, float y ) { return x < y; } ); break;
+         case f32_gt: binary< float >( []( float x, float y ) { return x > y; } ); break;
+         case f32_le: binary< float >( []( float x, float y ) { return x <= y; } ); break;
+         case f32_ge: binary< float >( []( float x, float y ) { return x >= y; } ); break;
+
+         case f64_eq: binary< double >( []( double x, double y ) { return x == y; } ); break;
+         case f64_ne: binary< double >( []( double x, double y ) { return x != y; } ); break;
+         case f64_lt: binary< double >( []( double x, double y ) { return x < y; } ); break;
+         case f64_gt: binary< double >( []( double x, double y ) { return x > y; } ); break;
+         case f64_le: binary< double >( []( double x, double y ) { return x <= y; } ); break;
+         case f64_ge: binary< double >( []( double x, double y ) { return x >= y; } ); break;
+
+         case i32_clz:    unary< uint32_t >( []( uint32_t x ) { return uint32_t( x ? __builtin_clz( x ) : 32 ); } ); break;
+         case i32_ctz:    unary< uint32_t >( []( uint32_t x ) { return uint32_t( x ? __builtin_ctz( x ) : 32 ); } ); break;
+         case i32_popcnt: unary< uint32_t >( []( uint32_t x ) { return uint32_t( __builtin_popcount( x ) ); } ); break;
+         case i32_add:    binary< uint32_t >( []( uint32_t x, uint32_t y ) { return uint32_t( x + y ); } ); break;
+         case i32_sub:    binary< uint32_t >( []( uint32_t x, uint32_t y ) { return uint32_t( x - y ); } ); break;
+         case i32_mul:    binary< uint32_t >( []( uint32_t x, uint32_t y ) { return uint32_t( x * y ); } ); break;
+         case i32_div_s:  binary< int32_t >( div_s< int32_t > ); break;
+         case i32_div_u:  binary< uint32_t >( div_u< uint32_t > ); break;
+         case i32_rem_s:  binary< int32_t >( rem_s< int32_t > ); break;
+         case i32_rem_u:  binary< uint32_t >( rem_u< uint32_t > ); break;
+         case i32_and:    binary< uint32_t >( []( uint32_t x, uint32_t y ) { return x & y; } ); break;
+         case i32_or:     binary< uint32_t >( []( uint32_t x, uint32_t y ) { return x | y; } ); break;
+         case i32_xor:    binary< uint32_t >( []( uint32_t x, uint32_t y ) { return x ^ y; } ); break;
+         case i32_shl:    binary< uint32_t >( []( uint32_t x, uint32_t y ) { return uint32_t( x << ( y & 31 ) ); } ); break;
+         case i32_shr_s:  binary< int32_t >( []( int32_t x, int32_t y ) { return int32_t( x >> ( y & 31 ) ); } ); break;
+         case i32_shr_u:  binary< uint32_t >( []( uint32_t x, uint32_t y ) { return x >> ( y & 31 ); } ); break;
+         case i32_rotl:   binary< uint32_t >( rotl< uint32_t > ); break;
+         case i32_rotr:   binary< uint32_t >( rotr< uint32_t > ); break;
+
+         case i64_clz:    unary< uint64_t >( []( uint64_t x ) { return uint64_t( x ? __builtin_clzll( x ) : 64 ); } ); break;
+         case i64_ctz:    unary< uint64_t >( []( uint64_t x ) { return uint64_t( x ? __builtin_ctzll( x ) : 64 ); } ); break;
+         case i64_popcnt: unary< uint64_t >( []( uint64_t x ) { return uint64_t( __builtin_popcountll( x ) ); } ); break;
+         case i64_add:    binary< uint64_t >( []( uint64_t x, uint64_t y ) { return x + y; } ); break;
+         case i64_sub:    binary< uint64_t >( []( uint64_t x, uint64_t y ) { return x - y; } ); break;
+         case i64_mul:    binary< uint64_t >( []( uint64_t x, uint64_t y ) { return x * y; } ); break;
+         case i64_div_s:  binary< int64_t >( div_s< int64_t > ); break;
+         case i64_div_u:  binary< uint64_t >( div_u< uint64_t > ); break;
+         case i64_rem_s:  binary< int64_t >( rem_s< int64_t > ); break;
+         case i64_rem_u:  binary< uint64_t >( rem_u< uint64_t > ); break;
+         case i64_and:    binary< uint64_t >( []( uint64_t x, uint64_t y ) { return x & y; } ); break;
+         case i64_or:     binary< uint64_t >( []( uint64_t x, uint64_t y ) { return x | y; } ); break;
+         case i64_xor:    binary< uint64_t >( []( uint64_t x, uint64_t y ) { return x ^ y; } ); break;
+         case i64_shl:    binary< uint64_t >( []( uint64_t x, uint64_t y ) { return x << ( y & 63 ); } ); break;
+         case i64_shr_s:  binary< int64_t >( []( int64_t x, int64_t y ) { return int64_t( x >> ( y & 63 ) ); } ); break;
+         case i64_shr_u:  binary< uint64_t >( []( uint64_t x, uint64_t y ) { return x >> ( y & 63 ); } ); break;
+         case i64_rotl:   binary< uint64_t >( rotl< uint64_t > ); break;
+         case i64_rotr:   binary< uint64_t >( rotr< uint64_t > ); break;
+
+         // Sign operations work on the bits, keeping NaN payloads
+         case f32_abs:      _stack.back() &= 0x7fffffffull; break;
+         case f32_neg:      _stack.back() ^= 0x80000000ull; break;
+         case f32_ceil:     unary< float >( []( float x ) { return std::ceil( x ); } ); break;
+         case f32_floor:    unary< float >( []( float x ) { return std::floor( x ); } ); break;
+         case f32_trunc:    unary< float >( []( float x ) { return std::trunc( x ); } ); break;
+         case f32_nearest:  unary< float >( []( float x ) { return std::nearbyint( x ); } ); break;
+         case f32_sqrt:     unary< float >( []( float x ) { return std::sqrt( x ); } ); break;
+         case f32_add:      binary< float >( []( float x, float y ) { return x + y; } ); break;
+         case f32_sub:      binary< float >( []( float x, float y ) { return x - y; } ); break;
+         case f32_mul:      binary< float >( []( float x, float y ) { return x * y; } ); break;
+         case f32_div:      binary< float >( []( float x, float y ) { return x / y; } ); break;
+         case f32_min:      binary< float >( wasm_min< float > ); break;
+         case f32_max:      binary< float >( wasm_max< float > ); break;
+         case f32_copysign: binary< uint32_t >( []( uint32_t x, uint32_t y ) { return ( x & 0x7fffffffu ) | ( y & 0x80000000u ); } ); break;
+
+         case f64_abs:      _stack.back() &= 0x7fffffffffffffffull; break;
+         case f64_neg:      _stack.back() ^= 0x8000000000000000ull; break;
+         case f64_ceil:     unary< double >( []( double x ) { return std::ceil( x ); } ); break;
+         case f64_floor:    unary< double >( []( double x ) { return std::floor( x ); } ); break;
+         case f64_trunc:    unary< double >( []( double x ) { return std::trunc( x ); } ); break;
+         case f64_nearest:  unary< double >( []( double x ) { return std::nearbyint( x ); } ); break;
+         case f64_sqrt:     unary< double >( []( double x ) { return std::sqrt( x ); } ); break;
+         case f64_add:      binary< double >( []( double x, double y ) { return x + y; } ); break;
+         case f64_sub:      binary< double >( []( double x, double y ) { return x - y; } ); break;
+         case f64_mul:      binary< double >( []( double x, double y ) { return x * y; } ); break;
+         case f64_div:      binary< double >( []( double x, double y ) { return x / y; } ); break;
+         case f64_min:      binary< double >( wasm_min< double > ); break;
+         case f64_max:      binary< double >( wasm_max< double > ); break;
+         case f64_copysign: binary< uint64_t >( []( uint64_t x, uint64_t y ) { return uint64_t( ( x & 0x7fffffffffffffffull ) | ( y & 0x8000000000000000ull ) ); } ); break;
+
+         case i32_wrap_i64:      unary< uint64_t >( []( uint64_t x ) { return uint32_t( x ); } ); break;
+         case i32_trunc_f32_s:   unary< float >( trunc_checked< int32_t, float > ); break;
+         case i32_trunc_f32_u:   unary< float >( trunc_checked< uint32_t, float > ); break;
+         case i32_trunc_f64_s:   unary< double >( trunc_checked< int32_t, double > ); break;
+         case i32_trunc_f64_u:   unary< double >( trunc_checked< uint32_t, double > ); break;
+         case i64_extend_i32_s:  unary< int32_t >( []( int32_t x ) { return int64_t( x ); } ); break;
+         case i64_extend_i32_u:  unary< uint32_t >( []( uint32_t x ) { return uint64_t( x ); } ); break;
+         case i64_trunc_f32_s:   unary< float >( trunc_checked< int64_t, float > ); break;
+         case i64_trunc_f32_u:   unary< float >( trunc_checked< uint64_t, float > ); break;
+         case i64_trunc_f64_s:   unary< double >( trunc_checked< int64_t, double > ); break;
+         case i64_trunc_f64_u:   unary< double >( trunc_checked< uint64_t, double > ); break;
+         case f32_convert_i32_s: unary< int32_t >( []( int32_t x ) { return float( x ); } ); break;
+         case f32_convert_i32_u: unary< uint32_t >( []( uint32_t x ) { return float( x ); } ); break;
+         case f32_convert_i64_s: unary< int64_t >( []( int64_t x ) { return float( x ); } ); break;
+         case f32_convert_i64_u: unary< uint64_t >( []( uint64_t x ) { return float( x ); } ); break;
+         case f32_demote_f64:    unary< double >( []( double x ) { return float( x ); } ); break;
+         case f64_convert_i32_s: unary< int32_t >( []( int32_t x ) { return double( x ); } ); break;
+         case f64_convert_i32_u: unary< uint32_t >( []( uint32_t x ) { return double( x ); } ); break;
+         case f64_convert_i64_s: unary< int64_t >( []( int64_t x ) { return double( x ); } ); break;
+         case f64_convert_i64_u: unary< uint64_t >( []( uint64_t x ) { return double( x ); } ); break;
+         case f64_promote_f32:   unary< float >( []( float x ) { return double( x ); } ); break;
+
+         // The stack already holds floats as their bits
+         case i32_reinterpret_f32:
+         case i64_reinterpret_f64:
+         case f32_reinterpret_i32:
+         case f64_reinterpret_i64:
+            break;
+
+         case i32_extend8_s:  unary< uint32_t >( []( uint32_t x ) { return int32_t( int8_t( x ) ); } ); break;
+         case i32_extend16_s: unary< uint32_t >( []( uint32_t x ) { return int32_t( int16_t( x ) ); } ); break;
+         case i64_extend8_s:  unary< uint64_t >( []( uint64_t x ) { return int64_t( int8_t( x ) ); } ); break;
+         case i64_extend16_s: unary< uint64_t >( []( uint64_t x ) { return int64_t( int16_t( x ) ); } ); break;
+         case i64_extend32_s: unary< uint64_t >( []( uint64_t x ) { return int64_t( int32_t( x ) ); } ); break;
+
+         case ref_null:
+            push( null_ref );
+            break;
+
+         case ref_is_null:
+            _stack.back() = bits( _stack.back() == null_ref );
+            break;
+
+         case ref_func:
+            push( in.a );
+            break;
+
+         case i32_trunc_sat_f32_s: unary< float >( trunc_saturated< int32_t, float > ); break;
+         case i32_trunc_sat_f32_u: unary< float >( trunc_saturated< uint32_t, float > ); break;
+         case i32_trunc_sat_f64_s: unary< double >( trunc_saturated< int32_t, double > ); break;
+         case i32_trunc_sat_f64_u: unary< double >( trunc_saturated< uint32_t, double > ); break;
+         case i64_trunc_sat_f32_s: unary< float >( trunc_saturated< int64_t, float > ); break;
+         case i64_trunc_sat_f32_u: unary< float >( trunc_saturated< uint64_t, float > ); break;
+         case i64_trunc_sat_f64_s: unary< double >( trunc_saturated< int64_t, double > ); break;
+         case i64_trunc_sat_f64_u: unary< double >( trunc_saturated< uint64_t, double > ); break;
+
+         case memory_init:
+         {
+            auto n = uint64_t( uint32_t( pop() ) );
+            auto s = uint64_t( uint32_t( pop() ) );
+            auto d = uint64_t( uint32_t( pop() ) );
+            const auto& segment = _module.data[ in.a ].bytes;
+            auto available = _dropped[ in.a ] ? 0 : segment.size();
+            if ( s + n > available || d + n > _memory.size() )
+               throw trap( "out of bounds memory access" );
+            std::copy_n( segment.begin() + s, n, _memory.begin() + d );
+            break;
+         }
+
+         case data_drop:
+            _dropped[ in.a ] = true;
+            break;
+
+         case memory_copy:
+         {
+            auto n = uint64_t( uint32_t( pop() ) );
+            auto s = uint64_t( uint32_t( pop() ) );
+            auto d = uint64_t( uint32_t( pop() ) );
+            if ( s + n > _memory.size() || d + n > _memory.size() )
+               throw trap( "out of bounds memory access" );
+            std::memmove( _memory.data() + d, _memory.data() + s, n );
+            break;
+         }
+
+         case memory_fill:
+         {
+            auto n = uint64_t( uint32_t( pop() ) );
+            auto v = uint8_t( pop() );
+            auto d = uint64_t( uint32_t( pop() ) );
+            if ( d + n > _memory.size() )
+               throw trap( "out of bounds memory access" );
+            std::memset( _memory.data() + d, v, n );
+            break;
+         }
+
+         default:
+            throw trap( "unsupported instruction" );
+      }
+   }
+}
+
+} // koinos::wasm_meter
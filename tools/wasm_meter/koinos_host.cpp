@@ -0,0 +1,373 @@
+#include <koinos/wasm_meter/host_results.hpp>
+#include <koinos/wasm_meter/koinos_host.hpp>
+#include <koinos/wasm_meter/instance.hpp>
+
+#include <koinos/native_host/host.hpp>
+#include <koinos/system/system_calls.hpp>
+#include <koinos/system_contracts/wire.hpp>
+#include <koinos/tools/sha256.hpp>
+
+#include <cstring>
+#include <type_traits>
+
+namespace koinos::wasm_meter {
+
+namespace {
+
+namespace wire = koinos::system_contracts::wire;
+
+constexpr uint64_t sha256_id  = 0x12;
+constexpr int32_t  wasi_ebadf = 8;
+
+// Thrown by the exit system call and by proc_exit to end the invocation
+struct exit_signal
+{
+   int32_t     code;
+   std::string output;
+};
+
+constexpr uint32_t id( chain::system_call_id sid )
+{
+   return std::underlying_type_t< chain::system_call_id >( sid );
+}
+
+uint32_t load_u32( instance& inst, uint32_t address )
+{
+   uint32_t v;
+   std::memcpy( &v, inst.memory( address, sizeof( v ) ), sizeof( v ) );
+   return v;
+}
+
+void store_u32( instance& inst, uint32_t address, uint32_t v )
+{
+   std::memcpy( inst.memory( address, sizeof( v ) ), &v, sizeof( v ) );
+}
+
+void store_u64( instance& inst, uint32_t address, uint64_t v )
+{
+   std::memcpy( inst.memory( address, sizeof( v ) ), &v, sizeof( v ) );
+}
+
+// Reads the fields a system call needs from its arguments. Fields not asked
+// for are skipped.
+class fields
+{
+public:
+   fields( const std::string& message )
+   {
+      wire::reader rdr( reinterpret_cast< const uint8_t* >( message.data() ), message.size() );
+      while ( !rdr.eof() )
+      {
+         uint32_t field;
+         wire::wire_type type;
+         if ( !rdr.read_tag( field, type ) )
+         {
+            _ok = false;
+            return;
+         }
+
+         if ( type == wire::wire_type::varint )
+         {
+            uint64_t v = 0;
+            _ok = _ok && rdr.read_varint( v );
+            _varints[ field ] = v;
+         }
+         else if ( type == wire::wire_type::length_delimited )
+         {
+            std::string v;
+            _ok = _ok && rdr.read_bytes( v );
+            _bytes[ field ] = std::move( v );
+         }
+         else
+         {
+            _ok = _ok && rdr.skip( type );
+         }
+
+         if ( !_ok )
+            return;
+      }
+   }
+
+   bool ok() const { return _ok; }
+
+   uint64_t varint( uint32_t field ) const
+   {
+      auto it = _varints.find( field );
+      return it == _varints.end() ? 0 : it->second;
+   }
+
+   std::string bytes( uint32_t field ) const
+   {
+      auto it = _bytes.find( field );
+      return it == _bytes.end() ? std::string() : it->second;
+   }
+
+private:
+   bool                              _ok = true;
+   std::map< uint32_t, uint64_t >    _varints;
+   std::map< uint32_t, std::string > _bytes;
+};
+
+class session
+{
+public:
+   session( const chain_state& chain, uint32_t entry_point, const std::string& arguments, invocation_result& result ) :
+      _chain( chain ), _entry_point( entry_point ), _arguments( arguments ), _result( result )
+   {}
+
+   host_function resolve( const import& imp, const func_type& type )
+   {
+      auto shape = [&]( std::size_t params, std::size_t results )
+      {
+         return type.params.size() == params && type.results.size() == results;
+      };
+
+      if ( imp.module == "env" && ( imp.name == "invoke_system_call" || imp.name == "invoke_thunk" ) && shape( 6, 1 ) )
+      {
+         return [this]( instance& inst, const uint64_t* a, uint64_t* r )
+         {
+            r[0] = uint32_t( system_call( inst, uint32_t( a[0] ), uint32_t( a[1] ), uint32_t( a[2] ), uint32_t( a[3] ), uint32_t( a[4] ), uint32_t( a[5] ) ) );
+         };
+      }
+
+      if ( imp.module == "wasi_snapshot_preview1" )
+         return wasi( imp.name, shape );
+
+      return {};
+   }
+
+private:
+   template< typename Shape >
+   host_function wasi( const std::string& name, Shape shape )
+   {
+      if ( name == "proc_exit" && shape( 1, 0 ) )
+      {
+         return []( instance&, const uint64_t* a, uint64_t* )
+         {
+            throw exit_signal{ int32_t( a[0] ), std::string() };
+         };
+      }
+
+      if ( name == "fd_write" && shape( 4, 1 ) )
+      {
+         return [this]( instance& inst, const uint64_t* a, uint64_t* r )
+         {
+            uint32_t total = 0;
+            std::string text;
+            for ( uint32_t i = 0; i < uint32_t( a[2] ); i++ )
+            {
+               auto iov = uint32_t( a[1] ) + 8 * i;
+               auto len = load_u32( inst, iov + 4 );
+               text.append( reinterpret_cast< const char* >( inst.memory( load_u32( inst, iov ), len ) ), len );
+               total += len;
+            }
+            _result.logs.push_back( std::move( text ) );
+            store_u32( inst, uint32_t( a[3] ), total );
+            r[0] = 0;
+         };
+      }
+
+      if ( ( name == "args_sizes_get" || name == "environ_sizes_get" ) && shape( 2, 1 ) )
+      {
+         return []( instance& inst, const uint64_t* a, uint64_t* r )
+         {
+            store_u32( inst, uint32_t( a[0] ), 0 );
+            store_u32( inst, uint32_t( a[1] ), 0 );
+            r[0] = 0;
+         };
+      }
+
+      if ( ( name == "args_get" || name == "environ_get" ) && shape( 2, 1 ) )
+         return []( instance&, const uint64_t*, uint64_t* r ) { r[0] = 0; };
+
+      if ( name == "clock_time_get" && shape( 3, 1 ) )
+      {
+         return []( instance& inst, const uint64_t* a, uint64_t* r )
+         {
+            store_u64( inst, uint32_t( a[2] ), 0 );
+            r[0] = 0;
+         };
+      }
+
+      if ( name == "random_get" && shape( 2, 1 ) )
+      {
+         return []( instance& inst, const uint64_t* a, uint64_t* r )
+         {
+            std::memset( inst.memory( uint32_t( a[0] ), uint32_t( a[1] ) ), 0, uint32_t( a[1] ) );
+            r[0] = 0;
+         };
+      }
+
+      // Files and anything else the libc may link in
+      return []( instance&, const uint64_t*, uint64_t* r ) { r[0] = wasi_ebadf; };
+   }
+
+   int32_t system_call( instance& inst, uint32_t sid, uint32_t ret_ptr, uint32_t ret_len, uint32_t arg_ptr, uint32_t arg_len, uint32_t bytes_written_ptr )
+   {
+      _result.system_calls++;
+
+      // Copied, as a result may be written over the arguments
+      std::string args( reinterpret_cast< const char* >( inst.memory( arg_ptr, arg_len ) ), arg_len );
+      auto ret = reinterpret_cast< char* >( inst.memory( ret_ptr, ret_len ) );
+
+      uint32_t written = 0;
+      auto code = serve( sid, args, ret, ret_len, written );
+      store_u32( inst, bytes_written_ptr, written );
+      return code;
+   }
+
+   int32_t serve( uint32_t sid, std::string& args, char* ret, uint32_t ret_len, uint32_t& written )
+   {
+      std::string out;
+
+      if ( sid == id( chain::system_call_id::get_arguments ) )
+      {
+         out = results::arguments( _entry_point, _arguments );
+      }
+      else if ( sid == id( chain::system_call_id::get_contract_id ) )
+      {
+         out = results::bytes( _chain.contract_id );
+      }
+      else if ( sid == id( chain::system_call_id::get_caller ) )
+      {
+         auto privilege = std::underlying_type_t< chain::privilege >( _chain.kernel_mode ? chain::privilege::kernel_mode : chain::privilege::user_mode );
+         out = results::caller( _chain.caller, uint64_t( privilege ) );
+      }
+      else if ( sid == id( chain::system_call_id::get_head_info ) )
+      {
+         out = results::head_info( _chain.head_height, _chain.head_block_time );
+      }
+      else if ( sid == id( chain::system_call_id::get_chain_id ) )
+      {
+         out = results::bytes( _chain.chain_id );
+      }
+      else if ( sid == id( chain::system_call_id::get_transaction_field ) )
+      {
+         // get_transaction_field_arguments { string field = 1; }
+         fields f( args );
+         if ( !f.ok() )
+            return native_host::malformed_arguments;
+         if ( f.bytes( 1 ) != "id" )
+            return native_host::unknown_system_call;
+
+         out = results::transaction_id( _chain.transaction_id );
+      }
+      else if ( sid == id( chain::system_call_id::check_authority ) )
+      {
+         out = results::authority( _chain.authorized );
+      }
+      else if ( sid == id( chain::system_call_id::hash ) )
+      {
+         // hash_arguments { uint64 code = 1; bytes obj = 2; uint64 size = 3; }
+         fields f( args );
+         if ( !f.ok() )
+            return native_host::malformed_arguments;
+         if ( f.varint( 1 ) != sha256_id || ( f.varint( 3 ) && f.varint( 3 ) != 32 ) )
+            return native_host::unknown_system_call;
+
+         out = results::bytes( std::string( "\x12\x20", 2 ) + tools::sha256( f.bytes( 2 ) ) );
+      }
+      else if ( sid == id( chain::system_call_id::call ) )
+      {
+         // call_arguments { bytes contract_id = 1; uint32 entry_point = 2; bytes args = 3; }
+         fields f( args );
+         if ( !f.ok() )
+            return native_host::malformed_arguments;
+
+         auto it = _chain.call_results.find( uint32_t( f.varint( 2 ) ) );
+         if ( it == _chain.call_results.end() )
+         {
+            _result.logs.push_back( "no result given for a call to entry point " + std::to_string( f.varint( 2 ) ) );
+            return native_host::unknown_system_call;
+         }
+         out = results::bytes( it->second );
+      }
+      else if ( sid == id( chain::system_call_id::event ) )
+      {
+         _result.events++;
+      }
+      else if ( sid == id( chain::system_call_id::log ) )
+      {
+         // log_arguments { string message = 1; }
+         fields f( args );
+         _result.logs.push_back( f.bytes( 1 ) );
+      }
+      else if ( sid == id( chain::system_call_id::exit ) )
+      {
+         // exit_arguments { int32 code = 1; result res = 2; }
+         // result { bytes object = 1; error_data error = 2; }, error_data { string message = 1; }
+         fields f( args );
+         fields res( f.bytes( 2 ) );
+         auto code = int32_t( f.varint( 1 ) );
+         throw exit_signal{ code, code ? fields( res.bytes( 2 ) ).bytes( 1 ) : res.bytes( 1 ) };
+      }
+      else
+      {
+         // Object calls, and an error for anything else
+         return invoke_system_call( sid, ret, ret_len, args.data(), uint32_t( args.size() ), &written );
+      }
+
+      if ( out.size() > ret_len )
+         return native_host::buffer_too_small;
+
+      std::memcpy( ret, out.data(), out.size() );
+      written = uint32_t( out.size() );
+      return native_host::success;
+   }
+
+   const chain_state&  _chain;
+   uint32_t            _entry_point;
+   const std::string&  _arguments;
+   invocation_result&  _result;
+};
+
+// Serves object calls from a store on this thread for its lifetime
+class host_scope
+{
+public:
+   explicit host_scope( native_host::host& h ) { native_host::set_current_host( &h ); }
+   ~host_scope() { native_host::set_current_host( nullptr ); }
+};
+
+} // anonymous
+
+invocation_result invoke( const module& m, const chain_state& chain, native_host::sharded_store& store,
+   uint32_t entry_point, const std::string& arguments, uint64_t instruction_limit )
+{
+   invocation_result result;
+
+   native_host::store_transaction tx( store );
+   native_host::host objects;
+   objects.store       = &tx;
+   objects.batch_calls = chain.batch_calls;
+   host_scope scope( objects );
+
+   session s( chain, entry_point, arguments, result );
+   instance inst( m, [&]( const import& imp, const func_type& type ) { return s.resolve( imp, type ); } );
+   inst.set_instruction_limit( instruction_limit );
+
+   try
+   {
+      inst.start();
+      inst.call( "_start" );
+   }
+   catch ( const exit_signal& e )
+   {
+      result.code   = e.code;
+      result.output = e.output;
+   }
+   catch ( const trap& t )
+   {
+      result.trapped = true;
+      result.output  = t.what();
+   }
+
+   result.instructions = inst.instructions();
+
+   if ( result.ok() )
+      tx.commit();
+
+   return result;
+}
+
+} // koinos::wasm_meter
@@ -0,0 +1,713 @@
+#include <koinos/wasm_meter/module.hpp>
+
+#include <cstring>
+
+namespace koinos::wasm_meter {
+
+namespace {
+
+constexpr uint32_t max_pages  = 65536;
+constexpr uint32_t max_locals = 50000;
+
+std::string hex_byte( uint32_t b )
+{
+   static constexpr char digits[] = "0123456789abcdef";
+   std::string s = "0x";
+   if ( b > 0xff )
+   {
+      s.push_back( digits[ ( b >> 12 ) & 0xf ] );
+      s.push_back( digits[ ( b >> 8 ) & 0xf ] );
+   }
+   s.push_back( digits[ ( b >> 4 ) & 0xf ] );
+   s.push_back( digits[ b & 0xf ] );
+   return s;
+}
+
+class reader
+{
+public:
+   reader( const uint8_t* data, std::size_t size ) : _data( data ), _size( size ) {}
+
+   bool eof() const { return _pos == _size; }
+   std::size_t remaining() const { return _size - _pos; }
+
+   uint8_t byte()
+   {
+      if ( eof() )
+         throw module_error( "unexpected end of module" );
+      return _data[ _pos++ ];
+   }
+
+   const uint8_t* bytes( std::size_t n )
+   {
+      if ( n > remaining() )
+         throw module_error( "unexpected end of module" );
+      auto p = _data + _pos;
+      _pos += n;
+      return p;
+   }
+
+   uint32_t u32()
+   {
+      uint64_t v = 0;
+      for ( unsigned shift = 0; ; shift += 7 )
+      {
+         if ( shift >= 35 )
+            throw module_error( "integer representation too long" );
+
+         auto b = byte();
+         v |= uint64_t( b & 0x7f ) << shift;
+         if ( !( b & 0x80 ) )
+            break;
+      }
+
+      if ( v > 0xffffffffull )
+         throw module_error( "integer too large" );
+      return uint32_t( v );
+   }
+
+   // Signed LEB128 of at most bits bits
+   int64_t sleb( unsigned bits )
+   {
+      const unsigned max_bytes = ( bits + 6 ) / 7;
+
+      uint64_t v = 0;
+      unsigned shift = 0;
+      uint8_t b;
+      for ( unsigned i = 0; ; i++ )
+      {
+         if ( i == max_bytes )
+            throw module_error( "integer representation too long" );
+
+         b = byte();
+         if ( shift < 64 )
+            v |= uint64_t( b & 0x7f ) << shift;
+         shift += 7;
+         if ( !( b & 0x80 ) )
+            break;
+      }
+
+      if ( shift < 64 && ( b & 0x40 ) )
+         v |= ~uint64_t( 0 ) << shift;
+      return int64_t( v );
+   }
+
+   std::string name()
+   {
+      auto n = u32();
+      auto p = bytes( n );
+      return std::string( reinterpret_cast< const char* >( p ), n );
+   }
+
+   reader sub( std::size_t n )
+   {
+      return reader( bytes( n ), n );
+   }
+
+private:
+   const uint8_t* _data;
+   std::size_t    _size;
+   std::size_t    _pos = 0;
+};
+
+value_type read_value_type( reader& r )
+{
+   auto b = r.byte();
+   switch ( b )
+   {
+      case uint8_t( value_type::i32 ):
+      case uint8_t( value_type::i64 ):
+      case uint8_t( value_type::f32 ):
+      case uint8_t( value_type::f64 ):
+      case uint8_t( value_type::funcref ):
+      case uint8_t( value_type::externref ):
+         return value_type( b );
+      default:
+         throw module_error( "unsupported value type " + hex_byte( b ) );
+   }
+}
+
+limits read_limits( reader& r )
+{
+   limits l;
+   auto flags = r.byte();
+   if ( flags > 1 )
+      throw module_error( "shared and 64-bit memories are not supported" );
+
+   l.min = r.u32();
+   if ( flags == 1 )
+   {
+      l.max = r.u32();
+      if ( *l.max < l.min )
+         throw module_error( "limits maximum is below minimum" );
+   }
+   return l;
+}
+
+uint64_t read_const_expr( reader& r, const module& m )
+{
+   uint64_t v;
+   auto code = r.byte();
+   switch ( code )
+   {
+      case i32_const:
+         v = uint32_t( r.sleb( 32 ) );
+         break;
+      case i64_const:
+         v = uint64_t( r.sleb( 64 ) );
+         break;
+      case f32_const:
+      {
+         uint32_t bits;
+         std::memcpy( &bits, r.bytes( 4 ), 4 );
+         v = bits;
+         break;
+      }
+      case f64_const:
+         std::memcpy( &v, r.bytes( 8 ), 8 );
+         break;
+      case ref_null:
+         r.byte();
+         v = null_ref;
+         break;
+      case ref_func:
+         v = r.u32();
+         if ( v >= m.function_count() )
+            throw module_error( "function index out of range" );
+         break;
+      case global_get:
+      {
+         auto index = r.u32();
+         if ( index >= m.globals.size() )
+            throw module_error( "global index out of range" );
+         v = m.globals[ index ].init;
+         break;
+      }
+      default:
+         throw module_error( "unsupported constant expression " + hex_byte( code ) );
+   }
+
+   if ( r.byte() != end )
+      throw module_error( "constant expression is not a single instruction" );
+   return v;
+}
+
+// Params and results of a block type
+void read_block_type( reader& r, const module& m, instruction& in )
+{
+   auto t = r.sleb( 33 );
+   if ( t == -0x40 )
+      return;
+
+   if ( t < 0 )
+   {
+      switch ( value_type( uint8_t( t & 0x7f ) ) )
+      {
+         case value_type::i32:
+         case value_type::i64:
+         case value_type::f32:
+         case value_type::f64:
+         case value_type::funcref:
+         case value_type::externref:
+            in.c = 1;
+            return;
+         default:
+            throw module_error( "malformed block type" );
+      }
+   }
+
+   if ( uint64_t( t ) >= m.types.size() )
+      throw module_error( "type index out of range" );
+
+   in.b = uint32_t( m.types[ t ].params.size() );
+   in.c = m.types[ t ].results.size();
+}
+
+void require_memory( const module& m )
+{
+   if ( !m.memory )
+      throw module_error( "memory instruction in a module without memory" );
+}
+
+struct control
+{
+   uint32_t index;                   // The block, loop or if
+   uint32_t else_index = 0;
+};
+
+void decode_body( reader& r, const module& m, std::optional< uint32_t > data_count, function& fn )
+{
+   uint64_t locals = 0;
+   auto groups = r.u32();
+   for ( uint32_t i = 0; i < groups; i++ )
+   {
+      locals += r.u32();
+      read_value_type( r );
+      if ( locals > max_locals )
+         throw module_error( "too many locals" );
+   }
+
+   fn.locals = uint32_t( locals );
+   auto local_count = locals + m.types[ fn.type ].params.size();
+
+   std::vector< control > ctrl;
+   for ( ;; )
+   {
+      instruction in;
+      auto index = uint32_t( fn.code.size() );
+      auto code = r.byte();
+      in.op = code;
+
+      switch ( code )
+      {
+         case block:
+         case loop:
+         case if_:
+            read_block_type( r, m, in );
+            ctrl.push_back( control{ index } );
+            break;
+
+         case else_:
+         {
+            if ( ctrl.empty() || fn.code[ ctrl.back().index ].op != if_ || ctrl.back().else_index )
+               throw module_error( "else without if" );
+            ctrl.back().else_index = index;
+            fn.code[ ctrl.back().index ].c |= uint64_t( index ) << 32;
+            break;
+         }
+
+         case end:
+         {
+            if ( ctrl.empty() )
+            {
+               fn.code.push_back( in );
+               if ( !r.eof() )
+                  throw module_error( "bytes after the end of a function body" );
+               return;
+            }
+
+            auto c = ctrl.back();
+            ctrl.pop_back();
+            if ( fn.code[ c.index ].op != loop )
+               fn.code[ c.index ].a = index;
+            if ( c.else_index )
+               fn.code[ c.else_index ].a = index;
+            break;
+         }
+
+         case br:
+         case br_if:
+            in.a = r.u32();
+            if ( in.a > ctrl.size() )
+               throw module_error( "branch depth out of range" );
+            break;
+
+         case br_table:
+         {
+            auto n = r.u32();
+            if ( n >= r.remaining() )
+               throw module_error( "unexpected end of module" );
+
+            in.a = uint32_t( fn.br_tables.size() );
+            in.b = n;
+            for ( uint32_t i = 0; i <= n; i++ )
+            {
+               auto depth = r.u32();
+               if ( depth > ctrl.size() )
+                  throw module_error( "branch depth out of range" );
+               fn.br_tables.push_back( depth );
+            }
+            break;
+         }
+
+         case call:
+         case ref_func:
+            in.a = r.u32();
+            if ( in.a >= m.function_count() )
+               throw module_error( "function index out of range" );
+            break;
+
+         case call_indirect:
+            in.a = r.u32();
+            in.b = r.u32();
+            if ( in.a >= m.types.size() )
+               throw module_error( "type index out of range" );
+            if ( in.b >= m.tables.size() )
+               throw module_error( "table index out of range" );
+            break;
+
+         case select_t:
+         {
+            auto n = r.u32();
+            for ( uint32_t i = 0; i < n; i++ )
+               read_value_type( r );
+            in.op = select;
+            break;
+         }
+
+         case local_get:
+         case local_set:
+         case local_tee:
+            in.a = r.u32();
+            if ( in.a >= local_count )
+               throw module_error( "local index out of range" );
+            break;
+
+         case global_get:
+         case global_set:
+            in.a = r.u32();
+            if ( in.a >= m.globals.size() )
+               throw module_error( "global index out of range" );
+            break;
+
+         case memory_size:
+         case memory_grow:
+            require_memory( m );
+            if ( r.u32() )
+               throw module_error( "multiple memories are not supported" );
+            break;
+
+         case i32_const:
+            in.c = uint32_t( r.sleb( 32 ) );
+            break;
+
+         case i64_const:
+            in.c = uint64_t( r.sleb( 64 ) );
+            break;
+
+         case f32_const:
+         {
+            uint32_t bits;
+            std::memcpy( &bits, r.bytes( 4 ), 4 );
+            in.c = bits;
+            break;
+         }
+
+         case f64_const:
+            std::memcpy( &in.c, r.bytes( 8 ), 8 );
+            break;
+
+         case ref_null:
+            r.byte();
+            break;
+
+         case 0xfc:
+         {
+            auto sub = r.u32();
+            if ( sub > 0x0b )
+               throw module_error( "unsupported instruction 0xfc " + hex_byte( sub ) );
+
+            in.op = uint16_t( 0xfc00 | sub );
+            switch ( in.op )
+            {
+               case memory_init:
+               case data_drop:
+                  require_memory( m );
+                  if ( !data_count )
+                     throw module_error( "data segment instruction without a data count section" );
+                  in.a = r.u32();
+                  if ( in.a >= *data_count )
+                     throw module_error( "data segment index out of range" );
+                  if ( in.op == memory_init && r.byte() )
+                     throw module_error( "multiple memories are not supported" );
+                  break;
+               case memory_copy:
+                  require_memory( m );
+                  if ( r.byte() || r.byte() )
+                     throw module_error( "multiple memories are not supported" );
+                  break;
+               case memory_fill:
+                  require_memory( m );
+                  if ( r.byte() )
+                     throw module_error( "multiple memories are not supported" );
+                  break;
+               default:
+                  break;
+            }
+            break;
+         }
+
+         default:
+            if ( code >= i32_load && code <= i64_store32 )
+            {
+               require_memory( m );
+               r.u32();                      // Alignment hint
+               in.a = r.u32();
+            }
+            else if ( !( code == unreachable || code == nop || code == return_ || code == drop || code == select
+               || ( code >= i32_eqz && code <= i64_extend32_s ) || code == ref_is_null ) )
+            {
+               throw module_error( "unsupported instruction " + hex_byte( code ) );
+            }
+            break;
+      }
+
+      fn.code.push_back( in );
+   }
+}
+
+} // anonymous
+
+const func_type& module::function_type( uint32_t index ) const
+{
+   if ( index < imports.size() )
+      return types[ imports[ index ].type ];
+   return types[ functions.at( index - imports.size() ).type ];
+}
+
+const export_entry* module::find_export( const std::string& name, external_kind kind ) const
+{
+   for ( const auto& e : exports )
+      if ( e.name == name && e.kind == kind )
+         return &e;
+   return nullptr;
+}
+
+module decode_module( const uint8_t* data, std::size_t size )
+{
+   static constexpr uint8_t header[] = { 0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00 };
+
+   reader r( data, size );
+   if ( size < sizeof( header ) || std::memcmp( r.bytes( sizeof( header ) ), header, sizeof( header ) ) )
+      throw module_error( "not a version 1 wasm module" );
+
+   module m;
+   std::optional< uint32_t > data_count;
+   bool has_code = false;
+
+   while ( !r.eof() )
+   {
+      auto id = r.byte();
+      auto s = r.sub( r.u32() );
+
+      switch ( id )
+      {
+         case 0:                             // Custom
+            continue;
+
+         case 1:                             // Type
+         {
+            auto n = s.u32();
+            for ( uint32_t i = 0; i < n; i++ )
+            {
+               if ( s.byte() != 0x60 )
+                  throw module_error( "malformed function type" );
+
+               func_type t;
+               auto params = s.u32();
+               for ( uint32_t p = 0; p < params; p++ )
+                  t.params.push_back( read_value_type( s ) );
+               auto results = s.u32();
+               for ( uint32_t p = 0; p < results; p++ )
+                  t.results.push_back( read_value_type( s ) );
+               m.types.push_back( std::move( t ) );
+            }
+            break;
+         }
+
+         case 2:                             // Import
+         {
+            auto n = s.u32();
+            for ( uint32_t i = 0; i < n; i++ )
+            {
+               import imp;
+               imp.module = s.name();
+               imp.name   = s.name();
+               if ( s.byte() != uint8_t( external_kind::function ) )
+                  throw module_error( "import " + imp.module + "." + imp.name + " is not a function, which is not supported" );
+
+               imp.type = s.u32();
+               if ( imp.type >= m.types.size() )
+                  throw module_error( "type index out of range" );
+               m.imports.push_back( std::move( imp ) );
+            }
+            break;
+         }
+
+         case 3:                             // Function
+         {
+            auto n = s.u32();
+            for ( uint32_t i = 0; i < n; i++ )
+            {
+               function fn;
+               fn.type = s.u32();
+               if ( fn.type >= m.types.size() )
+                  throw module_error( "type index out of range" );
+               m.functions.push_back( std::move( fn ) );
+            }
+            break;
+         }
+
+         case 4:                             // Table
+         {
+            auto n = s.u32();
+            for ( uint32_t i = 0; i < n; i++ )
+            {
+               read_value_type( s );
+               m.tables.push_back( read_limits( s ) );
+            }
+            break;
+         }
+
+         case 5:                             // Memory
+         {
+            auto n = s.u32();
+            if ( n > 1 || ( n && m.memory ) )
+               throw module_error( "multiple memories are not supported" );
+            if ( n )
+            {
+               m.memory = read_limits( s );
+               if ( m.memory->min > max_pages )
+                  throw module_error( "memory is too large" );
+            }
+            break;
+         }
+
+         case 6:                             // Global
+         {
+            auto n = s.u32();
+            for ( uint32_t i = 0; i < n; i++ )
+            {
+               global g;
+               g.type       = read_value_type( s );
+               g.is_mutable = s.byte() != 0;
+               g.init       = read_const_expr( s, m );
+               m.globals.push_back( g );
+            }
+            break;
+         }
+
+         case 7:                             // Export
+         {
+            auto n = s.u32();
+            for ( uint32_t i = 0; i < n; i++ )
+            {
+               export_entry e;
+               e.name  = s.name();
+               e.kind  = external_kind( s.byte() );
+               e.index = s.u32();
+               if ( e.kind == external_kind::function && e.index >= m.function_count() )
+                  throw module_error( "function index out of range" );
+               m.exports.push_back( std::move( e ) );
+            }
+            break;
+         }
+
+         case 8:                             // Start
+            m.start = s.u32();
+            if ( *m.start >= m.function_count() )
+               throw module_error( "function index out of range" );
+            break;
+
+         case 9:                             // Element
+         {
+            auto n = s.u32();
+            for ( uint32_t i = 0; i < n; i++ )
+            {
+               element_segment e;
+               auto flags = s.u32();
+               if ( flags > 7 )
+                  throw module_error( "malformed element segment" );
+
+               e.active = !( flags & 1 );
+               if ( e.active )
+               {
+                  if ( flags & 2 )
+                     e.table = s.u32();
+                  e.offset = uint32_t( read_const_expr( s, m ) );
+                  if ( e.table >= m.tables.size() )
+                     throw module_error( "table index out of range" );
+               }
+
+               // Element kind or reference type, absent from the original form
+               if ( flags & 3 )
+                  s.byte();
+
+               auto count = s.u32();
+               for ( uint32_t j = 0; j < count; j++ )
+               {
+                  if ( flags & 4 )
+                  {
+                     e.refs.push_back( read_const_expr( s, m ) );
+                  }
+                  else
+                  {
+                     auto index = s.u32();
+                     if ( index >= m.function_count() )
+                        throw module_error( "function index out of range" );
+                     e.refs.push_back( index );
+                  }
+               }
+
+               // Declarative segments only declare references
+               if ( ( flags & 3 ) != 3 )
+                  m.elements.push_back( std::move( e ) );
+            }
+            break;
+         }
+
+         case 10:                            // Code
+         {
+            auto n = s.u32();
+            if ( n != m.functions.size() )
+               throw module_error( "function and code section counts differ" );
+
+            for ( auto& fn : m.functions )
+            {
+               auto body = s.sub( s.u32() );
+               decode_body( body, m, data_count, fn );
+            }
+            has_code = true;
+            break;
+         }
+
+         case 11:                            // Data
+         {
+            auto n = s.u32();
+            if ( data_count && n != *data_count )
+               throw module_error( "data and data count section counts differ" );
+
+            for ( uint32_t i = 0; i < n; i++ )
+            {
+               data_segment d;
+               auto flags = s.u32();
+               if ( flags > 2 )
+                  throw module_error( "malformed data segment" );
+
+               d.active = flags != 1;
+               if ( flags == 2 && s.u32() )
+                  throw module_error( "multiple memories are not supported" );
+               if ( d.active )
+               {
+                  if ( !m.memory )
+                     throw module_error( "data segment in a module without memory" );
+                  d.offset = uint32_t( read_const_expr( s, m ) );
+               }
+
+               auto len = s.u32();
+               auto p = s.bytes( len );
+               d.bytes.assign( p, p + len );
+               m.data.push_back( std::move( d ) );
+            }
+            break;
+         }
+
+         case 12:                            // Data count
+            data_count = s.u32();
+            break;
+
+         default:
+            throw module_error( "unknown section " + hex_byte( id ) );
+      }
+
+      if ( !s.eof() )
+         throw module_error( "section " + hex_byte( id ) + " has trailing bytes" );
+   }
+
+   if ( !m.functions.empty() && !has_code )
+      throw module_error( "functions without a code section" );
+
+   return m;
+}
+
+} // koinos::wasm_meter
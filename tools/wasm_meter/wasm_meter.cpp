@@ -0,0 +1,561 @@
+#include <koinos/wasm_meter/instance.hpp>
+#include <koinos/wasm_meter/koinos_host.hpp>
+#include <koinos/wasm_meter/module.hpp>
+
+#include <koinos/system_contracts/wire.hpp>
+#include <koinos/tools/address.hpp>
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Runs a wasm contract in the metering interpreter over the calls listed in
+// a fixture, and compares the instructions each call executes against the
+// budget the fixture gives it. Calls run in order against one state store,
+// so later calls see what earlier ones wrote.
+//
+// A fixture is a list of directives, one per line, # to the end of the line
+// being a comment:
+//
+//    contract <address>                      the contract's id
+//    address <name> <address>                names an address for @name
+//    caller <address|-> [kernel|user]        the caller, - for none (default: -, user)
+//    authority allow|deny                    the answer to check_authority (default: allow)
+//    time <ms>                               head block time
+//    height <n>                              head block height
+//    transaction <bytes>                     the transaction id
+//    returns <entry point> [field=value ...] result of a call to another contract
+//    call <name> <entry point> <budget|-> [field=value ...]
+//    revert <name> <entry point> <budget|-> [field=value ...]
+//
+// call expects the invocation to succeed and revert expects it to fail. A
+// budget of - has not been recorded yet: the count is reported, but the run
+// fails unless --report or --record is given. --record writes measured
+// budgets only when every call succeeds or fails as its directive expects,
+// so budgets are never recorded from a contract the fixture does not
+// describe. Arguments are protobuf fields, by
+// number: @name or @address for address bytes, 0x-prefixed hex for bytes,
+// 'text' for a string, true, false or a decimal for a varint, and { ... }
+// for a nested message, as in 1={ 1=5 2=@alice }.
+
+using namespace koinos;
+using namespace koinos::wasm_meter;
+
+namespace wire = koinos::system_contracts::wire;
+
+namespace {
+
+constexpr uint64_t default_instruction_limit = 10'000'000'000ull;
+
+struct options
+{
+   std::string               contract_path;
+   std::string               fixture_path;
+   bool                      verbose     = false;
+   bool                      report      = false;
+   std::optional< uint32_t > record;                 // Headroom, in percent
+   uint64_t                  limit       = default_instruction_limit;
+   bool                      batch_calls = false;
+};
+
+struct token
+{
+   std::string text;
+   std::size_t pos;
+};
+
+struct step
+{
+   bool                      expect_ok   = true;
+   std::string               name;
+   uint32_t                  entry_point = 0;
+   std::string               arguments;
+   std::optional< uint64_t > budget;
+   chain_state               chain;
+   std::size_t               line        = 0;
+   token                     budget_token;
+};
+
+int usage( const char* argv0 )
+{
+   std::fprintf( stderr,
+      "usage: %s [-v] [--report] [--record percent] [-l limit] [-b] <contract.wasm> <fixture>\n"
+      "\n"
+      "  -v                 print each call's logs and error\n"
+      "  --report           report counts over budget or unrecorded without failing\n"
+      "  --record percent   rewrite the fixture's budgets to the measured counts plus\n"
+      "                     percent headroom, if every call behaves as expected\n"
+      "  -l limit           instructions a single call may execute (default: 10000000000)\n"
+      "  -b                 serve get_objects/put_objects, for BATCHED_OBJECT_CALLS builds\n",
+      argv0 );
+   return 1;
+}
+
+bool parse_u64( const std::string& text, uint64_t& v )
+{
+   if ( text.empty() )
+      return false;
+
+   char* end;
+   bool hex = text.size() > 2 && text[0] == '0' && ( text[1] == 'x' || text[1] == 'X' );
+   v = std::strtoull( text.c_str(), &end, hex ? 16 : 10 );
+   return *end == '\0' && text[0] != '-';
+}
+
+// Splits a line into whitespace separated tokens, keeping quoted text whole
+// and dropping comments
+bool tokenize( const std::string& line, std::vector< token >& out )
+{
+   std::size_t i = 0;
+   while ( i < line.size() )
+   {
+      if ( std::isspace( uint8_t( line[i] ) ) )
+      {
+         i++;
+         continue;
+      }
+      if ( line[i] == '#' )
+         break;
+
+      std::size_t start = i;
+      bool quoted = false;
+      while ( i < line.size() && ( quoted || !std::isspace( uint8_t( line[i] ) ) ) )
+      {
+         if ( line[i] == '\'' )
+            quoted = !quoted;
+         i++;
+      }
+      if ( quoted )
+         return false;
+
+      out.push_back( { line.substr( start, i - start ), start } );
+   }
+   return true;
+}
+
+class fixture_parser
+{
+public:
+   bool parse( const std::vector< std::string >& lines, std::vector< step >& steps )
+   {
+      for ( _line = 0; _line < lines.size(); _line++ )
+      {
+         std::vector< token > tokens;
+         if ( !tokenize( lines[ _line ], tokens ) )
+            return fail( "unterminated string" );
+         if ( tokens.empty() )
+            continue;
+         if ( !directive( tokens, steps ) )
+            return false;
+      }
+      return true;
+   }
+
+   const std::string& error() const { return _error; }
+
+private:
+   bool fail( const std::string& message )
+   {
+      _error = "line " + std::to_string( _line + 1 ) + ": " + message;
+      return false;
+   }
+
+   bool address( const std::string& text, std::string& out )
+   {
+      auto it = _names.find( text );
+      if ( it != _names.end() )
+      {
+         out = it->second;
+         return true;
+      }
+      if ( !tools::parse_address( text, out ) || out.empty() )
+         return fail( "invalid address: " + text );
+      return true;
+   }
+
+   bool directive( const std::vector< token >& t, std::vector< step >& steps )
+   {
+      const auto& name = t[0].text;
+      auto args = t.size() - 1;
+
+      if ( name == "contract" && args == 1 )
+         return address( t[1].text, _chain.contract_id );
+
+      if ( name == "address" && args == 2 )
+         return address( t[2].text, _names[ t[1].text ] );
+
+      if ( name == "caller" && ( args == 1 || args == 2 ) )
+      {
+         _chain.caller.clear();
+         if ( t[1].text != "-" && !address( t[1].text, _chain.caller ) )
+            return false;
+
+         _chain.kernel_mode = args == 2 && t[2].text == "kernel";
+         if ( args == 2 && !_chain.kernel_mode && t[2].text != "user" )
+            return fail( "expected kernel or user" );
+         return true;
+      }
+
+      if ( name == "authority" && args == 1 )
+      {
+         if ( t[1].text != "allow" && t[1].text != "deny" )
+            return fail( "expected allow or deny" );
+         _chain.authorized = t[1].text == "allow";
+         return true;
+      }
+
+      if ( name == "time" && args == 1 )
+         return parse_u64( t[1].text, _chain.head_block_time ) || fail( "invalid time" );
+
+      if ( name == "height" && args == 1 )
+         return parse_u64( t[1].text, _chain.head_height ) || fail( "invalid height" );
+
+      if ( name == "transaction" && args == 1 )
+         return bytes( t[1].text, _chain.transaction_id );
+
+      if ( name == "returns" && args >= 1 )
+      {
+         uint64_t entry_point;
+         if ( !parse_u64( t[1].text, entry_point ) )
+            return fail( "invalid entry point" );
+
+         auto& result = _chain.call_results[ uint32_t( entry_point ) ];
+         result.clear();
+
+         std::size_t pos = 2;
+         return message( t, pos, false, result );
+      }
+
+      if ( ( name == "call" || name == "revert" ) && args >= 3 )
+      {
+         step s;
+         s.expect_ok    = name == "call";
+         s.name         = t[1].text;
+         s.chain        = _chain;
+         s.line         = _line;
+         s.budget_token = t[3];
+
+         uint64_t v;
+         if ( !parse_u64( t[2].text, v ) )
+            return fail( "invalid entry point" );
+         s.entry_point = uint32_t( v );
+
+         if ( t[3].text != "-" )
+         {
+            if ( !parse_u64( t[3].text, v ) )
+               return fail( "invalid budget" );
+            s.budget = v;
+         }
+
+         std::size_t pos = 4;
+         if ( !message( t, pos, false, s.arguments ) )
+            return false;
+
+         steps.push_back( std::move( s ) );
+         return true;
+      }
+
+      return fail( "unknown directive: " + name );
+   }
+
+   bool bytes( const std::string& text, std::string& out )
+   {
+      if ( text.size() < 2 || text[0] != '0' || ( text[1] != 'x' && text[1] != 'X' ) || !tools::from_hex( text.substr( 2 ), out ) )
+         return fail( "invalid bytes: " + text );
+      return true;
+   }
+
+   // Encodes field=value tokens from pos, up to the end of the line or, when
+   // nested, up to the closing brace
+   bool message( const std::vector< token >& t, std::size_t& pos, bool nested, std::string& out )
+   {
+      for ( ; pos < t.size(); pos++ )
+      {
+         const auto& text = t[ pos ].text;
+         if ( text == "}" )
+         {
+            if ( !nested )
+               return fail( "unmatched }" );
+            return true;
+         }
+
+         auto eq = text.find( '=' );
+         uint64_t field;
+         if ( eq == std::string::npos || !parse_u64( text.substr( 0, eq ), field ) || !field || field >= ( 1u << 29 ) )
+            return fail( "expected field=value: " + text );
+
+         auto value = text.substr( eq + 1 );
+         if ( value == "{" )
+         {
+            std::string sub;
+            pos++;
+            if ( !message( t, pos, true, sub ) )
+               return false;
+            wire::append_bytes( out, uint32_t( field ), sub );
+         }
+         else if ( !value.empty() && value[0] == '@' )
+         {
+            std::string addr;
+            if ( !address( value.substr( 1 ), addr ) )
+               return false;
+            wire::append_bytes( out, uint32_t( field ), addr );
+         }
+         else if ( value.size() >= 2 && value.front() == '\'' && value.back() == '\'' )
+         {
+            wire::append_bytes( out, uint32_t( field ), value.substr( 1, value.size() - 2 ) );
+         }
+         else if ( value.rfind( "0x", 0 ) == 0 )
+         {
+            std::string b;
+            if ( !bytes( value, b ) )
+               return false;
+            wire::append_bytes( out, uint32_t( field ), b );
+         }
+         else if ( value == "true" || value == "false" )
+         {
+            wire::append_bool( out, uint32_t( field ), value == "true" );
+         }
+         else
+         {
+            uint64_t v;
+            if ( !parse_u64( value, v ) )
+               return fail( "invalid value: " + value );
+            wire::append_uint64( out, uint32_t( field ), v );
+         }
+      }
+
+      if ( nested )
+         return fail( "missing }" );
+      return true;
+   }
+
+   std::size_t                          _line = 0;
+   chain_state                          _chain;
+   std::map< std::string, std::string > _names;
+   std::string                          _error;
+};
+
+bool read_file( const std::string& path, std::string& out )
+{
+   std::ifstream in( path, std::ios::binary );
+   if ( !in )
+      return false;
+   std::ostringstream ss;
+   ss << in.rdbuf();
+   out = ss.str();
+   return true;
+}
+
+std::string status( const invocation_result& r )
+{
+   if ( r.trapped )
+      return "trap";
+   if ( r.code )
+      return "revert " + std::to_string( r.code );
+   return "ok";
+}
+
+// Replaces each recorded step's budget token, padding shorter budgets so the
+// columns after it stay aligned
+bool record_budgets( const options& opts, std::vector< std::string >& lines, const std::vector< step >& steps, const std::vector< uint64_t >& counts )
+{
+   for ( std::size_t i = steps.size(); i-- > 0; )
+   {
+      const auto& s   = steps[i];
+      auto budget     = std::to_string( ( counts[i] * ( 100 + *opts.record ) + 99 ) / 100 );
+      const auto& old = s.budget_token;
+      if ( budget.size() < old.text.size() )
+         budget.append( old.text.size() - budget.size(), ' ' );
+      lines[ s.line ].replace( old.pos, old.text.size(), budget );
+   }
+
+   std::ofstream out( opts.fixture_path, std::ios::binary | std::ios::trunc );
+   for ( const auto& line : lines )
+      out << line << '\n';
+   return bool( out );
+}
+
+int meter( const options& opts )
+{
+   std::string code;
+   if ( !read_file( opts.contract_path, code ) )
+   {
+      std::fprintf( stderr, "cannot read %s\n", opts.contract_path.c_str() );
+      return 1;
+   }
+
+   std::string text;
+   if ( !read_file( opts.fixture_path, text ) )
+   {
+      std::fprintf( stderr, "cannot read %s\n", opts.fixture_path.c_str() );
+      return 1;
+   }
+
+   std::vector< std::string > lines;
+   std::istringstream ss( text );
+   for ( std::string line; std::getline( ss, line ); )
+      lines.push_back( line );
+
+   std::vector< step > steps;
+   fixture_parser parser;
+   if ( !parser.parse( lines, steps ) )
+   {
+      std::fprintf( stderr, "%s: %s\n", opts.fixture_path.c_str(), parser.error().c_str() );
+      return 1;
+   }
+
+   module m;
+   try
+   {
+      m = decode_module( reinterpret_cast< const uint8_t* >( code.data() ), code.size() );
+   }
+   catch ( const module_error& e )
+   {
+      std::fprintf( stderr, "%s: %s\n", opts.contract_path.c_str(), e.what() );
+      return 1;
+   }
+
+   std::printf( "%s: %zu bytes, %zu functions\n\n", opts.contract_path.c_str(), code.size(), m.function_count() );
+   std::printf( "%-32s %14s %14s %7s  %s\n", "entry point", "instructions", "budget", "calls", "result" );
+
+   native_host::sharded_store store( 4, 256 );
+   std::vector< uint64_t > counts;
+   std::size_t over = 0, unexpected = 0, unrecorded = 0;
+
+   for ( auto& s : steps )
+   {
+      s.chain.batch_calls = opts.batch_calls;
+
+      invocation_result r;
+      try
+      {
+         r = invoke( m, s.chain, store, s.entry_point, s.arguments, opts.limit );
+      }
+      catch ( const std::exception& e )
+      {
+         std::fprintf( stderr, "%s: %s\n", opts.contract_path.c_str(), e.what() );
+         return 1;
+      }
+      counts.push_back( r.instructions );
+
+      std::string note;
+      if ( r.ok() != s.expect_ok )
+      {
+         unexpected++;
+         note = s.expect_ok ? "  unexpected failure" : "  unexpected success";
+      }
+      if ( !s.budget )
+      {
+         unrecorded++;
+      }
+      else if ( r.instructions > *s.budget )
+      {
+         over++;
+         note += "  over budget by " + std::to_string( r.instructions - *s.budget );
+      }
+
+      std::printf( "%-32s %14llu %14s %7llu  %s%s\n",
+         s.name.c_str(),
+         (unsigned long long)r.instructions,
+         s.budget ? std::to_string( *s.budget ).c_str() : "-",
+         (unsigned long long)r.system_calls,
+         status( r ).c_str(),
+         note.c_str() );
+
+      if ( opts.verbose || ( r.ok() != s.expect_ok ) )
+      {
+         for ( const auto& log : r.logs )
+            std::printf( "   log: %s\n", log.c_str() );
+         if ( !r.ok() && !r.output.empty() )
+            std::printf( "   error: %s\n", r.output.c_str() );
+         else if ( r.ok() && !r.output.empty() )
+            std::printf( "   result: 0x%s\n", tools::to_hex( reinterpret_cast< const uint8_t* >( r.output.data() ), r.output.size() ).c_str() );
+      }
+   }
+
+   std::printf( "\n%zu calls, %zu over budget, %zu unrecorded, %zu unexpected\n", steps.size(), over, unrecorded, unexpected );
+
+   if ( opts.record && unexpected )
+   {
+      std::fprintf( stderr, "not recording budgets in %s: %zu calls did not behave as expected\n", opts.fixture_path.c_str(), unexpected );
+      return 1;
+   }
+
+   if ( opts.record )
+   {
+      if ( !record_budgets( opts, lines, steps, counts ) )
+      {
+         std::fprintf( stderr, "cannot write %s\n", opts.fixture_path.c_str() );
+         return 1;
+      }
+      std::printf( "recorded budgets with %u%% headroom in %s\n", *opts.record, opts.fixture_path.c_str() );
+   }
+
+   if ( unrecorded && !opts.report )
+      std::fprintf( stderr, "%s: %zu budgets are not recorded, run with --record\n", opts.fixture_path.c_str(), unrecorded );
+
+   if ( unexpected || ( ( over || unrecorded ) && !opts.report ) )
+      return 1;
+   return 0;
+}
+
+} // anonymous
+
+int main( int argc, char** argv )
+{
+   options opts;
+   std::vector< std::string > positional;
+   for ( int i = 1; i < argc; i++ )
+   {
+      std::string arg = argv[i];
+      if ( ( arg == "--record" || arg == "-l" ) && i + 1 < argc )
+      {
+         uint64_t n;
+         if ( !parse_u64( argv[++i], n ) )
+            return usage( argv[0] );
+
+         if ( arg == "--record" )
+            opts.record = uint32_t( n );
+         else
+            opts.limit = n;
+      }
+      else if ( arg == "-v" )
+      {
+         opts.verbose = true;
+      }
+      else if ( arg == "--report" )
+      {
+         opts.report = true;
+      }
+      else if ( arg == "-b" )
+      {
+         opts.batch_calls = true;
+      }
+      else if ( !arg.empty() && arg[0] == '-' )
+      {
+         return usage( argv[0] );
+      }
+      else
+      {
+         positional.push_back( arg );
+      }
+   }
+
+   if ( positional.size() != 2 )
+      return usage( argv[0] );
+
+   opts.contract_path = positional[0];
+   opts.fixture_path  = positional[1];
+
+   // Recorded budgets replace the old ones, so the old ones do not apply
+   if ( opts.record )
+      opts.report = true;
+
+   return meter( opts );
+}